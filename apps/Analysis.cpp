@@ -1,12 +1,37 @@
+#include "AnalysisEngine.hpp"
 #include "CLI/CLI.hpp"
 #include "Channel.hpp"
+#include "Checkpoint.hpp"
+#include "Classifier.hpp"
+#include "Clustering.hpp"
+#include "Counters.hpp"
+#include "Crosstalk.hpp"
+#include "Distributed.hpp"
 #include "Event.hpp"
+#include "EventBuilder.hpp"
+#include "EventViewer.hpp"
+#include "Filter.hpp"
+#include "Histogram.hpp"
+#include "Kernels.hpp"
+#include "Memory.hpp"
+#include "PeakFinder.hpp"
+#include "Precision.hpp"
+#include "PulseShape.hpp"
+#include "RunSummary.hpp"
+#include "Scan.hpp"
+#include "Selection.hpp"
+#include "Spectrum.hpp"
+#include "State.hpp"
+#include "TimeSeries.hpp"
+#include "WindowFinder.hpp"
 #include "TCanvas.h"
 #include "TFile.h"
 #include "TH1F.h"
+#include "TH2F.h"
 #include "TROOT.h"
 #include "TSpectrum.h"
 #include "TGraph.h"
+#include "TGraphErrors.h"
 #include "TTree.h"
 #include "TTreeReader.h"
 #include "TPaveLabel.h"
@@ -17,17 +42,24 @@
 #include "TLatex.h"
 #include "TGaxis.h"
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <map>
+#include <sstream>
 #include <utility>
 #include <vector>
 #include <filesystem>
 #include <limits>
+#include <memory>
+#include <thread>
 
 #include "TApplication.h"
 namespace fs = std::filesystem;
 
-#include "rapidcsv.h"
+#include "Results.hpp"
 
 #include "Style.hpp"
 #include "Screen.hpp"
@@ -186,10 +218,44 @@ TH1F CreateAndFillWaveform(const int& eventNbr, const Channel& channel, const st
 }
 
 
+TH1D ToTH1D(const Histogram& histogram)
+{
+  TH1D th1(histogram.getName().c_str(), histogram.getTitle().c_str(), histogram.getNbins(), histogram.getMin(), histogram.getMax());
+  for(std::size_t i = 0; i != histogram.getNbins(); ++i) th1.SetBinContent(i+1, histogram.getBinContent(i));
+  th1.SetBinContent(0, histogram.getUnderflow());
+  th1.SetBinContent(histogram.getNbins()+1, histogram.getOverflow());
+  th1.SetEntries(histogram.getEntries());
+  return th1;
+}
+
+// Contents (underflow and overflow included), statistics and entries of the histogram for the checkpoints
+void SaveHistogram(std::ostream& stream, const TH1D& histogram)
+{
+  std::vector<double> contents(static_cast<std::size_t>(histogram.GetNbinsX())+2);
+  for(std::size_t bin = 0; bin != contents.size(); ++bin) contents[bin]=histogram.GetBinContent(bin);
+  std::vector<double> stats(TH1::kNstat,0);
+  histogram.GetStats(stats.data());
+  const double entries{histogram.GetEntries()};
+  State::write(stream,contents);
+  State::write(stream,stats);
+  State::write(stream,entries);
+}
+
+void RestoreHistogram(std::istream& stream, TH1D& histogram)
+{
+  std::vector<double> contents(static_cast<std::size_t>(histogram.GetNbinsX())+2);
+  std::vector<double> stats(TH1::kNstat,0);
+  double entries{0};
+  State::read(stream,contents);
+  State::read(stream,stats);
+  State::read(stream,entries);
+  for(std::size_t bin = 0; bin != contents.size(); ++bin) histogram.SetBinContent(bin,contents[bin]);
+  histogram.PutStats(stats.data());
+  histogram.SetEntries(entries);
+}
+
 void ToVolt(Channel& channel)
 {
-  float VPP{560}; //1.12VPP for 0-4096
-  float DAC_TO_VOLT{VPP/2048};
   for(std::size_t j = 0; j != channel.Data.size(); ++j)
   {
     channel.Data[j] = (channel.Data[j] - 2048) * DAC_TO_VOLT;
@@ -220,7 +286,7 @@ std::pair<std::pair<double,int>,std::pair<double,int>> getMinMax(const Channel&
   int tick_max{0};
   int tick_min{0};
   double min{std::numeric_limits<double>::max()};
-  double max{std::numeric_limits<double>::min()};
+  double max{std::numeric_limits<double>::lowest()};
   std::size_t begin_{0};
   std::size_t end_{channel.Data.size()};
   if(begin>0) begin_=begin;
@@ -305,131 +371,197 @@ std::pair<std::pair<double, double>, std::pair<double, double>> MeanSTD(const Ch
   return std::pair<std::pair<double, double>, std::pair<double, double>>(noise, signal);
 }
 
-class EventViewer
+// Canvas created the first time it is used
+class LazyCanvas
 {
 public:
-  EventViewer(const std::string& name="",const std::string& title="",const bool& create=true) : m_Canvas(new TCanvas(create))
-  {
-    m_Canvas->SetName(name.c_str());
-    m_Canvas->SetTitle(title.c_str());
-    m_Canvas->SetFillStyle(4000);
-    m_Canvas->SetCanvasSize(m_CanvasX,m_CanvasY);
-    m_Canvas->SetWindowPosition(m_PositionCanvasX,m_PositionCanvasY);
-    m_Canvas->cd();
-    m_Pad = new TPad("","",0.01,0.01,0.99,0.95);
-    m_PaveLabel = new TPaveLabel(0.01, 0.96, 0.99, 0.99,m_PaveTitle.c_str());
-    m_PaveLabel->Draw();
-    m_Pad->Draw();
-  }
-  ~EventViewer()=default;
-  void setPaveLabel(const std::string& title)
-  {
-    m_PaveLabel->SetLabel(title.c_str());
-    m_PaveLabel->Draw();
-  }
-  void setCanvasName(const std::string& title)
-  {
-    m_Canvas->SetName(title.c_str());
-  }
-  void setCanvasTitle(const std::string& title)
-  {
-    m_Canvas->SetTitle(title.c_str());
-  }
-  void divide(const int& div)
-  {
-    m_Pad->Divide(1,div,0,0);
-  }
-  void cd(const int& id)
-  {
-    m_Pad->cd(id);
-  }
-  void cdNext()
-  {
-    m_cd++;
-    m_Pad->cd(m_cd);
-  }
-  void reset()
-  {
-    m_cd=0;
-  }
-  void saveAs(const std::string& filename)
+  LazyCanvas(const int& width,const int& height) : m_Width(width), m_Height(height) {}
+  TCanvas* operator->()
   {
-    m_Canvas->SaveAs(filename.c_str());
+    if(m_Canvas==nullptr) m_Canvas=std::make_unique<TCanvas>("","",0,0,m_Width,m_Height);
+    return m_Canvas.get();
   }
-  static void setPeriod(const double& period)
-  {
-    m_Period=period;
-  }
-  void createWaveForm(const Analysis::Channels& channels,const Channel& channel)
-  {
-    int number{channels.getChannelByNumber(channel.Group*8+channel.Number).getID()};
-    std::cout<<"Creating "<<number<<std::endl;
-    m_ChannelPlot[number] = TH1F(("Waveform_"+std::to_string(number)).c_str(),";Time (ns);Signal (mV)", channel.Data.size(), 0, channel.Data.size());
-    m_ChannelPlot[number].Clear();
-    for(std::size_t i = 0; i != channel.Data.size(); ++i) m_ChannelPlot[number].Fill(i, channel.Data[i]);
-    m_ChannelPlot[number].SetLineColor(16);
-    m_ChannelPlot[number].GetXaxis()->SetRangeUser(0, channel.Data.size());
-    m_ChannelPlot[number].GetXaxis()->SetLimits(0.,channel.Data.size()*m_Period);
-  }
-  void UnderlineSignalRegion(const int& channel, const Color_t& color,const double& min,const double& max)
+private:
+  int m_Width{800};
+  int m_Height{600};
+  std::unique_ptr<TCanvas> m_Canvas{nullptr};
+};
+
+// Warm-up pass : fill windows with the position of the significant extrema relative to their trigger
+void LearnWindows(WindowFinder& windows, EventBuilder& builder, Analysis::Channels& channels, const std::vector<int>& triggers, const std::pair<double, double>& noiseWindow, const double& nbrSigma, const Long64_t& nbrEvents)
+{
+  const Kernels::Dispatcher kernels{Kernels::Dispatcher::generic()};
+  std::map<int,int> ticks;
+  Event event;
+  for(Long64_t evt = 0; evt < nbrEvents && builder.next(event); ++evt)
   {
-    TH1F* h1c = static_cast<TH1F*>(m_ChannelPlot[channel].Clone());
-    h1c->SetLineColor(color);
-    h1c->GetXaxis()->SetRange(min,max);
-    h1c->Draw("HISTsame");
-    //delete h1c;
+    if(evt==0)
+    {
+      // Delays binned on the record length (channels which are not decoded are empty)
+      std::size_t recordLength{0};
+      for(std::size_t ch = 0; ch != event.Channels.size() && recordLength==0; ++ch) recordLength=event.Channels[ch].Data.size();
+      if(recordLength!=0) windows.setLength(recordLength);
+    }
+    for(const int& trigger : triggers)
+    {
+      if(trigger >= static_cast<int>(event.Channels.size())) continue;
+      kernels.baseline(event.Channels[trigger].Data.data(),event.Channels[trigger].Data.size());
+      ticks[trigger]=TriggerTick(event.Channels[trigger].Data.data(),event.Channels[trigger].Data.size());
+    }
+    for(const auto& channel : channels.get())
+    {
+      const int ch{channel.first};
+      const int trigger{findWichTrigger(ch,triggers)};
+      if(ch >= static_cast<int>(event.Channels.size()) || trigger == -1 || ticks[trigger] == 0) continue;
+      // Scale and offset of ToVolt don't change the tick nor the significance
+      const double* data{event.Channels[ch].Data.data()};
+      const std::size_t length{event.Channels[ch].Data.size()};
+      const int sign{channel.second.getSignPolarity()};
+      const std::pair<double,double> noise{kernels.meanSigma(data,length,noiseWindow.first,noiseWindow.second)};
+      const std::pair<double,int> extremum{kernels.extremum(sign,data,length)};
+      if(sign*(extremum.first-noise.first) > nbrSigma*noise.second) windows.fill(trigger,ticks[trigger],extremum.second);
+    }
+    event.clear();
   }
-  TH1F& getPlot(const int& channel)
+}
+
+// Common mode weights of each chamber learnt on the noise window of the first events
+CommonMode LearnCommonMode(EventBuilder& builder, Analysis::Channels& channels, const std::vector<int>& analysedChannels, const std::vector<int>& channelIndex, const std::pair<double, double>& noiseWindow, const Long64_t& nbrEvents)
+{
+  const Kernels::Dispatcher kernels{Kernels::Dispatcher::generic()};
+  const std::size_t begin{static_cast<std::size_t>(std::max(0.,std::ceil(noiseWindow.first)))};
+  const std::size_t samples{static_cast<std::size_t>(std::max(0.,std::floor(noiseWindow.second)-begin+1))};
+  Crosstalk covariance(analysedChannels.size(),samples);
+  Event event;
+  for(Long64_t evt = 0; evt < nbrEvents && builder.next(event); ++evt)
   {
-    return m_ChannelPlot[channel];
+    for(const int& ch : analysedChannels)
+    {
+      if(ch >= static_cast<int>(event.Channels.size())) continue;
+      ToVolt(event.Channels[ch]);
+      kernels.baseline(event.Channels[ch].Data.data(),event.Channels[ch].Data.size());
+      covariance.addNoise(channelIndex[ch],event.Channels[ch].Data.data(),event.Channels[ch].Data.size(),begin);
+    }
+    covariance.endEvent();
+    event.clear();
   }
-private:
-  TCanvas* m_Canvas{nullptr};
-  TPad* m_Pad{nullptr};
-  TPaveLabel* m_PaveLabel{nullptr};
-  std::map<int,TH1F> m_ChannelPlot;
-  std::string m_PaveTitle;
-  static int m_CanvasX;
-  static int m_CanvasY;
-  static int m_PositionCanvasX;
-  static int m_PositionCanvasY;
-  static double m_Period;
-  int m_cd{0};
-};
+  covariance.finish();
+  std::map<int,std::vector<std::size_t>> chambers;
+  for(const int& ch : analysedChannels) chambers[channels.getChannel(ch).getOnChamber()].push_back(channelIndex[ch]);
+  std::vector<std::vector<std::size_t>> groups;
+  for(const auto& chamber : chambers) groups.push_back(chamber.second);
+  fmt::print("Common mode learnt on {} of {} events\n",covariance.getNoiseEvents(),covariance.getEvents());
+  return covariance.getCommonMode(groups);
+}
 
-double EventViewer::m_Period =1.0;
-int EventViewer::m_CanvasX =1200;
-int EventViewer::m_CanvasY =1500;
-int EventViewer::m_PositionCanvasX =0;
-int EventViewer::m_PositionCanvasY =0;
+// Windows computed on the ADC codes of the channel (--precision compact) : ToVolt and the baseline subtraction are
+// affine so only the results are converted to mV, baseline being the mean of the record in codes
+ChannelWindows CodeWindows(const Kernels::Dispatcher& kernels,const std::vector<std::int16_t>& codes,const double& baseline,const std::pair<double,double>& noise,const std::pair<double,double>& noiseAfter,const std::pair<int,int>& signal)
+{
+  const auto meanSigma=[&baseline](const std::pair<double,double>& code){ return std::pair<double,double>{(code.first-baseline)*DAC_TO_VOLT,code.second*DAC_TO_VOLT}; };
+  const auto extremum=[&baseline](const std::pair<int,int>& code){ return std::pair<double,int>{(code.first-baseline)*DAC_TO_VOLT,code.second}; };
+  const std::int16_t* data{codes.data()};
+  const std::size_t length{codes.size()};
+  ChannelWindows windows;
+  windows.Noise=meanSigma(kernels.meanSigma(data,length,noise.first,noise.second));
+  windows.NoiseAfter=meanSigma(kernels.meanSigma(data,length,noiseAfter.first,noiseAfter.second));
+  windows.Signal=meanSigma(kernels.meanSigma(data,length,signal.first,signal.second));
+  windows.Minimum=extremum(kernels.extremum(-1,data,length,signal.first,signal.second));
+  windows.Maximum=extremum(kernels.extremum(+1,data,length,signal.first,signal.second));
+  return windows;
+}
 
-int GetTickTrigger(const Channel& channel,const double& percent,const Polarity& polarity)
+// HV of a run from the name of its first file (<HV>V.root)
+double RunHV(const std::string& file)
 {
-  std::pair<std::pair<double,int>,std::pair<double,int>> min_max=getMinMax(channel);
-  int value{0};
-  for(std::size_t j = 0; j != channel.Data.size(); ++j)
+  const std::string name{fs::path(file).filename().string()};
+  return std::stof(name.substr(0,name.find("V.root")));
+}
+
+std::string Quote(const std::string& argument)
+{
+#ifdef _WIN32
+  return "\""+argument+"\"";
+#else
+  std::string quoted{"'"};
+  for(const char& c : argument) quoted+= c=='\'' ? std::string("'\\''") : std::string(1,c);
+  return quoted+"'";
+#endif
+}
+
+// Command line of a local worker : the options of the coordinator without the ones of the coordinator mode
+std::string WorkerCommand(int argc, char** argv, const unsigned short& port)
+{
+  const std::vector<std::string> withValue{"--port","--localWorkers","--taskEvents","--taskTimeout"};
+  std::string command{Quote(argv[0])};
+  for(int i = 1; i < argc; ++i)
   {
-    if(polarity==Polarity::Positive && channel.Data[j] > percent*min_max.second.first)
+    const std::string argument{argv[i]};
+    const std::string name{argument.substr(0,argument.find('='))};
+    if(name=="--coordinator") continue;
+    if(std::find(withValue.begin(),withValue.end(),name)!=withValue.end())
     {
-      value=j;
-      break;
+      // Value in the next argument
+      if(name==argument) ++i;
+      continue;
     }
-    else if(polarity==Polarity::Negative && channel.Data[j] < percent*min_max.first.first)
+    command+=" "+Quote(argument);
+  }
+  return command+fmt::format(" --worker 127.0.0.1:{}",port);
+}
+
+// Hash of the options which change the results, a checkpoint is only resumed by a job with the same : the options
+// of the job itself (resume, checkpoints, workers, memory, profile, display) are not in it
+std::uint64_t OptionsHash(int argc, char** argv)
+{
+  const std::vector<std::string> flags{"--resume","--coordinator","--perfCounters"};
+  const std::vector<std::string> withValue{"--checkpoint","--worker","--port","--localWorkers","--taskTimeout","--memory","--plotEvents","--spectrumThreads"};
+  std::string options;
+  for(int i = 1; i < argc; ++i)
+  {
+    const std::string argument{argv[i]};
+    const std::string name{argument.substr(0,argument.find('='))};
+    if(std::find(flags.begin(),flags.end(),name)!=flags.end()) continue;
+    if(std::find(withValue.begin(),withValue.end(),name)!=withValue.end())
     {
-      value=j;
-      break;
+      // Value in the next argument
+      if(name==argument) ++i;
+      continue;
     }
+    options+=argument+"\n";
   }
-  return value;
+  return Checkpoint::hash(options);
+}
+
+// Folder of the plots and checkpoint of a task
+std::string RunFolder(const Task& task)
+{
+  std::string folder{"Results/"+fs::path(task.Files[0]).stem().string()};
+  // Parts of a run processed in parallel don't share their plots
+  if(task.isChunk()) folder+=fmt::format("_{}",task.First);
+  return folder;
 }
 
+// Join the threads when leaving the scope, whatever the way
+struct JoinThreads
+{
+  std::vector<std::thread>& Threads;
+  ~JoinThreads()
+  {
+    for(std::size_t i=0;i!=Threads.size();++i)
+      if(Threads[i].joinable()) Threads[i].join();
+  }
+};
+
 int main(int argc, char** argv)
 {
+  const auto start = std::chrono::steady_clock::now();
+  // Nothing is displayed : no connection to the display, the canvases are only written to files
+  gROOT->SetBatch(true);
   SetStyle();
   gROOT->ForceStyle();
   ROOT::EnableThreadSafety();
   ROOT::EnableImplicitMT(5);
-  std::istringstream Results;
 
   try
   {
@@ -490,6 +622,12 @@ int main(int argc, char** argv)
 
   double NbrSigma{5.0};
   app.add_option("--sigma", NbrSigma, "Number of sigma above the mean noise.");
+  std::string HitSelection{"abs(value - signal_mean) > nsigma*sigma_noise"};
+  app.add_option("--hit", HitSelection, "Selection of the channels with a hit. Variables : value (extremum in the signal window), amp (|value - signal_mean|), signal_mean, signal_sigma, noise_mean, sigma_noise, noise_after_mean, sigma_after, tick (of the extremum), polarity, chamber, strip. Constants : nsigma (--sigma), nsigma_noise (--sigmaNoise).");
+  std::string NoisySelection{"sigma_after/sigma_noise >= nsigma_noise"};
+  app.add_option("--noisy", NoisySelection, "Selection of the noisy channels, their event and the next one are not in the corrected efficiency (same variables as --hit).");
+  std::string Precision{"double"};
+  app.add_option("--precision", Precision, "Arithmetic of the --hit and --noisy features : double (waveforms in mV), compact (12 bits ADC codes as int16, decoded as such from the raw files, with exact integer sums, the waveforms are converted to mV only when needed) or validate (double, compared with compact on the same channels, saved in Precision/).")->check(CLI::IsMember({"double","compact","validate"}));
 
   bool dontPlotNoiseLines{false};
   app.add_option("--dontPlotNoiseLines", dontPlotNoiseLines,"Disable the Noise Lines on the plots.");
@@ -503,6 +641,98 @@ int main(int argc, char** argv)
   double scalefactor{1.0};
   app.add_option("--scaleFactor", plotIndividualChannels,"Factor to divide the multiplicity.");
 
+  // Runs written by several digitizer boards : the files are taken by groups of NbrBoards (same order in each group)
+  std::size_t NbrBoards{1};
+  app.add_option("--boards", NbrBoards, "Number of boards (files) used for one run, the events are built on the TriggerTimeTag.")->check(CLI::PositiveNumber);
+
+  double CoincidenceWindow{2};
+  app.add_option("--coincidence", CoincidenceWindow, "Coincidence window between boards (in TriggerTimeTag ticks).");
+
+  unsigned int RolloverBits{30};
+  app.add_option("--rollover", RolloverBits, "Number of bits of the TriggerTimeTag counter.");
+  Long64_t LearnWindow{0};
+  app.add_option("--learnWindow", LearnWindow, "Number of events of a warm-up pass used to learn the signal delay of each trigger (0 to use the delay given by --signal).");
+  bool DecodeAll{false};
+  app.add_flag("--decodeAll", DecodeAll, "Decode all the channels (by default only the triggers and the analysed channels are read from the files with one branch by channel).");
+
+  std::string FilterType{"none"};
+  app.add_option("--filter", FilterType, "Filter applied on the analysed channels after the baseline subtraction (none, average, fir, iir).")->check(CLI::IsMember({"none","average","fir","iir"}));
+
+  std::size_t FilterWidth{5};
+  app.add_option("--filterWidth", FilterWidth, "Width (in ticks) of the moving average.")->check(CLI::PositiveNumber);
+
+  std::vector<double> FilterCoefficients;
+  app.add_option("--filterCoefficients", FilterCoefficients, "Coefficients of the FIR filter (template for a matched filter).");
+
+  double FilterAlpha{0.5};
+  app.add_option("--filterAlpha", FilterAlpha, "Smoothing factor of the IIR low-pass filter ]0,1].");
+
+  double ClusterWindow{10};
+  app.add_option("--clusterWindow", ClusterWindow, "Maximum time difference (in ticks) between adjacent fired strips of a cluster.");
+
+  double TimeBin{1.0};
+  app.add_option("--timeBin", TimeBin, "Initial width (in s) of the time bins of the efficiency monitoring (doubled when the run is too long).")->check(CLI::PositiveNumber);
+
+  std::size_t TimeBins{512};
+  app.add_option("--timeBins", TimeBins, "Maximum number of time bins of the efficiency monitoring.");
+
+  double CFDFraction{0.2};
+  app.add_option("--cfd", CFDFraction, "Fraction of the amplitude used for the constant fraction time of the hits.");
+
+  std::pair<double, double> ChargeWindow{10,30};
+  app.add_option("--chargeWindow", ChargeWindow, "Number of ticks before and after the peak used to integrate the charge.")->type_size(2);
+
+  bool SavePulses{false};
+  app.add_option("--savePulses", SavePulses, "Save the features (amplitude, charge, rise time, time) of each hit in Pulses.res.");
+  bool FindPeaks{false};
+  app.add_flag("--peaks", FindPeaks, "Search all the peaks (pile-up, afterpulses) in the signal window of the hits, histograms in Peaks/.");
+  double PeakHysteresis{0.5};
+  app.add_option("--peakHysteresis", PeakHysteresis, "Fraction of the hit threshold below which a peak ends.")->check(CLI::Range(0.0,1.0));
+  bool PeakCompare{false};
+  app.add_flag("--peakCompare", PeakCompare, "Run TSpectrum::SearchHighRes on the same windows and report its time and agreement with the peak finder.");
+  std::string SpectrumMode{"none"};
+  app.add_option("--spectrum", SpectrumMode, "Noise power spectral density of each channel from the noise window (noise) or from the whole records of the events without hit (records), saved in Spectrum/.")->check(CLI::IsMember({"none","noise","records"}));
+  std::size_t SpectrumThreads{std::max(1u,std::thread::hardware_concurrency())};
+  app.add_option("--spectrumThreads", SpectrumThreads, "Number of threads computing the FFTs of the noise spectrum.")->check(CLI::PositiveNumber);
+  bool HardwareCounters{false};
+  app.add_flag("--perfCounters", HardwareCounters, "Time and hardware counters (perf_event_open : cycles, instructions, cache and branch misses) of each stage of the event loop and of the noise spectrum threads, reported by event and by sample at the end of the run (time only when the counters are not available).");
+  bool CrosstalkMatrix{false};
+  app.add_flag("--crosstalk", CrosstalkMatrix, "Channel x channel noise covariance, correlation and hit coincidence matrices, saved in Crosstalk/.");
+  Long64_t CommonModeEvents{0};
+  app.add_option("--commonMode", CommonModeEvents, "Number of events on which the common mode weights of each chamber are learnt before the analysis, 0 to not subtract the common mode.")->check(CLI::NonNegativeNumber);
+  std::string ClassifierModel{""};
+  app.add_option("--classifier", ClassifierModel, "Linear model file for the empty/avalanche/streamer/noise event classifier (cuts if not given).")->check(CLI::ExistingFile);
+  double StreamerCharge{10.0};
+  app.add_option("--streamerCharge", StreamerCharge, "Charge (pC) above which a chamber event is tagged as streamer by the cut classifier.")->check(CLI::PositiveNumber);
+  bool CoordinatorMode{false};
+  app.add_flag("--coordinator", CoordinatorMode, "Distribute the runs (or parts of them, see --taskEvents) to worker processes and merge their results.");
+  unsigned short Port{0};
+  app.add_option("--port", Port, "Port of the coordinator (0 : any free port, printed at startup).");
+  unsigned int LocalWorkers{std::max(1u,std::thread::hardware_concurrency())};
+  app.add_option("--localWorkers", LocalWorkers, "Number of worker processes started on this host by the coordinator (0 to only use remote workers).");
+  Long64_t TaskEvents{0};
+  app.add_option("--taskEvents", TaskEvents, "Number of events of each task of the coordinator (0 : one task by run).");
+  double TaskTimeout{0};
+  app.add_option("--taskTimeout", TaskTimeout, "Time (s) after which the task of a worker is given to another one (0 : no limit).");
+  Long64_t CheckpointInterval{10000};
+  app.add_option("--checkpoint", CheckpointInterval, "Number of events between two checkpoints of the counters of a run (0 to disable).");
+  bool Resume{false};
+  app.add_flag("--resume", Resume, "Restart each run from its last checkpoint and skip the runs complete (the results are the same as without interruption).");
+  long PlotEvents{-1};
+  app.add_option("--plotEvents", PlotEvents, "Number of events of each run for which the event displays are saved (-1 : all, 0 : none, no canvas is created before the end of the run).");
+  std::size_t MemoryBudget{0};
+  app.add_option("--memory", MemoryBudget, "Resident memory target (MB, 0 : no limit), the read caches of the files are reduced to stay below it.");
+  std::vector<double> ScanSigma;
+  app.add_option("--scanSigma", ScanSigma, "Thresholds (number of sigma) of the efficiency scan made in the same pass (Scan.csv of each run, disabled if empty).");
+  std::vector<double> ScanSigmaNoise;
+  app.add_option("--scanSigmaNoise", ScanSigmaNoise, "Noisy event thresholds (--sigmaNoise) of the efficiency scan (--sigmaNoise if empty).");
+  std::vector<double> ScanDelay;
+  app.add_option("--scanDelay", ScanDelay, "Delays (ticks) of the signal windows of the efficiency scan (delay of --signal if empty).");
+  std::vector<double> ScanWidth;
+  app.add_option("--scanWidth", ScanWidth, "Widths (ticks) of the signal windows of the efficiency scan (width of --signal if empty).");
+  std::string WorkerAddress{""};
+  app.add_option("--worker", WorkerAddress, "Process the tasks of the coordinator host:port (same options as the coordinator, the files must be reachable with the same paths).");
+
   try
   {
     app.parse(argc, argv);
@@ -511,6 +741,15 @@ int main(int argc, char** argv)
   {
     return app.exit(e);
   }
+  // The compact features are computed on the ADC codes as read
+  if(Precision!="double" && (FilterType!="none" || CommonModeEvents>0)) throw std::runtime_error(fmt::format("--precision {} works on the raw ADC codes, it can't be used with --filter or --commonMode !",Precision));
+  // Grid of the scan : all the (delay, width) pairs
+  if(ScanSigmaNoise.empty()) ScanSigmaNoise.push_back(NbrSigmaNoise);
+  if(ScanDelay.empty()) ScanDelay.push_back(SignalWindow.second);
+  if(ScanWidth.empty()) ScanWidth.push_back(SignalWindow.first);
+  std::vector<std::pair<double, double>> ScanWindows;
+  for(const double& delay : ScanDelay)
+    for(const double& width : ScanWidth) ScanWindows.emplace_back(delay,width);
   std::vector<std::string> line;
   /*std::string arguments{"#"};
    l ine.clear();             *                                                                                            *
@@ -522,18 +761,6 @@ int main(int argc, char** argv)
   line.push_back(arguments);
   documents.SetRow(-1,line);*/
 
-  line={"HV","Efficiency","Error Efficiency","Efficiency Corrected","Error Efficiency Corrected","Multiplicity"};
-  std::vector<rapidcsv::Document> documents;
-  std::vector<std::istringstream> Results;
-  std::vector<int> Indexes;
-  for(std::size_t i =0 ;i!=NumberChambers;++i)
-  {
-    Indexes.push_back(0);
-    Results.push_back(std::istringstream());
-    documents.push_back(rapidcsv::Document(Results[i],rapidcsv::LabelParams(0,-1)));
-    documents[i].SetRow(-1,line);
-  }
-
   std::size_t found = path.find_last_of("/\\");
   path = path.substr(0,found);
   std::vector<std::string> path_file;
@@ -541,6 +768,7 @@ int main(int argc, char** argv)
   {
     path_file.push_back(path+"/"+files[i]);
   }
+  if(path_file.size()%NbrBoards!=0) throw std::runtime_error(fmt::format("{} files given but {} boards by run !",path_file.size(),NbrBoards));
 
 
   //Perform some check to avoid problem
@@ -558,18 +786,146 @@ int main(int argc, char** argv)
   }
 
   channels.print();
+  // Channels to read from the files
+  std::vector<int> decoded{triggers};
+  // Triggers of the groups with analysed channels
+  std::vector<int> usedTriggers;
+  for(const auto& channel : channels.get())
+  {
+    const int trigger{findWichTrigger(channel.first,triggers)};
+    if(std::find(usedTriggers.begin(),usedTriggers.end(),trigger)==usedTriggers.end()) usedTriggers.push_back(trigger);
+  }
+  if(!DecodeAll)
+    for(const auto& channel : channels.get()) decoded.push_back(channel.first);
+
+  Filter filter{Filter::fromString(FilterType,FilterWidth,FilterCoefficients,FilterAlpha)};
+  // Selections compiled once, errors reported before any file is opened
+  ChannelSelections selections(HitSelection,NoisySelection,NbrSigma,NbrSigmaNoise);
+  std::vector<double*> toFilter;
+  std::vector<unsigned int> toFilterChannels;
+
+  // Strips (channel numbers) connected to each chamber
+  std::vector<std::vector<int>> strips(NumberChambers);
+  for(auto channel : channels.get())
+  {
+    if(channel.second.getOnChamber()>=0 && channel.second.getOnChamber()<NumberChambers) strips[channel.second.getOnChamber()].push_back(channel.second.getNumber());
+  }
 
   std::map<int,EventViewer> eventViewers;
   //Create the graph for chambers
   for(std::size_t i=0;i!=NumberChambers;++i)
   {
-    eventViewers[i]=EventViewer();
     eventViewers[i].divide(channels.getNumberChannelActivatedForChamber(i));
   }
 
-  TCanvas can2("","",0,0,800,600);
-  for(std::size_t file=0;file!=path_file.size();++file)
+  // One task by run (its NbrBoards files)
+  std::vector<Task> tasks;
+  for(std::size_t file=0;file!=path_file.size();file+=NbrBoards)
+  {
+    Task task;
+    task.ID=tasks.size();
+    task.Run=tasks.size();
+    task.Files.assign(path_file.begin()+file,path_file.begin()+file+NbrBoards);
+    tasks.push_back(task);
+  }
+
+  // Checkpoints resumed only by a job with the same options, the runs complete are not made again
+  const std::uint64_t Options{OptionsHash(argc,argv)};
+  std::size_t finishedRuns{0};
+  for(std::size_t run=0;run!=tasks.size() && Resume && !CoordinatorMode && WorkerAddress.empty();++run)
+  {
+    Checkpoint checkpoint;
+    if(!Checkpoint::read(RunFolder(tasks[run])+"/Checkpoint.txt",checkpoint)) continue;
+    if(checkpoint.Options!=Options) throw std::runtime_error(fmt::format("Checkpoint of {} made with other options, run without --resume !",RunFolder(tasks[run])));
+    if(checkpoint.isFinished()) ++finishedRuns;
+  }
+
+  // One binary results file by chamber (one record by run), exported to .csv at the end
+  // The workers send their results to the coordinator, which writes them. A job resumed appends the runs it makes to
+  // the records of the runs complete (the runs are made in order, the ones complete are the first ones).
+  std::vector<std::unique_ptr<ResultsWriter>> documents;
+  for(std::size_t i =0 ;i!=NumberChambers && WorkerAddress.empty();++i)
+  {
+    documents.push_back(std::make_unique<ResultsWriter>(save+"_Chamber"+std::to_string(i)+".res",RunSummary::getColumns(),Resume && !CoordinatorMode,finishedRuns));
+  }
+
+  if(CoordinatorMode)
+  {
+    // Local workers joined once the coordinator is destroyed, also when run throws : its connections are closed so
+    // the workers stop
+    std::vector<std::thread> localWorkers;
+    const JoinThreads joinWorkers{localWorkers};
+    // Remote workers only : leave them time to be started by hand
+    Coordinator coordinator(Port,TaskTimeout,LocalWorkers==0 ? 3600 : 60);
+    for(const Task& run : tasks)
+    {
+      if(TaskEvents<=0)
+      {
+        coordinator.addTask(run);
+        continue;
+      }
+      // Parts of TaskEvents events of the run
+      int NbrEventsRun{NbrEvents};
+      NbrEventsRun=NbrEventToProcess(NbrEventsRun,EventBuilder(run.Files,nameTree,CoincidenceWindow,RolloverBits).getEntries());
+      for(Long64_t first=0;first<NbrEventsRun;first+=TaskEvents)
+      {
+        Task task{run};
+        task.First=first;
+        task.Events=std::min<Long64_t>(TaskEvents,NbrEventsRun-first);
+        coordinator.addTask(task);
+      }
+    }
+    fmt::print(fg(fmt::color::green) | fmt::emphasis::bold,"Coordinator listening on port {}, {} local workers\n",coordinator.getPort(),LocalWorkers);
+    const std::string command{WorkerCommand(argc,argv,coordinator.getPort())};
+    for(std::size_t i=0;i!=LocalWorkers;++i) localWorkers.emplace_back([command](){ std::system(command.c_str()); });
+    std::vector<RunSummary> summaries(tasks.size());
+    // Tasks the workers couldn't process by run : the run is incomplete, it is not written and the job fails
+    std::vector<std::size_t> failed(tasks.size(),0);
+    std::size_t received{0};
+    coordinator.run([&](const Task& task, const std::string& result)
+    {
+      summaries[task.Run].add(RunSummary::deserialize(result));
+      fmt::print("Task {} done (run {}, events [{},{}[), {} results received\n",task.ID,task.Run,task.First,task.First+task.Events,++received);
+    },
+    [&](const Task& task, const std::string& reason)
+    {
+      ++failed[task.Run];
+      fmt::print(fg(fmt::color::red) | fmt::emphasis::bold,"Task {} failed (run {}, events [{},{}[) : {}\n",task.ID,task.Run,task.First,task.First+task.Events,reason);
+    });
+    for(std::size_t i=0;i!=localWorkers.size();++i) localWorkers[i].join();
+    if(coordinator.getReassigned()!=0) fmt::print(fg(fmt::color::orange),"{} tasks given again to another worker\n",coordinator.getReassigned());
+    for(std::size_t run=0;run!=summaries.size();++run)
+    {
+      if(failed[run]!=0) continue;
+      for(std::size_t chamber=0;chamber!=NumberChambers;++chamber) documents[chamber]->append(summaries[run].getRecord(chamber,RunHV(tasks[run].Files[0]),scalefactor));
+    }
+    for(std::size_t document=0; document!=documents.size();++document)
+    {
+      ResultsReader(documents[document]->getFilename()).exportCSV(save+"_Chamber"+std::to_string(document)+".csv");
+    }
+    if(coordinator.getFailed()==0) return 0;
+    for(std::size_t run=0;run!=failed.size();++run)
+    {
+      if(failed[run]!=0) fmt::print(fg(fmt::color::red) | fmt::emphasis::bold,"Run {} ({}) not written : {} tasks failed\n",run,tasks[run].Files[0],failed[run]);
+    }
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<Worker> worker{nullptr};
+  if(!WorkerAddress.empty())
   {
+    const std::size_t colon{WorkerAddress.rfind(':')};
+    if(colon==std::string::npos) throw std::runtime_error(fmt::format("Coordinator address {} is not host:port !",WorkerAddress));
+    worker=std::make_unique<Worker>(WorkerAddress.substr(0,colon),static_cast<unsigned short>(std::stoul(WorkerAddress.substr(colon+1))));
+  }
+
+  LazyCanvas can2(800,600);
+  bool firstProcessed{false};
+  std::size_t nextTask{0};
+  Task task;
+  while(worker!=nullptr ? worker->next(task) : nextTask!=tasks.size())
+  {
+    if(worker==nullptr) task=tasks[nextTask++];
     TH1D total("Tick Distribution","Tick Distribution",1024,0,1024);
     TH1D delta_t("delta_T","delta_T",100,0,10);
     TH1D delta_T_not_event("delta_T_not_even","delta_T_not_even",100,0,10);
@@ -579,10 +935,24 @@ int main(int argc, char** argv)
     delta_T_not_event.Clear();
     delta_T_noisy.Clear();
 
-  //Open The file
-    TFile fileIn(path_file[file].c_str());
   // Create Directory
-    std::string folder{"Results/"+std::string(fs::path(path_file[file]).stem())};
+    const std::string folder{RunFolder(task)};
+    // Restart after the last checkpoint of the run, the run is not made again if it is complete
+    const std::string checkpointFile{folder+"/Checkpoint.txt"};
+    Checkpoint resumed;
+    if(Resume && Checkpoint::read(checkpointFile,resumed))
+    {
+      if(resumed.Options!=Options) throw std::runtime_error(fmt::format("Checkpoint of {} made with other options, run without --resume !",folder));
+      if(resumed.isFinished())
+      {
+        fmt::print(fg(fmt::color::green) | fmt::emphasis::bold,"{} already analysed\n",folder);
+        if(worker!=nullptr) worker->send(task,resumed.Summary.serialize());
+        continue;
+      }
+    }
+    else resumed=Checkpoint();
+    // State of the accumulators, the records of Pulses.res first
+    std::istringstream resumedState(resumed.State);
   fs::create_directories(folder+"/Events");
   fs::create_directories(folder+"/Others");
 
@@ -599,60 +969,231 @@ int main(int argc, char** argv)
     ticks_distribution[triggers[i]]=TH1D("Tick Distribution","Tick Distribution",1024,0,1024);
   }
 
-  TTree* Run{nullptr};
+  // Index of each analysed channel in the noise spectrum, crosstalk and common mode
+  std::vector<int> channelIndex;
+  std::vector<int> analysedChannels;
+  for(const auto& channel : channels.get())
+  {
+    if(channel.first>=static_cast<int>(channelIndex.size())) channelIndex.resize(channel.first+1,-1);
+    channelIndex[channel.first]=analysedChannels.size();
+    analysedChannels.push_back(channel.first);
+  }
+
+  //Open The file(s)
+  std::unique_ptr<EventBuilder> Run{nullptr};
+  CommonMode commonMode;
+  std::vector<double*> commonModeData(analysedChannels.size(),nullptr);
+  // Features of the analysed channels of the event (one row by channel) and the result of the selections on them
+  std::vector<std::vector<double>> features(FeatureNames.size(),std::vector<double>(analysedChannels.size(),0));
+  std::vector<const double*> featureColumns;
+  for(const std::vector<double>& column : features) featureColumns.push_back(column.data());
+  std::vector<ChannelWindows> channelWindows(analysedChannels.size());
+  std::vector<std::uint8_t> hitSelected(analysedChannels.size(),0);
+  std::vector<std::uint8_t> noisySelected(analysedChannels.size(),0);
+  // ADC codes of the analysed channels and their mean (--precision compact or validate), the waveform in mV is made
+  // when needed only (inVolt)
+  std::vector<std::vector<std::int16_t>> codes(analysedChannels.size());
+  std::vector<double> codeBaseline(analysedChannels.size(),0);
+  std::vector<bool> inVolt(analysedChannels.size(),false);
+  // Features and selections of the compact path compared to the double ones (--precision validate)
+  std::vector<std::vector<double>> codeFeatures(features);
+  std::vector<const double*> codeFeatureColumns;
+  for(const std::vector<double>& column : codeFeatures) codeFeatureColumns.push_back(column.data());
+  std::vector<std::uint8_t> codeHitSelected(analysedChannels.size(),0);
+  std::vector<std::uint8_t> codeNoisySelected(analysedChannels.size(),0);
+  // Record length set once the first event is read
+  WindowFinder windows(triggers,SignalWindow.first,SignalWindow.second);
   try
   {
-    if(fileIn.IsZombie())
+    Run = std::make_unique<EventBuilder>(task.Files,nameTree,CoincidenceWindow,RolloverBits);
+    if(LearnWindow>0)
+    {
+      EventBuilder warmup(task.Files,nameTree,CoincidenceWindow,RolloverBits);
+      warmup.setChannels(decoded);
+      LearnWindows(windows,warmup,channels,triggers,NoiseWindow,NbrSigma,LearnWindow);
+      windows.learn();
+      for(const int& trigger : triggers) fmt::print("Trigger {} : signal delay {:.1f} ticks ({})\n",trigger,windows.getDelay(trigger),windows.isLearnt(trigger) ? "learnt" : "no significant peak, --signal value kept");
+    }
+    if(CommonModeEvents>0)
     {
-      throw std::runtime_error(fmt::format("File {} Not Opened",path_file[file]));
+      EventBuilder warmup(task.Files,nameTree,CoincidenceWindow,RolloverBits);
+      warmup.setChannels(decoded);
+      commonMode=LearnCommonMode(warmup,channels,analysedChannels,channelIndex,NoiseWindow,CommonModeEvents);
+      for(const int& ch : analysedChannels) fmt::print("Channel {} : common mode weight {:.3f}\n",channels.getChannel(ch).getNumber(),commonMode.getWeight(channelIndex[ch]));
     }
-    Run = static_cast<TTree*>(fileIn.Get(nameTree.c_str()));
-    if(Run == nullptr || Run->IsZombie())
+    // The compact features start from the ADC codes, decoded as such from the raw files
+    if(Precision!="double") Run->setCodes(true);
+    if(!DecodeAll)
     {
-      throw std::runtime_error("Problem Opening TTree \"Tree\" !!!");
+      Run->setChannels(decoded);
+      if(Run->getNumberSelectiveBoards()!=0) fmt::print("Decoding only {} channels for {} of the {} boards\n",decoded.size(),Run->getNumberSelectiveBoards(),Run->getNumberBoards());
     }
   }
   catch(const std::runtime_error& error)
   {
     fmt::print(fg(fmt::color::red) | fmt::emphasis::bold,"{}\n",error.what());
+    // The coordinator mustn't wait for the result, nor merge the run without this part
+    if(worker!=nullptr) worker->fail(task,error.what());
     continue;
   }
 
+  ClusterBuilder clusters(strips,ClusterWindow);
+  TimeSeries timeSeries(NumberChambers,TimeBin,TimeBins,8.5e-9,RolloverBits);
+  PulseAnalyser pulses(NumberChambers,channels.getNumberChannels(),CFDFraction,ChargeWindow);
+  PeakFinder peaks(NumberChambers,channels.getNumberChannels(),PeakHysteresis);
+  TSpectrum spectrum;
+  std::vector<double> spectrumSource;
+  std::vector<double> spectrumDestination;
+  double peakSeconds{0};
+  double spectrumSeconds{0};
+  std::size_t spectrumCompared{0};
+  std::size_t spectrumAgree{0};
+  std::unique_ptr<ResultsWriter> pulseFile{nullptr};
+  // The pulses written after the checkpoint are written again
+  std::size_t pulseRecords{0};
+  if(resumed.Done!=0) State::read(resumedState,pulseRecords);
+  if(SavePulses) pulseFile=std::make_unique<ResultsWriter>(folder+"/Pulses.res",std::vector<std::string>{"Event","Chamber","Strip","Amplitude","Charge","Rise Time","Time"},resumed.Done!=0,pulseRecords);
+  std::vector<double> pulseRecord(7);
+  Classifier classifier(NumberChambers,NbrSigmaNoise,StreamerCharge);
+  if(!ClassifierModel.empty()) classifier.load(ClassifierModel);
+  // Efficiency scan over the thresholds and windows of the command line, on the events of this job
+  std::unique_ptr<Scan> scan{nullptr};
+  if(!ScanSigma.empty()) scan=std::make_unique<Scan>(NumberChambers,ScanSigma,ScanWindows,ScanSigmaNoise,NoiseWindow,NoiseWindowAfter);
+  double Period{0};
+  // Noise spectrum, created once the record length is known
+  std::unique_ptr<NoiseSpectrum> noiseSpectrum{nullptr};
+  const std::size_t spectrumBegin{static_cast<std::size_t>(std::max(0.,std::ceil(NoiseWindow.first)))};
+  std::unique_ptr<Crosstalk> crosstalk{nullptr};
+  if(CrosstalkMatrix) crosstalk=std::make_unique<Crosstalk>(analysedChannels.size(),static_cast<std::size_t>(std::max(0.,std::floor(NoiseWindow.second)-spectrumBegin+1)));
+  // Waveform kernels specialised on the record length of the first event
+  Kernels::Dispatcher kernels;
+  PrecisionValidation validation(Precision=="validate" ? NumberChambers : 0,channels.getNumberChannels());
+  double doubleSeconds{0};
+  double compactSeconds{0};
+  // Stages of the event loop measured with --perfCounters
+  enum Stage : std::size_t {StageRead,StageTriggers,StageConversion,StageNoise,StageFeatures,StageHits,StageEndEvent,StageSpectrum};
+  StageProfile profile({"read","triggers","conversion","noise","features","hits","end of event","spectrum FFT"});
+  StageClock stageClock(HardwareCounters ? &profile : nullptr);
+  std::uint64_t profiledEvents{0};
+  std::uint64_t profiledSamples{0};
+
   std::map<int,TH1D> mins;
   for(auto channel : channels.get())
   {
     mins[channel.first]=TH1D("min position distribution","min position distribution",1024,0,1024);
   }
 
-  NbrEvents={NbrEventToProcess(NbrEvents,Run->GetEntries())};
-  //channels.print();
-  Event* event{nullptr};
-
-  bool   hasseensomething{false};
-  if(Run->SetBranchAddress("Events", &event))
+  // Keep NbrEvents untouched, each run (or group of boards) can have a different number of entries
+  int NbrEventsRun{NbrEvents};
+  // A chunk is read from the event before it, analysed only up to its noisy flag : the first event of the chunk is
+  // in the corrected efficiency as in the whole run, the merged results don't depend on --taskEvents
+  bool previousEvent{false};
+  if(task.isChunk())
   {
-    throw std::runtime_error("Error while SetBranchAddress !!!");
+    previousEvent=task.First>0 && resumed.Done==0;
+    Run->skip(task.First-(previousEvent ? 1 : 0));
+    NbrEventsRun=task.Events;
   }
-
-  // Initialize multiplicity
-  std::vector<float> Multiplicity;
-  std::vector<int> goodStack;
-  std::vector<int> goodStackCorrected;
-  std::vector<bool> goods;
-  for(std::size_t i=0;i!=NumberChambers;++i)
+  else NbrEventsRun=NbrEventToProcess(NbrEventsRun,Run->getEntries());
+  // Read caches within a quarter of the memory budget (events are decoded and analysed one by one)
+  const std::size_t MemoryBytes{MemoryBudget*1024*1024};
+  if(MemoryBudget>0) Run->setCacheSize(MemoryBytes/4);
+  // Restart after the last checkpoint of the run, its accumulators are restored on the first event
+  const Long64_t NbrEventsPlanned{NbrEventsRun};
+  Long64_t firstEvent{0};
+  if(resumed.Done!=0)
   {
-    Multiplicity.push_back(0.);
-    goodStack.push_back(0.);
-    goodStackCorrected.push_back(0.);
-    goods.push_back(false);
+    if(resumed.Events!=NbrEventsPlanned || resumed.Summary.Chambers.size()!=NumberChambers) throw std::runtime_error(fmt::format("Checkpoint of {} made on {} events, {} now : run without --resume !",folder,resumed.Events,NbrEventsPlanned));
+    firstEvent=Run->skip(resumed.Done);
+    fmt::print(fg(fmt::color::green) | fmt::emphasis::bold,"Resuming {} after event {}\n",folder,firstEvent);
   }
+  //channels.print();
+  Event* event{new Event()};
+  // Waveform of an analysed channel in mV without its baseline, made once by event
+  const auto toVolt=[&](const unsigned int& ch)
+  {
+    const std::size_t row{static_cast<std::size_t>(channelIndex[ch])};
+    if(inVolt[row]) return;
+    // Decoded as codes only
+    if(event->Channels[ch].Data.empty()) event->Channels[ch].Data.assign(codes[row].begin(),codes[row].end());
+    ToVolt(event->Channels[ch]);
+    kernels.baseline(event->Channels[ch].Data.data(),event->Channels[ch].Data.size());
+    inVolt[row]=true;
+  };
 
+  bool   hasseensomething{false};
 
-  int event_skip1{-1};
-  int event_skip2{-1};
-  int total_event{0};
-  for(Long64_t evt = 0; evt < NbrEvents; ++evt)
+  // Efficiency, multiplicity and hits/noisy channels of the current event
+  EfficiencyCounter efficiency(NumberChambers);
+  // Counters of the events before the checkpoint
+  if(resumed.Done!=0) efficiency.restore(resumed.Summary,resumed.NoisyLast);
+  // State of the other accumulators of the run for the checkpoints, read back in the same order
+  auto SaveState=[&]()
+  {
+    std::ostringstream state;
+    if(pulseFile!=nullptr) pulseFile->flush();
+    State::write(state,pulseFile!=nullptr ? pulseFile->getNumberRecords() : std::size_t{0});
+    State::write(state,spectrumCompared,spectrumAgree);
+    for(const TH1D* histogram : {&total,&delta_t,&delta_T_not_event,&delta_T_noisy}) SaveHistogram(state,*histogram);
+    for(const auto& ticks : ticks_distribution) SaveHistogram(state,ticks.second);
+    for(const auto& min : mins) SaveHistogram(state,min.second);
+    clusters.save(state);
+    timeSeries.save(state);
+    pulses.save(state);
+    peaks.save(state);
+    classifier.save(state);
+    if(scan!=nullptr) scan->save(state);
+    if(crosstalk!=nullptr) crosstalk->save(state);
+    State::write(state,noiseSpectrum!=nullptr);
+    if(noiseSpectrum!=nullptr) noiseSpectrum->save(state);
+    validation.save(state);
+    return state.str();
+  };
+  auto RestoreState=[&]()
   {
+    State::read(resumedState,spectrumCompared,spectrumAgree);
+    for(TH1D* histogram : {&total,&delta_t,&delta_T_not_event,&delta_T_noisy}) RestoreHistogram(resumedState,*histogram);
+    for(auto& ticks : ticks_distribution) RestoreHistogram(resumedState,ticks.second);
+    for(auto& min : mins) RestoreHistogram(resumedState,min.second);
+    clusters.restore(resumedState);
+    timeSeries.restore(resumedState);
+    pulses.restore(resumedState);
+    peaks.restore(resumedState);
+    classifier.restore(resumedState);
+    if(scan!=nullptr) scan->restore(resumedState);
+    if(crosstalk!=nullptr) crosstalk->restore(resumedState);
+    bool spectrumSaved{false};
+    State::read(resumedState,spectrumSaved);
+    if(spectrumSaved!=(noiseSpectrum!=nullptr)) throw std::runtime_error(fmt::format("Checkpoint of {} made with another noise spectrum, run without --resume !",folder));
+    if(noiseSpectrum!=nullptr) noiseSpectrum->restore(resumedState);
+    validation.restore(resumedState);
+  };
+  const Long64_t firstRead{firstEvent-(previousEvent ? 1 : 0)};
+  for(Long64_t evt = firstRead; evt < NbrEventsRun; ++evt)
+  {
+    const bool previous{evt<firstEvent};
+    if(MemoryBudget>0 && (evt-firstEvent)%1000==0 && getResidentMemory()>MemoryBytes && Run->getCacheSize()>(1<<20))
+    {
+      Run->setCacheSize(Run->getCacheSize()/2);
+      fmt::print(fg(fmt::color::orange),"Resident memory above the budget of {} MB, read cache reduced to {} MB\n",MemoryBudget,Run->getCacheSize()/(1024*1024));
+    }
+    if(!firstProcessed && evt>firstEvent)
+    {
+      firstProcessed=true;
+      fmt::print(fg(fmt::color::green),"First event processed {:.1f} ms after the start\n",std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+    }
+    // The events before evt are done
+    if(CheckpointInterval>0 && evt>firstEvent && (evt-firstEvent)%CheckpointInterval==0)
+    {
+      Checkpoint checkpoint;
+      checkpoint.Done=evt;
+      checkpoint.Events=NbrEventsPlanned;
+      checkpoint.NoisyLast=efficiency.isNoisyLast();
+      checkpoint.Options=Options;
+      checkpoint.Summary=Summarise(evt,efficiency,clusters,pulses,classifier);
+      checkpoint.State=SaveState();
+      checkpoint.write(checkpointFile);
+    }
 
 
     std::map<int,std::pair<float,float>> MinMaxChamber;
@@ -661,7 +1202,9 @@ int main(int argc, char** argv)
       MinMaxChamber[i]=std::pair<float,float>(std::numeric_limits<float>::max(),std::numeric_limits<float>::min());
     }
 
-    for(std::map<int,EventViewer>::iterator it= eventViewers.begin(); it!=eventViewers.end();++it)
+    // Event displays of the first PlotEvents events only
+    const bool display{!previous && (PlotEvents<0 || evt<firstEvent+PlotEvents)};
+    for(std::map<int,EventViewer>::iterator it= eventViewers.begin(); it!=eventViewers.end() && display;++it)
     {
       it->second.reset();
       it->second.setPaveLabel(fmt::format("Event {}",evt));
@@ -669,49 +1212,195 @@ int main(int argc, char** argv)
 
     BoxedText(fg(fmt::color::orange) | fmt::emphasis::bold,fmt::format("Event {}",evt));
 
+    stageClock.restart();
     event->clear();
-    Run->GetEntry(evt);
+    if(!Run->next(*event))
+    {
+      // Not enough coincidences between the boards to reach the number of events asked
+      NbrEventsRun=std::max(evt,firstEvent);
+      break;
+    }
+    ++profiledEvents;
+    stageClock.lap(StageRead);
+
+    if(evt==firstRead && !event->Channels.empty())
+    {
+      // Channels which are not decoded are empty, take the length of the first one read
+      std::size_t recordLength{0};
+      for(std::size_t ch = 0; ch != event->Channels.size() && recordLength==0; ++ch) recordLength=std::max(event->Channels[ch].Data.size(),event->Channels[ch].Codes.size());
+      kernels=Kernels::Dispatcher::select(recordLength);
+      // Same length as the warm-up : the learnt delays and their histograms are kept
+      if(recordLength!=0) windows.setLength(recordLength);
+      // Cluster times are the ticks of the peaks
+      if(recordLength!=0) clusters.setRecordLength(recordLength);
+      if(kernels.isSpecialised()) fmt::print("Using the waveform kernels specialised for {} samples\n",kernels.getRecordLength());
+      else fmt::print("No waveform kernels specialised for {} samples, using the generic ones\n",recordLength);
+      if(SpectrumMode!="none" && noiseSpectrum==nullptr)
+      {
+        // Longest power of two inside the noise window (or the record)
+        const std::size_t size{FFT::floorPowerOfTwo(SpectrumMode=="noise" ? static_cast<std::size_t>(std::max(0.,std::floor(NoiseWindow.second)-spectrumBegin+1)) : recordLength)};
+        if(size==0) fmt::print(fg(fmt::color::orange),"Less than 4 samples for the noise spectrum, disabled\n");
+        else
+        {
+          noiseSpectrum=std::make_unique<NoiseSpectrum>(analysedChannels.size(),size,SpectrumThreads);
+          if(stageClock.isEnabled()) noiseSpectrum->setProfile(&profile,StageSpectrum,1);
+          fmt::print("Noise spectrum on {} samples ({} threads)\n",size,SpectrumThreads);
+        }
+      }
+    }
+    // Accumulators of the events before the checkpoint (the noise spectrum is made above)
+    if(evt==firstEvent && resumed.Done!=0) RestoreState();
 
     //std::vector<TH1F> Plots(event->Channels.size());
     float min{std::numeric_limits<float>::max()};
     float max{std::numeric_limits<float>::min()};
+    efficiency.beginEvent();
     // First loop on triggers
+    toFilter.clear();
+    toFilterChannels.clear();
+    EventViewer::setPeriod(event->Period_ns);
+    // Triggers first : an event with an invalid trigger for one of the analysed channels is skipped before any work
+    bool validTriggers{true};
+    for(const int& ch : triggers)
+    {
+      if(ch >= static_cast<int>(event->Channels.size())) continue;
+      //ToVolt(event->Channels[ch]); //CHANGE THIS
+      kernels.baseline(event->Channels[ch].Data.data(),event->Channels[ch].Data.size());
+      double max=getAbsMax(event->Channels[ch]);
+      //Normalise(event->Channels[ch],max);
+      int tick=TriggerTick(event->Channels[ch].Data.data(),event->Channels[ch].Data.size());
+      trigger_ticks[ch]=tick;
+      const bool valid{windows.setTrigger(ch,tick)};
+      if(std::find(usedTriggers.begin(),usedTriggers.end(),ch)!=usedTriggers.end()) validTriggers&=valid;
+      /*if(PlotTriggers)
+      {
+        can.Clear();
+        TH1F toto=CreateAndFillWaveform(evt, event->Channels[ch], "Waveform");
+        toto.Draw("HIST");
+        TLine event_min;
+        event_min.SetLineColor(15);
+        event_min.SetLineWidth(1);
+        event_min.SetLineStyle(2);
+        event_min.DrawLine(tick,-1.,tick,1.);
+        event_min.DrawLine(0,-0.2,1024,-0.2);
+        ticks_distribution[ch].Fill(tick);
+        can.SaveAs((folder+"/Triggers"+"/Event"+std::to_string(evt)+"_Trigger"+std::to_string(ch)+".pdf").c_str(),"Q");
+      }*/
+    }
+    stageClock.lap(StageTriggers);
+    if(!validTriggers)
+    {
+      // Event before the chunk : the next one is in the corrected efficiency
+      if(previous) continue;
+      efficiency.skipEvent();
+      if(scan!=nullptr) scan->skipEvent();
+      continue;
+    }
+    // With the compact precision only the hits need the waveforms in mV, unless they are plotted or used by the scan,
+    // the spectrum or the crosstalk
+    const bool voltWaveforms{Precision!="compact" || display || scan!=nullptr || SpectrumMode!="none" || crosstalk!=nullptr};
     for(unsigned int ch = 0; ch != event->Channels.size(); ++ch)
     {
-      EventViewer::setPeriod(event->Period_ns);
-      if(std::find(triggers.begin(),triggers.end(),ch)!=triggers.end())
+      if(std::find(triggers.begin(),triggers.end(),ch)!=triggers.end()) continue;
+      if(!channels.hasToBeAnalysed(ch)) continue;  // Data for channel X is in file but i dont give a *** to analyse it !
+      const std::size_t row{static_cast<std::size_t>(channelIndex[ch])};
+      if(Precision!="double")
       {
-        //ToVolt(event->Channels[ch]); //CHANGE THIS
-        SupressBaseLine(event->Channels[ch]);
-        double max=getAbsMax(event->Channels[ch]);
-        //Normalise(event->Channels[ch],max);
-        int tick=GetTickTrigger(event->Channels[ch],0.20,Polarity::Negative);
-        trigger_ticks[ch]=tick;
-        /*if(PlotTriggers)
+        std::vector<std::int16_t>& channelCodes{codes[row]};
+        if(!event->Channels[ch].Codes.empty())
         {
-          can.Clear();
-          TH1F toto=CreateAndFillWaveform(evt, event->Channels[ch], "Waveform");
-          toto.Draw("HIST");
-          TLine event_min;
-          event_min.SetLineColor(15);
-          event_min.SetLineWidth(1);
-          event_min.SetLineStyle(2);
-          event_min.DrawLine(tick,-1.,tick,1.);
-          event_min.DrawLine(0,-0.2,1024,-0.2);
-          ticks_distribution[ch].Fill(tick);
-          can.SaveAs((folder+"/Triggers"+"/Event"+std::to_string(evt)+"_Trigger"+std::to_string(ch)+".pdf").c_str(),"Q");
-        }*/
+          // Raw files : the codes as decoded
+          channelCodes.swap(event->Channels[ch].Codes);
+          codeBaseline[row]=kernels.mean(channelCodes.data(),channelCodes.size());
+        }
+        else
+        {
+          // ROOT files : the samples are stored as doubles
+          channelCodes.resize(event->Channels[ch].Data.size());
+          std::int64_t sum{0};
+          if(!Kernels::toCodes(event->Channels[ch].Data.data(),channelCodes.size(),channelCodes.data(),sum)) throw std::runtime_error(fmt::format("Channel {} of event {} is not made of 12 bits ADC codes, --precision {} can't be used !",ch,evt,Precision));
+          codeBaseline[row]=static_cast<double>(sum)/channelCodes.size();
+        }
       }
+      else codes[row].clear();
+      inVolt[row]=false;
+      if(voltWaveforms) toVolt(ch);
+      profiledSamples+=std::max(event->Channels[ch].Data.size(),codes[row].size());
+      toFilter.push_back(event->Channels[ch].Data.data());
+      toFilterChannels.push_back(ch);
+    }
+
+    // Common mode of each chamber removed before the filter
+    if(commonMode.isEnabled() && !toFilterChannels.empty())
+    {
+      std::fill(commonModeData.begin(),commonModeData.end(),nullptr);
+      for(const unsigned int& ch : toFilterChannels) commonModeData[channelIndex[ch]]=event->Channels[ch].Data.data();
+      commonMode.apply(commonModeData,event->Channels[toFilterChannels[0]].Data.size());
+    }
+
+    // All the analysed channels of the event are filtered together
+    if(filter.isEnabled() && !toFilterChannels.empty()) filter.apply(toFilter,event->Channels[toFilterChannels[0]].Data.size());
+    stageClock.lap(StageConversion);
+
+    for(const unsigned int& ch : toFilterChannels)
+    {
+      if(!previous && noiseSpectrum!=nullptr && SpectrumMode=="noise") noiseSpectrum->add(channelIndex[ch],event->Channels[ch].Data.data(),event->Channels[ch].Data.size(),spectrumBegin);
+      if(!previous && crosstalk!=nullptr) crosstalk->addNoise(channelIndex[ch],event->Channels[ch].Data.data(),event->Channels[ch].Data.size(),spectrumBegin);
+      std::pair<std::pair<double,int>,std::pair<double,int>> min_max_all=getMinMax(event->Channels[ch]);
+
+      if(MinMaxChamber[channels.getChannel(ch).getOnChamber()].first>min_max_all.first.first) MinMaxChamber[channels.getChannel(ch).getOnChamber()].first = min_max_all.first.first;
+      if(MinMaxChamber[channels.getChannel(ch).getOnChamber()].second<min_max_all.second.first) MinMaxChamber[channels.getChannel(ch).getOnChamber()].second=min_max_all.second.first;
+    }
+    stageClock.lap(StageNoise);
+
+    // Features of the channels analysed below, the selections are run on all of them at once
+    for(unsigned int ch = 0; ch != event->Channels.size(); ++ch)
+    {
+      if(!channels.hasToBeAnalysed(ch)) continue;
+      const std::size_t row{static_cast<std::size_t>(channelIndex[ch])};
+      const std::pair<int,int> signalWindow{windows.getWindow(findWichTrigger(ch,triggers))};
+      const double* data{event->Channels[ch].Data.data()};
+      const std::size_t length{event->Channels[ch].Data.size()};
+      ChannelWindows& stored{channelWindows[row]};
+      const int sign{channels.getChannel(ch).getSignPolarity()};
+      const auto doubleStart=std::chrono::steady_clock::now();
+      if(Precision=="compact") stored=CodeWindows(kernels,codes[row],codeBaseline[row],NoiseWindow,NoiseWindowAfter,signalWindow);
       else
       {
-        if(!channels.hasToBeAnalysed(ch)) continue;  // Data for channel X is in file but i dont give a *** to analyse it !
-        ToVolt(event->Channels[ch]);
-        SupressBaseLine(event->Channels[ch]);
-        std::pair<std::pair<double,int>,std::pair<double,int>> min_max_all=getMinMax(event->Channels[ch]);
-
-        if(MinMaxChamber[channels.getChannel(ch).getOnChamber()].first>min_max_all.first.first) MinMaxChamber[channels.getChannel(ch).getOnChamber()].first = min_max_all.first.first;
-        if(MinMaxChamber[channels.getChannel(ch).getOnChamber()].second<min_max_all.second.first) MinMaxChamber[channels.getChannel(ch).getOnChamber()].second=min_max_all.second.first;
+        stored.Noise=kernels.meanSigma(data,length,NoiseWindow.first,NoiseWindow.second);
+        stored.NoiseAfter=kernels.meanSigma(data,length,NoiseWindowAfter.first,NoiseWindowAfter.second);
+        stored.Signal=kernels.meanSigma(data,length,signalWindow.first,signalWindow.second);
+        stored.Minimum=kernels.extremum(-1,data,length,signalWindow.first,signalWindow.second);
+        stored.Maximum=kernels.extremum(+1,data,length,signalWindow.first,signalWindow.second);
       }
+      FillFeatures(features,row,stored,sign,channels.getChannel(ch).getOnChamber(),channels.getChannel(ch).getNumber());
+      if(Precision!="validate") continue;
+      const auto compactStart=std::chrono::steady_clock::now();
+      const ChannelWindows compact{CodeWindows(kernels,codes[row],codeBaseline[row],NoiseWindow,NoiseWindowAfter,signalWindow)};
+      compactSeconds+=std::chrono::duration<double>(std::chrono::steady_clock::now()-compactStart).count();
+      doubleSeconds+=std::chrono::duration<double>(compactStart-doubleStart).count();
+      FillFeatures(codeFeatures,row,compact,sign,channels.getChannel(ch).getOnChamber(),channels.getChannel(ch).getNumber());
+    }
+    selections.evaluate(featureColumns,analysedChannels.size(),hitSelected.data(),noisySelected.data());
+    if(Precision=="validate" && !previous)
+    {
+      selections.evaluate(codeFeatureColumns,analysedChannels.size(),codeHitSelected.data(),codeNoisySelected.data());
+      for(unsigned int ch = 0; ch != event->Channels.size(); ++ch)
+      {
+        if(!channels.hasToBeAnalysed(ch)) continue;
+        const std::size_t row{static_cast<std::size_t>(channelIndex[ch])};
+        validation.addChannel(channels.getChannel(ch).getOnChamber(),{hitSelected[row]!=0,noisySelected[row]!=0,features[FeatureAmp][row],features[FeatureNoiseSigma][row]},{codeHitSelected[row]!=0,codeNoisySelected[row]!=0,codeFeatures[FeatureAmp][row],codeFeatures[FeatureNoiseSigma][row]});
+      }
+      validation.endEvent();
+    }
+    stageClock.lap(StageFeatures);
+    if(previous)
+    {
+      // Nothing counted, only whether the first event of the chunk follows a noisy one
+      bool noisy{false};
+      for(unsigned int ch = 0; ch != event->Channels.size(); ++ch) noisy|=channels.hasToBeAnalysed(ch) && noisySelected[channelIndex[ch]]!=0;
+      efficiency.restore(RunSummary(NumberChambers),noisy);
+      continue;
     }
 
     double delta_t_last{0};
@@ -720,7 +1409,7 @@ int main(int argc, char** argv)
     {
       if(!channels.hasToBeAnalysed(ch)) continue;  // Data for channel X is in file but i dont give a *** to analyse it !
       //ToVolt(event->Channels[ch]);
-      eventViewers[channels.getChannel(ch).getOnChamber()].cdNext();
+      if(display) eventViewers[channels.getChannel(ch).getOnChamber()].cdNext();
 
 
       if(ch==0)
@@ -738,52 +1427,80 @@ int main(int argc, char** argv)
       int realChannel=channels.getChannelByNumber(channels.getChannel(ch).getNumber()).getID();
 
       std::cout<<"************"<<ch<<"  "<<realChannel<<"***********";
-      eventViewers[channels.getChannel(ch).getOnChamber()].createWaveForm(channels,event->Channels[ch]);
       double RangeUsermin{MinMaxChamber[channels.getChannel(ch).getOnChamber()].first*1.05};
       double RangeUsermax{MinMaxChamber[channels.getChannel(ch).getOnChamber()].second*1.05};
-      eventViewers[channels.getChannel(ch).getOnChamber()].getPlot(realChannel).GetYaxis()->SetRangeUser(RangeUsermin,RangeUsermax);
-      eventViewers[channels.getChannel(ch).getOnChamber()].getPlot(realChannel).Draw("HIST");
-
-      ///BAD PLEASE FIX THIS !!!
-      std::pair<int,int> SignalWindow2;
-      SignalWindow2.first=trigger_ticks[findWichTrigger(ch,triggers)]-SignalWindow.second-SignalWindow.first/2;
-      SignalWindow2.second=trigger_ticks[findWichTrigger(ch,triggers)]-SignalWindow.second+SignalWindow.first/2;
-      std::pair<std::pair<double, double>, std::pair<double, double>> meanstd  = MeanSTD(event->Channels[ch], SignalWindow2, NoiseWindow);
-      std::pair<std::pair<double, double>, std::pair<double, double>> meanstdAfter  = MeanSTD(event->Channels[ch], SignalWindow2, NoiseWindowAfter);
-
-      if(meanstdAfter.first.second*1.0/meanstd.first.second >= NbrSigmaNoise)
+      if(display)
       {
-        event_skip1=evt;
-        event_skip2=evt+1;
+        eventViewers[channels.getChannel(ch).getOnChamber()].createWaveForm(channels.getChannelByNumber(event->Channels[ch].Group*8+event->Channels[ch].Number).getID(),event->Channels[ch]);
+        eventViewers[channels.getChannel(ch).getOnChamber()].getPlot(realChannel).GetYaxis()->SetRangeUser(RangeUsermin,RangeUsermax);
+        eventViewers[channels.getChannel(ch).getOnChamber()].getPlot(realChannel).Draw("HIST");
       }
 
-      std::pair<std::pair<double,int>,std::pair<double,int>> min_max_all=getMinMax(event->Channels[ch]);
+      // Window of the trigger group (delay given by --signal or learnt on the warm-up pass)
+      const std::pair<int,int> SignalWindow2{windows.getWindow(findWichTrigger(ch,triggers))};
+      const double* data{event->Channels[ch].Data.data()};
+      std::size_t length{event->Channels[ch].Data.size()};
+      const std::size_t row{static_cast<std::size_t>(channelIndex[ch])};
+      const ChannelWindows& stored{channelWindows[row]};
+      std::pair<std::pair<double, double>, std::pair<double, double>> meanstd{stored.Noise,stored.Signal};
+      std::pair<std::pair<double, double>, std::pair<double, double>> meanstdAfter{stored.NoiseAfter,stored.Signal};
+
+      if(noisySelected[row]) efficiency.setNoisy(channels.getChannel(ch).getOnChamber());
+
+      std::pair<std::pair<double,int>,std::pair<double,int>> min_max_all;
+      if(inVolt[row]) min_max_all=getMinMax(event->Channels[ch]);
+      // Waveform still in codes (compact, nothing displayed) : only the tick of the minimum is used, the same as in mV
+      else min_max_all.first.second=kernels.extremum(-1,codes[row].data(),codes[row].size()).second;
       mins[ch].Fill(trigger_ticks[findWichTrigger(ch,triggers)]-min_max_all.first.second);
       total.Fill(trigger_ticks[findWichTrigger(ch,triggers)]-min_max_all.first.second);
 
-      std::pair<std::pair<double,int>,std::pair<double,int>> min_max=getMinMax(event->Channels[ch],SignalWindow2.first,SignalWindow2.second);
+      std::pair<std::pair<double,int>,std::pair<double,int>> min_max{stored.Minimum,stored.Maximum};
       // std::cout<<"Event "<<evt<<" Channel "<<ch<<"/n";
       // std::cout<<" Mean : "<<meanstd.first<<" STD :
       // "<<meanstd.second<<std::endl;
       // selected with be updated each time we make some selection... For now
       // it's the same as Waveform one but in Red !!!
       // TH1D selected = CreateSelectionPlot(waveform);
-      float value;
-      if(channels.getChannel(ch).getSignPolarity()==-1) value = min_max.first.first;
-      else value = min_max.second.first;
+      hasseensomething = hitSelected[row]!=0;
+      ClassifyChannel(classifier,features,row);
+      if(scan!=nullptr) scan->addChannel(channels.getChannel(ch).getOnChamber(),data,length,channels.getChannel(ch).getSignPolarity(),trigger_ticks[findWichTrigger(ch,triggers)]);
 
-      if(std::fabs(value-meanstd.second.first) > NbrSigma * meanstd.first.second) hasseensomething = true;
-      else hasseensomething = false;
 
-
-      eventViewers[channels.getChannel(ch).getOnChamber()].UnderlineSignalRegion(realChannel,hasseensomething ? 8 : 46,SignalWindow2.first,SignalWindow2.second);
+      if(display) eventViewers[channels.getChannel(ch).getOnChamber()].UnderlineSignalRegion(realChannel,hasseensomething ? 8 : 46,SignalWindow2.first,SignalWindow2.second);
       CenterXText(hasseensomething ? fg(fmt::color::green) : fg(fmt::color::red) | fmt::emphasis::bold,fmt::format("Mean signal region : {:05.4f}+-{:05.4f} min = {:05.4f}, Mean noise region : {:05.4f}+-{:05.4f}, Selection criteria {:05.4f} sigmas ({:05.4f}), Condition to fullfill {:05.4f}>{:05.4f}",meanstd.second.first,meanstd.second.second,min_max.first.first,meanstd.first.first,meanstd.first.second,NbrSigma,NbrSigma * meanstd.first.second,(min_max.first.first-meanstd.first.first)*channels.getChannel(ch).getSignPolarity(),NbrSigma * meanstd.first.second));
       if(hasseensomething == true)
       {
-        goods[channels.getChannel(ch).getOnChamber()] =true;
-        Multiplicity[channels.getChannel(ch).getOnChamber()]++;
+        efficiency.addHit(channels.getChannel(ch).getOnChamber());
+        const int peak{channels.getChannel(ch).getSignPolarity()==-1 ? min_max.first.second : min_max.second.second};
+        if(crosstalk!=nullptr) crosstalk->addHit(channelIndex[ch]);
+        toVolt(ch);
+        data=event->Channels[ch].Data.data();
+        length=event->Channels[ch].Data.size();
+        AnalyseHit(clusters,pulses,classifier,channels.getChannel(ch).getOnChamber(),channels.getChannel(ch).getNumber(),data,length,channels.getChannel(ch).getSignPolarity(),peak,meanstd.first.first,event->Period_ns);
+        if(FindPeaks || PeakCompare)
+        {
+          const auto peakStart=std::chrono::steady_clock::now();
+          const PeakTrain& train{peaks.find(channels.getChannel(ch).getOnChamber(),channels.getChannel(ch).getNumber(),data,length,SignalWindow2.first,SignalWindow2.second,channels.getChannel(ch).getSignPolarity(),meanstd.first.first,NbrSigma*meanstd.first.second)};
+          const auto peakEnd=std::chrono::steady_clock::now();
+          peakSeconds+=std::chrono::duration<double>(peakEnd-peakStart).count();
+          const int size{SignalWindow2.second-SignalWindow2.first};
+          if(PeakCompare && size>0)
+          {
+            // TSpectrum threshold is a percentage of the highest peak
+            spectrumSource.resize(size);
+            spectrumDestination.resize(size);
+            for(int i = 0; i != size; ++i) spectrumSource[i]=channels.getChannel(ch).getSignPolarity()*(data[SignalWindow2.first+i]-meanstd.first.first);
+            const double highest{*std::max_element(spectrumSource.begin(),spectrumSource.end())};
+            const double percent{std::min(100.,std::max(1.,100.*NbrSigma*meanstd.first.second/highest))};
+            const int found{spectrum.SearchHighRes(spectrumSource.data(),spectrumDestination.data(),size,2,percent,true,3,false,3)};
+            spectrumSeconds+=std::chrono::duration<double>(std::chrono::steady_clock::now()-peakEnd).count();
+            ++spectrumCompared;
+            if(static_cast<std::size_t>(found)==train.Number) ++spectrumAgree;
+          }
+        }
       }
 
+      if(!display) continue;
       TLine event_min;
       // Signal Region
       event_min.SetLineColor(30);
@@ -850,21 +1567,21 @@ int main(int argc, char** argv)
 
       event_min.Draw();
 
-      TGraph* gr = new TGraph(1);
-      gr->SetPoint(0,min_max.first.second,min_max.first.first);
+      EventViewer& viewer = eventViewers[channels.getChannel(ch).getOnChamber()];
+      TGraph* gr = &viewer.getMarker(realChannel,min_max.first.second,min_max.first.first);
       gr->SetMarkerStyle(51);
       gr->Draw("PSAME");
 
       TArrow *ar3{nullptr};
       if(!dontPlotNoiseLines)
       {
-        ar3 = new TArrow(NoiseWindow.first*event->Period_ns,meanstd.first.first,NoiseWindow.first*event->Period_ns,meanstd.first.first-NbrSigma * meanstd.first.second,0.005,"<|>");
+        ar3 = &viewer.getArrow(realChannel,0,NoiseWindow.first*event->Period_ns,meanstd.first.first,NoiseWindow.first*event->Period_ns,meanstd.first.first-NbrSigma * meanstd.first.second);
         ar3->SetAngle(40);
         ar3->SetLineWidth(2);
         ar3->Draw();
       }
 
-      TArrow *ar4 = new TArrow(SignalWindow2.first*event->Period_ns,meanstd.second.first,SignalWindow2.first*event->Period_ns,meanstd.second.first-NbrSigma * meanstd.first.second,0.005,"<|>");
+      TArrow *ar4 = &viewer.getArrow(realChannel,1,SignalWindow2.first*event->Period_ns,meanstd.second.first,SignalWindow2.first*event->Period_ns,meanstd.second.first-NbrSigma * meanstd.first.second);
       ar4->SetAngle(40);
       ar4->SetLineWidth(2);
       ar4->Draw();
@@ -881,7 +1598,7 @@ int main(int argc, char** argv)
 
       if(plotIndividualChannels)
       {
-        can2.cd();
+        can2->cd();
         eventViewers[channels.getChannel(ch).getOnChamber()].getPlot(realChannel).Draw("HIST");
         eventViewers[channels.getChannel(ch).getOnChamber()].getPlot(realChannel).GetYaxis()->SetRangeUser(min_max_all.first.first*1.05,min_max_all.second.first*1.05);
         eventViewers[channels.getChannel(ch).getOnChamber()].UnderlineSignalRegion(realChannel,hasseensomething ? 8 : 46,SignalWindow2.first,SignalWindow2.second);
@@ -922,110 +1639,308 @@ int main(int argc, char** argv)
           ar3->Draw();
         }
         std::string filename = folder+"/Events"+"/Event"+std::to_string(evt)+"chamber"+std::to_string(channels.getChannel(ch).getOnChamber())+"channel"+std::to_string(ch)+".png";
-        can2.SaveAs(filename.c_str());
+        can2->SaveAs(filename.c_str());
       }
 
     }
+    stageClock.lap(StageHits);
 
-    for(std::map<int,EventViewer>::iterator it= eventViewers.begin(); it!=eventViewers.end();++it)
+    for(std::map<int,EventViewer>::iterator it= eventViewers.begin(); it!=eventViewers.end() && display;++it)
     {
       std::string filename = folder+"/Events"+"/Event"+std::to_string(evt)+"chamber"+std::to_string(it->first)+".png";
       it->second.saveAs(filename.c_str());
     }
 
-    for(std::size_t nub =0 ;nub!=goods.size();++nub)
+    clusters.endEvent();
+    if(pulseFile!=nullptr)
     {
-      if(goods[nub] == true)
-      {
-        if(event_skip2!=evt)
-        {
-          goodStackCorrected[nub]++;
-
-        }
-        goodStack[nub]++;
-        goods[nub] = false;
-      }
-      else
+      for(std::size_t i = 0; i != pulses.getNumberPulses(); ++i)
       {
-        delta_T_not_event.Fill((delta_t_new-delta_t_last)*8.5e-9);
+        const Pulse& pulse{pulses.getPulse(i)};
+        pulseRecord={static_cast<double>(evt),static_cast<double>(pulse.Chamber),static_cast<double>(pulse.Strip),pulse.Amplitude,pulse.Charge,pulse.RiseTime,pulse.Time};
+        pulseFile->append(pulseRecord,false);
       }
     }
-
-
-    if(event_skip2!=evt)
+    pulses.endEvent();
+    peaks.endEvent(event->Period_ns);
+    classifier.endEvent();
+    if(scan!=nullptr) scan->endEvent();
+    if(crosstalk!=nullptr) crosstalk->endEvent();
+    Period=event->Period_ns;
+    // Whole records of the events without any hit
+    if(noiseSpectrum!=nullptr && SpectrumMode=="records" && !efficiency.hasHit())
     {
-      total_event++;
+      for(const unsigned int& ch : toFilterChannels) noiseSpectrum->add(channelIndex[ch],event->Channels[ch].Data.data(),event->Channels[ch].Data.size(),0);
     }
+    timeSeries.fill(event->TriggerTimeTag,efficiency.getHits(),efficiency.getNoisy());
+    for(const int& hits : efficiency.getHits())
+      if(hits==0) delta_T_not_event.Fill((delta_t_new-delta_t_last)*8.5e-9);
+    efficiency.endEvent();
     delta_t_new=delta_t_last;
     Clear();
+    stageClock.lap(StageEndEvent);
   }
   for(std::map<int,TH1D>::iterator it= ticks_distribution.begin();it!= ticks_distribution.end();++it)
   {
-    can2.Clear();
+    can2->Clear();
     it->second.Draw();
-    can2.SaveAs((folder+"/Others"+"/Tick_Distribution_"+std::to_string(it->first)+".pdf").c_str(),"Q");
+    can2->SaveAs((folder+"/Others"+"/Tick_Distribution_"+std::to_string(it->first)+".pdf").c_str(),"Q");
   }
   for(auto min : mins)
   {
-    can2.Clear();
+    can2->Clear();
     min.second.GetXaxis()->SetNdivisions(510);
     min.second.Draw();
-    can2.SaveAs((folder+"/Others"+"/minimum_position_distribution"+std::to_string(min.first)+".pdf").c_str(),"Q");
+    can2->SaveAs((folder+"/Others"+"/minimum_position_distribution"+std::to_string(min.first)+".pdf").c_str(),"Q");
   }
-  can2.Clear();
+  can2->Clear();
   total.GetXaxis()->SetNdivisions(510);
   total.Draw();
-  can2.SaveAs((folder+"/Others"+"/minimum_position_distribution_total.pdf").c_str(),"Q");
+  can2->SaveAs((folder+"/Others"+"/minimum_position_distribution_total.pdf").c_str(),"Q");
 
-  can2.Clear();
+  timeSeries.write(folder+"/TimeSeries.csv");
+  for(std::size_t chamber = 0; chamber != timeSeries.getNumberChambers(); ++chamber)
+  {
+    std::vector<double> times, efficiencies, errorTimes, errorEfficiencies;
+    for(std::size_t bin = 0; bin != timeSeries.getNumberBins(); ++bin)
+    {
+      if(timeSeries.getEvents(bin)==0) continue;
+      const double efficiency{timeSeries.getEfficient(bin,chamber)*1.0/timeSeries.getEvents(bin)};
+      times.push_back((bin+0.5)*timeSeries.getBinWidth());
+      errorTimes.push_back(timeSeries.getBinWidth()/2);
+      efficiencies.push_back(efficiency);
+      errorEfficiencies.push_back(std::sqrt(efficiency*(1-efficiency)/timeSeries.getEvents(bin)));
+    }
+    if(times.empty()) continue;
+    can2->Clear();
+    TGraphErrors efficiencyTime(times.size(),&times[0],&efficiencies[0],&errorTimes[0],&errorEfficiencies[0]);
+    efficiencyTime.SetTitle(";Time (s);Efficiency (#varepsilon)");
+    efficiencyTime.SetMarkerStyle(21);
+    efficiencyTime.GetYaxis()->SetRangeUser(0,1.);
+    efficiencyTime.Draw("AP");
+    can2->SaveAs((folder+"/Others"+"/Efficiency_vs_time_chamber"+std::to_string(chamber)+".pdf").c_str(),"Q");
+  }
+
+  pulseFile.reset();
+  classifier.flush();
+  fs::create_directories(folder+"/Pulses");
+  for(std::size_t chamber = 0; chamber != pulses.getNumberChambers(); ++chamber)
+  {
+    for(const Histogram* histogram : {&pulses.getCharge(chamber),&pulses.getAmplitude(chamber),&pulses.getRiseTime(chamber)})
+    {
+      can2->Clear();
+      TH1D th1=ToTH1D(*histogram);
+      th1.Draw("HIST");
+      can2->SaveAs((folder+"/Pulses/"+histogram->getName()+".pdf").c_str(),"Q");
+    }
+  }
+
+  if(FindPeaks || PeakCompare)
+  {
+    fs::create_directories(folder+"/Peaks");
+    for(std::size_t chamber = 0; chamber != peaks.getNumberChambers(); ++chamber)
+    {
+      fmt::print("Chamber {} : {} hits with several peaks in the signal window ({:.2f}%)\n",chamber,peaks.getPileUp(chamber),peaks.getPeaks(chamber).getEntries()==0 ? 0. : 100.*peaks.getPileUp(chamber)/peaks.getPeaks(chamber).getEntries());
+      for(const Histogram* histogram : {&peaks.getPeaks(chamber),&peaks.getInterPeakTime(chamber)})
+      {
+        can2->Clear();
+        TH1D th1=ToTH1D(*histogram);
+        th1.Draw("HIST");
+        can2->SaveAs((folder+"/Peaks/"+histogram->getName()+".pdf").c_str(),"Q");
+      }
+    }
+    if(spectrumCompared!=0) fmt::print("Peak finder {:.3f} ms, TSpectrum {:.3f} ms on {} hits, same number of peaks for {:.1f}% of them\n",peakSeconds*1e3,spectrumSeconds*1e3,spectrumCompared,100.*spectrumAgree/spectrumCompared);
+  }
+
+  fs::create_directories(folder+"/Clusters");
+  for(std::size_t chamber = 0; chamber != clusters.getNumberChambers(); ++chamber)
+  {
+    for(const Histogram* histogram : {&clusters.getClusterSize(chamber),&clusters.getClusterNumber(chamber),&clusters.getClusterTime(chamber),&clusters.getStripHits(chamber)})
+    {
+      can2->Clear();
+      TH1D th1=ToTH1D(*histogram);
+      th1.Draw("HIST");
+      can2->SaveAs((folder+"/Clusters/"+histogram->getName()+".pdf").c_str(),"Q");
+    }
+  }
+
+  can2->Clear();
   delta_t.GetXaxis()->SetNdivisions(510);
   delta_t.Draw();
-  can2.SaveAs((folder+"/DeltaT.pdf").c_str(),"Q");
+  can2->SaveAs((folder+"/DeltaT.pdf").c_str(),"Q");
 
-  can2.Clear();
+  can2->Clear();
   delta_T_not_event.GetXaxis()->SetNdivisions(510);
   delta_T_not_event.Draw();
-  can2.SaveAs((folder+"/delta_T_not_event.pdf").c_str(),"Q");
+  can2->SaveAs((folder+"/delta_T_not_event.pdf").c_str(),"Q");
 
-  can2.Clear();
+  can2->Clear();
   delta_T_noisy.GetXaxis()->SetNdivisions(510);
   delta_T_noisy.Draw();
-  can2.SaveAs((folder+"/delta_T_noisy.pdf").c_str(),"Q");
+  can2->SaveAs((folder+"/delta_T_noisy.pdf").c_str(),"Q");
 
 
+  if(LearnWindow>0)
+  {
+    fs::create_directories(folder+"/Windows");
+    for(const int& trigger : triggers)
+    {
+      can2->Clear();
+      TH1D th1=ToTH1D(windows.getDelays(trigger));
+      th1.Draw("HIST");
+      can2->SaveAs((folder+"/Windows/"+windows.getDelays(trigger).getName()+".pdf").c_str(),"Q");
+    }
+  }
+
+  const RunSummary summary{Summarise(NbrEventsRun,efficiency,clusters,pulses,classifier)};
+  if(summary.Invalid!=0) fmt::print(fg(fmt::color::orange),"{} events skipped (no trigger found or signal window outside of the record)\n",summary.Invalid);
+  // Events with an invalid trigger were not analysed, they don't count in the efficiency
+  const Long64_t validEvents{summary.Events-summary.Invalid};
   for(std::size_t chamber = 0; chamber != NumberChambers ; ++chamber)
   {
-    float efficiency=goodStack[chamber] * 1.00 / (NbrEvents * scalefactor);
-    float efficiency_corrected=goodStackCorrected[chamber] * 1.00 / (total_event * scalefactor);
-    std::cout << "Chamber efficiency " << efficiency << " +-" <<std::sqrt(efficiency*(1-efficiency)/NbrEvents)<<" with signal "<<goodStack[chamber]<<" total event "<< NbrEvents<<" Multiplicity"<< Multiplicity[chamber]/goodStack[chamber]<< std::endl;
-    std::cout << "Chamber efficiency corrected " << efficiency_corrected << " +-" <<std::sqrt(efficiency_corrected*(1-efficiency_corrected)/total_event)<<" with signal "<<goodStackCorrected[chamber]<<" total event "<< total_event <<std::endl;
-
-    std::cout<< "Number event analysed " << total_event*100.0/NbrEvents <<std::endl;
-
-    std::vector<float> line;
-    std::string value;
-    std::size_t found = files[file].find("V.root");
-    std::string HV = files[file].substr(0,found);
-    line.push_back(std::stof(HV));
-    line.push_back(efficiency);
-    line.push_back(std::sqrt(efficiency*(1-efficiency)/NbrEvents));
-    line.push_back(efficiency_corrected);
-    line.push_back(std::sqrt(efficiency_corrected*(1-efficiency_corrected)/total_event));
-    line.push_back(Multiplicity[chamber]/goodStack[chamber]);
-
-    documents[chamber].SetRow(Indexes[chamber],line);
-    Indexes[chamber]++;
+    const RunSummary::Chamber& counters = summary.Chambers[chamber];
+    const std::vector<double> record{summary.getRecord(chamber,RunHV(task.Files[0]),scalefactor)};
+    std::cout << "Chamber efficiency " << record[1] << " +-" << record[2] <<" with signal "<<counters.Efficient<<" total event "<< validEvents<<" Multiplicity"<< record[5]<< std::endl;
+    std::cout << "Chamber efficiency corrected " << record[3] << " +-" << record[4] <<" with signal "<<counters.EfficientCorrected<<" total event "<< summary.Corrected <<std::endl;
+
+    std::cout<< "Number event analysed " << summary.Corrected*100.0/summary.Events <<std::endl;
+
+    fmt::print("Chamber {} : {} empty, {} avalanche, {} streamer, {} noise burst ({} model)\n",chamber,counters.Classes[static_cast<std::size_t>(EventClass::Empty)],counters.Classes[static_cast<std::size_t>(EventClass::Avalanche)],counters.Classes[static_cast<std::size_t>(EventClass::Streamer)],counters.Classes[static_cast<std::size_t>(EventClass::NoiseBurst)],classifier.isLinear() ? "linear" : "cut");
+
+    if(worker==nullptr) documents[chamber]->append(record);
+  }
+  if(worker!=nullptr) worker->send(task,summary.serialize());
+  if(noiseSpectrum!=nullptr)
+  {
+    noiseSpectrum->finish();
+    fs::create_directories(folder+"/Spectrum");
+    std::vector<std::string> columns{"Frequency (MHz)"};
+    for(const int& ch : analysedChannels) columns.push_back(fmt::format("Channel {}",channels.getChannel(ch).getNumber()));
+    {
+      ResultsWriter spectrumFile(folder+"/Spectrum/Spectrum.res",columns);
+      std::vector<double> record(columns.size());
+      for(std::size_t bin = 0; bin != noiseSpectrum->getNumberBins(); ++bin)
+      {
+        record[0]=noiseSpectrum->getFrequency(bin,Period)*1e-6;
+        for(std::size_t channel = 0; channel != analysedChannels.size(); ++channel) record[channel+1]=noiseSpectrum->getDensity(channel,bin,Period);
+        spectrumFile.append(record,false);
+      }
+    }
+    ResultsReader(folder+"/Spectrum/Spectrum.res").exportCSV(folder+"/Spectrum/Spectrum.csv");
+    std::vector<double> frequencies(noiseSpectrum->getNumberBins());
+    std::vector<double> densities(noiseSpectrum->getNumberBins());
+    for(std::size_t channel = 0; channel != analysedChannels.size(); ++channel)
+    {
+      if(noiseSpectrum->getSegments(channel)==0) continue;
+      for(std::size_t bin = 0; bin != noiseSpectrum->getNumberBins(); ++bin)
+      {
+        frequencies[bin]=noiseSpectrum->getFrequency(bin,Period)*1e-6;
+        densities[bin]=noiseSpectrum->getDensity(channel,bin,Period);
+      }
+      can2->Clear();
+      can2->SetLogy(true);
+      TGraph density(frequencies.size()-1,&frequencies[1],&densities[1]);
+      density.SetTitle(fmt::format("Noise spectrum channel {} ({} segments);Frequency (MHz);PSD (mV^{{2}}/Hz)",channels.getChannel(analysedChannels[channel]).getNumber(),noiseSpectrum->getSegments(channel)).c_str());
+      density.Draw("AL");
+      can2->SaveAs((folder+"/Spectrum/Spectrum_channel"+std::to_string(channels.getChannel(analysedChannels[channel]).getNumber())+".pdf").c_str(),"Q");
+      can2->SetLogy(false);
+    }
+  }
+  if(scan!=nullptr)
+  {
+    {
+      ResultsWriter scanFile(folder+"/Scan.res",Scan::getColumns());
+      for(const std::vector<double>& record : scan->getRecords(RunHV(task.Files[0]),scalefactor,Period)) scanFile.append(record,false);
+    }
+    ResultsReader(folder+"/Scan.res").exportCSV(folder+"/Scan.csv");
+    fmt::print("Efficiency scan of {} events ({} thresholds x {} windows x {} noise thresholds) saved in {}/Scan.csv\n",scan->getEvents(),scan->getNumberSigmas(),scan->getNumberWindows(),scan->getNumberNoiseRatios(),folder);
   }
+  if(crosstalk!=nullptr)
+  {
+    crosstalk->finish();
+    fs::create_directories(folder+"/Crosstalk");
+    {
+      ResultsWriter crosstalkFile(folder+"/Crosstalk/Crosstalk.res",std::vector<std::string>{"Channel i","Channel j","Covariance","Correlation","Hits i","Coincidences","P(j|i)"});
+      std::vector<double> record(7);
+      for(std::size_t i = 0; i != analysedChannels.size(); ++i)
+      {
+        for(std::size_t j = 0; j != analysedChannels.size(); ++j)
+        {
+          record={static_cast<double>(channels.getChannel(analysedChannels[i]).getNumber()),static_cast<double>(channels.getChannel(analysedChannels[j]).getNumber()),crosstalk->getCovariance(i,j),crosstalk->getCorrelation(i,j),static_cast<double>(crosstalk->getHits(i)),static_cast<double>(crosstalk->getCoincidences(i,j)),crosstalk->getConditional(j,i)};
+          crosstalkFile.append(record,false);
+        }
+      }
+    }
+    ResultsReader(folder+"/Crosstalk/Crosstalk.res").exportCSV(folder+"/Crosstalk/Crosstalk.csv");
+    const int nbrChannels{static_cast<int>(analysedChannels.size())};
+    TH2F correlation("Correlation","Noise correlation (analysed channel index);Channel i;Channel j",nbrChannels,0,nbrChannels,nbrChannels,0,nbrChannels);
+    TH2F conditional("Conditional","Probability of a hit on j when i is hit (analysed channel index);Channel i;Channel j",nbrChannels,0,nbrChannels,nbrChannels,0,nbrChannels);
+    for(int i = 0; i != nbrChannels; ++i)
+    {
+      for(int j = 0; j != nbrChannels; ++j)
+      {
+        correlation.SetBinContent(i+1,j+1,crosstalk->getCorrelation(i,j));
+        conditional.SetBinContent(i+1,j+1,crosstalk->getConditional(j,i));
+      }
+    }
+    can2->Clear();
+    correlation.Draw("COLZ");
+    can2->SaveAs((folder+"/Crosstalk/Correlation.pdf").c_str(),"Q");
+    can2->Clear();
+    conditional.Draw("COLZ");
+    can2->SaveAs((folder+"/Crosstalk/Conditional.pdf").c_str(),"Q");
+    fmt::print("Crosstalk matrices of {} channels from {} events ({} with the noise of all the channels) saved in {}/Crosstalk/\n",nbrChannels,crosstalk->getEvents(),crosstalk->getNoiseEvents(),folder);
+  }
+  if(Precision=="validate")
+  {
+    fs::create_directories(folder+"/Precision");
+    {
+      ResultsWriter precisionFile(folder+"/Precision/Precision.res",std::vector<std::string>{"Chamber","Channels","Hits lost","Hits gained","Noisy lost","Noisy gained","Efficiency double","Efficiency compact","Noisy events double","Noisy events compact","Max amplitude difference","Max sigma difference","Amplitude bins changed","Sigma bins changed","Multiplicity bins changed"});
+      for(std::size_t chamber = 0; chamber != validation.getNumberChambers(); ++chamber)
+      {
+        const PrecisionValidation::Chamber& counts{validation.getChamber(chamber)};
+        if(counts.Channels==0) continue;
+        precisionFile.append({static_cast<double>(chamber),static_cast<double>(counts.Channels),static_cast<double>(counts.HitLost),static_cast<double>(counts.HitGained),static_cast<double>(counts.NoisyLost),static_cast<double>(counts.NoisyGained),validation.getEfficiency(chamber,PrecisionValidation::Double),validation.getEfficiency(chamber,PrecisionValidation::Compact),static_cast<double>(counts.Noisy[PrecisionValidation::Double]),static_cast<double>(counts.Noisy[PrecisionValidation::Compact]),counts.MaxAmplitudeDifference,counts.MaxSigmaDifference,static_cast<double>(PrecisionValidation::countDifferences(counts.Amplitude[0],counts.Amplitude[1])),static_cast<double>(PrecisionValidation::countDifferences(counts.Sigma[0],counts.Sigma[1])),static_cast<double>(PrecisionValidation::countDifferences(counts.Multiplicity[0],counts.Multiplicity[1]))},false);
+        fmt::print("Chamber {} : efficiency {:.4f}% (double) {:.4f}% (compact), {} hits lost, {} gained, {} noisy lost, {} gained, amplitudes within {:.2e} mV\n",chamber,100.*validation.getEfficiency(chamber,PrecisionValidation::Double),100.*validation.getEfficiency(chamber,PrecisionValidation::Compact),counts.HitLost,counts.HitGained,counts.NoisyLost,counts.NoisyGained,counts.MaxAmplitudeDifference);
+        // Compact path in red over the double one
+        for(const std::array<Histogram,2>* histograms : {&counts.Amplitude,&counts.Sigma,&counts.Multiplicity})
+        {
+          can2->Clear();
+          TH1D reference=ToTH1D((*histograms)[PrecisionValidation::Double]);
+          TH1D compact=ToTH1D((*histograms)[PrecisionValidation::Compact]);
+          compact.SetLineColor(2);
+          compact.SetLineStyle(2);
+          reference.Draw("HIST");
+          compact.Draw("HIST SAME");
+          can2->SaveAs((folder+"/Precision/"+(*histograms)[PrecisionValidation::Double].getName()+".pdf").c_str(),"Q");
+        }
+      }
+    }
+    ResultsReader(folder+"/Precision/Precision.res").exportCSV(folder+"/Precision/Precision.csv");
+    fmt::print(validation.getChanges()==0 ? fg(fmt::color::green) : fg(fmt::color::orange),"{} decisions changed by the compact precision on {} events, features {:.3f} ms (double) {:.3f} ms (compact), saved in {}/Precision/\n",validation.getChanges(),validation.getEvents(),doubleSeconds*1e3,compactSeconds*1e3,folder);
+  }
+  if(stageClock.isEnabled())
+  {
+    fmt::print(fmt::emphasis::bold,"Event loop profile ({} events, {} samples analysed)\n",profiledEvents,profiledSamples);
+    fmt::print("{}",profile.report(profiledEvents,profiledSamples));
+  }
+  // The run is complete : its checkpoint keeps the summary so a job resumed doesn't make it again
+  Checkpoint finished;
+  finished.Done=NbrEventsPlanned;
+  finished.Events=NbrEventsPlanned;
+  finished.Options=Options;
+  finished.Summary=summary;
+  finished.write(checkpointFile);
   if(event != nullptr) delete event;
-  if(Run != nullptr) delete Run;
-  if(fileIn.IsOpen()) fileIn.Close();
+  fmt::print("Peak resident memory {:.1f} MB\n",getPeakResidentMemory()/(1024.*1024.));
+  if(Run->getNumberBoards()>1) fmt::print("{} events built from {} boards, {} board events dropped (no coincidence)\n",Run->getBuilt(),Run->getNumberBoards(),Run->getDropped());
+  Run.reset();
 
 
+  }
   for(std::size_t document=0; document!=documents.size();++document)
   {
-    documents[document].Save((save+"_Chamber"+std::to_string(document)+".csv").c_str());
-  }
-
+    ResultsReader(documents[document]->getFilename()).exportCSV(save+"_Chamber"+std::to_string(document)+".csv");
   }
   }
   catch(const std::exception& e)
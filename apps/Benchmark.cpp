@@ -0,0 +1,888 @@
+#include "AnalysisEngine.hpp"
+#include "CLI/CLI.hpp"
+#include "Checkpoint.hpp"
+#include "Classifier.hpp"
+#include "Clustering.hpp"
+#include "Counters.hpp"
+#include "Crosstalk.hpp"
+#include "Distributed.hpp"
+#include "Filter.hpp"
+#include "Kernels.hpp"
+#include "PeakFinder.hpp"
+#include "Precision.hpp"
+#include "RawReader.hpp"
+#include "RunSummary.hpp"
+#include "Scan.hpp"
+#include "Selection.hpp"
+#include "Spectrum.hpp"
+#include "Synthetic.hpp"
+#include "fmt/color.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Benchmarks of the waveform processing stages on synthetic events (no ROOT file needed).
+// To run the code see the help doing "./Benchmark -h"
+
+namespace
+{
+template<typename Function> double Time(const Function& function)
+{
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Report(const std::string& name, const double& seconds, const std::size_t& samples, const std::size_t& events)
+{
+  fmt::print("\t{:<30} {:>10.3f} ms {:>12.3e} samples/s {:>12.3e} events/s\n", name, seconds * 1e3, samples / seconds, events / seconds);
+}
+
+void BenchmarkFilters(const Waveforms& waveforms)
+{
+  fmt::print(fmt::emphasis::bold, "Filters ({} events x {} channels x {} samples)\n", waveforms.getEvents(), waveforms.getChannels(), waveforms.getLength());
+  std::vector<std::pair<std::string, Filter>> filters{{"none", Filter()}, {"average (5)", Filter::MovingAverage(5)}, {"fir (16 taps)", Filter::FIR(std::vector<double>(16, 1.0 / 16))}, {"iir (alpha 0.3)", Filter::IIR(0.3)}};
+  std::vector<double*>                        pointers(waveforms.getChannels());
+  for(std::size_t f = 0; f != filters.size(); ++f)
+  {
+    Waveforms    copy{waveforms};
+    const double seconds = Time([&]() {
+      for(std::size_t evt = 0; evt != copy.getEvents(); ++evt)
+      {
+        for(std::size_t ch = 0; ch != copy.getChannels(); ++ch) pointers[ch] = copy.get(evt, ch);
+        filters[f].second.apply(pointers, copy.getLength());
+      }
+    });
+    Report(filters[f].first, seconds, copy.getSamples(), copy.getEvents());
+  }
+}
+
+// Same algorithm as MeanSTD in Analysis.cpp : whole record scanned with the window checked sample by sample
+std::pair<double, double> ReferenceMeanSigma(const double* data, const std::size_t& length, const double& first, const double& second)
+{
+  double mean{0};
+  double sigma{0};
+  int    used{0};
+  for(std::size_t j = 0; j != length; ++j)
+  {
+    if(j >= first && j <= second)
+    {
+      used++;
+      mean += data[j];
+    }
+  }
+  mean /= used;
+  for(std::size_t j = 0; j != length; ++j)
+  {
+    if(j >= first && j <= second) sigma += (data[j] - mean) * (data[j] - mean);
+  }
+  return {mean, std::sqrt(sigma / (used - 1))};
+}
+
+std::pair<double, int> ReferenceMinimum(const double* data, const std::size_t& length, const int& begin, const int& end)
+{
+  double min{std::numeric_limits<double>::max()};
+  int    tick{0};
+  for(std::size_t j = begin; j != static_cast<std::size_t>(end) && j != length; ++j)
+  {
+    if(data[j] < min)
+    {
+      min  = data[j];
+      tick = j;
+    }
+  }
+  return {min, tick};
+}
+
+// Kernels against the reference MeanSTD/getMinMax (they only change the summation order, the sums are reported)
+void BenchmarkKernels(const Waveforms& waveforms)
+{
+  fmt::print(fmt::emphasis::bold, "Kernels (noise [0,200], signal [400,600[, minimum)\n");
+  const std::size_t length{waveforms.getLength()};
+  const int         begin{static_cast<int>(0.4 * length)};
+  const int         end{static_cast<int>(0.6 * length)};
+  const double      noiseEnd{0.2 * length};
+  double            check[3]{0, 0, 0};
+  auto              run = [&](const std::string& name, const auto& meanSigma, const auto& minimum, double& result) {
+    const double seconds = Time([&]() {
+      for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+      {
+        for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+        {
+          const double* data{waveforms.get(evt, ch)};
+          result += meanSigma(data, length, 0, noiseEnd).second + meanSigma(data, length, begin, end).first + minimum(data, length, begin, end).first;
+        }
+      }
+    });
+    Report(name, seconds, waveforms.getSamples(), waveforms.getEvents());
+  };
+  const Kernels::Dispatcher generic{Kernels::Dispatcher::generic()};
+  const Kernels::Dispatcher specialised{Kernels::Dispatcher::select(length)};
+  run("reference (MeanSTD/getMinMax)", ReferenceMeanSigma, ReferenceMinimum, check[0]);
+  run("generic kernels", [&](const double* d, const std::size_t& l, const double& f, const double& s) { return generic.meanSigma(d, l, f, s); }, [&](const double* d, const std::size_t& l, const int& b, const int& e) { return generic.extremum(-1, d, l, b, e); }, check[1]);
+  if(specialised.isSpecialised()) run(fmt::format("specialised kernels ({})", length), [&](const double* d, const std::size_t& l, const double& f, const double& s) { return specialised.meanSigma(d, l, f, s); }, [&](const double* d, const std::size_t& l, const int& b, const int& e) { return specialised.extremum(-1, d, l, b, e); }, check[2]);
+  else
+    check[2] = check[1];
+  fmt::print("\trelative difference to the reference {:.1e} (generic), {:.1e} (specialised)\n", std::fabs(check[1] - check[0]) / std::fabs(check[0]), std::fabs(check[2] - check[0]) / std::fabs(check[0]));
+}
+
+// Features from the synthetic waveforms (minimum in the signal window, sigma ratio) scored by the cut classifier
+// and by a linear model giving the same decisions
+void BenchmarkClassifier(const Waveforms& waveforms)
+{
+  fmt::print(fmt::emphasis::bold, "Classifier ({} chambers of {} strips)\n", (waveforms.getChannels() + 7) / 8, 8);
+  const std::size_t         length{waveforms.getLength()};
+  const std::size_t         chambers{(waveforms.getChannels() + 7) / 8};
+  const Kernels::Dispatcher kernels{Kernels::Dispatcher::select(length)};
+  const int                 begin{static_cast<int>(0.3 * length)};
+  const int                 end{static_cast<int>(0.8 * length)};
+  // amplitude, ratio by event and channel (computed once so only the classifier is timed)
+  std::vector<std::pair<double, double>> features(waveforms.getEvents() * waveforms.getChannels());
+  for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+  {
+    for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+    {
+      const double*                   data{waveforms.get(evt, ch)};
+      const std::pair<double, double> noise{kernels.meanSigma(data, length, 0, 0.2 * length)};
+      const std::pair<double, double> after{kernels.meanSigma(data, length, 0.9 * length, length - 1)};
+      features[evt * waveforms.getChannels() + ch] = {noise.first - kernels.extremum(-1, data, length, begin, end).first, after.second / noise.second};
+    }
+  }
+  const std::string model{(std::filesystem::temp_directory_path() / "Classifier_benchmark.txt").string()};
+  {
+    // Amplitude is used in place of the charge : a streamer is a hit above 40 mV
+    std::ofstream file(model);
+    file << "# class w_hits w_amplitude w_charge w_ratio w_spread bias\n";
+    file << "empty 0 0 0 0 0 0\n";
+    file << "avalanche 1000 0 0 0 0 -500\n";
+    file << "streamer 1000 0 50 0 0 -2500\n";
+    file << "noise 0 0 0 1e6 0 -5e6\n";
+  }
+  for(std::size_t m = 0; m != 2; ++m)
+  {
+    Classifier classifier(chambers, 5.0, 40.0);
+    if(m == 1) classifier.load(model);
+    const double seconds = Time([&]() {
+      for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+      {
+        for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+        {
+          const std::pair<double, double>& feature{features[evt * waveforms.getChannels() + ch]};
+          classifier.addChannel(ch / 8, feature.first, feature.second);
+          if(feature.first > 10.0) classifier.addHit(ch / 8, feature.first, 0);
+        }
+        classifier.endEvent();
+      }
+      classifier.flush();
+    });
+    Report(m == 0 ? "cut classifier" : "linear classifier", seconds, waveforms.getSamples(), waveforms.getEvents());
+  }
+  std::remove(model.c_str());
+}
+
+// Coordinator and workers in the same process over real sockets, one worker disconnects while holding a task
+void BenchmarkDistributed(const std::size_t& nbrTasks, const std::size_t& nbrWorkers)
+{
+  fmt::print(fmt::emphasis::bold, "Distributed ({} tasks, {} workers, one failing)\n", nbrTasks, nbrWorkers);
+  Coordinator coordinator(0, 0, 10);
+  for(std::size_t i = 0; i != nbrTasks; ++i)
+  {
+    Task task;
+    task.Run    = i % 3;
+    task.First  = 1000 * i;
+    task.Events = 1000;
+    task.Files  = {fmt::format("{}V.root", 7000 + 100 * task.Run)};
+    coordinator.addTask(task);
+  }
+  auto work = [&](const bool& failing) {
+    Worker worker("127.0.0.1", coordinator.getPort());
+    Task   task;
+    while(worker.next(task))
+    {
+      // Disconnect without answering
+      if(failing) return;
+      RunSummary summary(2);
+      summary.Events    = task.Events;
+      summary.Corrected = task.Events;
+      for(RunSummary::Chamber& chamber : summary.Chambers)
+      {
+        chamber.ClusterSize   = Histogram(10, 0, 10);
+        chamber.ClusterNumber = Histogram(10, 0, 10);
+        chamber.Charge        = Histogram(10, 0, 10);
+        chamber.Efficient     = task.ID + 1;
+        chamber.ClusterSize.fill(task.ID % 10);
+      }
+      worker.send(task, summary.serialize());
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.emplace_back(work, true);
+  for(std::size_t i = 1; i < nbrWorkers; ++i) workers.emplace_back(work, false);
+  std::vector<RunSummary> runs(3);
+  std::size_t             results{0};
+  const double            seconds = Time([&]() {
+    coordinator.run([&](const Task& task, const std::string& result) {
+      runs[task.Run].add(RunSummary::deserialize(result));
+      ++results;
+    });
+  });
+  for(std::size_t i = 0; i != workers.size(); ++i) workers[i].join();
+  fmt::print("\t{} results in {:.3f} ms, {} workers connected, {} tasks reassigned\n", results, seconds * 1e3, coordinator.getWorkers(), coordinator.getReassigned());
+}
+
+// Cost of a checkpoint of the counters of a run
+void BenchmarkCheckpoint(const std::size_t& chambers, const std::size_t& repetitions)
+{
+  fmt::print(fmt::emphasis::bold, "Checkpoint ({} chambers)\n", chambers);
+  std::mt19937 generator(11);
+  Checkpoint   checkpoint;
+  checkpoint.Done      = 123456;
+  checkpoint.Events    = 1000000;
+  checkpoint.NoisyLast = true;
+  checkpoint.Summary   = RunSummary(chambers);
+  checkpoint.Summary.Events = checkpoint.Done;
+  for(RunSummary::Chamber& chamber : checkpoint.Summary.Chambers)
+  {
+    chamber.ClusterSize   = Histogram(32, 0, 32);
+    chamber.ClusterNumber = Histogram(16, 0, 16);
+    chamber.Charge        = Histogram(1000, 0, 100);
+    std::exponential_distribution<double> charge(0.2);
+    for(std::size_t i = 0; i != 100000; ++i) chamber.Charge.fill(charge(generator));
+    chamber.Efficient = 98765;
+    chamber.Hits      = 123457;
+  }
+  const std::string filename{(std::filesystem::temp_directory_path() / "BenchmarkCheckpoint.txt").string()};
+  const double      seconds = Time([&]() {
+    for(std::size_t i = 0; i != repetitions; ++i) checkpoint.write(filename);
+  });
+  fmt::print("\t{:.3f} ms by checkpoint ({} bytes)\n", seconds * 1e3 / repetitions, std::filesystem::file_size(filename));
+  std::filesystem::remove(filename);
+}
+
+// Scan of 19 thresholds x 16 windows x 3 noise thresholds in one pass against the same grid made point by point
+// the way a run does it (WindowFinder window, MeanSTD mean, extremum)
+void BenchmarkScan(const Waveforms& waveforms)
+{
+  const std::size_t                      length{waveforms.getLength()};
+  const std::size_t                      chambers{4};
+  const int                              tick{static_cast<int>(0.8 * length)};
+  const std::pair<double, double>        noiseWindow{0, 0.2 * length};
+  const std::pair<double, double>        noiseWindowAfter{0.85 * length, length - 1.0};
+  std::vector<double>                    sigmas;
+  std::vector<std::pair<double, double>> windows;
+  const std::vector<double>              noiseRatios{1.2, 1.5, 3.0};
+  for(double sigma = 1; sigma <= 10; sigma += 0.5) sigmas.push_back(sigma);
+  for(const double& delay : {0.2 * length, 0.25 * length, 0.3 * length, 0.35 * length})
+    for(const double& width : {0.1 * length, 0.2 * length, 0.3 * length, 0.45 * length}) windows.emplace_back(delay, width);
+  fmt::print(fmt::emphasis::bold, "Scan ({} thresholds x {} windows x {} noise thresholds)\n", sigmas.size(), windows.size(), noiseRatios.size());
+  Scan         all(chambers, sigmas, windows, noiseRatios, noiseWindow, noiseWindowAfter);
+  const double seconds = Time([&]() {
+    for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+    {
+      for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch) all.addChannel(ch % chambers, waveforms.get(evt, ch), length, -1, tick);
+      all.endEvent();
+    }
+  });
+  // One point as a run makes it, the grid point by point is long : timed on the first events only
+  const std::size_t          events{std::min<std::size_t>(waveforms.getEvents(), 100)};
+  const Kernels::Dispatcher  kernels{Kernels::Dispatcher::generic()};
+  std::vector<std::uint64_t> efficient(chambers), hits(chambers), corrected(chambers);
+  std::uint64_t              correctedEvents{0};
+  auto                       point = [&](const double& sigma, const std::pair<double, double>& window, const double& noiseRatio) {
+    std::fill(efficient.begin(), efficient.end(), 0);
+    std::fill(hits.begin(), hits.end(), 0);
+    std::fill(corrected.begin(), corrected.end(), 0);
+    correctedEvents = 0;
+    const int begin{std::max(static_cast<int>(tick - window.first - window.second / 2), 0)};
+    const int end{std::min(static_cast<int>(tick - window.first + window.second / 2), static_cast<int>(length))};
+    bool      noisyBefore{false};
+    for(std::size_t evt = 0; evt != events; ++evt)
+    {
+      std::vector<bool> good(chambers, false);
+      bool              noisy{false};
+      for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+      {
+        const double*                   data{waveforms.get(evt, ch)};
+        const std::pair<double, double> noise{kernels.meanSigma(data, length, noiseWindow.first, noiseWindow.second)};
+        const std::pair<double, double> after{kernels.meanSigma(data, length, noiseWindowAfter.first, noiseWindowAfter.second)};
+        noisy |= after.second * 1.0 / noise.second >= noiseRatio;
+        const double value{kernels.extremum(-1, data, length, begin, end).first};
+        if(std::fabs(value - kernels.meanSigma(data, length, begin, end).first) > sigma * noise.second)
+        {
+          good[ch % chambers] = true;
+          ++hits[ch % chambers];
+        }
+      }
+      for(std::size_t chamber = 0; chamber != chambers; ++chamber)
+      {
+        efficient[chamber] += good[chamber];
+        if(!noisyBefore) corrected[chamber] += good[chamber];
+      }
+      if(!noisyBefore) ++correctedEvents;
+      noisyBefore = noisy;
+    }
+  };
+  const double pointSeconds = Time([&]() { point(sigmas[0], windows[0], noiseRatios[0]); });
+  const double gridSeconds  = Time([&]() {
+    for(std::size_t w = 0; w != windows.size(); ++w)
+      for(std::size_t t = 0; t != sigmas.size(); ++t)
+        for(std::size_t k = 0; k != noiseRatios.size(); ++k) point(sigmas[t], windows[w], noiseRatios[k]);
+  });
+  Report("scan (all the grid)", seconds, waveforms.getSamples(), waveforms.getEvents());
+  const std::size_t samples{events * waveforms.getChannels() * length};
+  Report("one point", pointSeconds, samples, events);
+  Report("point by point (all the grid)", gridSeconds, samples * sigmas.size() * windows.size() * noiseRatios.size(), events);
+  const double scanEvent{seconds / waveforms.getEvents()};
+  fmt::print("\tscan / one point : {:.2f}, speedup on the grid : {:.1f}\n", scanEvent / (pointSeconds / events), gridSeconds / events / scanEvent);
+}
+
+// Waveforms with 0 to 3 separated pulses : the peak finder against a sample by sample version of the same
+// hysteresis search. The waveforms stay in cache like the channels of an event just decoded (on waveforms read
+// from memory both are bandwidth bound).
+void BenchmarkPeaks(const std::size_t& nbrWaveforms, const std::size_t& length, const std::size_t& repetitions)
+{
+  fmt::print(fmt::emphasis::bold, "Peak finder ({} waveforms of {} samples, 0 to 3 pulses, {} times)\n", nbrWaveforms, length, repetitions);
+  std::mt19937                       generator(5);
+  std::normal_distribution<double>   noise(0.0, 2.0);
+  std::uniform_int_distribution<>    pulses(0, 3);
+  std::uniform_real_distribution<>   amplitude(20.0, 80.0);
+  std::vector<double>                data(nbrWaveforms * length);
+  for(std::size_t w = 0; w != nbrWaveforms; ++w)
+  {
+    double* waveform{&data[w * length]};
+    for(std::size_t i = 0; i != length; ++i) waveform[i] = noise(generator);
+    const int number{pulses(generator)};
+    for(int p = 0; p != number; ++p)
+    {
+      const double t0{(p + 1) * length / 5.0};
+      const double amp{amplitude(generator)};
+      for(std::size_t i = 0; i != length; ++i)
+      {
+        const double t{(i - t0) / 4.0};
+        waveform[i] -= t > 0 ? amp * t * std::exp(1.0 - t) : 0.0;
+      }
+    }
+  }
+  const double threshold{5 * 2.0};
+  const double hysteresis{0.5};
+  // Sample by sample reference
+  std::vector<PeakTrain> reference(nbrWaveforms);
+  const double           referenceSeconds = Time([&]() {
+    for(std::size_t r = 0; r != repetitions * nbrWaveforms; ++r)
+    {
+      const std::size_t w{r % nbrWaveforms};
+      const double*     waveform{&data[w * length]};
+      PeakTrain&        train{reference[w]};
+      bool              inPeak{false};
+      train.Number = 0;
+      for(std::size_t i = 0; i != length; ++i)
+      {
+        const double y{-waveform[i]};
+        if(!inPeak && y > threshold)
+        {
+          inPeak = true;
+          if(train.Number < PeakTrain::MaxPeaks) train.Peaks[train.Number] = Peak{static_cast<int>(i), y};
+          ++train.Number;
+        }
+        else if(inPeak && y < hysteresis * threshold)
+          inPeak = false;
+        else if(inPeak && train.Number <= PeakTrain::MaxPeaks && y > train.Peaks[train.Number - 1].Amplitude)
+          train.Peaks[train.Number - 1] = Peak{static_cast<int>(i), y};
+      }
+    }
+  });
+  PeakFinder   finder(1, nbrWaveforms, hysteresis);
+  const double seconds = Time([&]() {
+    for(std::size_t r = 0; r != repetitions; ++r)
+    {
+      finder.endEvent(1.0);
+      for(std::size_t w = 0; w != nbrWaveforms; ++w) finder.find(0, w, &data[w * length], length, 0, length, -1, 0, threshold);
+    }
+  });
+  Report("sample by sample", referenceSeconds, data.size() * repetitions, nbrWaveforms * repetitions);
+  Report("peak finder (blocks)", seconds, data.size() * repetitions, nbrWaveforms * repetitions);
+  fmt::print("\tspeedup {:.2f}\n", referenceSeconds / seconds);
+}
+
+// Noise PSD of the synthetic waveforms with a 50 MHz pickup, throughput for 1, 2, 8 and 32 threads
+void BenchmarkSpectrum(const Waveforms& waveforms)
+{
+  const std::size_t segment{std::min<std::size_t>(FFT::floorPowerOfTwo(waveforms.getLength()), 256)};
+  fmt::print(fmt::emphasis::bold, "Noise spectrum ({} points, {} segments)\n", segment, waveforms.getEvents() * waveforms.getChannels());
+  const double period{1.0};
+  const double pickup{50e6};
+  // Waveforms with the pickup added once, segments taken at the end of the records (no pulse there)
+  std::vector<double> data(waveforms.copy());
+  const std::size_t   length{waveforms.getLength()};
+  for(std::size_t i = 0; i != data.size(); ++i) data[i] += std::sin(2 * std::acos(-1.0) * pickup * (i % length) * period * 1e-9);
+  const std::size_t begin{length - segment};
+  for(const int threads : {1, 2, 8, 32})
+  {
+    NoiseSpectrum spectrum(waveforms.getChannels(), segment, threads);
+    const double  seconds = Time([&]() {
+      for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+        for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch) spectrum.add(ch, &data[(evt * waveforms.getChannels() + ch) * length], length, begin);
+      spectrum.finish();
+    });
+    Report(fmt::format("{} thread(s)", threads), seconds, waveforms.getEvents() * waveforms.getChannels() * segment, waveforms.getEvents());
+  }
+}
+
+// Strips with independent noise (RMS 2) plus a common mode (RMS 3) seen with a gain in [0.5,1.5] by each strip,
+// the blocked covariance updates against direct sums over the samples
+void BenchmarkCrosstalk(const std::size_t& nbrEvents, const std::size_t& channels, const std::size_t& samples)
+{
+  fmt::print(fmt::emphasis::bold, "Crosstalk ({} events, {} channels, {} noise samples)\n", nbrEvents, channels, samples);
+  std::mt19937                     generator(17);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_real_distribution<> uniform(0.0, 1.0);
+  std::vector<double>              gains(channels);
+  for(double& gain : gains) gain = 0.5 + uniform(generator);
+  std::vector<std::vector<double>>      events(nbrEvents, std::vector<double>(channels * samples));
+  std::vector<std::vector<std::size_t>> hits(nbrEvents);
+  for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+  {
+    for(std::size_t s = 0; s != samples; ++s)
+    {
+      const double common{3 * normal(generator)};
+      for(std::size_t ch = 0; ch != channels; ++ch) events[evt][ch * samples + s] = 2 * normal(generator) + gains[ch] * common;
+    }
+    const std::size_t strip{static_cast<std::size_t>(uniform(generator) * (channels - 1))};
+    hits[evt].push_back(strip);
+    if(uniform(generator) < 0.3) hits[evt].push_back(strip + 1);
+  }
+  Crosstalk    crosstalk(channels, samples);
+  const double seconds = Time([&]() {
+    for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+    {
+      for(std::size_t ch = 0; ch != channels; ++ch) crosstalk.addNoise(ch, &events[evt][ch * samples], samples, 0);
+      for(const std::size_t& hit : hits[evt]) crosstalk.addHit(hit);
+      crosstalk.endEvent();
+    }
+    crosstalk.finish();
+  });
+  // Direct sums sample by sample
+  std::vector<double> products(channels * channels, 0), sums(channels, 0);
+  const double        directSeconds = Time([&]() {
+    for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+      for(std::size_t s = 0; s != samples; ++s)
+        for(std::size_t i = 0; i != channels; ++i)
+        {
+          sums[i] += events[evt][i * samples + s];
+          for(std::size_t j = 0; j != channels; ++j) products[i * channels + j] += events[evt][i * samples + s] * events[evt][j * samples + s];
+        }
+  });
+  Report("blocked rank-4 updates", seconds, nbrEvents * channels * samples, nbrEvents);
+  Report("direct sums", directSeconds, nbrEvents * channels * samples, nbrEvents);
+  fmt::print("\tspeedup {:.1f}\n", directSeconds / seconds);
+}
+
+// Raw file read through the memory mapping with 1 to 4 decoding threads (all the channels, as doubles then as the int16
+// codes of --precision compact, then 4 of them)
+void BenchmarkRaw(const std::size_t& nbrEvents, const std::size_t& samples, const std::string& keep)
+{
+  fmt::print(fmt::emphasis::bold, "Raw reader ({} events, {} channels, {} samples)\n", nbrEvents, RawReader::NumberChannels, samples);
+  const std::string filename{keep.empty() ? (std::filesystem::temp_directory_path() / "BenchmarkRaw.dat").string() : keep};
+  WriteRawFile(filename, nbrEvents, samples);
+  const std::vector<int> selected{0, 9, 18, 32};
+  for(const bool all : {true, false})
+  {
+    std::vector<bool> needed(RawReader::NumberChannels, all);
+    for(const int& ch : selected) needed[ch] = true;
+    for(const bool codes : {false, true})
+    {
+      if(codes && !all) continue;
+      for(const std::size_t threads : {1, 2, 4})
+      {
+        std::int64_t entries{0};
+        std::size_t  decoded{0};
+        RawEvent     event;
+        double       size{0};
+        const double seconds = Time([&]() {
+          RawReader reader(filename, threads);
+          reader.setChannels(needed);
+          // The first chunk is decoded as doubles (decoding starts with the reader)
+          reader.setCodes(codes);
+          size = reader.getFileSize();
+          while(reader.next(event))
+          {
+            ++entries;
+            for(const RawChannel& channel : event.Channels) decoded += channel.Data.size() + channel.Codes.size();
+          }
+        });
+        fmt::print("\t{:<30} {:>10.3f} ms {:>12.3e} samples/s {:>12.3e} events/s {:>8.1f} MB/s\n", fmt::format("{} channels{}, {} threads", all ? "all" : "4", codes ? " int16" : "", threads), seconds * 1e3, decoded / seconds, entries / seconds, size / seconds / 1e6);
+      }
+    }
+  }
+  if(keep.empty()) std::filesystem::remove(filename);
+}
+
+// Compiled selections against the same cuts written by hand on the feature columns of many channels
+void BenchmarkSelection(const std::size_t& rows, const std::size_t& repetitions)
+{
+  fmt::print(fmt::emphasis::bold, "Selection ({} channels)\n", rows);
+  std::mt19937                     generator(29);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_real_distribution<> uniform(0.5, 3.0);
+  const std::vector<std::string>   variables{"value", "signal_mean", "sigma_noise", "sigma_after"};
+  std::vector<std::vector<double>> features(variables.size(), std::vector<double>(rows));
+  for(std::size_t row = 0; row != rows; ++row)
+  {
+    features[1][row] = normal(generator);
+    features[2][row] = uniform(generator);
+    features[3][row] = uniform(generator) * (row % 10 == 0 ? 4 : 1);
+    features[0][row] = features[1][row] + features[2][row] * 6 * normal(generator);
+  }
+  std::vector<const double*> columns;
+  for(const std::vector<double>& feature : features) columns.push_back(feature.data());
+  const double* value{columns[0]};
+  const double* mean{columns[1]};
+  const double* noise{columns[2]};
+  const double* after{columns[3]};
+  const double  nsigma{5};
+  const std::vector<std::pair<std::string, std::string>> cuts{{"hit", "abs(value - signal_mean) > nsigma*sigma_noise"}, {"hit and not noisy", "abs(value - signal_mean) > 5*sigma_noise && sigma_after/sigma_noise < 3"}};
+  std::vector<std::uint8_t> compiled(rows);
+  std::vector<std::uint8_t> reference(rows);
+  for(std::size_t c = 0; c != cuts.size(); ++c)
+  {
+    Selection    selection(cuts[c].second, variables, {{"nsigma", nsigma}});
+    const double seconds = Time([&]() {
+      for(std::size_t r = 0; r != repetitions; ++r) selection.evaluate(columns, rows, compiled.data());
+    });
+    // Written by hand the way Analysis did it (the two cuts are inlined)
+    const double handSeconds = Time([&]() {
+      for(std::size_t r = 0; r != repetitions; ++r)
+      {
+        if(c == 0)
+          for(std::size_t i = 0; i != rows; ++i) reference[i] = std::fabs(value[i] - mean[i]) > nsigma * noise[i];
+        else
+          for(std::size_t i = 0; i != rows; ++i) reference[i] = std::fabs(value[i] - mean[i]) > 5 * noise[i] && after[i] / noise[i] < 3;
+      }
+    });
+    fmt::print("\t{:<20} {:>2} instructions {:>8.3f} ns/channel compiled {:>8.3f} ns/channel hand written ({:.2f}x)\n", cuts[c].first, selection.getNumberInstructions(), seconds * 1e9 / (rows * repetitions), handSeconds * 1e9 / (rows * repetitions), seconds / handSeconds);
+  }
+}
+
+// Features of the Analysis selections computed on the same 12 bits codes in double (ToVolt, baseline, kernels on mV)
+// and in compact precision (int16 codes, integer sums, results converted to mV)
+void BenchmarkPrecision(const Waveforms& waveforms)
+{
+  fmt::print(fmt::emphasis::bold, "Precision (double vs int16 codes)\n");
+  constexpr double                DacToVolt{560. / 2048};
+  const std::size_t               length{waveforms.getLength()};
+  const std::size_t               channels{waveforms.getChannels()};
+  const std::size_t               events{waveforms.getEvents()};
+  const std::pair<double, double> noise{0, 0.2 * length};
+  const std::pair<double, double> noiseAfter{0.8 * length, length - 1.};
+  const int                       begin{static_cast<int>(0.4 * length)};
+  const int                       end{static_cast<int>(0.6 * length)};
+  // ADC codes as stored in Channel::Data (pedestal above 2048 so the pulses stay in range)
+  std::vector<double> codes(waveforms.getSamples());
+  for(std::size_t evt = 0; evt != events; ++evt)
+    for(std::size_t ch = 0; ch != channels; ++ch)
+      for(std::size_t i = 0; i != length; ++i) codes[(evt * channels + ch) * length + i] = std::max(0., std::min(4095., std::round(2248 + waveforms.get(evt, ch)[i] / DacToVolt)));
+  const Kernels::Dispatcher kernels{Kernels::Dispatcher::select(length)};
+  std::vector<double>       volts(length);
+  std::vector<std::int16_t> compact(length);
+  double                    check{0};
+  const double              doubleSeconds = Time([&]() {
+    for(std::size_t i = 0; i != events * channels; ++i)
+    {
+      for(std::size_t j = 0; j != length; ++j) volts[j] = (codes[i * length + j] - 2048) * DacToVolt;
+      kernels.baseline(volts.data(), length);
+      const std::pair<double, double> signal{kernels.meanSigma(volts.data(), length, begin, end)};
+      const float                     value{static_cast<float>(kernels.extremum(-1, volts.data(), length, begin, end).first)};
+      check += kernels.extremum(+1, volts.data(), length, begin, end).first + std::fabs(value - signal.first);
+      check += kernels.meanSigma(volts.data(), length, noise.first, noise.second).second + kernels.meanSigma(volts.data(), length, noiseAfter.first, noiseAfter.second).second;
+    }
+  });
+  const double compactSeconds = Time([&]() {
+    for(std::size_t i = 0; i != events * channels; ++i)
+    {
+      std::int64_t sum{0};
+      Kernels::toCodes(&codes[i * length], length, compact.data(), sum);
+      const double                    baseline{static_cast<double>(sum) / length};
+      const std::pair<double, double> signal{kernels.meanSigma(compact.data(), length, begin, end)};
+      const float                     value{static_cast<float>((kernels.extremum(-1, compact.data(), length, begin, end).first - baseline) * DacToVolt)};
+      check += kernels.extremum(+1, compact.data(), length, begin, end).first + std::fabs(value - (signal.first - baseline) * DacToVolt);
+      check += (kernels.meanSigma(compact.data(), length, noise.first, noise.second).second + kernels.meanSigma(compact.data(), length, noiseAfter.first, noiseAfter.second).second) * DacToVolt;
+    }
+  });
+  // Codes already in int16 (no conversion from the double buffer)
+  std::vector<std::int16_t> allCodes(codes.size());
+  std::int64_t              sum{0};
+  Kernels::toCodes(codes.data(), codes.size(), allCodes.data(), sum);
+  const double codeSeconds = Time([&]() {
+    for(std::size_t i = 0; i != events * channels; ++i)
+    {
+      const std::int16_t* data{&allCodes[i * length]};
+      check += kernels.mean(data, length) + kernels.meanSigma(data, length, begin, end).first + kernels.extremum(-1, data, length, begin, end).first + kernels.extremum(+1, data, length, begin, end).first;
+      check += kernels.meanSigma(data, length, noise.first, noise.second).second + kernels.meanSigma(data, length, noiseAfter.first, noiseAfter.second).second;
+    }
+  });
+  Report("double (mV)", doubleSeconds, codes.size(), events);
+  Report("compact (from double codes)", compactSeconds, codes.size(), events);
+  Report("compact (int16 codes)", codeSeconds, codes.size(), events);
+  fmt::print("\t{:.2f}x faster from the double codes, {:.2f}x from int16 ({})\n", doubleSeconds / compactSeconds, doubleSeconds / codeSeconds, check != 0 ? "ok" : "");
+}
+
+// The events are cut in chunks analysed by 1, 2, 8 and 32 threads (hits, clusters, charge), each chunk giving a
+// partial summary merged in the order the chunks finish.
+void BenchmarkReproducibility(const Waveforms& waveforms, const std::size_t& chunk)
+{
+  const std::size_t channels{waveforms.getChannels()};
+  const std::size_t length{waveforms.getLength()};
+  const std::size_t nbrChunks{(waveforms.getEvents() + chunk - 1) / chunk};
+  fmt::print(fmt::emphasis::bold, "Reproducibility ({} chunks of {} events)\n", nbrChunks, chunk);
+  const Kernels::Dispatcher     kernels{Kernels::Dispatcher::select(length)};
+  std::vector<std::vector<int>> strips(std::max<std::size_t>(channels / 8, 1));
+  for(std::size_t ch = 0; ch != channels; ++ch) strips[std::min(ch / 8, strips.size() - 1)].push_back(static_cast<int>(ch));
+  auto analyse = [&](const std::size_t& first, const std::size_t& last) {
+    RunSummary          summary(strips.size());
+    ClusterBuilder      clusters(strips, 10, length);
+    std::vector<double> buffer(length);
+    std::vector<int>    hits(strips.size());
+    for(RunSummary::Chamber& chamber : summary.Chambers) chamber.Charge = Histogram(200, 0, 100);
+    for(std::size_t evt = first; evt != last; ++evt)
+    {
+      std::fill(hits.begin(), hits.end(), 0);
+      for(std::size_t ch = 0; ch != channels; ++ch)
+      {
+        const double* data{waveforms.get(evt, ch)};
+        buffer.assign(data, data + length);
+        kernels.baseline(buffer.data(), length);
+        const std::size_t               chamber{std::min(ch / 8, strips.size() - 1)};
+        const std::pair<double, double> noise{kernels.meanSigma(buffer.data(), length, 0, 0.2 * length)};
+        const std::pair<double, int>    minimum{kernels.extremum(-1, buffer.data(), length, static_cast<int>(0.2 * length), static_cast<int>(length))};
+        if(noise.first - minimum.first < 5 * noise.second) continue;
+        ++hits[chamber];
+        clusters.addHit(static_cast<int>(chamber), static_cast<int>(ch), minimum.second);
+        summary.Chambers[chamber].Charge.fill(noise.first - minimum.first);
+        summary.Chambers[chamber].ChargeSum += std::llround((noise.first - minimum.first) / PulseAnalyser::ChargeQuantum);
+        ++summary.Chambers[chamber].ChargeEntries;
+      }
+      clusters.endEvent();
+      for(std::size_t chamber = 0; chamber != strips.size(); ++chamber)
+      {
+        summary.Chambers[chamber].Efficient += hits[chamber] != 0;
+        summary.Chambers[chamber].EfficientCorrected += hits[chamber] != 0;
+        summary.Chambers[chamber].Hits += hits[chamber];
+      }
+    }
+    summary.Events    = static_cast<std::int64_t>(last - first);
+    summary.Corrected = summary.Events;
+    for(std::size_t chamber = 0; chamber != strips.size(); ++chamber)
+    {
+      summary.Chambers[chamber].ClusterSize   = clusters.getClusterSize(chamber);
+      summary.Chambers[chamber].ClusterNumber = clusters.getClusterNumber(chamber);
+    }
+    return summary;
+  };
+  double referenceSeconds{0};
+  for(const std::size_t threads : {1, 2, 8, 32})
+  {
+    // Empty summary with the binning of the partial ones
+    RunSummary               merged{analyse(0, 0)};
+    std::mutex               mutex;
+    std::atomic<std::size_t> next{0};
+    const double             seconds = Time([&]() {
+      auto work = [&]() {
+        for(std::size_t i = next++; i < nbrChunks; i = next++)
+        {
+          const RunSummary partial{analyse(i * chunk, std::min((i + 1) * chunk, waveforms.getEvents()))};
+          std::lock_guard<std::mutex> lock(mutex);
+          merged.add(partial);
+        }
+      };
+      std::vector<std::thread> workers;
+      for(std::size_t t = 1; t < threads; ++t) workers.emplace_back(work);
+      work();
+      for(std::thread& worker : workers) worker.join();
+    });
+    if(threads == 1) referenceSeconds = seconds;
+    fmt::print("\t{:<30} {:>10.3f} ms {:>12.3e} events/s, speed-up {:.2f}\n", fmt::format("{} thread(s)", threads), seconds * 1e3, waveforms.getEvents() / seconds, referenceSeconds / seconds);
+  }
+}
+
+// Stages of the per event chain (copy, baseline, features, clustering) and the FFT threads of the noise spectrum
+// measured with the hardware counters (time only without them). Cost of one lap.
+void BenchmarkCounters(const Waveforms& waveforms)
+{
+  const std::size_t channels{waveforms.getChannels()};
+  const std::size_t length{waveforms.getLength()};
+  fmt::print(fmt::emphasis::bold, "Hardware counters ({} events)\n", waveforms.getEvents());
+  const PerfCounters counters;
+  if(counters.isAvailable()) fmt::print("\tperf_event_open available\n");
+  enum Stage : std::size_t
+  {
+    Copy,
+    Baseline,
+    Features,
+    Clustering,
+    Spectrum,
+    Threads
+  };
+  StageProfile                  profile({"copy", "baseline", "features", "clustering", "spectrum (caller)", "spectrum FFT"});
+  const Kernels::Dispatcher     kernels{Kernels::Dispatcher::select(length)};
+  std::vector<std::vector<int>> strips(std::max<std::size_t>(channels / 8, 1));
+  for(std::size_t ch = 0; ch != channels; ++ch) strips[std::min(ch / 8, strips.size() - 1)].push_back(static_cast<int>(ch));
+  ClusterBuilder                         clusters(strips, 10, length);
+  NoiseSpectrum                          spectrum(channels, FFT::floorPowerOfTwo(std::max<std::size_t>(length / 4, 4)), 2);
+  std::vector<double>                    buffer(channels * length);
+  std::vector<std::pair<double, double>> noise(channels);
+  std::vector<std::pair<double, int>>    minimum(channels);
+  spectrum.setProfile(&profile, Threads, 1);
+  StageClock   clock(&profile);
+  const double seconds = Time([&]() {
+    clock.restart();
+    for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+    {
+      std::copy(waveforms.get(evt, 0), waveforms.get(evt, 0) + channels * length, buffer.begin());
+      clock.lap(Copy);
+      for(std::size_t ch = 0; ch != channels; ++ch) kernels.baseline(&buffer[ch * length], length);
+      clock.lap(Baseline);
+      for(std::size_t ch = 0; ch != channels; ++ch)
+      {
+        noise[ch]   = kernels.meanSigma(&buffer[ch * length], length, 0, 0.2 * length);
+        minimum[ch] = kernels.extremum(-1, &buffer[ch * length], length, static_cast<int>(0.2 * length), static_cast<int>(length));
+      }
+      clock.lap(Features);
+      for(std::size_t ch = 0; ch != channels; ++ch)
+        if(noise[ch].first - minimum[ch].first >= 5 * noise[ch].second) clusters.addHit(static_cast<int>(std::min(ch / 8, strips.size() - 1)), static_cast<int>(ch), minimum[ch].second);
+      clusters.endEvent();
+      clock.lap(Clustering);
+      for(std::size_t ch = 0; ch != channels; ++ch) spectrum.add(ch, &buffer[ch * length], length, 0);
+      clock.lap(Spectrum);
+    }
+    spectrum.finish();
+    clock.lap(Spectrum);
+  });
+  fmt::print("{}", profile.report(waveforms.getEvents(), waveforms.getSamples()));
+  double measured{0};
+  for(std::size_t stage = Copy; stage != Threads; ++stage) measured += profile.getSums(stage).Seconds;
+  // Cost of a lap (one read of the counters and one addition to the profile)
+  StageProfile      empty({"lap"});
+  StageClock        laps(&empty);
+  const std::size_t repetitions{100000};
+  const double      lapSeconds = Time([&]() {
+    for(std::size_t i = 0; i != repetitions; ++i) laps.lap(0);
+  });
+  fmt::print("\t{:.1f} ns by lap, laps cover {:.1f}% of the loop\n", lapSeconds * 1e9 / repetitions, 100 * measured / seconds);
+}
+
+// Engine of the analysis embedded : 2 chambers of 8 strips and one trigger, the strips fire a pulse at a fixed
+// delay before the trigger. One batch, then 4 threads (one engine each) whose summaries are merged.
+void BenchmarkEngine(const std::size_t& nbrEvents, const std::size_t& length)
+{
+  const std::size_t strips{16};
+  const std::size_t channels{strips + 1};
+  fmt::print(fmt::emphasis::bold, "Analysis engine ({} events, {} strips, {} samples)\n", nbrEvents, strips, length);
+  AnalysisConfiguration configuration;
+  for(std::size_t ch = 0; ch != strips; ++ch) configuration.Strips.push_back({static_cast<int>(ch), static_cast<int>(ch / 8), static_cast<int>(ch), -1});
+  configuration.Triggers         = {static_cast<int>(strips)};
+  configuration.SignalWindow     = {0.06 * length, 0.2 * length};
+  configuration.NoiseWindow      = {0.02 * length, 0.15 * length};
+  configuration.NoiseWindowAfter = {0.8 * length, 0.98 * length};
+  configuration.ADCCodes         = false;
+  std::mt19937                     generator(23);
+  std::normal_distribution<double> noise(0.0, 2.0);
+  std::uniform_real_distribution<> uniform(0.0, 1.0);
+  std::vector<double>              data(nbrEvents * channels * length);
+  for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+  {
+    double*           event{&data[evt * channels * length]};
+    const std::size_t trigger{static_cast<std::size_t>((0.55 + 0.1 * uniform(generator)) * length)};
+    for(std::size_t i = 0; i != channels * length; ++i) event[i] = noise(generator);
+    for(std::size_t i = trigger; i != length; ++i) event[strips * length + i] -= 100;
+    for(std::size_t chamber = 0; chamber != 2; ++chamber)
+    {
+      if(uniform(generator) >= 0.7) continue;
+      const std::size_t strip{chamber * 8 + static_cast<std::size_t>(uniform(generator) * 7)};
+      const double      amplitude{30 + 50 * uniform(generator)};
+      const double      t0{trigger - 0.2 * length - 4};
+      for(std::size_t i = 0; i != length; ++i)
+      {
+        const double t{(i - t0) / 4.0};
+        event[strip * length + i] -= t > 0 ? amplitude * t * std::exp(1.0 - t) : 0.0;
+      }
+    }
+  }
+  {
+    AnalysisEngine engine(configuration);
+    const double   seconds = Time([&]() { engine.process(data.data(), nbrEvents, channels, length, 1.0); });
+    Report("one batch", seconds, nbrEvents * channels * length, nbrEvents);
+  }
+  // One engine by thread
+  const std::size_t        threads{4};
+  RunSummary               merged;
+  std::mutex               mutex;
+  std::vector<std::thread> workers;
+  const double             seconds = Time([&]() {
+    for(std::size_t t = 0; t != threads; ++t)
+      workers.emplace_back([&, t]() {
+        const std::size_t first{t * nbrEvents / threads};
+        const std::size_t last{(t + 1) * nbrEvents / threads};
+        AnalysisEngine    engine(configuration);
+        engine.process(&data[first * channels * length], last - first, channels, length, 1.0);
+        const RunSummary            summary{engine.getSummary()};
+        std::lock_guard<std::mutex> lock(mutex);
+        if(merged.Chambers.empty()) merged = summary;
+        else
+          merged.add(summary);
+      });
+    for(std::thread& worker : workers) worker.join();
+  });
+  Report(fmt::format("{} threads", threads), seconds, nbrEvents * channels * length, nbrEvents);
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  CLI::App    app{"Benchmark"};
+  std::size_t NbrEvents{2000};
+  app.add_option("-e,--events", NbrEvents, "Number of synthetic events.")->check(CLI::PositiveNumber);
+  std::size_t NbrChannels{32};
+  app.add_option("-c,--channels", NbrChannels, "Number of channels by event.")->check(CLI::PositiveNumber);
+  std::size_t RecordLength{1024};
+  app.add_option("-l,--length", RecordLength, "Record length.")->check(CLI::PositiveNumber);
+  std::string RawFile{""};
+  app.add_option("--rawFile", RawFile, "Keep the synthetic raw digitizer file of the raw reader benchmark under this name.");
+  try
+  {
+    app.parse(argc, argv);
+  }
+  catch(const CLI::ParseError& e)
+  {
+    return app.exit(e);
+  }
+  Waveforms waveforms(NbrEvents, NbrChannels, RecordLength);
+  BenchmarkFilters(waveforms);
+  BenchmarkKernels(waveforms);
+  BenchmarkClassifier(waveforms);
+  BenchmarkDistributed(24, 4);
+  BenchmarkCheckpoint(4, 20);
+  BenchmarkScan(waveforms);
+  BenchmarkPeaks(64, RecordLength, 300);
+  BenchmarkSpectrum(waveforms);
+  BenchmarkCrosstalk(2000, 64, 200);
+  BenchmarkSelection(100003, 20);
+  BenchmarkPrecision(waveforms);
+  BenchmarkReproducibility(waveforms, 16);
+  BenchmarkCounters(waveforms);
+  BenchmarkEngine(std::max<std::size_t>(NbrEvents / 4, 40), RecordLength);
+  BenchmarkRaw(200, std::min<std::size_t>(RecordLength, 1024) / 8 * 8, RawFile);
+  return EXIT_SUCCESS;
+}
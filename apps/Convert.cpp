@@ -0,0 +1,171 @@
+#include "CLI/CLI.hpp"
+#include "Event.hpp"
+#include "EventBuilder.hpp"
+#include "EventWriter.hpp"
+#include "TROOT.h"
+#include "fmt/color.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Rewrite the runs (one "Events" object branch, or raw digitizer files) with the per-channel, fully split layout
+// (see EventWriter).
+// The converted files keep their names so Analysis can be pointed to the output folder.
+// To run the code see the help doing "./Convert -h"
+
+namespace
+{
+struct Conversion
+{
+  std::string Input;
+  std::string Output;
+  Long64_t    Entries{0};
+  double      Seconds{0};
+  std::string Error;
+};
+
+Conversion Convert(const std::string& input, const std::string& output, const std::string& treeName, const EventWriter::Layout& layout, const int& compression, const int& basketSize, const Long64_t& cluster)
+{
+  Conversion conversion;
+  conversion.Input  = input;
+  conversion.Output = output;
+  const auto start  = std::chrono::steady_clock::now();
+  try
+  {
+    EventBuilder reader({input}, treeName);
+    EventWriter  writer(output, layout, treeName, compression, basketSize);
+    writer.setClusterSize(cluster);
+    Event event;
+    while(reader.next(event)) writer.fill(event);
+    writer.close();
+    conversion.Entries = writer.getEntries();
+  }
+  catch(const std::runtime_error& error)
+  {
+    conversion.Error = error.what();
+  }
+  conversion.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return conversion;
+}
+
+// Read all the entries of a file through EventBuilder (as Analysis does), channels empty to decode all of them
+void Read(const std::string& name, const std::string& file, const std::string& treeName, const std::vector<int>& channels)
+{
+  EventBuilder reader({file}, treeName);
+  reader.setChannels(channels);
+  Event       event;
+  Long64_t    entries{0};
+  std::size_t samples{0};
+  const auto  start = std::chrono::steady_clock::now();
+  while(reader.next(event))
+  {
+    for(std::size_t ch = 0; ch != event.Channels.size(); ++ch) samples += event.Channels[ch].Data.size();
+    event.clear();
+    ++entries;
+  }
+  const double seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+  fmt::print("\t{:<36} {:>10.3f} s {:>12.3e} events/s {:>12.3e} samples/s {:>10.2f} MB\n", name, seconds, entries / seconds, samples / seconds, fs::file_size(file) / 1.0e6);
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  CLI::App                 app{"Convert"};
+  std::vector<std::string> files;
+  app.add_option("-f,--files", files, "Files to convert.")->required()->check(CLI::ExistingFile);
+  std::string output{"Converted"};
+  app.add_option("-o,--output", output, "Folder of the converted files (same names as the inputs).");
+  std::string nameTree{"Tree"};
+  app.add_option("-t,--tree", nameTree, "Name of the TTree.");
+  std::string layout{"channels"};
+  app.add_option("-l,--layout", layout, "Layout of the converted files : channels (one split branch by channel) or object (one Events branch).")->check(CLI::IsMember({"channels", "object"}));
+  int compression{404};
+  app.add_option("-c,--compression", compression, "ROOT compression setting (algorithm * 100 + level : 101 zlib, 404 lz4, 505 zstd, 0 none).");
+  int basketSize{256000};
+  app.add_option("--basket", basketSize, "Basket size (bytes).")->check(CLI::PositiveNumber);
+  Long64_t cluster{0};
+  app.add_option("--cluster", cluster, "Number of entries by cluster (0 for ROOT default).");
+  unsigned int threads{std::max(1u, std::thread::hardware_concurrency())};
+  app.add_option("-j,--threads", threads, "Number of threads (files converted in parallel, one thread by file, the baskets of a cluster compressed in parallel).")->check(CLI::PositiveNumber);
+  bool benchmark{false};
+  app.add_flag("--benchmark", benchmark, "Compare the reading speed of the original and converted files.");
+  std::vector<int> channels{8, 17, 26, 35};
+  app.add_option("--channels", channels, "Channels decoded by the selective reading benchmark.");
+  try
+  {
+    app.parse(argc, argv);
+  }
+  catch(const CLI::ParseError& e)
+  {
+    return app.exit(e);
+  }
+  fs::create_directories(output);
+  for(std::size_t i = 0; i != files.size(); ++i)
+  {
+    if(!fs::equivalent(fs::absolute(files[i]).parent_path(), output)) continue;
+    fmt::print(fg(fmt::color::red) | fmt::emphasis::bold, "Output folder {} contains the input {}, the file would be overwritten !\n", output, files[i]);
+    return EXIT_FAILURE;
+  }
+  // Raw digitizer files get the .root extension : two inputs with the same name (other folders, or x.dat and x.root)
+  // would be written to the same file by two threads
+  std::vector<std::string>           outputs(files.size());
+  std::map<std::string, std::size_t> written;
+  for(std::size_t i = 0; i != files.size(); ++i)
+  {
+    const fs::path name{RawReader::isRaw(files[i]) ? fs::path(files[i]).filename().replace_extension(".root") : fs::path(files[i]).filename()};
+    outputs[i] = (fs::path(output) / name).lexically_normal().string();
+    const auto inserted = written.emplace(outputs[i], i);
+    if(inserted.second) continue;
+    fmt::print(fg(fmt::color::red) | fmt::emphasis::bold, "{} and {} would both be converted to {} !\n", files[inserted.first->second], files[i], outputs[i]);
+    return EXIT_FAILURE;
+  }
+
+  // The parallelism is by file : each file is read and written by one thread in entry order (its entries are not split
+  // in cluster ranges). Inside a file, ROOT implicit multi-threading only compresses the baskets of the branches in
+  // parallel when a cluster is flushed, so a single file gets little from more threads.
+  ROOT::EnableThreadSafety();
+  if(threads > 1) ROOT::EnableImplicitMT(threads);
+  std::vector<Conversion>  conversions(files.size());
+  std::atomic<std::size_t> next{0};
+  std::mutex               print;
+  std::vector<std::thread> workers;
+  for(std::size_t worker = 0; worker != std::min<std::size_t>(threads, files.size()); ++worker)
+  {
+    workers.emplace_back([&]() {
+      for(std::size_t i = next++; i < files.size(); i = next++)
+      {
+        conversions[i] = Convert(files[i], outputs[i], nameTree, EventWriter::fromString(layout), compression, basketSize, cluster);
+        std::lock_guard<std::mutex> lock(print);
+        if(conversions[i].Error.empty()) fmt::print("{} -> {} : {} events in {:.2f} s\n", conversions[i].Input, conversions[i].Output, conversions[i].Entries, conversions[i].Seconds);
+        else
+          fmt::print(fg(fmt::color::red) | fmt::emphasis::bold, "{} : {}\n", conversions[i].Input, conversions[i].Error);
+      }
+    });
+  }
+  for(std::size_t worker = 0; worker != workers.size(); ++worker) workers[worker].join();
+  const bool ok{std::all_of(conversions.begin(), conversions.end(), [](const Conversion& conversion) { return conversion.Error.empty(); })};
+
+  if(benchmark)
+  {
+    for(std::size_t i = 0; i != conversions.size(); ++i)
+    {
+      if(!conversions[i].Error.empty()) continue;
+      fmt::print(fmt::emphasis::bold, "Reading {} ({} events)\n", conversions[i].Input, conversions[i].Entries);
+      Read("original", conversions[i].Input, nameTree, {});
+      Read(fmt::format("{} (all channels)", layout), conversions[i].Output, nameTree, {});
+      Read(fmt::format("{} ({} channels)", layout, channels.size()), conversions[i].Output, nameTree, channels);
+    }
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
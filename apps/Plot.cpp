@@ -11,6 +11,7 @@
 #include "TFrame.h"
 #include "TStyle.h"
 #include "TAxis.h"
+#include "TROOT.h"
 #include "TPaveStats.h"
 #include "TFitResult.h"
 #include "CLI/CLI.hpp"
@@ -18,15 +19,15 @@
 #include "TLatex.h"
 #include "TLegend.h"
 #include "rapidcsv.h"
+#include "Results.hpp"
 
 #include "Style.hpp"
 
 int main(int argc, char** argv)
 {
-  SetStyle();
   CLI::App    app{"Plotter"};
   std::vector<std::string> filenames{"Results.csv"};
-  app.add_option("-f,--files", filenames, "Name of the .csv file to process")->check(CLI::ExistingFile);
+  app.add_option("-f,--files", filenames, "Name of the .res (or .csv) file to process")->check(CLI::ExistingFile);
   std::vector<float> mins;
   app.add_option("-m,--min", mins, "Minimum voltages for the fit (-1) for default")->check(CLI::PositiveNumber);
   std::vector<float> maxs;
@@ -44,6 +45,10 @@ int main(int argc, char** argv)
     return app.exit(e);
   }
 
+  // Style and graphics only once the options are valid, the plots are only written to files
+  gROOT->SetBatch(true);
+  SetStyle();
+
   if(mins.size()==maxs.size())
   {
     if(mins.size()==0)
@@ -72,12 +77,28 @@ int main(int argc, char** argv)
   for(std::size_t file=0;file!=filenames.size();++file)
   {
     canvas.cd();
-    //Read the .csv file
-    rapidcsv::Document doc(filenames[file], rapidcsv::LabelParams(0, -1),rapidcsv::SeparatorParams(),rapidcsv::ConverterParams(),rapidcsv::LineReaderParams(true /* pSkipCommentLines */,'#' /* pCommentPrefix */,true /* pSkipEmptyLines */));
-    std::vector<float> HVs = doc.GetColumn<float>("HV");
-    std::vector<float> efficiencies = doc.GetColumn<float>("Efficiency");
-    std::vector<float> errorEfficiencies = doc.GetColumn<float>("Error Efficiency");
-    std::vector<float> Multiplicities = doc.GetColumn<float>("Multiplicity");
+    std::vector<float> HVs;
+    std::vector<float> efficiencies;
+    std::vector<float> errorEfficiencies;
+    std::vector<float> Multiplicities;
+    if(filenames[file].size()>=4 && filenames[file].compare(filenames[file].size()-4,4,".csv")==0)
+    {
+      //Read the .csv file
+      rapidcsv::Document doc(filenames[file], rapidcsv::LabelParams(0, -1),rapidcsv::SeparatorParams(),rapidcsv::ConverterParams(),rapidcsv::LineReaderParams(true /* pSkipCommentLines */,'#' /* pCommentPrefix */,true /* pSkipEmptyLines */));
+      HVs = doc.GetColumn<float>("HV");
+      efficiencies = doc.GetColumn<float>("Efficiency");
+      errorEfficiencies = doc.GetColumn<float>("Error Efficiency");
+      Multiplicities = doc.GetColumn<float>("Multiplicity");
+    }
+    else
+    {
+      //Memory map the binary results file
+      ResultsReader doc(filenames[file]);
+      HVs = doc.getColumn<float>("HV");
+      efficiencies = doc.getColumn<float>("Efficiency");
+      errorEfficiencies = doc.getColumn<float>("Error Efficiency");
+      Multiplicities = doc.getColumn<float>("Multiplicity");
+    }
     std::vector<float> errorHVs(HVs.size(),0);
 
     std::vector<float>::iterator result;
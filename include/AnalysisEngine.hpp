@@ -0,0 +1,210 @@
+#pragma once
+
+#include "Classifier.hpp"
+#include "Clustering.hpp"
+#include "Kernels.hpp"
+#include "PulseShape.hpp"
+#include "RunSummary.hpp"
+#include "Selection.hpp"
+#include "WindowFinder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// mV by ADC count : 1.12VPP for 0-4096
+constexpr double DAC_TO_VOLT{560. / 2048};
+
+// Features of a channel seen by the hit and noisy selections (columns in this order)
+enum FeatureColumn : std::size_t
+{
+  FeatureValue,
+  FeatureAmp,
+  FeatureSignalMean,
+  FeatureSignalSigma,
+  FeatureNoiseMean,
+  FeatureNoiseSigma,
+  FeatureNoiseAfterMean,
+  FeatureNoiseAfterSigma,
+  FeatureTick,
+  FeaturePolarity,
+  FeatureChamber,
+  FeatureStrip
+};
+extern const std::vector<std::string> FeatureNames;
+
+// Windows of a channel computed once by event, used by the selections and the rest of the analysis
+struct ChannelWindows
+{
+  std::pair<double, double> Noise;
+  std::pair<double, double> NoiseAfter;
+  std::pair<double, double> Signal;
+  std::pair<double, int>    Minimum;
+  std::pair<double, int>    Maximum;
+};
+
+void FillFeatures(std::vector<std::vector<double>>& features, const std::size_t& row, const ChannelWindows& windows, const int& sign, const int& chamber, const int& strip);
+
+// Steps of the event chain shared by Analysis and AnalysisEngine, so both give the same counters for the same events
+
+// Fraction of the trigger minimum giving its tick
+constexpr double TriggerFraction{0.20};
+// Tick of a (negative) trigger with its baseline removed : first sample below TriggerFraction of its minimum, 0 if none
+int TriggerTick(const double* data, const std::size_t& length);
+
+// Hit and noisy selections, run on the features of all the channels of an event at once
+class ChannelSelections
+{
+public:
+  ChannelSelections() = default;
+  // Constants : nsigma and nsigma_noise
+  ChannelSelections(const std::string& hit, const std::string& noisy, const double& nbrSigma, const double& nbrSigmaNoise);
+  void evaluate(const std::vector<const double*>& columns, const std::size_t& rows, std::uint8_t* hits, std::uint8_t* noisy);
+
+private:
+  Selection m_Hit;
+  Selection m_Noisy;
+};
+
+// Channel of the event given to the classifier, from its features
+void ClassifyChannel(Classifier& classifier, const std::vector<std::vector<double>>& features, const std::size_t& row);
+// Selected channel : its hit in the clusters, its pulse and the classifier. data : waveform in mV, baseline : noise mean
+const Pulse& AnalyseHit(ClusterBuilder& clusters, PulseAnalyser& pulses, Classifier& classifier, const int& chamber, const int& strip, const double* data, const std::size_t& length, const int& polarity, const int& peak, const double& baseline, const double& period);
+
+// Efficiency counters of a run : events with a hit by chamber, all and in the corrected efficiency which excludes
+// the event after a noisy one (a noisy event following a noisy one is counted, the skip only holds for the next event)
+class EfficiencyCounter
+{
+public:
+  explicit EfficiencyCounter(const std::size_t& chambers = 0);
+  // Before the channels of each event
+  void                     beginEvent();
+  void                     addHit(const std::size_t& chamber);
+  void                     setNoisy(const std::size_t& chamber);
+  void                     endEvent();
+  // Event with an invalid trigger : nothing counted, the event after it is in the corrected efficiency again
+  void                     skipEvent();
+  // Current (or last) event : hits and noisy channel by chamber
+  const std::vector<int>&  getHits() const { return m_Hits; }
+  const std::vector<bool>& getNoisy() const { return m_Noisy; }
+  bool                     hasHit() const;
+  // The next event is not in the corrected efficiency
+  bool                     isNoisyLast() const { return m_SkipNext; }
+  // Invalid, Corrected and the Efficient, EfficientCorrected and Hits of the chambers
+  void                     fill(RunSummary& summary) const;
+  void                     restore(const RunSummary& summary, const bool& noisyLast);
+
+private:
+  std::vector<int>  m_Hits;
+  std::vector<bool> m_Noisy;
+  bool              m_SkipNext{false};
+  RunSummary        m_Counts;
+};
+
+// Summary of the events [0, events[ of a run from its components
+RunSummary Summarise(const std::int64_t& events, const EfficiencyCounter& efficiency, const ClusterBuilder& clusters, const PulseAnalyser& pulses, Classifier& classifier);
+
+// Configuration of an AnalysisEngine, same meaning and defaults as the options of Analysis
+struct AnalysisConfiguration
+{
+  struct Strip
+  {
+    // Index of the channel in the event
+    int Channel{0};
+    int Chamber{0};
+    int Number{0};
+    int Polarity{-1};
+  };
+  std::vector<Strip>        Strips;
+  // Channels of the triggers (index in the event), a strip uses the first trigger after it
+  std::vector<int>          Triggers;
+  // Width of the signal window and delay between the signal and the trigger (ticks)
+  std::pair<double, double> SignalWindow{0, 0};
+  std::pair<double, double> NoiseWindow{0, 0};
+  std::pair<double, double> NoiseWindowAfter{0, 0};
+  double                    NbrSigma{5.0};
+  double                    NbrSigmaNoise{5.0};
+  std::string               HitSelection{"abs(value - signal_mean) > nsigma*sigma_noise"};
+  std::string               NoisySelection{"sigma_after/sigma_noise >= nsigma_noise"};
+  double                    ClusterWindow{10};
+  double                    CFDFraction{0.2};
+  std::pair<double, double> ChargeWindow{10, 30};
+  double                    StreamerCharge{10.0};
+  // The strips are 12 bits ADC codes converted to mV (as the V1742 files), else already in mV
+  bool                      ADCCodes{true};
+};
+
+// Efficiency engine of Analysis without the ROOT I/O and plots : the events are given by batches (waveform spans
+// or Event like objects), the per chamber counters grow event by event and can be read (or taken) at any time as
+// a RunSummary. Nothing global is set up and nothing is shared between instances : one instance by thread.
+// The waveforms given are not modified, the strips are copied in buffers allocated at the first event.
+class AnalysisEngine
+{
+public:
+  explicit AnalysisEngine(const AnalysisConfiguration& configuration);
+  // events x channels x length samples, sample i of channel c of event e at data[(e * channels + c) * length].
+  // period : sampling period (ns)
+  void                       process(const double* data, const std::size_t& events, const std::size_t& channels, const std::size_t& length, const double& period);
+  // Objects with Channels (each one with a Data vector of doubles) and Period_ns members, as Event
+  template<typename EventType> void process(const std::vector<EventType>& events)
+  {
+    for(const EventType& event : events)
+    {
+      m_Waveforms.resize(event.Channels.size());
+      m_Lengths.resize(event.Channels.size());
+      for(std::size_t ch = 0; ch != event.Channels.size(); ++ch)
+      {
+        m_Waveforms[ch] = event.Channels[ch].Data.data();
+        m_Lengths[ch]   = event.Channels[ch].Data.size();
+      }
+      analyse(event.Period_ns);
+    }
+  }
+  // Counters of the events processed since the construction (or the last takeSummary)
+  RunSummary                 getSummary();
+  // Same, the counters start again from zero
+  RunSummary                 takeSummary();
+  // Last event : trigger valid, hits and noisy channel by chamber (online decisions)
+  bool                       isLastValid() const { return m_LastValid; }
+  const std::vector<int>&    getLastHits() const { return m_Efficiency.getHits(); }
+  const std::vector<bool>&   getLastNoisy() const { return m_Efficiency.getNoisy(); }
+  std::size_t                getNumberChambers() const { return m_NbrChambers; }
+  const AnalysisConfiguration& getConfiguration() const { return m_Configuration; }
+
+private:
+  // Event in m_Waveforms and m_Lengths
+  void                             analyse(const double& period);
+  // Components holding the counters, made again by takeSummary
+  void                             reset();
+  AnalysisConfiguration            m_Configuration;
+  std::size_t                      m_NbrChambers{0};
+  // Strip of each analysed channel, by channel index
+  std::vector<AnalysisConfiguration::Strip> m_Strips;
+  std::vector<int>                 m_StripTriggers;
+  std::vector<int>                 m_UsedTriggers;
+  std::vector<std::vector<int>>    m_ChamberStrips;
+  Kernels::Dispatcher              m_Kernels;
+  std::size_t                      m_RecordLength{0};
+  std::unique_ptr<WindowFinder>    m_Windows;
+  ChannelSelections                m_Selections;
+  std::unique_ptr<ClusterBuilder>  m_Clusters;
+  std::unique_ptr<PulseAnalyser>   m_Pulses;
+  std::unique_ptr<Classifier>      m_Classifier;
+  // Event given
+  std::vector<const double*>       m_Waveforms;
+  std::vector<std::size_t>         m_Lengths;
+  // Work buffers
+  std::vector<std::vector<double>> m_Data;
+  std::vector<std::vector<double>> m_Features;
+  std::vector<const double*>       m_FeatureColumns;
+  std::vector<std::uint8_t>        m_HitSelected;
+  std::vector<std::uint8_t>        m_NoisySelected;
+  std::vector<std::pair<double, int>> m_Peaks;
+  std::vector<double>              m_Baselines;
+  bool                             m_LastValid{false};
+  std::int64_t                     m_Events{0};
+  EfficiencyCounter                m_Efficiency;
+};
@@ -2,6 +2,7 @@
 
 #include "TObject.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -18,5 +19,7 @@ class Channel: public TObject
   double              StartIndexCell{0.0};
   int                 Group{0};
   std::vector<double> Data;
+  // ADC codes decoded from a raw file instead of Data (EventBuilder::setCodes), not written to the ROOT files
+  std::vector<std::int16_t> Codes;  //!
   ClassDef(Channel, 2);
 };
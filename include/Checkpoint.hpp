@@ -0,0 +1,28 @@
+#pragma once
+
+#include "RunSummary.hpp"
+
+#include <cstdint>
+#include <string>
+
+// State of a run interrupted after Done of its Events events : the counters accumulated so far, whether the
+// last event processed was noisy (the next one is then excluded of the corrected efficiency) and the state of
+// the other accumulators of the run (State, written and read back by the job). Options is the hash of the
+// analysis options of the job which wrote it, a job with other options must not resume it.
+// A run completed keeps its checkpoint with Done = Events and its final summary : it is not made again.
+// The file is replaced atomically (written aside then renamed) so a job killed while writing keeps the previous one.
+struct Checkpoint
+{
+  std::int64_t         Done{0};
+  std::int64_t         Events{0};
+  bool                 NoisyLast{false};
+  std::uint64_t        Options{0};
+  RunSummary           Summary;
+  std::string          State;
+  bool                 isFinished() const { return Done == Events; }
+  void                 write(const std::string& filename) const;
+  // false when there is no checkpoint or it can't be read
+  static bool          read(const std::string& filename, Checkpoint& checkpoint);
+  // Hash (64 bits FNV-1a) of the options, the same on every host
+  static std::uint64_t hash(const std::string& options);
+};
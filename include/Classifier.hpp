@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <vector>
+
+enum class EventClass
+{
+  Empty      = 0,
+  Avalanche  = 1,
+  Streamer   = 2,
+  NoiseBurst = 3,
+};
+
+// Tag each chamber of each event as empty, avalanche, streamer or noise burst from a small feature vector
+// (number of hits, largest amplitude, total charge, largest sigma after/before ratio, time spread of the hits).
+// The features are stored by batches (one array by feature) and scored together at the end of the batch.
+// Default model : cuts (noise ratio, streamer charge). A linear model can be loaded from a text file with one
+// line by class "<empty|avalanche|streamer|noise> w_hits w_amplitude w_charge w_ratio w_spread bias" (# for
+// comments), the class with the highest score wins.
+class Classifier
+{
+public:
+  static constexpr std::size_t NbrFeatures{5};
+  static constexpr std::size_t NbrClasses{4};
+  Classifier(const std::size_t& chambers, const double& noiseRatio = 5.0, const double& streamerCharge = 10.0, const std::size_t& batch = 256);
+  void               load(const std::string& filename);
+  bool               isLinear() const { return m_Linear; }
+  // Per event filling
+  void               addChannel(const int& chamber, const double& amplitude, const double& sigmaRatio);
+  void               addHit(const int& chamber, const double& charge, const double& time);
+  void               endEvent();
+  // Score the events still in the batch
+  void               flush();
+  std::uint64_t      getCount(const std::size_t& chamber, const EventClass& type) const { return m_Counts[chamber][static_cast<std::size_t>(type)]; }
+  std::uint64_t      getEvents() const { return m_Events; }
+  std::size_t        getNumberChambers() const { return m_Chambers; }
+  static std::string toString(const EventClass& type);
+  // Counts for the checkpoints (the events waiting in the batch are scored first), restored into a classifier
+  // made with the same number of chambers
+  void               save(std::ostream& stream);
+  void               restore(std::istream& stream);
+
+private:
+  enum Feature
+  {
+    Hits      = 0,
+    Amplitude = 1,
+    Charge    = 2,
+    Ratio     = 3,
+    Spread    = 4,
+  };
+  struct Current
+  {
+    double Hits{0};
+    double Amplitude{0};
+    double Charge{0};
+    double Ratio{0};
+    // Times of the hits with a constant fraction time (none : TimeMin > TimeMax)
+    double TimeMin{std::numeric_limits<double>::max()};
+    double TimeMax{std::numeric_limits<double>::lowest()};
+  };
+  void                                       score();
+  std::size_t                                m_Chambers{0};
+  double                                     m_NoiseRatio{5.0};
+  double                                     m_StreamerCharge{10.0};
+  std::size_t                                m_Batch{256};
+  bool                                       m_Linear{false};
+  std::array<std::array<double, NbrFeatures + 1>, NbrClasses> m_Weights{};
+  std::vector<Current>                       m_Current;
+  // m_Features[feature][row], row = event in batch * chambers + chamber
+  std::array<std::vector<double>, NbrFeatures> m_Features;
+  std::vector<double>                        m_Scores;
+  std::vector<double>                        m_Best;
+  std::vector<unsigned char>                 m_Classes;
+  std::size_t                                m_Rows{0};
+  std::vector<std::array<std::uint64_t, NbrClasses>> m_Counts;
+  std::uint64_t                              m_Events{0};
+};
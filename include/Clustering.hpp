@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Histogram.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+struct Cluster
+{
+  int    Chamber{-1};
+  int    FirstStrip{-1};
+  int    Size{0};
+  // Time of the earliest hit of the cluster (ticks)
+  double Time{0};
+};
+
+// Build the strip clusters of each chamber event by event : fired strips with consecutive numbers and
+// hit times within the coincidence window of the cluster are merged.
+// The hit and cluster buffers have a fixed capacity (number of strips of the chamber) so nothing is
+// allocated in the event loop.
+class ClusterBuilder
+{
+public:
+  // strips[chamber] : strip numbers connected to the chamber, window and timeMax (end of the time histograms) in ticks
+  ClusterBuilder(const std::vector<std::vector<int>>& strips, const double& window = 10.0, const double& timeMax = 1024.0);
+  // Time histograms over the record (ticks), before the first event
+  void                  setRecordLength(const std::size_t& length);
+  void                  addHit(const int& chamber, const int& strip, const double& time);
+  // Build the clusters of the event, fill the histograms and prepare the next event
+  void                  endEvent();
+  // Clusters of the last event closed by endEvent()
+  std::size_t           getNumberClusters(const std::size_t& chamber) const { return m_Chambers[chamber].NbrClusters; }
+  const Cluster&        getCluster(const std::size_t& chamber, const std::size_t& i) const { return m_Chambers[chamber].Clusters[i]; }
+  std::size_t           getNumberChambers() const { return m_Chambers.size(); }
+  std::size_t           getEvents() const { return m_Events; }
+  // Hits not stored because the buffer of the chamber was full (same strip given twice)
+  std::size_t           getLostHits() const { return m_LostHits; }
+  const Histogram&      getClusterSize(const std::size_t& chamber) const { return m_Chambers[chamber].Size; }
+  const Histogram&      getClusterNumber(const std::size_t& chamber) const { return m_Chambers[chamber].Number; }
+  const Histogram&      getClusterTime(const std::size_t& chamber) const { return m_Chambers[chamber].Time; }
+  const Histogram&      getStripHits(const std::size_t& chamber) const { return m_Chambers[chamber].Strips; }
+  // State between two events (checkpoints), restored into a builder made with the same strips
+  void                  save(std::ostream& stream) const;
+  void                  restore(std::istream& stream);
+
+private:
+  struct Hit
+  {
+    int    Strip{-1};
+    double Time{0};
+  };
+  struct Chamber
+  {
+    std::vector<Hit>     Hits;
+    std::size_t          NbrHits{0};
+    std::vector<Cluster> Clusters;
+    std::size_t          NbrClusters{0};
+    Histogram            Size;
+    Histogram            Number;
+    Histogram            Time;
+    Histogram            Strips;
+  };
+  void                 build(const int& chamber, Chamber& data);
+  std::vector<Chamber> m_Chambers;
+  double               m_Window{10.0};
+  std::size_t          m_Events{0};
+  std::size_t          m_LostHits{0};
+};
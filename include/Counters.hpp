@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Hardware counters of the calling thread (user space only) read with perf_event_open on Linux, all in one group
+// so one read gives all of them. The counters the kernel refuses (perf_event_paranoid, virtual machines, other
+// systems) are unavailable, the time is always measured.
+class PerfCounters
+{
+public:
+  enum Counter : std::size_t
+  {
+    Cycles,
+    Instructions,
+    CacheMisses,
+    BranchMisses,
+    NbrCounters
+  };
+  struct Values
+  {
+    std::array<std::uint64_t, NbrCounters> Counts{};
+    double                                 Seconds{0};
+  };
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  // Counts since the construction (scaled if the kernel multiplexed the counters), only the differences of the
+  // seconds make sense
+  Values             read() const;
+  bool               isAvailable() const { return m_Leader >= 0; }
+  bool               isAvailable(const Counter& counter) const { return m_Descriptors[counter] >= 0; }
+  // Why the counters (or some of them) are not available
+  const std::string& getError() const { return m_Error; }
+  static std::string getName(const Counter& counter);
+
+private:
+  std::array<int, NbrCounters> m_Descriptors{-1, -1, -1, -1};
+  int                          m_Leader{-1};
+  // Position of each counter in the group read
+  std::array<std::size_t, NbrCounters> m_Slots{};
+  std::size_t                  m_Opened{0};
+  std::string                  m_Error;
+};
+
+// Time and hardware counters of the stages of a processing summed by stage and by thread. Each thread measures
+// with its own StageClock and adds what it counted to the profile (protected by a mutex).
+class StageProfile
+{
+public:
+  struct Sums
+  {
+    std::uint64_t                                        Calls{0};
+    double                                               Seconds{0};
+    std::array<std::uint64_t, PerfCounters::NbrCounters> Counts{};
+  };
+  explicit StageProfile(const std::vector<std::string>& stages = {}) : m_Stages(stages) {}
+  std::size_t        addStage(const std::string& name);
+  void               add(const std::size_t& stage, const std::size_t& thread, const PerfCounters::Values& difference);
+  // Counters opened by a thread measuring, a counter is reported only if all the threads have it
+  void               setAvailable(const PerfCounters& counters);
+  Sums               getSums(const std::size_t& stage) const;
+  std::size_t        getNumberStages() const { return m_Stages.size(); }
+  const std::string& getStage(const std::size_t& stage) const { return m_Stages[stage]; }
+  // Table of the stages (all threads) then of each stage by thread, rates by event and by sample
+  std::string        report(const std::uint64_t& events, const std::uint64_t& samples) const;
+
+private:
+  std::vector<std::string>                              m_Stages;
+  std::map<std::pair<std::size_t, std::size_t>, Sums>   m_Sums;
+  std::array<bool, PerfCounters::NbrCounters>           m_Available{true, true, true, true};
+  std::string                                           m_Error;
+  mutable std::mutex                                    m_Mutex;
+};
+
+// Stages run one after the other by one thread : each lap adds to the stage what was counted since the previous
+// lap (or restart). Without profile nothing is opened nor measured.
+class StageClock
+{
+public:
+  explicit StageClock(StageProfile* profile = nullptr, const std::size_t& thread = 0);
+  bool isEnabled() const { return m_Profile != nullptr; }
+  void restart()
+  {
+    if(m_Profile != nullptr) m_Last = m_Counters->read();
+  }
+  void lap(const std::size_t& stage);
+
+private:
+  StageProfile*                 m_Profile{nullptr};
+  std::size_t                   m_Thread{0};
+  std::unique_ptr<PerfCounters> m_Counters;
+  PerfCounters::Values          m_Last;
+};
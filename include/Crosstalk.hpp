@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+// Common mode noise removal : each channel of a group gets its common mode, the median of the group at each
+// sample, subtracted with its own weight (regression coefficient of the channel on the group mean, from the
+// covariance matrix). The median keeps a pulse on one strip out of the common mode of the others.
+class CommonMode
+{
+public:
+  CommonMode() = default;
+  CommonMode(const std::vector<std::vector<std::size_t>>& groups, const std::vector<double>& weights);
+  // data[channel] : waveform of each channel (nullptr if not in the event), all with the same length
+  void                       apply(const std::vector<double*>& data, const std::size_t& length);
+  bool                       isEnabled() const { return !m_Groups.empty(); }
+  double                     getWeight(const std::size_t& channel) const { return m_Weights[channel]; }
+
+private:
+  std::vector<std::vector<std::size_t>> m_Groups;
+  std::vector<double>                   m_Weights;
+  std::vector<double>                   m_Values;
+};
+
+// Channel x channel covariance of the noise window samples and hit coincidences, accumulated in one pass.
+// The noise samples of the events are stored in a batch (one row by sample, one column by channel) and the
+// covariance is updated by blocks of 4 rows (rank-4 updates of the upper triangle, the inner loop over the
+// channels vectorises) when the batch is full, so the main loop only copies the samples.
+class Crosstalk
+{
+public:
+  // samples : length of the noise window, batch : events by update
+  Crosstalk(const std::size_t& channels, const std::size_t& samples, const std::size_t& batch = 16);
+  // Noise window data[begin, begin + samples[ of the channel in the current event
+  void          addNoise(const std::size_t& channel, const double* data, const std::size_t& length, const std::size_t& begin);
+  void          addHit(const std::size_t& channel);
+  // Events without the noise of all the channels only count for the hits
+  void          endEvent();
+  // Update with the events waiting in the batch
+  void          finish();
+  std::size_t   getNumberChannels() const { return m_Channels; }
+  std::uint64_t getEvents() const { return m_Events; }
+  std::uint64_t getNoiseEvents() const { return m_NoiseEvents; }
+  double        getCovariance(const std::size_t& i, const std::size_t& j) const;
+  double        getCorrelation(const std::size_t& i, const std::size_t& j) const;
+  std::uint64_t getHits(const std::size_t& channel) const { return m_Hits[channel]; }
+  std::uint64_t getCoincidences(const std::size_t& i, const std::size_t& j) const { return m_Coincidences[i * m_Channels + j]; }
+  // Probability of a hit on j in the events with a hit on i
+  double        getConditional(const std::size_t& j, const std::size_t& i) const { return m_Hits[i] == 0 ? 0 : static_cast<double>(getCoincidences(i, j)) / m_Hits[i]; }
+  // Weights of the common mode of each group (covariance of the channel with the group mean / variance of the mean)
+  CommonMode    getCommonMode(const std::vector<std::vector<std::size_t>>& groups) const;
+  // State between two events (checkpoints) with the events waiting in the batch, so the updates are made on the
+  // same blocks of rows as without interruption. Restored into a matrix made with the same options.
+  void          save(std::ostream& stream) const;
+  void          restore(std::istream& stream);
+
+private:
+  void                       update();
+  std::size_t                m_Channels{0};
+  std::size_t                m_Samples{0};
+  std::size_t                m_BatchEvents{16};
+  // Batch : (event x sample) rows of m_Channels values
+  std::vector<double>        m_Batch;
+  std::size_t                m_BatchSize{0};
+  std::vector<std::uint8_t>  m_Present;
+  std::size_t                m_NbrPresent{0};
+  std::vector<std::size_t>   m_EventHits;
+  // Sums of x_i x_j (upper triangle used) and of x_i over all the rows
+  std::vector<double>        m_Products;
+  std::vector<double>        m_Sums;
+  std::uint64_t              m_Rows{0};
+  std::uint64_t              m_Events{0};
+  std::uint64_t              m_NoiseEvents{0};
+  std::vector<std::uint64_t> m_Hits;
+  std::vector<std::uint64_t> m_Coincidences;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Processing of the runs by several processes (local or on other hosts) over TCP.
+// The coordinator holds the list of tasks, the workers connect to it and loop on : READY -> TASK -> RESULT.
+// A task held by a worker which disconnects, exceeds the timeout, stalls in the middle of a message or sends a
+// malformed result is put back in the queue and given to another worker, only the first result received for a
+// task is kept. A worker which can't process its task answers FAILED instead of RESULT : the task is not given
+// again (another worker would fail the same way), it is reported as failed.
+// Messages are "<TYPE> <length>\n<payload>" with TYPE one of READY, TASK, RESULT, FAILED, DONE.
+
+// Part of a run : the events [First, First + Events[ of the run made by Files (Events = 0 : up to the end)
+struct Task
+{
+  std::size_t              ID{0};
+  std::size_t              Run{0};
+  std::int64_t             First{0};
+  std::int64_t             Events{0};
+  std::vector<std::string> Files;
+  bool                     isChunk() const { return First != 0 || Events != 0; }
+  std::string              serialize() const;
+  static Task              deserialize(const std::string& task);
+};
+
+class Coordinator
+{
+public:
+  // port 0 : any free port (see getPort), timeout (s) : maximum time a worker can hold a task (0 : no limit),
+  // idle (s) : give up when no worker is connected during this time while tasks remain, receive (s) : maximum
+  // wait for the rest of a message once it started (the worker is lost after it)
+  explicit Coordinator(const unsigned short& port = 0, const double& timeout = 0, const double& idle = 60, const double& receive = 10);
+  ~Coordinator();
+  Coordinator(const Coordinator&) = delete;
+  Coordinator&   operator=(const Coordinator&) = delete;
+  unsigned short getPort() const { return m_Port; }
+  void           addTask(const Task& task);
+  // Serve the tasks until all the results are received, result (or failed with the reason given by the worker) is
+  // called once by task (in the calling thread)
+  void           run(const std::function<void(const Task&, const std::string&)>& result, const std::function<void(const Task&, const std::string&)>& failed = nullptr);
+  std::size_t    getReassigned() const { return m_Reassigned; }
+  std::size_t    getFailed() const { return m_Failed; }
+  std::size_t    getWorkers() const { return m_Workers; }
+
+private:
+  struct Peer
+  {
+    std::intptr_t                         Handle{-1};
+    std::size_t                           Task{0};
+    bool                                  Busy{false};
+    bool                                  Waiting{false};
+    std::chrono::steady_clock::time_point Since;
+  };
+  void                    drop(const std::size_t& peer);
+  void                    serve(Peer& peer);
+  std::intptr_t           m_Listener{-1};
+  unsigned short          m_Port{0};
+  double                  m_Timeout{0};
+  double                  m_Idle{60};
+  double                  m_Receive{10};
+  std::vector<Task>       m_Tasks;
+  std::vector<bool>       m_Done;
+  std::deque<std::size_t> m_Pending;
+  std::vector<Peer>       m_Peers;
+  std::size_t             m_Reassigned{0};
+  std::size_t             m_Failed{0};
+  std::size_t             m_Workers{0};
+};
+
+class Worker
+{
+public:
+  Worker(const std::string& host, const unsigned short& port);
+  ~Worker();
+  Worker(const Worker&) = delete;
+  Worker& operator=(const Worker&) = delete;
+  // Ask for a task, false when the coordinator has nothing left
+  bool    next(Task& task);
+  void    send(const Task& task, const std::string& result);
+  // The task can't be processed (files missing, ...)
+  void    fail(const Task& task, const std::string& reason);
+
+private:
+  std::intptr_t m_Handle{-1};
+};
@@ -12,6 +12,8 @@ class Event: public TObject
   Event()=default;
   void                 addChannel(const Channel& ch);
   void                 clear();
+  // Copy everything but the channels (EventSize excepted)
+  void                 copyHeader(const Event& event);
   double               BoardID{0};
   int                  EventNumber{0};
   int                  Pattern{0};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Event.hpp"
+#include "RawReader.hpp"
+#include "RtypesCore.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+
+// Merge the runs written by several digitizer boards into one stream of Events.
+// Each board file is read entry by entry (only one Event per board is held in memory),
+// the heads are aligned on their unwrapped TriggerTimeTag and the ones falling inside
+// the coincidence window are concatenated (board order) into a single Event.
+// With only one file the events are passed through unchanged.
+// Files written with one branch by channel (see EventWriter) can be read selectively : after setChannels only the
+// requested channels are decompressed and deserialised, the others are left empty in Event::Channels (their
+// position in the vector is kept so the channel numbering doesn't change).
+// Raw digitizer files (see RawReader) are read directly, without the conversion to ROOT : they are recognised by
+// their first event header and give the same Events as the ROOT files (ADC counts, the channels of the groups not
+// read empty), their channels not requested by setChannels are not decoded.
+class EventBuilder
+{
+public:
+  EventBuilder(const std::vector<std::string>& files, const std::string& treeName = "Tree", const double& window = 2, const unsigned int& rolloverBits = 30);
+  ~EventBuilder();
+  EventBuilder(const EventBuilder&) = delete;
+  EventBuilder& operator=(const EventBuilder&) = delete;
+  // Fill event with the next built event, return false when one of the boards is exhausted
+  bool     next(Event& event);
+  // Skip the next events (a single board jumps directly, several boards need the coincidences), return the number skipped
+  Long64_t skip(const Long64_t& events);
+  // Maximum number of events which can be built (the smallest run)
+  Long64_t getEntries() const;
+  // Number of board events dropped because no coincidence was found
+  Long64_t getDropped() const { return m_Dropped; }
+  Long64_t getBuilt() const { return m_Built; }
+  std::size_t getNumberBoards() const { return m_Boards.size(); }
+  // Channels (index in the built Event) to decode, empty to decode all of them. Only files with one branch by
+  // channel are concerned, the ones with a single Events branch are always fully decoded.
+  void        setChannels(const std::vector<int>& channels);
+  // Samples of the channels of the raw files given as 12 bits codes in Channel::Codes instead of Data (the trigger
+  // channels and the ROOT files are not concerned)
+  void        setCodes(const bool& codes);
+  // Number of boards for which the unused channels are not decoded
+  std::size_t getNumberSelectiveBoards() const;
+  // Read cache (bytes) shared by the boards, the compressed baskets of the coming entries are kept in it
+  void        setCacheSize(const Long64_t& bytes);
+  Long64_t    getCacheSize() const { return m_CacheSize; }
+
+private:
+  struct Board
+  {
+    std::string                Name;
+    std::unique_ptr<TFile>     File;
+    std::unique_ptr<RawReader> Raw;
+    RawEvent                   RawBuffer;
+    TTree*                     Tree{nullptr};
+    Event*                     Buffer{nullptr};
+    // Layout with one branch by channel
+    bool                       PerChannel{false};
+    std::vector<Channel*>      Channels;
+    std::vector<bool>          Needed;
+    Long64_t                   Entry{-1};
+    Long64_t                   Entries{0};
+    double                     LastTag{0};
+    double                     Offset{0};
+    double                     Time{0};
+    bool                       Valid{false};
+  };
+  bool               advance(Board& board);
+  void               fromRaw(Board& board);
+  std::vector<Board> m_Boards;
+  double             m_Window{2};
+  double             m_Rollover{0};
+  Long64_t           m_Dropped{0};
+  Long64_t           m_Built{0};
+  Long64_t           m_CacheSize{-1};
+};
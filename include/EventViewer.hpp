@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Channel.hpp"
+#include "TArrow.h"
+#include "TCanvas.h"
+#include "TGraph.h"
+#include "TH1F.h"
+#include "TPad.h"
+#include "TPaveLabel.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+// Event display of a chamber : one pad by channel with its waveform, the signal region, the minimum and the noise
+// arrows. The graphic objects of a channel are kept and reused for each event, nothing is allocated by event.
+class EventViewer
+{
+public:
+  // The canvas is created the first time it is used (no graphics for the jobs which don't display the events)
+  EventViewer(const std::string& name = "", const std::string& title = "") : m_Name(name), m_Title(title) {}
+  void        setPaveLabel(const std::string& title);
+  void        setCanvasName(const std::string& title);
+  void        setCanvasTitle(const std::string& title);
+  void        divide(const int& div);
+  void        cd(const int& id);
+  void        cdNext();
+  void        reset() { m_cd = 0; }
+  void        saveAs(const std::string& filename);
+  static void setPeriod(const double& period) { m_Period = period; }
+  // Waveform of the channel plotted under the number given
+  void        createWaveForm(const int& number, const Channel& channel);
+  void        UnderlineSignalRegion(const int& channel, const Color_t& color, const double& min, const double& max);
+  TH1F&       getPlot(const int& channel) { return m_ChannelPlot[channel]; }
+  TGraph&     getMarker(const int& channel, const double& x, const double& y);
+  TArrow&     getArrow(const int& channel, const int& index, const double& x1, const double& y1, const double& x2, const double& y2);
+
+private:
+  void                                  create();
+  std::string                           m_Name;
+  std::string                           m_Title;
+  int                                   m_Division{0};
+  TCanvas*                              m_Canvas{nullptr};
+  TPad*                                 m_Pad{nullptr};
+  TPaveLabel*                           m_PaveLabel{nullptr};
+  std::map<int, TH1F>                   m_ChannelPlot;
+  std::map<int, TH1F>                   m_SignalPlot;
+  std::map<int, TGraph>                 m_Markers;
+  std::map<std::pair<int, int>, TArrow> m_Arrows;
+  std::string                           m_PaveTitle;
+  static int                            m_CanvasX;
+  static int                            m_CanvasY;
+  static int                            m_PositionCanvasX;
+  static int                            m_PositionCanvasY;
+  static double                         m_Period;
+  int                                   m_cd{0};
+};
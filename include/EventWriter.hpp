@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Event.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+
+// Write Events in a TTree with one of the two layouts read by EventBuilder :
+//  - Object : one "Events" branch holding the whole Event (what the DAQ writes),
+//  - PerChannel : one "Header." branch (the Event without its channels) and one "Channel<i>." branch by channel,
+//    a reader needing only some channels then decompresses and deserialises only those branches. With the
+//    default split level each member is stored in its own sub-branch ("Header.TriggerTimeTag", "Channel3.Data"...)
+//    so the tree is fully columnar.
+class EventWriter
+{
+public:
+  enum class Layout
+  {
+    Object,
+    PerChannel,
+  };
+  // compression : ROOT setting (algorithm * 100 + level, 404 = LZ4 level 4), basketSize in bytes
+  EventWriter(const std::string& filename, const Layout& layout = Layout::Object, const std::string& treeName = "Tree", const int& compression = 101, const int& basketSize = 32000, const int& splitLevel = 99);
+  ~EventWriter();
+  EventWriter(const EventWriter&) = delete;
+  EventWriter& operator=(const EventWriter&) = delete;
+  // With the PerChannel layout all the events must have the number of channels of the first one
+  void               fill(const Event& event);
+  // Write the tree and close the file (called by the destructor)
+  void               close();
+  // Number of entries by cluster (the baskets of all the branches are flushed together), 0 for ROOT default
+  void               setClusterSize(const Long64_t& entries);
+  Long64_t           getEntries() const { return m_Entries; }
+  Layout             getLayout() const { return m_Layout; }
+  static Layout      fromString(const std::string& layout);
+  static std::string toString(const Layout& layout);
+
+private:
+  std::unique_ptr<TFile> m_File;
+  TTree*                 m_Tree{nullptr};
+  Layout                 m_Layout{Layout::Object};
+  int                    m_BasketSize{32000};
+  int                    m_SplitLevel{99};
+  Event                  m_Header;
+  // Points to the event being filled (to m_Header before, so ROOT doesn't allocate one)
+  Event*                 m_Event{&m_Header};
+  Event*                 m_HeaderPointer{&m_Header};
+  std::vector<Channel*>  m_Channels;
+  Long64_t               m_Entries{0};
+};
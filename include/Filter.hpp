@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// In place digital filters applied on the baseline subtracted waveforms before the features are extracted.
+// All the channels of one event are filtered together : apply() takes the data pointers of the analysed channels
+// (same record length). The FIR and moving average are centred (no time shift), the IIR low-pass is run forward
+// and backward (zero phase) so the signal stays in the same window as without filter.
+// The scratch buffers are kept in the object : no allocation once the first event has been processed.
+class Filter
+{
+public:
+  enum class Type
+  {
+    None,
+    MovingAverage,
+    FIR,
+    IIR,
+  };
+  Filter() = default;
+  static Filter      MovingAverage(const std::size_t& width);
+  // y[n] = sum_k h[k] x[n-(K-1)/2+k] : correlation with the coefficients, a pulse template gives the matched filter
+  static Filter      FIR(const std::vector<double>& coefficients);
+  // First order low-pass y[n] = y[n-1] + alpha * (x[n] - y[n-1]), 0 < alpha <= 1
+  static Filter      IIR(const double& alpha);
+  static Filter      fromString(const std::string& type, const std::size_t& width, const std::vector<double>& coefficients, const double& alpha);
+  static std::string toString(const Type& type);
+  Type               getType() const { return m_Type; }
+  bool               isEnabled() const { return m_Type != Type::None; }
+  void               apply(double* data, const std::size_t& length);
+  void               apply(const std::vector<double*>& channels, const std::size_t& length);
+  void               apply(std::vector<double>& data) { apply(data.data(), data.size()); }
+
+private:
+  void                movingAverage(double* data, const std::size_t& length);
+  void                fir(double* data, const std::size_t& length);
+  void                iir(const std::vector<double*>& channels, const std::size_t& begin, const std::size_t& end, const std::size_t& length);
+  void                pad(const double* data, const std::size_t& length, const std::size_t& before, const std::size_t& after);
+  Type                m_Type{Type::None};
+  std::vector<double> m_Coefficients;
+  std::size_t         m_Width{1};
+  double              m_Alpha{1.0};
+  std::vector<double> m_Padded;
+  std::vector<double> m_Block;
+  // Number of output samples computed together by the FIR (fits in L1 with the taps)
+  static constexpr std::size_t m_BlockSize{256};
+  // Number of channels interleaved together by the IIR (one SIMD lane per channel)
+  static constexpr std::size_t m_Lanes{8};
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Fixed binning 1D histogram with integer counts. Filling never allocates and two histograms with the same
+// binning can be merged exactly (the counts do not depend on the filling order).
+// Converted to ROOT histograms only when the plots are produced.
+class Histogram
+{
+public:
+  Histogram(const std::size_t& bins = 1, const double& min = 0, const double& max = 1, const std::string& name = "", const std::string& title = "");
+  void fill(const double& x, const std::uint64_t& weight = 1)
+  {
+    // NaN goes in the underflow
+    if(!(x >= m_Min)) m_Underflow += weight;
+    else if(x >= m_Max)
+      m_Overflow += weight;
+    else
+      m_Counts[std::min(static_cast<std::size_t>((x - m_Min) * m_InvWidth), m_Counts.size() - 1)] += weight;
+    m_Entries += weight;
+  }
+  void                        add(const Histogram& other);
+  void                        reset();
+  std::size_t                 getNbins() const { return m_Counts.size(); }
+  double                      getMin() const { return m_Min; }
+  double                      getMax() const { return m_Max; }
+  double                      getBinLowEdge(const std::size_t& bin) const { return m_Min + bin / m_InvWidth; }
+  double                      getBinCenter(const std::size_t& bin) const { return m_Min + (bin + 0.5) / m_InvWidth; }
+  std::uint64_t               getBinContent(const std::size_t& bin) const { return m_Counts[bin]; }
+  const std::vector<std::uint64_t>& getCounts() const { return m_Counts; }
+  std::uint64_t               getUnderflow() const { return m_Underflow; }
+  std::uint64_t               getOverflow() const { return m_Overflow; }
+  std::uint64_t               getEntries() const { return m_Entries; }
+  // Mean computed from the bin centres (underflow and overflow excluded)
+  double                      getMean() const;
+  const std::string&          getName() const { return m_Name; }
+  const std::string&          getTitle() const { return m_Title; }
+  // Exact text serialisation (to send the partial histograms between processes)
+  void                        write(std::ostream& stream) const;
+  static Histogram            read(std::istream& stream);
+
+private:
+  std::string                m_Name;
+  std::string                m_Title;
+  double                     m_Min{0};
+  double                     m_Max{1};
+  double                     m_InvWidth{1};
+  std::vector<std::uint64_t> m_Counts;
+  std::uint64_t              m_Underflow{0};
+  std::uint64_t              m_Overflow{0};
+  std::uint64_t              m_Entries{0};
+};
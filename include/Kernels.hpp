@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+// Waveform kernels specialised at compile time on the record length (N) and on the polarity (Sign = -1 or +1).
+// N = 0 is the generic version using the length given at runtime. The windows are clamped once to the record
+// so the loops don't check the bounds sample by sample, and the sums use independent accumulators so they can
+// be vectorised (the last bits can differ from a plain sequential sum).
+// The window layout is not a template parameter : the noise windows come from the command line and the signal
+// window moves with the trigger tick and the learnt delay of each event, so none of them is known at compile
+// time. Clamping them once by call keeps the inner loops free of bound checks, which is the gain a compile time
+// layout would give, without one instantiation by setting.
+namespace Kernels
+{
+constexpr std::size_t Lanes{4};
+
+// Mean and standard deviation (n-1) of the samples in [first,second] (inclusive, like MeanSTD)
+template<std::size_t N> std::pair<double, double> meanSigma(const double* data, const std::size_t& length, const double& first, const double& second)
+{
+  const std::size_t size{N == 0 ? length : N};
+  if(size == 0 || second < 0 || first > static_cast<double>(size - 1)) return {std::nan(""), std::nan("")};
+  const std::size_t begin{first <= 0 ? 0 : static_cast<std::size_t>(std::ceil(first))};
+  const std::size_t end{std::min(size - 1, static_cast<std::size_t>(std::floor(second))) + 1};
+  if(end <= begin) return {std::nan(""), std::nan("")};
+  const std::size_t n{end - begin};
+  const double*     x{data + begin};
+  // Tails from a block count (as in baseline) : the compiler sees their bounds when the window is a constant
+  const std::size_t blocks{n - n % Lanes};
+  double            sum[Lanes]{};
+  for(std::size_t i = 0; i != blocks; i += Lanes)
+    for(std::size_t l = 0; l != Lanes; ++l) sum[l] += x[i + l];
+  for(std::size_t i = blocks; i != n; ++i) sum[0] += x[i];
+  const double mean{((sum[0] + sum[1]) + (sum[2] + sum[3])) / n};
+  double       square[Lanes]{};
+  for(std::size_t i = 0; i != blocks; i += Lanes)
+    for(std::size_t l = 0; l != Lanes; ++l) square[l] += (x[i + l] - mean) * (x[i + l] - mean);
+  for(std::size_t i = blocks; i != n; ++i) square[0] += (x[i] - mean) * (x[i] - mean);
+  return {mean, std::sqrt(((square[0] + square[1]) + (square[2] + square[3])) / (n - 1))};
+}
+
+// Extremum (minimum for Sign=-1, maximum for Sign=+1) and its first tick in [begin,end[ (same conventions as getMinMax)
+template<int Sign, std::size_t N> std::pair<double, int> extremum(const double* data, const std::size_t& length, const int& begin = -1, const int& end = -1)
+{
+  const std::size_t size{N == 0 ? length : N};
+  const std::size_t first{begin > 0 ? static_cast<std::size_t>(begin) : 0};
+  const std::size_t last{(end != -1 && end >= 0 && static_cast<std::size_t>(end) <= size) ? static_cast<std::size_t>(end) : size};
+  if(first >= last) return {Sign < 0 ? std::numeric_limits<double>::max() : std::numeric_limits<double>::lowest(), 0};
+  // Work on Sign*x so both polarities look for a maximum
+  double            best[Lanes];
+  const std::size_t blocks{last - (last - first) % Lanes};
+  std::fill(best, best + Lanes, std::numeric_limits<double>::lowest());
+  for(std::size_t i = first; i != blocks; i += Lanes)
+    for(std::size_t l = 0; l != Lanes; ++l) best[l] = std::max(best[l], Sign * data[i + l]);
+  for(std::size_t i = blocks; i != last; ++i) best[0] = std::max(best[0], Sign * data[i]);
+  const double value{std::max(std::max(best[0], best[1]), std::max(best[2], best[3]))};
+  std::size_t  tick{first};
+  while(tick != last && Sign * data[tick] != value) ++tick;
+  return {Sign * value, static_cast<int>(tick == last ? first : tick)};
+}
+
+// Subtract the mean of the whole record (SupressBaseLine)
+template<std::size_t N> void baseline(double* data, const std::size_t& length)
+{
+  const std::size_t size{N == 0 ? length : N};
+  if(size == 0) return;
+  const std::size_t blocks{size - size % Lanes};
+  double            sum[Lanes]{};
+  for(std::size_t i = 0; i != blocks; i += Lanes)
+    for(std::size_t l = 0; l != Lanes; ++l) sum[l] += data[i + l];
+  for(std::size_t i = blocks; i != size; ++i) sum[0] += data[i];
+  const double mean{((sum[0] + sum[1]) + (sum[2] + sum[3])) / size};
+  for(std::size_t i = 0; i != size; ++i) data[i] -= mean;
+}
+
+// Reduced precision versions working on the 12 bits ADC codes kept as int16 : 8 samples by SSE register instead of
+// 2 doubles and a quarter of the memory traffic. The sums are exact integers (int32 on blocks of CodeBlock samples,
+// which can't overflow for codes below 4096, int64 across the blocks) and only the results are converted to double.
+constexpr std::size_t CodeBlock{64};
+constexpr std::size_t CodeLanes{16};
+
+// Codes of the samples (ADC counts stored as double) and their sum (the baseline is sum/length), false if one of the
+// samples is not an integer in [0,4095]
+bool toCodes(const double* data, const std::size_t& length, std::int16_t* codes, std::int64_t& sum);
+
+// Sum of x-origin and, if Squares, of (x-origin)^2 over n codes
+template<bool Squares> std::pair<std::int64_t, std::int64_t> codeSums(const std::int16_t* x, const std::size_t& n, const std::int32_t& origin)
+{
+  std::int64_t      sum{0};
+  std::int64_t      square{0};
+  const std::size_t blocks{n - n % CodeBlock};
+  for(std::size_t i = 0; i != blocks; i += CodeBlock)
+  {
+    std::int32_t blockSum{0};
+    std::int32_t blockSquare{0};
+    for(std::size_t j = 0; j != CodeBlock; ++j)
+    {
+      const std::int32_t d{x[i + j] - origin};
+      blockSum += d;
+      if(Squares) blockSquare += d * d;
+    }
+    sum += blockSum;
+    square += blockSquare;
+  }
+  for(std::size_t i = blocks; i != n; ++i)
+  {
+    const std::int64_t d{x[i] - origin};
+    sum += d;
+    if(Squares) square += d * d;
+  }
+  return {sum, square};
+}
+
+// meanSigma on the codes : the sums are taken around the first code of the window so the variance is computed
+// from exact integers (no cancellation)
+template<std::size_t N> std::pair<double, double> meanSigma(const std::int16_t* codes, const std::size_t& length, const double& first, const double& second)
+{
+  const std::size_t size{N == 0 ? length : N};
+  if(size == 0 || second < 0 || first > static_cast<double>(size - 1)) return {std::nan(""), std::nan("")};
+  const std::size_t begin{first <= 0 ? 0 : static_cast<std::size_t>(std::ceil(first))};
+  const std::size_t end{std::min(size - 1, static_cast<std::size_t>(std::floor(second))) + 1};
+  if(end <= begin) return {std::nan(""), std::nan("")};
+  const std::size_t                           n{end - begin};
+  const std::int32_t                          origin{codes[begin]};
+  const std::pair<std::int64_t, std::int64_t> sums{codeSums<true>(codes + begin, n, origin)};
+  const double                                sum{static_cast<double>(sums.first)};
+  return {origin + sum / n, std::sqrt((static_cast<double>(sums.second) - sum * sum / n) / (n - 1))};
+}
+
+// extremum on the codes (value in ADC counts)
+template<int Sign, std::size_t N> std::pair<int, int> extremum(const std::int16_t* codes, const std::size_t& length, const int& begin = -1, const int& end = -1)
+{
+  const std::size_t size{N == 0 ? length : N};
+  const std::size_t first{begin > 0 ? static_cast<std::size_t>(begin) : 0};
+  const std::size_t last{(end != -1 && end >= 0 && static_cast<std::size_t>(end) <= size) ? static_cast<std::size_t>(end) : size};
+  if(first >= last) return {Sign < 0 ? std::numeric_limits<int>::max() : std::numeric_limits<int>::lowest(), 0};
+  std::int16_t      best[CodeLanes];
+  const std::size_t blocks{last - (last - first) % CodeLanes};
+  std::fill(best, best + CodeLanes, std::numeric_limits<std::int16_t>::lowest());
+  for(std::size_t i = first; i != blocks; i += CodeLanes)
+    for(std::size_t l = 0; l != CodeLanes; ++l) best[l] = std::max(best[l], static_cast<std::int16_t>(Sign * codes[i + l]));
+  for(std::size_t i = blocks; i != last; ++i) best[0] = std::max(best[0], static_cast<std::int16_t>(Sign * codes[i]));
+  const int   value{*std::max_element(best, best + CodeLanes)};
+  std::size_t tick{first};
+  while(tick != last && Sign * codes[tick] != value) ++tick;
+  return {Sign * value, static_cast<int>(tick == last ? first : tick)};
+}
+
+// Mean of the whole record in codes (what baseline subtracts)
+template<std::size_t N> double mean(const std::int16_t* codes, const std::size_t& length)
+{
+  const std::size_t size{N == 0 ? length : N};
+  if(size == 0) return std::nan("");
+  return static_cast<double>(codeSums<false>(codes, size, 0).first) / size;
+}
+
+// Set of kernels chosen once from the record length of the first event, the generic (N=0) ones are used
+// when no specialisation exists or when a channel doesn't have the expected length.
+class Dispatcher
+{
+public:
+  using MeanSigma = std::pair<double, double> (*)(const double*, const std::size_t&, const double&, const double&);
+  using Extremum  = std::pair<double, int> (*)(const double*, const std::size_t&, const int&, const int&);
+  using Baseline  = void (*)(double*, const std::size_t&);
+  using CodeMeanSigma = std::pair<double, double> (*)(const std::int16_t*, const std::size_t&, const double&, const double&);
+  using CodeExtremum  = std::pair<int, int> (*)(const std::int16_t*, const std::size_t&, const int&, const int&);
+  using CodeMean      = double (*)(const std::int16_t*, const std::size_t&);
+  Dispatcher() = default;
+  // Select the specialisation for this record length (generic kernels if there is none)
+  static Dispatcher select(const std::size_t& recordLength);
+  static Dispatcher generic();
+  bool              isSpecialised() const { return m_RecordLength != 0; }
+  std::size_t       getRecordLength() const { return m_RecordLength; }
+  std::pair<double, double> meanSigma(const double* data, const std::size_t& length, const double& first, const double& second) const
+  {
+    return length == m_RecordLength ? m_MeanSigma(data, length, first, second) : Kernels::meanSigma<0>(data, length, first, second);
+  }
+  std::pair<double, int> extremum(const int& sign, const double* data, const std::size_t& length, const int& begin = -1, const int& end = -1) const
+  {
+    if(length != m_RecordLength) return sign < 0 ? Kernels::extremum<-1, 0>(data, length, begin, end) : Kernels::extremum<+1, 0>(data, length, begin, end);
+    return sign < 0 ? m_Negative(data, length, begin, end) : m_Positive(data, length, begin, end);
+  }
+  void baseline(double* data, const std::size_t& length) const
+  {
+    if(length == m_RecordLength) m_Baseline(data, length);
+    else
+      Kernels::baseline<0>(data, length);
+  }
+
+  std::pair<double, double> meanSigma(const std::int16_t* codes, const std::size_t& length, const double& first, const double& second) const
+  {
+    return length == m_RecordLength ? m_CodeMeanSigma(codes, length, first, second) : Kernels::meanSigma<0>(codes, length, first, second);
+  }
+  std::pair<int, int> extremum(const int& sign, const std::int16_t* codes, const std::size_t& length, const int& begin = -1, const int& end = -1) const
+  {
+    if(length != m_RecordLength) return sign < 0 ? Kernels::extremum<-1, 0>(codes, length, begin, end) : Kernels::extremum<+1, 0>(codes, length, begin, end);
+    return sign < 0 ? m_CodeNegative(codes, length, begin, end) : m_CodePositive(codes, length, begin, end);
+  }
+  double mean(const std::int16_t* codes, const std::size_t& length) const { return length == m_RecordLength ? m_CodeMean(codes, length) : Kernels::mean<0>(codes, length); }
+
+private:
+  template<std::size_t N> static Dispatcher make();
+  std::size_t                               m_RecordLength{0};
+  MeanSigma                                 m_MeanSigma{&Kernels::meanSigma<0>};
+  Extremum                                  m_Negative{&Kernels::extremum<-1, 0>};
+  Extremum                                  m_Positive{&Kernels::extremum<+1, 0>};
+  Baseline                                  m_Baseline{&Kernels::baseline<0>};
+  CodeMeanSigma                             m_CodeMeanSigma{&Kernels::meanSigma<0>};
+  CodeExtremum                              m_CodeNegative{&Kernels::extremum<-1, 0>};
+  CodeExtremum                              m_CodePositive{&Kernels::extremum<+1, 0>};
+  CodeMean                                  m_CodeMean{&Kernels::mean<0>};
+};
+}  // namespace Kernels
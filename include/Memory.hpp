@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstddef>
+
+// Memory used by the process (bytes), 0 when the system doesn't tell
+std::size_t getResidentMemory();
+std::size_t getPeakResidentMemory();
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Histogram.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+// One peak of a waveform
+struct Peak
+{
+  int    Tick{0};
+  // Amplitude above the baseline (always positive)
+  double Amplitude{0};
+};
+
+// Peaks found in the signal window of one fired strip, the first MaxPeaks are kept (Number counts all of them)
+struct PeakTrain
+{
+  static constexpr std::size_t   MaxPeaks{8};
+  int                            Chamber{-1};
+  int                            Strip{-1};
+  std::size_t                    Number{0};
+  std::array<Peak, MaxPeaks>     Peaks;
+  std::size_t                    getStored() const { return Number < MaxPeaks ? Number : MaxPeaks; }
+};
+
+// Multi-peak search (pile-up, double pulses, afterpulses) by threshold crossing with hysteresis : a peak starts
+// when the signal goes above threshold and ends when it goes back below hysteresis x threshold, its amplitude
+// is the maximum in between. The samples are tested by blocks, a block without any sample above threshold is
+// skipped with one branch so the cost is mostly one vectorised comparison by sample.
+// Like PulseAnalyser it's called for the hits and the trains of the event are kept in a buffer of fixed capacity.
+class PeakFinder
+{
+public:
+  PeakFinder(const std::size_t& chambers, const std::size_t& capacity, const double& hysteresis = 0.5);
+  // Peaks in [begin, end[, baseline : mean of the noise window, threshold : above the baseline
+  const PeakTrain& find(const int& chamber, const int& strip, const double* data, const std::size_t& length, const int& begin, const int& end, const int& sign, const double& baseline, const double& threshold);
+  // Fill the histograms (period in ns for the time between peaks) with the trains of the event and clear the buffer
+  void             endEvent(const double& period);
+  std::size_t      getNumberTrains() const { return m_NbrTrains; }
+  const PeakTrain& getTrain(const std::size_t& i) const { return m_Trains[i]; }
+  std::size_t      getNumberChambers() const { return m_Peaks.size(); }
+  const Histogram& getPeaks(const std::size_t& chamber) const { return m_Peaks[chamber]; }
+  const Histogram& getInterPeakTime(const std::size_t& chamber) const { return m_InterPeakTime[chamber]; }
+  // Hits with more than one peak
+  std::uint64_t    getPileUp(const std::size_t& chamber) const { return m_PileUp[chamber]; }
+  // State between two events (checkpoints), restored into a finder made with the same number of chambers
+  void             save(std::ostream& stream) const;
+  void             restore(std::istream& stream);
+
+private:
+  std::vector<PeakTrain>     m_Trains;
+  std::size_t                m_NbrTrains{0};
+  double                     m_Hysteresis{0.5};
+  std::vector<Histogram>     m_Peaks;
+  std::vector<Histogram>     m_InterPeakTime;
+  std::vector<std::uint64_t> m_PileUp;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Histogram.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+// Comparison of the decisions taken on the double features (waveforms in mV) and on the compact ones (ADC codes as
+// int16) of the same channels. The efficiency of each chamber is counted with both decisions and the amplitude, noise
+// sigma and hit multiplicity distributions are filled for both so they can be compared bin by bin.
+class PrecisionValidation
+{
+public:
+  enum Path : std::size_t
+  {
+    Double,
+    Compact
+  };
+  // What one path gives for a channel
+  struct Decision
+  {
+    bool   Hit{false};
+    bool   Noisy{false};
+    double Amplitude{0};
+    double Sigma{0};
+  };
+  struct Chamber
+  {
+    std::uint64_t                Channels{0};
+    // Hits (noisy channels) of the double path not found by the compact one (Lost) and the reverse (Gained)
+    std::uint64_t                HitLost{0};
+    std::uint64_t                HitGained{0};
+    std::uint64_t                NoisyLost{0};
+    std::uint64_t                NoisyGained{0};
+    // Events with at least one hit (noisy channel)
+    std::array<std::uint64_t, 2> Efficient{};
+    std::array<std::uint64_t, 2> Noisy{};
+    double                       MaxAmplitudeDifference{0};
+    double                       MaxSigmaDifference{0};
+    std::array<Histogram, 2>     Amplitude;
+    std::array<Histogram, 2>     Sigma;
+    std::array<Histogram, 2>     Multiplicity;
+  };
+  PrecisionValidation(const std::size_t& chambers = 0, const std::size_t& strips = 32, const double& maxAmplitude = 200, const double& maxSigma = 20);
+  void                  addChannel(const std::size_t& chamber, const Decision& reference, const Decision& compact);
+  void                  endEvent();
+  std::uint64_t         getEvents() const { return m_Events; }
+  std::size_t           getNumberChambers() const { return m_Chambers.size(); }
+  const Chamber&        getChamber(const std::size_t& chamber) const { return m_Chambers[chamber]; }
+  double                getEfficiency(const std::size_t& chamber, const Path& path) const;
+  std::uint64_t         getChanges() const;
+  // Number of bins (underflow and overflow included) with different counts
+  static std::size_t    countDifferences(const Histogram& a, const Histogram& b);
+  // State between two events (checkpoints), restored into a validation made with the same options
+  void                  save(std::ostream& stream) const;
+  void                  restore(std::istream& stream);
+
+private:
+  std::vector<Chamber>                    m_Chambers;
+  std::vector<std::array<std::size_t, 2>> m_EventHits;
+  std::vector<std::array<bool, 2>>        m_EventNoisy;
+  std::uint64_t                           m_Events{0};
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Histogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+// Features of one fired strip
+struct Pulse
+{
+  int    Chamber{-1};
+  int    Strip{-1};
+  // Amplitude above the baseline (mV, always positive)
+  double Amplitude{0};
+  // Charge integrated around the peak (pC on 50 Ohm)
+  double Charge{0};
+  // 10%-90% rise time (ns), NaN when the leading edge doesn't cross one of the levels
+  double RiseTime{0};
+  // Constant fraction time (ns), NaN when the leading edge doesn't cross the fraction
+  double Time{0};
+  int    Peak{0};
+};
+
+// Compute the pulse shape features of the channels passing the selection. It's called only for the hits so
+// the cost by event scales with the number of fired strips. The pulses of the current event are kept in a
+// buffer of fixed capacity (one pulse by analysed channel).
+class PulseAnalyser
+{
+public:
+  // The charges are also summed exactly as integer multiples of ChargeQuantum (pC) : the mean charge doesn't
+  // depend on the binning of the histogram nor on the order of the merges
+  static constexpr double ChargeQuantum{1e-6};
+  PulseAnalyser(const std::size_t& chambers, const std::size_t& capacity, const double& fraction = 0.2, const std::pair<double, double>& chargeWindow = {10, 30}, const double& impedance = 50.0);
+  // data : waveform, sign : polarity, peak : tick of the extremum, baseline : mean of the noise window
+  const Pulse&     analyse(const int& chamber, const int& strip, const double* data, const std::size_t& length, const int& sign, const int& peak, const double& baseline, const double& period);
+  // Fill the histograms with the pulses of the event and clear the buffer
+  void             endEvent();
+  std::size_t      getNumberPulses() const { return m_NbrPulses; }
+  const Pulse&     getPulse(const std::size_t& i) const { return m_Pulses[i]; }
+  std::size_t      getNumberChambers() const { return m_Charge.size(); }
+  const Histogram& getCharge(const std::size_t& chamber) const { return m_Charge[chamber]; }
+  const Histogram& getAmplitude(const std::size_t& chamber) const { return m_Amplitude[chamber]; }
+  const Histogram& getRiseTime(const std::size_t& chamber) const { return m_RiseTime[chamber]; }
+  std::int64_t     getChargeSum(const std::size_t& chamber) const { return m_ChargeSum[chamber]; }
+  std::uint64_t    getChargeEntries(const std::size_t& chamber) const { return m_ChargeEntries[chamber]; }
+  // State between two events (checkpoints), restored into an analyser made with the same number of chambers
+  void             save(std::ostream& stream) const;
+  void             restore(std::istream& stream);
+
+private:
+  // Interpolated time (in ticks) where the leading edge crosses level, searching backward from the peak (NaN if
+  // it doesn't)
+  static double              crossing(const double* data, const int& sign, const int& peak, const double& baseline, const double& level);
+  std::vector<Pulse>         m_Pulses;
+  std::size_t                m_NbrPulses{0};
+  double                     m_Fraction{0.2};
+  std::pair<double, double>  m_ChargeWindow{10, 30};
+  double                     m_Impedance{50.0};
+  std::vector<Histogram>     m_Charge;
+  std::vector<Histogram>     m_Amplitude;
+  std::vector<Histogram>     m_RiseTime;
+  std::vector<std::int64_t>  m_ChargeSum;
+  std::vector<std::uint64_t> m_ChargeEntries;
+};
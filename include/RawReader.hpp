@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+// Waveform of one channel of a raw event, the samples are the ADC counts : in Data, or in Codes for the channels
+// of the groups when the reader decodes them as 12 bits codes (see RawReader::setCodes)
+struct RawChannel
+{
+  int                       Number{0};
+  int                       Group{0};
+  double                    StartIndexCell{0};
+  double                    TriggerTimeTag{0};
+  std::vector<double>       Data;
+  std::vector<std::int16_t> Codes;
+};
+
+// Event of the raw readout. Channels has always RawReader::NumberChannels entries : the 8 channels of group g are
+// at 8g..8g+7 and the fast trigger digitised by group g (TR0 for the groups 0 and 1, TR1 for 2 and 3) at 32+g.
+// The channels of the groups not read and the ones not requested (see RawReader::setChannels) are empty.
+struct RawEvent
+{
+  int                     BoardID{0};
+  int                     EventNumber{0};
+  int                     Pattern{0};
+  // Groups in the event
+  int                     GroupMask{0};
+  std::size_t             EventSize{0};
+  // Trigger time tag of the first group (30 bits)
+  double                  TriggerTimeTag{0};
+  double                  Period_ns{0};
+  std::vector<RawChannel> Channels;
+};
+
+// Reader of the raw binary output of the V1742 (DRS4) digitizers, the events as given by the board readout :
+// 4 words header (0xA and event size, board ID / pattern / group mask, event counter, time tag) then for each group
+// of the mask a header (start index cell, frequency, trigger channel flag, size), the 8 channels packed 12 bits by
+// 12 bits (3 words by sample), the trigger channel packed the same way and a trailer with the group time tag.
+// The file is memory mapped and indexed (offset of each event) at the opening. The events are decoded by chunks
+// straight from the mapped pages into the waveform buffers : the chunk is split between the threads and the next
+// chunk is decoded in the background while the current one is read.
+class RawReader
+{
+public:
+  static constexpr std::size_t Groups{4};
+  static constexpr std::size_t ChannelsByGroup{8};
+  static constexpr std::size_t NumberChannels{Groups * ChannelsByGroup + Groups};
+  explicit RawReader(const std::string& file, const std::size_t& threads = 1, const std::size_t& chunk = 64);
+  ~RawReader();
+  RawReader(const RawReader&) = delete;
+  RawReader& operator=(const RawReader&) = delete;
+  // Swap the next event in event (its waveform buffers are reused by the next chunk), false at the end of the file
+  bool          next(RawEvent& event);
+  // Skip the next events without decoding them, return the number skipped
+  std::int64_t  skip(const std::int64_t& events);
+  std::int64_t  getEntries() const { return static_cast<std::int64_t>(m_Offsets.size()); }
+  std::size_t   getFileSize() const { return m_Size; }
+  // Channels to decode (empty to decode all of them), the chunk already decoded keeps the previous selection
+  void          setChannels(const std::vector<bool>& needed);
+  // Decode the 8 channels of the groups in Codes (int16) instead of Data, the trigger channels stay in Data. The
+  // chunk already decoded keeps the previous layout.
+  void          setCodes(const bool& codes);
+  // The file starts with a raw event header
+  static bool   isRaw(const std::string& file);
+  // Raw words of the event (synthetic files) : the groups of GroupMask with the same number of samples (multiple of
+  // 8), the trigger channel written if not empty
+  static void   encode(const RawEvent& event, std::vector<std::uint32_t>& words);
+
+private:
+  void          decode(const std::size_t& index, RawEvent& event) const;
+  void          decodeChunk(std::vector<RawEvent>& chunk, const std::size_t& first, const std::size_t& count) const;
+  void          launch();
+  void          wait();
+  std::string   m_Name;
+  const unsigned char*     m_Data{nullptr};
+  std::size_t              m_Size{0};
+#if defined(_WIN32)
+  void*                    m_File{nullptr};
+  void*                    m_Mapping{nullptr};
+#endif
+  std::vector<std::size_t> m_Offsets;
+  std::vector<bool>        m_Needed;
+  bool                     m_Codes{false};
+  std::size_t              m_Threads{1};
+  std::size_t              m_ChunkSize{64};
+  // Chunk being read and the one decoded in the background
+  std::vector<RawEvent>    m_Chunks[2];
+  std::size_t              m_Current{0};
+  std::size_t              m_Ready{0};
+  std::size_t              m_Position{0};
+  std::size_t              m_Pending{0};
+  std::future<void>        m_Decoding;
+  // Next event to give to a chunk
+  std::size_t              m_Next{0};
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Binary results file : a small header with the column names followed by fixed size records of doubles.
+//   "RPCRES01" | uint32 number of columns | uint32 header size | (uint32 length, name) x columns | padding to 8 bytes
+//   records : number of columns x double
+// Records are appended (and flushed) one by one so an interrupted job keeps all the records written before.
+// A resumed job opens the file in append mode : the first keep records of the file are kept (the ones after were
+// written after its checkpoint) and the new records are written after them.
+// The reader memory maps the file and reads the columns directly from the mapping (no text parsing).
+class ResultsWriter
+{
+public:
+  // append : an existing file must have the same columns (a missing one is created)
+  ResultsWriter(const std::string& filename, const std::vector<std::string>& columns, const bool& append = false, const std::size_t& keep = std::numeric_limits<std::size_t>::max());
+  // flush=false lets the stream buffer records written at high rate (per hit)
+  void                            append(const std::vector<double>& record, const bool& flush = true);
+  void                            flush();
+  const std::vector<std::string>& getColumns() const { return m_Columns; }
+  const std::string&              getFilename() const { return m_Filename; }
+  // Records of the file (the ones kept included)
+  std::size_t                     getNumberRecords() const { return m_NbrRecords; }
+
+private:
+  std::string              m_Filename;
+  std::vector<std::string> m_Columns;
+  std::ofstream            m_File;
+  std::size_t              m_NbrRecords{0};
+};
+
+class ResultsReader
+{
+public:
+  explicit ResultsReader(const std::string& filename);
+  ~ResultsReader();
+  ResultsReader(const ResultsReader&) = delete;
+  ResultsReader&                  operator=(const ResultsReader&) = delete;
+  const std::vector<std::string>& getColumns() const { return m_Columns; }
+  std::size_t                     getNumberRecords() const { return m_NbrRecords; }
+  bool                            hasColumn(const std::string& name) const;
+  double                          get(const std::size_t& record, const std::size_t& column) const { return m_Records[record * m_Columns.size() + column]; }
+  template<typename T> std::vector<T> getColumn(const std::string& name) const
+  {
+    const std::size_t column{getColumnIndex(name)};
+    std::vector<T>    values(m_NbrRecords);
+    for(std::size_t record = 0; record != m_NbrRecords; ++record) values[record] = static_cast<T>(get(record, column));
+    return values;
+  }
+  void exportCSV(const std::string& filename) const;
+
+private:
+  std::size_t              getColumnIndex(const std::string& name) const;
+  void                     unmap();
+  std::vector<std::string> m_Columns;
+  const double*            m_Records{nullptr};
+  std::size_t              m_NbrRecords{0};
+  void*                    m_Map{nullptr};
+  std::size_t              m_Size{0};
+#if defined(_WIN32)
+  void* m_FileHandle{nullptr};
+  void* m_MapHandle{nullptr};
+#endif
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Classifier.hpp"
+#include "Histogram.hpp"
+#include "PulseShape.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Counters of one run (or of one part of it) needed to compute its results records. The summaries of the parts
+// of a run processed separately (entry ranges sent to different workers) are merged exactly with add : all the
+// counters are integers, so the results are bitwise the same whatever the parts and the order of the merges.
+struct RunSummary
+{
+  struct Chamber
+  {
+    // Events with at least one hit (all and outside of the noisy events)
+    std::uint64_t                                     Efficient{0};
+    std::uint64_t                                     EfficientCorrected{0};
+    // Sum of the number of hits of the efficient events (integer so the merged sum doesn't depend on the order)
+    std::uint64_t                                     Hits{0};
+    std::array<std::uint64_t, Classifier::NbrClasses> Classes{};
+    Histogram                                         ClusterSize;
+    Histogram                                         ClusterNumber;
+    // Shape of the charge spectrum, the mean charge comes from the exact sum (multiples of PulseAnalyser::ChargeQuantum)
+    Histogram                                         Charge;
+    std::int64_t                                      ChargeSum{0};
+    std::uint64_t                                     ChargeEntries{0};
+    double                                            getMeanCharge() const { return ChargeEntries == 0 ? 0 : ChargeSum * PulseAnalyser::ChargeQuantum / ChargeEntries; }
+  };
+  explicit RunSummary(const std::size_t& chambers = 0) : Chambers(chambers) {}
+  // Events read, events skipped (invalid trigger), events outside of the noisy ones, events classified
+  std::int64_t                    Events{0};
+  std::int64_t                    Invalid{0};
+  std::int64_t                    Corrected{0};
+  std::uint64_t                   Classified{0};
+  std::vector<Chamber>            Chambers;
+  void                            add(const RunSummary& other);
+  std::string                     serialize() const;
+  static RunSummary               deserialize(const std::string& summary);
+  // Record of one chamber, same order as getColumns
+  std::vector<double>             getRecord(const std::size_t& chamber, const double& HV, const double& scaleFactor) const;
+  static std::vector<std::string> getColumns();
+};
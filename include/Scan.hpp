@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Scan of the selection parameters in one pass over the data : hit thresholds (--sigma), signal windows (delay and
+// width of -s) and noisy event thresholds (--sigmaNoise). The features of a channel (noise, extremum and mean of
+// each window) are computed once, in one pass over the samples covered by the windows, then all the thresholds
+// are compared at once and the results accumulated in counters indexed by chamber x window x threshold.
+// A grid point gives the same counts as a run made with its values (same criterion : |extremum - mean of the
+// window| > sigma x noise RMS, the window [tick - delay - width/2, tick - delay + width/2] of WindowFinder).
+class Scan
+{
+public:
+  // windows : (delay, width) in ticks
+  Scan(const std::size_t& chambers, const std::vector<double>& sigmas, const std::vector<std::pair<double, double>>& windows, const std::vector<double>& noiseRatios, const std::pair<double, double>& noiseWindow, const std::pair<double, double>& noiseWindowAfter);
+  // Waveform after the baseline subtraction, tick of the trigger of its group
+  void                            addChannel(const int& chamber, const double* data, const std::size_t& length, const int& sign, const int& triggerTick);
+  void                            endEvent();
+  // The event wasn't analysed (invalid trigger), it breaks the "event after a noisy one" sequence like in the run
+  void                            skipEvent();
+  std::size_t                     getNumberSigmas() const { return m_Sigmas.size(); }
+  std::size_t                     getNumberWindows() const { return m_Windows.size(); }
+  std::size_t                     getNumberNoiseRatios() const { return m_NoiseRatios.size(); }
+  std::uint64_t                   getEvents() const { return m_Events; }
+  std::uint64_t                   getEfficient(const std::size_t& chamber, const std::size_t& window, const std::size_t& sigma) const { return m_Efficient[index(chamber, window, sigma)]; }
+  std::uint64_t                   getHits(const std::size_t& chamber, const std::size_t& window, const std::size_t& sigma) const { return m_Hits[index(chamber, window, sigma)]; }
+  // Events of the corrected efficiency (not after a noisy one, or noisy themselves, for this noise ratio) and
+  // efficient ones among them
+  std::uint64_t                   getCorrected(const std::size_t& noise) const { return m_Corrected[noise]; }
+  std::uint64_t                   getEfficientCorrected(const std::size_t& noise, const std::size_t& chamber, const std::size_t& window, const std::size_t& sigma) const { return m_EfficientCorrected[noise * m_Efficient.size() + index(chamber, window, sigma)]; }
+  // Events with a hit in the noise window after the signal
+  std::uint64_t                   getNoiseEvents(const std::size_t& chamber, const std::size_t& sigma) const { return m_NoiseEvents[chamber * m_Sigmas.size() + sigma]; }
+  std::uint64_t                   getNoisyEvents(const std::size_t& chamber, const std::size_t& noise) const { return m_NoisyEvents[chamber * m_NoiseRatios.size() + noise]; }
+  // One record by grid point, same order as getColumns (period in ns for the noise rate in Hz)
+  std::vector<std::vector<double>> getRecords(const double& HV, const double& scaleFactor, const double& period) const;
+  static std::vector<std::string> getColumns();
+  // State between two events (checkpoints), restored into a scan made with the same grid
+  void                            save(std::ostream& stream) const;
+  void                            restore(std::istream& stream);
+
+private:
+  std::size_t index(const std::size_t& chamber, const std::size_t& window, const std::size_t& sigma) const { return (chamber * m_Windows.size() + window) * m_Sigmas.size() + sigma; }
+  std::size_t                              m_Chambers{0};
+  std::vector<double>                      m_Sigmas;
+  std::vector<std::pair<double, double>>   m_Windows;
+  std::vector<double>                      m_NoiseRatios;
+  std::pair<double, double>                m_NoiseWindow;
+  std::pair<double, double>                m_NoiseWindowAfter;
+  // Window bounds relative to the trigger tick ([begin, end[ for the extremum, [begin, end] for the mean)
+  std::vector<int>                         m_Begin;
+  std::vector<int>                         m_End;
+  // Sorted distinct bounds (relative), the segments between them are the elements of all the windows
+  std::vector<int>                         m_Bounds;
+  std::vector<std::size_t>                 m_FirstSegment;
+  std::vector<std::size_t>                 m_LastSegment;
+  // Per channel work arrays
+  std::vector<double>                      m_Segment;
+  std::vector<double>                      m_Prefix;
+  std::vector<double>                      m_Distance;
+  // Per event : hits by chamber x window x threshold, noise hits by chamber x threshold, noisy flags
+  std::vector<std::uint16_t>               m_EventHits;
+  std::vector<std::uint8_t>                m_EventNoise;
+  std::vector<std::uint8_t>                m_EventNoisy;
+  std::vector<std::uint8_t>                m_NoisyBefore;
+  // Counters
+  std::uint64_t                            m_Events{0};
+  std::vector<std::uint64_t>               m_Efficient;
+  std::vector<std::uint64_t>               m_Hits;
+  std::vector<std::uint64_t>               m_Corrected;
+  std::vector<std::uint64_t>               m_EfficientCorrected;
+  std::vector<std::uint64_t>               m_NoiseEvents;
+  std::vector<std::uint64_t>               m_NoisyEvents;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Selection written as an expression over named features, e.g. "abs(value - signal_mean) > nsigma*sigma_noise".
+// Operators : || && ! < <= > >= == != + - * / (C precedence), functions abs, sqrt, min, max, numbers and the
+// variables/constants given. The expression is parsed once and compiled into a stack bytecode (constants folded).
+// The bytecode is run on blocks of Block rows of the feature columns : each instruction is a loop over the block
+// (vectorised), so the cost of the dispatch is shared by all the rows of the block.
+class Selection
+{
+public:
+  static constexpr std::size_t Block{64};
+  Selection() = default;
+  // constants : names replaced by their value at the compilation (command line parameters)
+  Selection(const std::string& expression, const std::vector<std::string>& variables, const std::map<std::string, double>& constants = {});
+  // columns[v][row] : value of the variable v, results[row] : 1 if the row is selected
+  void               evaluate(const std::vector<const double*>& columns, const std::size_t& rows, std::uint8_t* results);
+  const std::string& getExpression() const { return m_Expression; }
+  std::size_t        getNumberInstructions() const { return m_Code.size(); }
+
+private:
+  enum class Op : std::uint8_t
+  {
+    Variable,
+    Constant,
+    Negate,
+    Not,
+    Abs,
+    Sqrt,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    NotEqual,
+    And,
+    Or,
+    Min,
+    Max
+  };
+  struct Instruction
+  {
+    Op          Code{Op::Constant};
+    std::size_t Operand{0};
+  };
+  struct Slot
+  {
+    const double* Data{nullptr};
+    double        Storage[Block];
+  };
+  // Recursive descent, the instructions are emitted in postfix order
+  void                             parseOr();
+  void                             parseAnd();
+  void                             parseComparison();
+  void                             parseSum();
+  void                             parseProduct();
+  void                             parseUnary();
+  void                             parsePrimary();
+  void                             skipSpaces();
+  bool                             accept(const std::string& token);
+  void                             emit(const Op& code, const std::size_t& operand = 0);
+  void                             pushConstant(const double& value);
+  [[noreturn]] void                fail(const std::string& error) const;
+  static void                      apply(const Op& code, const double* a, const double* b, double* out);
+  void                             run(const std::vector<const double*>& columns, const std::size_t& offset, std::uint8_t* results, const std::size_t& rows);
+  std::string                      m_Expression;
+  std::vector<std::string>         m_Variables;
+  std::map<std::string, double>    m_Names;
+  std::size_t                      m_Position{0};
+  std::vector<Instruction>         m_Code;
+  std::vector<double>              m_Values;
+  // Constants as full blocks so they are read as the variables
+  std::vector<std::vector<double>> m_Blocks;
+  std::vector<Slot>                m_Stack;
+  // Last rows padded to a full block
+  std::vector<std::vector<double>> m_Tail;
+  std::vector<const double*>       m_TailColumns;
+};
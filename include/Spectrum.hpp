@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Counters.hpp"
+
+#include <complex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Real FFT of a power of two size (radix-2, the N real samples are packed in N/2 complex ones). The plan (bit
+// reversal and twiddles) is computed once and only read afterwards so one plan is shared by all the threads,
+// each thread giving its own work buffer.
+class FFT
+{
+public:
+  explicit FFT(const std::size_t& size);
+  std::size_t getSize() const { return m_Size; }
+  // |X_k|^2 for k in [0, size/2] of data[0, size[, work : size/2 elements
+  void        power(const double* data, std::complex<double>* work, double* power) const;
+  // Largest power of two <= length (0 if length < 4)
+  static std::size_t floorPowerOfTwo(const std::size_t& length);
+
+private:
+  std::size_t                       m_Size{0};
+  std::vector<std::size_t>          m_Reverse;
+  std::vector<std::complex<double>> m_Twiddles;
+  std::vector<std::complex<double>> m_Split;
+};
+
+// Power spectral density of the noise of each channel, averaged over all the segments given (Hann window, mean
+// removed). The segments are copied in a batch, a full batch is transformed by the worker threads while the
+// next one is filled, each thread writing the power of its part of the segments in the batch. The powers of a
+// batch are then added to the sums in the order of the segments, so the result is bitwise the same whatever the
+// number of threads. Nothing is allocated after the construction.
+class NoiseSpectrum
+{
+public:
+  // size : number of samples of a segment (power of two), batch : segments transformed together
+  NoiseSpectrum(const std::size_t& channels, const std::size_t& size, const std::size_t& threads = 1, const std::size_t& batch = 256);
+  ~NoiseSpectrum();
+  NoiseSpectrum(const NoiseSpectrum&) = delete;
+  NoiseSpectrum& operator=(const NoiseSpectrum&) = delete;
+  // Segment data[begin, begin + size[ of the channel, false if it's not inside the record
+  bool           add(const std::size_t& channel, const double* data, const std::size_t& length, const std::size_t& begin);
+  // Transform and add the segments waiting
+  void           finish();
+  // The worker threads add the time and counters of their FFTs to the stage, as the threads firstThread,
+  // firstThread + 1... (one thread : the FFTs are done in add and finish, measured by the caller)
+  void           setProfile(StageProfile* profile, const std::size_t& stage, const std::size_t& firstThread);
+  std::size_t    getNumberChannels() const { return m_Channels; }
+  std::size_t    getSize() const { return m_Plan.getSize(); }
+  std::size_t    getNumberBins() const { return m_Plan.getSize() / 2 + 1; }
+  std::uint64_t  getSegments(const std::size_t& channel) const { return m_Segments[channel]; }
+  // One-sided PSD (unit^2/Hz) of bin k (frequency k / (size x period)), period in ns, after finish
+  double         getDensity(const std::size_t& channel, const std::size_t& bin, const double& period) const;
+  double         getFrequency(const std::size_t& bin, const double& period) const { return bin / (m_Plan.getSize() * period * 1e-9); }
+  // Sums for the checkpoints (the segments waiting are added first, each segment is added on its own so the sums
+  // don't depend on the batches), restored into a spectrum made with the same channels and size
+  void           save(std::ostream& stream);
+  void           restore(std::istream& stream);
+
+private:
+  struct Batch
+  {
+    std::vector<double>      Samples;
+    std::vector<std::size_t> Channels;
+    // |X_k|^2 of each segment
+    std::vector<double>      Power;
+    std::size_t              Size{0};
+  };
+  // Work buffers of a thread
+  struct Buffers
+  {
+    std::vector<double>               Segment;
+    std::vector<std::complex<double>> Work;
+  };
+  void                     process(Batch& batch, Buffers& buffers, const std::size_t& thread) const;
+  // Add the powers of a transformed batch in the order of its segments
+  void                     accumulate(const Batch& batch);
+  void                     submit();
+  void                     wait();
+  void                     run(const std::size_t& thread);
+  std::size_t              m_Channels{0};
+  FFT                      m_Plan;
+  std::vector<double>      m_Window;
+  double                   m_WindowPower{0};
+  Batch                    m_Batches[2];
+  // Batch being filled, the other one can be in the hands of the threads
+  std::size_t              m_Filling{0};
+  std::size_t              m_Processing{0};
+  // The batch processed is not added yet
+  bool                     m_Pending{false};
+  std::vector<Buffers>     m_Buffers;
+  std::vector<double>      m_Power;
+  std::vector<std::uint64_t> m_Segments;
+  std::vector<std::thread> m_Threads;
+  std::mutex               m_Mutex;
+  std::condition_variable  m_Start;
+  std::condition_variable  m_Done;
+  StageProfile*            m_Profile{nullptr};
+  std::size_t              m_ProfileStage{0};
+  std::size_t              m_ProfileThread{0};
+  std::uint64_t            m_Generation{0};
+  std::size_t              m_Running{0};
+  bool                     m_Stop{false};
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "fmt/format.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Text state of the accumulators saved in the checkpoints : the size of each array followed by its values, the
+// doubles written with the shortest representation read back to the same value so a resumed run gives the same
+// results bit for bit. An accumulator is restored into one made with the same options, a size which differs
+// means the state is not the one of this accumulator.
+namespace State
+{
+// The doubles through strtod, which reads back nan and inf as written by fmt (operator>> doesn't), the bytes
+// (uint8_t, bool) as numbers
+template<typename T> void parse(std::istream& stream, T& value)
+{
+  if constexpr(std::is_floating_point_v<T>)
+  {
+    std::string token;
+    stream >> token;
+    char* end{nullptr};
+    value = static_cast<T>(std::strtod(token.c_str(), &end));
+    if(token.empty() || *end != '\0') stream.setstate(std::ios::failbit);
+  }
+  else if constexpr(sizeof(T) == 1)
+  {
+    int number{0};
+    stream >> number;
+    value = static_cast<T>(number);
+  }
+  else stream >> value;
+}
+
+template<typename T> void write(std::ostream& stream, const std::vector<T>& values)
+{
+  stream << values.size();
+  // uint8_t as a number, not as a character
+  for(std::size_t i = 0; i != values.size(); ++i) stream << ' ' << fmt::format("{}", +values[i]);
+  stream << '\n';
+}
+
+template<typename T> void read(std::istream& stream, std::vector<T>& values)
+{
+  std::size_t size{0};
+  stream >> size;
+  if(!stream || size != values.size()) throw std::runtime_error(fmt::format("State with {} values for {} !", size, values.size()));
+  for(std::size_t i = 0; i != size; ++i)
+  {
+    T value{};
+    parse(stream, value);
+    values[i] = value;
+  }
+  if(!stream) throw std::runtime_error("Can't read the state values !");
+}
+
+// Values saved one after the other (same order to read them)
+template<typename... T> void write(std::ostream& stream, const T&... values)
+{
+  const char* separator{""};
+  ((stream << separator << fmt::format("{}", +values), separator = " "), ...);
+  stream << '\n';
+}
+
+template<typename... T> void read(std::istream& stream, T&... values)
+{
+  (parse(stream, values), ...);
+  if(!stream) throw std::runtime_error("Can't read the state values !");
+}
+}  // namespace State
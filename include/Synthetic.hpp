@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Synthetic V1742 like data used by the benchmark and the tests (no input file needed).
+
+// Events in mV : gaussian noise (RMS 2) + one negative pulse on one channel out of 3
+class Waveforms
+{
+public:
+  Waveforms(const std::size_t& events, const std::size_t& channels, const std::size_t& length, const unsigned int& seed = 42);
+  double*             get(const std::size_t& evt, const std::size_t& ch) { return &m_Data[(evt * m_Channels + ch) * m_Length]; }
+  const double*       get(const std::size_t& evt, const std::size_t& ch) const { return &m_Data[(evt * m_Channels + ch) * m_Length]; }
+  std::size_t         getEvents() const { return m_Events; }
+  std::size_t         getChannels() const { return m_Channels; }
+  std::size_t         getLength() const { return m_Length; }
+  std::size_t         getSamples() const { return m_Data.size(); }
+  std::vector<double> copy() const { return m_Data; }
+
+private:
+  std::size_t         m_Events{0};
+  std::size_t         m_Channels{0};
+  std::size_t         m_Length{0};
+  std::vector<double> m_Data;
+};
+
+// Raw V1742 file : 4 groups of samples (multiple of 8) with their trigger channel, ADC counts around 2048 with
+// noise, a negative pulse on the trigger channels (at 20% of the record) and on one channel out of 3. The events are
+// written by the board given with the TriggerTimeTag of timeTags (30 bits, empty : 1000 * event).
+// Return the samples written (12 bits) by event, channel (RawReader numbering) and sample.
+std::vector<std::uint16_t> WriteRawFile(const std::string& filename, const std::size_t& nbrEvents, const std::size_t& samples, const unsigned int& seed = 23, const int& board = 3, const std::vector<double>& timeTags = {});
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Efficiency, multiplicity and noisy event fraction of each chamber as function of the time in the run.
+// The time comes from the (unwrapped) TriggerTimeTag. The number of bins is bounded : when the run gets longer
+// than maxBins bins, neighbouring bins are merged two by two and the bin width doubles, so the memory used does
+// not depend on the length of the run.
+class TimeSeries
+{
+public:
+  TimeSeries(const std::size_t& chambers, const double& binWidth = 1.0, const std::size_t& maxBins = 512, const double& tickPeriod = 8.5e-9, const unsigned int& rolloverBits = 30);
+  // Add one event : hits[chamber] fired strips, noisy[chamber] noisy flag
+  void        fill(const double& triggerTimeTag, const std::vector<int>& hits, const std::vector<bool>& noisy);
+  // Time (s) since the first event of the run
+  double      getTime() const { return m_Time; }
+  double      getBinWidth() const { return m_BinWidth; }
+  std::size_t getNumberBins() const { return m_NbrBins; }
+  std::size_t getNumberChambers() const { return m_Chambers; }
+  std::uint64_t getEvents(const std::size_t& bin) const { return m_Events[bin]; }
+  std::uint64_t getEfficient(const std::size_t& bin, const std::size_t& chamber) const { return m_Bins[bin * m_Chambers + chamber].Efficient; }
+  std::uint64_t getHits(const std::size_t& bin, const std::size_t& chamber) const { return m_Bins[bin * m_Chambers + chamber].Hits; }
+  std::uint64_t getNoisy(const std::size_t& bin, const std::size_t& chamber) const { return m_Bins[bin * m_Chambers + chamber].Noisy; }
+  // One line per chamber and time bin
+  void        write(const std::string& filename) const;
+  // State between two events (checkpoints), restored into a series made with the same options
+  void        save(std::ostream& stream) const;
+  void        restore(std::istream& stream);
+
+private:
+  struct Bin
+  {
+    std::uint64_t Efficient{0};
+    std::uint64_t Hits{0};
+    std::uint64_t Noisy{0};
+  };
+  void                       merge();
+  std::size_t                m_Chambers{0};
+  double                     m_BinWidth{1.0};
+  std::size_t                m_MaxBins{512};
+  double                     m_TickPeriod{8.5e-9};
+  double                     m_Rollover{0};
+  std::size_t                m_NbrBins{0};
+  std::vector<std::uint64_t> m_Events;
+  std::vector<Bin>           m_Bins;
+  bool                       m_First{true};
+  double                     m_FirstTag{0};
+  double                     m_LastTag{0};
+  double                     m_Offset{0};
+  double                     m_Time{0};
+};
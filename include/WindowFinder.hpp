@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Histogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Signal window of each trigger group : [tick - delay - width/2, tick - delay + width/2] where tick is the trigger
+// tick of the event. The delay starts from the value given by the user and can be learnt from the distribution
+// of (trigger tick - tick of the significant extrema) filled on a warm-up sample : the learnt delay is the centroid
+// of the width wide interval holding the most entries.
+// A trigger tick of 0 (no crossing found) or giving a window outside of the record makes the trigger invalid.
+class WindowFinder
+{
+public:
+  WindowFinder(const std::vector<int>& triggers, const double& width, const double& delay, const std::size_t& length = 1024);
+  // Samples by record, known once the first event is read. The delay histograms are made again (empty) when it
+  // changes, the delays are kept.
+  void               setLength(const std::size_t& length);
+  std::size_t        getLength() const { return m_Length; }
+  // Warm-up : one entry by significant extremum
+  void               fill(const int& trigger, const int& triggerTick, const int& signalTick);
+  // Learn the delays, a group keeps its delay if its peak is below significance (in sigmas over the flat
+  // background). Return the number of groups learnt.
+  std::size_t        learn(const double& significance = 5.0);
+  // Set the trigger tick of the event, return its validity
+  bool               setTrigger(const int& trigger, const int& tick);
+  bool               isValid(const int& trigger) const { return m_Groups[index(trigger)].Valid; }
+  // Window of the current event clamped to the record
+  std::pair<int, int> getWindow(const int& trigger) const;
+  double             getDelay(const int& trigger) const { return m_Groups[index(trigger)].Delay; }
+  bool               isLearnt(const int& trigger) const { return m_Groups[index(trigger)].Learnt; }
+  std::uint64_t      getInvalid(const int& trigger) const { return m_Groups[index(trigger)].Invalid; }
+  const Histogram&   getDelays(const int& trigger) const { return m_Groups[index(trigger)].Delays; }
+  double             getWidth() const { return m_Width; }
+
+private:
+  struct Group
+  {
+    int           Trigger{-1};
+    double        Delay{0};
+    bool          Learnt{false};
+    int           Tick{0};
+    bool          Valid{false};
+    std::uint64_t Invalid{0};
+    Histogram     Delays;
+  };
+  std::size_t        index(const int& trigger) const;
+  std::vector<Group> m_Groups;
+  double             m_Width{0};
+  std::size_t        m_Length{1024};
+};
@@ -0,0 +1,274 @@
+#include "AnalysisEngine.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+const std::vector<std::string> FeatureNames{"value", "amp", "signal_mean", "signal_sigma", "noise_mean", "sigma_noise", "noise_after_mean", "sigma_after", "tick", "polarity", "chamber", "strip"};
+
+void FillFeatures(std::vector<std::vector<double>>& features, const std::size_t& row, const ChannelWindows& windows, const int& sign, const int& chamber, const int& strip)
+{
+  // The extremum is a float as in the former hard-coded cut
+  const float value{static_cast<float>(sign == -1 ? windows.Minimum.first : windows.Maximum.first)};
+  features[FeatureValue][row]           = value;
+  features[FeatureAmp][row]             = std::fabs(value - windows.Signal.first);
+  features[FeatureSignalMean][row]      = windows.Signal.first;
+  features[FeatureSignalSigma][row]     = windows.Signal.second;
+  features[FeatureNoiseMean][row]       = windows.Noise.first;
+  features[FeatureNoiseSigma][row]      = windows.Noise.second;
+  features[FeatureNoiseAfterMean][row]  = windows.NoiseAfter.first;
+  features[FeatureNoiseAfterSigma][row] = windows.NoiseAfter.second;
+  features[FeatureTick][row]            = sign == -1 ? windows.Minimum.second : windows.Maximum.second;
+  features[FeaturePolarity][row]        = sign;
+  features[FeatureChamber][row]         = chamber;
+  features[FeatureStrip][row]           = strip;
+}
+
+int TriggerTick(const double* data, const std::size_t& length)
+{
+  const double minimum{length == 0 ? 0 : *std::min_element(data, data + length)};
+  for(std::size_t i = 0; i != length; ++i)
+    if(data[i] < TriggerFraction * minimum) return static_cast<int>(i);
+  return 0;
+}
+
+ChannelSelections::ChannelSelections(const std::string& hit, const std::string& noisy, const double& nbrSigma, const double& nbrSigmaNoise)
+{
+  const std::map<std::string, double> constants{{"nsigma", nbrSigma}, {"nsigma_noise", nbrSigmaNoise}};
+  m_Hit   = Selection(hit, FeatureNames, constants);
+  m_Noisy = Selection(noisy, FeatureNames, constants);
+}
+
+void ChannelSelections::evaluate(const std::vector<const double*>& columns, const std::size_t& rows, std::uint8_t* hits, std::uint8_t* noisy)
+{
+  m_Hit.evaluate(columns, rows, hits);
+  m_Noisy.evaluate(columns, rows, noisy);
+}
+
+void ClassifyChannel(Classifier& classifier, const std::vector<std::vector<double>>& features, const std::size_t& row)
+{
+  classifier.addChannel(static_cast<int>(features[FeatureChamber][row]), std::fabs(features[FeatureValue][row] - features[FeatureNoiseMean][row]), features[FeatureNoiseAfterSigma][row] / features[FeatureNoiseSigma][row]);
+}
+
+const Pulse& AnalyseHit(ClusterBuilder& clusters, PulseAnalyser& pulses, Classifier& classifier, const int& chamber, const int& strip, const double* data, const std::size_t& length, const int& polarity, const int& peak, const double& baseline, const double& period)
+{
+  clusters.addHit(chamber, strip, peak);
+  const Pulse& pulse{pulses.analyse(chamber, strip, data, length, polarity, peak, baseline, period)};
+  classifier.addHit(chamber, pulse.Charge, pulse.Time);
+  return pulse;
+}
+
+EfficiencyCounter::EfficiencyCounter(const std::size_t& chambers) : m_Hits(chambers, 0), m_Noisy(chambers, false), m_Counts(chambers) {}
+
+void EfficiencyCounter::beginEvent()
+{
+  std::fill(m_Hits.begin(), m_Hits.end(), 0);
+  std::fill(m_Noisy.begin(), m_Noisy.end(), false);
+}
+
+void EfficiencyCounter::addHit(const std::size_t& chamber)
+{
+  ++m_Hits[chamber];
+  ++m_Counts.Chambers[chamber].Hits;
+}
+
+void EfficiencyCounter::setNoisy(const std::size_t& chamber) { m_Noisy[chamber] = true; }
+
+void EfficiencyCounter::endEvent()
+{
+  const bool noisy{std::find(m_Noisy.begin(), m_Noisy.end(), true) != m_Noisy.end()};
+  const bool corrected{!m_SkipNext || noisy};
+  m_SkipNext = noisy;
+  m_Counts.Corrected += corrected;
+  for(std::size_t chamber = 0; chamber != m_Hits.size(); ++chamber)
+  {
+    if(m_Hits[chamber] == 0) continue;
+    ++m_Counts.Chambers[chamber].Efficient;
+    m_Counts.Chambers[chamber].EfficientCorrected += corrected;
+  }
+}
+
+void EfficiencyCounter::skipEvent()
+{
+  ++m_Counts.Invalid;
+  m_SkipNext = false;
+}
+
+bool EfficiencyCounter::hasHit() const
+{
+  return std::find_if(m_Hits.begin(), m_Hits.end(), [](const int& hits) { return hits != 0; }) != m_Hits.end();
+}
+
+void EfficiencyCounter::fill(RunSummary& summary) const
+{
+  summary.Invalid   = m_Counts.Invalid;
+  summary.Corrected = m_Counts.Corrected;
+  for(std::size_t chamber = 0; chamber != m_Counts.Chambers.size(); ++chamber)
+  {
+    summary.Chambers[chamber].Efficient          = m_Counts.Chambers[chamber].Efficient;
+    summary.Chambers[chamber].EfficientCorrected = m_Counts.Chambers[chamber].EfficientCorrected;
+    summary.Chambers[chamber].Hits               = m_Counts.Chambers[chamber].Hits;
+  }
+}
+
+void EfficiencyCounter::restore(const RunSummary& summary, const bool& noisyLast)
+{
+  if(summary.Chambers.size() != m_Counts.Chambers.size()) throw std::runtime_error(fmt::format("Summary of {} chambers for {} !", summary.Chambers.size(), m_Counts.Chambers.size()));
+  m_Counts   = RunSummary(m_Counts.Chambers.size());
+  m_SkipNext = noisyLast;
+  m_Counts.Invalid   = summary.Invalid;
+  m_Counts.Corrected = summary.Corrected;
+  for(std::size_t chamber = 0; chamber != m_Counts.Chambers.size(); ++chamber)
+  {
+    m_Counts.Chambers[chamber].Efficient          = summary.Chambers[chamber].Efficient;
+    m_Counts.Chambers[chamber].EfficientCorrected = summary.Chambers[chamber].EfficientCorrected;
+    m_Counts.Chambers[chamber].Hits               = summary.Chambers[chamber].Hits;
+  }
+}
+
+RunSummary Summarise(const std::int64_t& events, const EfficiencyCounter& efficiency, const ClusterBuilder& clusters, const PulseAnalyser& pulses, Classifier& classifier)
+{
+  classifier.flush();
+  RunSummary summary(efficiency.getHits().size());
+  summary.Events = events;
+  efficiency.fill(summary);
+  summary.Classified = classifier.getEvents();
+  for(std::size_t chamber = 0; chamber != summary.Chambers.size(); ++chamber)
+  {
+    RunSummary::Chamber& counters{summary.Chambers[chamber]};
+    for(std::size_t type = 0; type != counters.Classes.size(); ++type) counters.Classes[type] = classifier.getCount(chamber, static_cast<EventClass>(type));
+    counters.ClusterSize   = clusters.getClusterSize(chamber);
+    counters.ClusterNumber = clusters.getClusterNumber(chamber);
+    counters.Charge        = pulses.getCharge(chamber);
+    counters.ChargeSum     = pulses.getChargeSum(chamber);
+    counters.ChargeEntries = pulses.getChargeEntries(chamber);
+  }
+  return summary;
+}
+
+AnalysisEngine::AnalysisEngine(const AnalysisConfiguration& configuration) : m_Configuration(configuration), m_Strips(configuration.Strips), m_Kernels(Kernels::Dispatcher::generic())
+{
+  m_Selections = ChannelSelections(m_Configuration.HitSelection, m_Configuration.NoisySelection, m_Configuration.NbrSigma, m_Configuration.NbrSigmaNoise);
+  if(m_Strips.empty()) throw std::runtime_error("The analysis engine needs at least one strip !");
+  // Same order as Analysis : by channel in the event
+  std::sort(m_Strips.begin(), m_Strips.end(), [](const AnalysisConfiguration::Strip& a, const AnalysisConfiguration::Strip& b) { return a.Channel < b.Channel; });
+  std::vector<int> triggers{m_Configuration.Triggers};
+  std::sort(triggers.begin(), triggers.end());
+  for(const AnalysisConfiguration::Strip& strip : m_Strips)
+  {
+    if(strip.Channel < 0 || strip.Chamber < 0) throw std::runtime_error(fmt::format("Strip {} : channel {} or chamber {} is negative !", strip.Number, strip.Channel, strip.Chamber));
+    const std::vector<int>::const_iterator trigger{std::upper_bound(triggers.begin(), triggers.end(), strip.Channel)};
+    if(trigger == triggers.end()) throw std::runtime_error(fmt::format("No trigger after the channel {} of the strip {} !", strip.Channel, strip.Number));
+    m_StripTriggers.push_back(*trigger);
+    if(std::find(m_UsedTriggers.begin(), m_UsedTriggers.end(), *trigger) == m_UsedTriggers.end()) m_UsedTriggers.push_back(*trigger);
+    m_NbrChambers = std::max(m_NbrChambers, static_cast<std::size_t>(strip.Chamber) + 1);
+  }
+  m_ChamberStrips.resize(m_NbrChambers);
+  for(const AnalysisConfiguration::Strip& strip : m_Strips) m_ChamberStrips[strip.Chamber].push_back(strip.Number);
+  m_Data.resize(m_Strips.size());
+  m_Features.assign(FeatureNames.size(), std::vector<double>(m_Strips.size(), 0));
+  for(const std::vector<double>& column : m_Features) m_FeatureColumns.push_back(column.data());
+  m_HitSelected.resize(m_Strips.size());
+  m_NoisySelected.resize(m_Strips.size());
+  m_Peaks.resize(m_Strips.size());
+  m_Baselines.resize(m_Strips.size());
+  reset();
+}
+
+void AnalysisEngine::reset()
+{
+  m_Clusters   = std::make_unique<ClusterBuilder>(m_ChamberStrips, m_Configuration.ClusterWindow);
+  m_Pulses     = std::make_unique<PulseAnalyser>(m_NbrChambers, m_Strips.size(), m_Configuration.CFDFraction, m_Configuration.ChargeWindow);
+  m_Classifier = std::make_unique<Classifier>(m_NbrChambers, m_Configuration.NbrSigmaNoise, m_Configuration.StreamerCharge);
+  m_Events     = 0;
+  m_Efficiency = EfficiencyCounter(m_NbrChambers);
+}
+
+void AnalysisEngine::process(const double* data, const std::size_t& events, const std::size_t& channels, const std::size_t& length, const double& period)
+{
+  m_Waveforms.resize(channels);
+  m_Lengths.assign(channels, length);
+  for(std::size_t evt = 0; evt != events; ++evt)
+  {
+    for(std::size_t ch = 0; ch != channels; ++ch) m_Waveforms[ch] = data + (evt * channels + ch) * length;
+    analyse(period);
+  }
+}
+
+void AnalysisEngine::analyse(const double& period)
+{
+  ++m_Events;
+  m_Efficiency.beginEvent();
+  for(const AnalysisConfiguration::Strip& strip : m_Strips)
+    if(static_cast<std::size_t>(strip.Channel) >= m_Waveforms.size() || m_Lengths[strip.Channel] == 0) throw std::runtime_error(fmt::format("Channel {} of the strip {} is not in the event !", strip.Channel, strip.Number));
+  // Kernels and windows for the record length of the first event (again if it changes)
+  const std::size_t length{m_Lengths[m_Strips[0].Channel]};
+  if(length != m_RecordLength)
+  {
+    m_RecordLength = length;
+    m_Kernels      = Kernels::Dispatcher::select(length);
+    m_Windows      = std::make_unique<WindowFinder>(m_Configuration.Triggers, m_Configuration.SignalWindow.first, m_Configuration.SignalWindow.second, length);
+    if(m_Clusters->getEvents() == 0) m_Clusters->setRecordLength(length);
+  }
+  bool validTriggers{true};
+  for(const int& trigger : m_Configuration.Triggers)
+  {
+    if(trigger < 0 || static_cast<std::size_t>(trigger) >= m_Waveforms.size()) continue;
+    std::vector<double>& buffer{m_Data[0]};
+    buffer.assign(m_Waveforms[trigger], m_Waveforms[trigger] + m_Lengths[trigger]);
+    m_Kernels.baseline(buffer.data(), buffer.size());
+    const bool valid{m_Windows->setTrigger(trigger, TriggerTick(buffer.data(), buffer.size()))};
+    if(std::find(m_UsedTriggers.begin(), m_UsedTriggers.end(), trigger) != m_UsedTriggers.end()) validTriggers &= valid;
+  }
+  m_LastValid = validTriggers;
+  if(!validTriggers)
+  {
+    m_Efficiency.skipEvent();
+    return;
+  }
+  for(std::size_t row = 0; row != m_Strips.size(); ++row)
+  {
+    const AnalysisConfiguration::Strip& strip{m_Strips[row]};
+    std::vector<double>&                data{m_Data[row]};
+    data.assign(m_Waveforms[strip.Channel], m_Waveforms[strip.Channel] + m_Lengths[strip.Channel]);
+    if(m_Configuration.ADCCodes)
+      for(double& sample : data) sample = (sample - 2048) * DAC_TO_VOLT;
+    m_Kernels.baseline(data.data(), data.size());
+    const std::pair<int, int> signal{m_Windows->getWindow(m_StripTriggers[row])};
+    ChannelWindows            windows;
+    windows.Noise      = m_Kernels.meanSigma(data.data(), data.size(), m_Configuration.NoiseWindow.first, m_Configuration.NoiseWindow.second);
+    windows.NoiseAfter = m_Kernels.meanSigma(data.data(), data.size(), m_Configuration.NoiseWindowAfter.first, m_Configuration.NoiseWindowAfter.second);
+    windows.Signal     = m_Kernels.meanSigma(data.data(), data.size(), signal.first, signal.second);
+    windows.Minimum    = m_Kernels.extremum(-1, data.data(), data.size(), signal.first, signal.second);
+    windows.Maximum    = m_Kernels.extremum(+1, data.data(), data.size(), signal.first, signal.second);
+    FillFeatures(m_Features, row, windows, strip.Polarity, strip.Chamber, strip.Number);
+    m_Peaks[row]     = strip.Polarity == -1 ? windows.Minimum : windows.Maximum;
+    m_Baselines[row] = windows.Noise.first;
+  }
+  m_Selections.evaluate(m_FeatureColumns, m_Strips.size(), m_HitSelected.data(), m_NoisySelected.data());
+  for(std::size_t row = 0; row != m_Strips.size(); ++row)
+  {
+    const AnalysisConfiguration::Strip& strip{m_Strips[row]};
+    if(m_NoisySelected[row]) m_Efficiency.setNoisy(strip.Chamber);
+    ClassifyChannel(*m_Classifier, m_Features, row);
+    if(!m_HitSelected[row]) continue;
+    m_Efficiency.addHit(strip.Chamber);
+    AnalyseHit(*m_Clusters, *m_Pulses, *m_Classifier, strip.Chamber, strip.Number, m_Data[row].data(), m_Data[row].size(), strip.Polarity, m_Peaks[row].second, m_Baselines[row], period);
+  }
+  m_Clusters->endEvent();
+  m_Pulses->endEvent();
+  m_Classifier->endEvent();
+  m_Efficiency.endEvent();
+}
+
+RunSummary AnalysisEngine::getSummary() { return Summarise(m_Events, m_Efficiency, *m_Clusters, *m_Pulses, *m_Classifier); }
+
+RunSummary AnalysisEngine::takeSummary()
+{
+  const RunSummary summary{getSummary()};
+  reset();
+  return summary;
+}
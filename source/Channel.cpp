@@ -11,4 +11,5 @@ void Channel::clear()
   StartIndexCell = 0.0;
   Group          = 0.0;
   Data.clear();
+  Codes.clear();
 }
@@ -0,0 +1,60 @@
+#include "Checkpoint.hpp"
+
+#include "fmt/format.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+void Checkpoint::write(const std::string& filename) const
+{
+  const std::string temporary{filename + ".tmp"};
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if(!file) throw std::runtime_error(fmt::format("Can't open the checkpoint {} !", temporary));
+    // The summary is prefixed by its size, the state takes the rest of the file
+    const std::string summary{Summary.serialize()};
+    file << fmt::format("Checkpoint {} {} {} {} {}\n", Done, Events, NoisyLast ? 1 : 0, Options, summary.size()) << summary << State;
+    file.flush();
+    if(!file) throw std::runtime_error(fmt::format("Can't write the checkpoint {} !", temporary));
+  }
+  // rename replaces the previous checkpoint in one step
+  std::filesystem::rename(temporary, filename);
+}
+
+bool Checkpoint::read(const std::string& filename, Checkpoint& checkpoint)
+{
+  std::ifstream file(filename, std::ios::binary);
+  if(!file) return false;
+  std::string magic;
+  int         noisy{0};
+  std::size_t size{0};
+  file >> magic >> checkpoint.Done >> checkpoint.Events >> noisy >> checkpoint.Options >> size;
+  if(!file || magic != "Checkpoint") return false;
+  file.get();
+  checkpoint.NoisyLast = noisy != 0;
+  std::string summary(size, '\0');
+  if(!file.read(&summary[0], size)) return false;
+  try
+  {
+    checkpoint.Summary = RunSummary::deserialize(summary);
+  }
+  catch(const std::runtime_error&)
+  {
+    return false;
+  }
+  checkpoint.State.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+std::uint64_t Checkpoint::hash(const std::string& options)
+{
+  std::uint64_t hash{14695981039346656037ULL};
+  for(const char& character : options)
+  {
+    hash ^= static_cast<unsigned char>(character);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
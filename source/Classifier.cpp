@@ -0,0 +1,163 @@
+#include "Classifier.hpp"
+
+#include "State.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+Classifier::Classifier(const std::size_t& chambers, const double& noiseRatio, const double& streamerCharge, const std::size_t& batch) :
+    m_Chambers(chambers), m_NoiseRatio(noiseRatio), m_StreamerCharge(streamerCharge), m_Batch(std::max<std::size_t>(batch, 1)), m_Current(chambers), m_Counts(chambers)
+{
+  for(std::size_t f = 0; f != NbrFeatures; ++f) m_Features[f].resize(m_Batch * m_Chambers);
+  m_Scores.resize(m_Batch * m_Chambers);
+  m_Best.resize(m_Batch * m_Chambers);
+  m_Classes.resize(m_Batch * m_Chambers);
+  for(std::size_t chamber = 0; chamber != m_Chambers; ++chamber) m_Counts[chamber].fill(0);
+}
+
+std::string Classifier::toString(const EventClass& type)
+{
+  switch(type)
+  {
+    case EventClass::Avalanche: return "avalanche";
+    case EventClass::Streamer: return "streamer";
+    case EventClass::NoiseBurst: return "noise";
+    default: return "empty";
+  }
+}
+
+void Classifier::load(const std::string& filename)
+{
+  std::ifstream file(filename);
+  if(!file) throw std::runtime_error(fmt::format("Can't open the classifier model {} !", filename));
+  std::array<bool, NbrClasses> found{};
+  std::string                  line;
+  while(std::getline(file, line))
+  {
+    if(line.empty() || line[0] == '#') continue;
+    std::istringstream stream(line);
+    std::string        name;
+    stream >> name;
+    std::size_t type{NbrClasses};
+    for(std::size_t c = 0; c != NbrClasses; ++c)
+      if(toString(static_cast<EventClass>(c)) == name) type = c;
+    if(type == NbrClasses) throw std::runtime_error(fmt::format("Unknown class \"{}\" in {} !", name, filename));
+    for(std::size_t w = 0; w != NbrFeatures + 1; ++w)
+    {
+      if(!(stream >> m_Weights[type][w])) throw std::runtime_error(fmt::format("Class \"{}\" in {} needs {} weights and a bias !", name, filename, NbrFeatures));
+    }
+    found[type] = true;
+  }
+  if(std::find(found.begin(), found.end(), false) != found.end()) throw std::runtime_error(fmt::format("{} must give the weights of the {} classes !", filename, NbrClasses));
+  m_Linear = true;
+}
+
+void Classifier::addChannel(const int& chamber, const double& amplitude, const double& sigmaRatio)
+{
+  Current& current{m_Current[chamber]};
+  current.Amplitude = std::max(current.Amplitude, amplitude);
+  current.Ratio     = std::max(current.Ratio, sigmaRatio);
+}
+
+void Classifier::addHit(const int& chamber, const double& charge, const double& time)
+{
+  Current& current{m_Current[chamber]};
+  // No time when the leading edge doesn't cross the fraction (NaN)
+  if(!std::isnan(time))
+  {
+    current.TimeMin = std::min(current.TimeMin, time);
+    current.TimeMax = std::max(current.TimeMax, time);
+  }
+  current.Charge += charge;
+  current.Hits += 1;
+}
+
+void Classifier::endEvent()
+{
+  for(std::size_t chamber = 0; chamber != m_Chambers; ++chamber)
+  {
+    Current&          current{m_Current[chamber]};
+    const std::size_t row{m_Rows + chamber};
+    m_Features[Hits][row]      = current.Hits;
+    m_Features[Amplitude][row] = current.Amplitude;
+    m_Features[Charge][row]    = current.Charge;
+    m_Features[Ratio][row]     = current.Ratio;
+    m_Features[Spread][row]    = current.TimeMax >= current.TimeMin ? current.TimeMax - current.TimeMin : 0;
+    current                    = Current();
+  }
+  m_Rows += m_Chambers;
+  ++m_Events;
+  if(m_Rows == m_Features[0].size()) score();
+}
+
+void Classifier::flush()
+{
+  if(m_Rows != 0) score();
+}
+
+// All the rows of the batch are scored together, the loops run over the rows so they vectorise
+void Classifier::score()
+{
+  const std::size_t rows{m_Rows};
+  unsigned char*    classes{m_Classes.data()};
+  const double*     hits{m_Features[Hits].data()};
+  const double*     charge{m_Features[Charge].data()};
+  const double*     ratio{m_Features[Ratio].data()};
+  if(m_Linear)
+  {
+    std::fill(classes, classes + rows, 0);
+    double* scores{m_Scores.data()};
+    double* best{m_Best.data()};
+    for(std::size_t c = 0; c != NbrClasses; ++c)
+    {
+      const std::array<double, NbrFeatures + 1>& weights{m_Weights[c]};
+      for(std::size_t r = 0; r != rows; ++r) scores[r] = weights[NbrFeatures];
+      for(std::size_t f = 0; f != NbrFeatures; ++f)
+      {
+        const double  w{weights[f]};
+        const double* x{m_Features[f].data()};
+        for(std::size_t r = 0; r != rows; ++r) scores[r] += w * x[r];
+      }
+      for(std::size_t r = 0; r != rows; ++r)
+      {
+        const bool better{c == 0 || scores[r] > best[r]};
+        classes[r] = better ? static_cast<unsigned char>(c) : classes[r];
+        best[r]    = better ? scores[r] : best[r];
+      }
+    }
+  }
+  else
+  {
+    const double noise{m_NoiseRatio};
+    const double streamer{m_StreamerCharge};
+    for(std::size_t r = 0; r != rows; ++r)
+    {
+      const unsigned char hit{static_cast<unsigned char>(hits[r] > 0 ? (charge[r] >= streamer ? 2 : 1) : 0)};
+      classes[r] = ratio[r] >= noise ? static_cast<unsigned char>(3) : hit;
+    }
+  }
+  for(std::size_t r = 0; r != rows; ++r) ++m_Counts[r % m_Chambers][classes[r]];
+  m_Rows = 0;
+}
+
+void Classifier::save(std::ostream& stream)
+{
+  flush();
+  std::vector<std::uint64_t> counts;
+  for(const std::array<std::uint64_t, NbrClasses>& chamber : m_Counts) counts.insert(counts.end(), chamber.begin(), chamber.end());
+  State::write(stream, m_Events);
+  State::write(stream, counts);
+}
+
+void Classifier::restore(std::istream& stream)
+{
+  std::vector<std::uint64_t> counts(m_Chambers * NbrClasses);
+  State::read(stream, m_Events);
+  State::read(stream, counts);
+  for(std::size_t i = 0; i != counts.size(); ++i) m_Counts[i / NbrClasses][i % NbrClasses] = counts[i];
+  m_Rows = 0;
+}
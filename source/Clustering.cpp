@@ -0,0 +1,114 @@
+#include "Clustering.hpp"
+
+#include "State.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+Histogram TimeHistogram(const std::size_t& chamber, const double& timeMax) { return Histogram(256, 0, timeMax, fmt::format("Cluster_time_chamber{}", chamber), "Cluster time;Time (ticks);Clusters"); }
+}  // namespace
+
+ClusterBuilder::ClusterBuilder(const std::vector<std::vector<int>>& strips, const double& window, const double& timeMax) : m_Window(window)
+{
+  m_Chambers.resize(strips.size());
+  for(std::size_t chamber = 0; chamber != strips.size(); ++chamber)
+  {
+    Chamber&          data{m_Chambers[chamber]};
+    const std::size_t capacity{std::max<std::size_t>(strips[chamber].size(), 1)};
+    int               first{0};
+    int               last{1};
+    if(!strips[chamber].empty())
+    {
+      first = *std::min_element(strips[chamber].begin(), strips[chamber].end());
+      last  = *std::max_element(strips[chamber].begin(), strips[chamber].end()) + 1;
+    }
+    data.Hits.resize(capacity);
+    data.Clusters.resize(capacity);
+    data.Size   = Histogram(capacity, 0.5, capacity + 0.5, fmt::format("Cluster_size_chamber{}", chamber), "Cluster size;Number of strips;Clusters");
+    data.Number = Histogram(capacity + 1, -0.5, capacity + 0.5, fmt::format("Cluster_number_chamber{}", chamber), "Clusters by event;Number of clusters;Events");
+    data.Time   = TimeHistogram(chamber, timeMax);
+    data.Strips = Histogram(last - first, first, last, fmt::format("Strip_hits_chamber{}", chamber), "Hits by strip;Strip;Hits");
+  }
+}
+
+void ClusterBuilder::setRecordLength(const std::size_t& length)
+{
+  if(m_Events != 0) throw std::runtime_error(fmt::format("Record length of the cluster times set after {} events !", m_Events));
+  for(std::size_t chamber = 0; chamber != m_Chambers.size(); ++chamber) m_Chambers[chamber].Time = TimeHistogram(chamber, static_cast<double>(length));
+}
+
+void ClusterBuilder::addHit(const int& chamber, const int& strip, const double& time)
+{
+  Chamber& data{m_Chambers[chamber]};
+  if(data.NbrHits == data.Hits.size())
+  {
+    ++m_LostHits;
+    return;
+  }
+  data.Hits[data.NbrHits].Strip = strip;
+  data.Hits[data.NbrHits].Time  = time;
+  ++data.NbrHits;
+  data.Strips.fill(strip);
+}
+
+void ClusterBuilder::build(const int& chamber, Chamber& data)
+{
+  data.NbrClusters = 0;
+  if(data.NbrHits == 0) return;
+  std::sort(data.Hits.begin(), data.Hits.begin() + data.NbrHits, [](const Hit& a, const Hit& b) { return a.Strip < b.Strip; });
+  Cluster* current{&data.Clusters[0]};
+  int      last{data.Hits[0].Strip};
+  *current = Cluster{chamber, last, 1, data.Hits[0].Time};
+  for(std::size_t i = 1; i != data.NbrHits; ++i)
+  {
+    const Hit& hit{data.Hits[i]};
+    if(hit.Strip == last + 1 && std::abs(hit.Time - current->Time) <= m_Window)
+    {
+      ++current->Size;
+      current->Time = std::min(current->Time, hit.Time);
+    }
+    else
+    {
+      ++data.NbrClusters;
+      current  = &data.Clusters[data.NbrClusters];
+      *current = Cluster{chamber, hit.Strip, 1, hit.Time};
+    }
+    last = hit.Strip;
+  }
+  ++data.NbrClusters;
+}
+
+void ClusterBuilder::endEvent()
+{
+  for(std::size_t chamber = 0; chamber != m_Chambers.size(); ++chamber)
+  {
+    Chamber& data{m_Chambers[chamber]};
+    build(static_cast<int>(chamber), data);
+    data.Number.fill(data.NbrClusters);
+    for(std::size_t i = 0; i != data.NbrClusters; ++i)
+    {
+      data.Size.fill(data.Clusters[i].Size);
+      data.Time.fill(data.Clusters[i].Time);
+    }
+    data.NbrHits = 0;
+  }
+  ++m_Events;
+}
+
+void ClusterBuilder::save(std::ostream& stream) const
+{
+  State::write(stream, m_Events, m_LostHits);
+  for(const Chamber& data : m_Chambers)
+    for(const Histogram* histogram : {&data.Size, &data.Number, &data.Time, &data.Strips}) histogram->write(stream);
+}
+
+void ClusterBuilder::restore(std::istream& stream)
+{
+  State::read(stream, m_Events, m_LostHits);
+  for(Chamber& data : m_Chambers)
+    for(Histogram* histogram : {&data.Size, &data.Number, &data.Time, &data.Strips}) *histogram = Histogram::read(stream);
+}
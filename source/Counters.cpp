@@ -0,0 +1,201 @@
+#include "Counters.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+double now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}  // namespace
+
+PerfCounters::PerfCounters()
+{
+#if defined(__linux__)
+  const std::array<std::uint64_t, NbrCounters> configs{PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+  bool denied{false};
+  for(std::size_t counter = 0; counter != NbrCounters; ++counter)
+  {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size   = sizeof(attributes);
+    attributes.type   = PERF_TYPE_HARDWARE;
+    attributes.config = configs[counter];
+    // The first one opened leads the group, the others start and stop with it
+    attributes.disabled       = m_Leader < 0;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv     = 1;
+    attributes.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // This thread, any CPU
+    const long descriptor{syscall(__NR_perf_event_open, &attributes, 0, -1, m_Leader, PERF_FLAG_FD_CLOEXEC)};
+    if(descriptor < 0)
+    {
+      denied = denied || errno == EACCES || errno == EPERM;
+      m_Error += fmt::format("{}{} : {}", m_Error.empty() ? "" : ", ", getName(static_cast<Counter>(counter)), std::strerror(errno));
+      continue;
+    }
+    m_Descriptors[counter] = static_cast<int>(descriptor);
+    if(m_Leader < 0) m_Leader = m_Descriptors[counter];
+    m_Slots[counter] = m_Opened++;
+  }
+  if(denied) m_Error += " (see /proc/sys/kernel/perf_event_paranoid)";
+  if(m_Leader < 0) return;
+  ioctl(m_Leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(m_Leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+  m_Error = "perf_event_open is only available on Linux";
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(__linux__)
+  for(const int& descriptor : m_Descriptors)
+    if(descriptor >= 0) close(descriptor);
+#endif
+}
+
+PerfCounters::Values PerfCounters::read() const
+{
+  Values values;
+  values.Seconds = now();
+#if defined(__linux__)
+  if(m_Leader < 0) return values;
+  // Number of counters, time enabled, time running, counts
+  std::array<std::uint64_t, 3 + NbrCounters> buffer{};
+  if(::read(m_Leader, buffer.data(), sizeof(buffer)) < static_cast<ssize_t>((3 + m_Opened) * sizeof(std::uint64_t))) return values;
+  // Multiplexed with other events : extrapolated to the time enabled
+  const double scale{buffer[2] != 0 && buffer[2] < buffer[1] ? static_cast<double>(buffer[1]) / buffer[2] : 1.0};
+  for(std::size_t counter = 0; counter != NbrCounters; ++counter)
+    if(m_Descriptors[counter] >= 0) values.Counts[counter] = static_cast<std::uint64_t>(buffer[3 + m_Slots[counter]] * scale);
+#endif
+  return values;
+}
+
+std::string PerfCounters::getName(const Counter& counter)
+{
+  switch(counter)
+  {
+    case Cycles: return "cycles";
+    case Instructions: return "instructions";
+    case CacheMisses: return "cache misses";
+    case BranchMisses: return "branch misses";
+    case NbrCounters: break;
+  }
+  return "";
+}
+
+std::size_t StageProfile::addStage(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Stages.push_back(name);
+  return m_Stages.size() - 1;
+}
+
+void StageProfile::add(const std::size_t& stage, const std::size_t& thread, const PerfCounters::Values& difference)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  Sums& sums{m_Sums[{stage, thread}]};
+  ++sums.Calls;
+  sums.Seconds += difference.Seconds;
+  for(std::size_t counter = 0; counter != PerfCounters::NbrCounters; ++counter) sums.Counts[counter] += difference.Counts[counter];
+}
+
+void StageProfile::setAvailable(const PerfCounters& counters)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  for(std::size_t counter = 0; counter != PerfCounters::NbrCounters; ++counter) m_Available[counter] = m_Available[counter] && counters.isAvailable(static_cast<PerfCounters::Counter>(counter));
+  if(m_Error.empty()) m_Error = counters.getError();
+}
+
+StageProfile::Sums StageProfile::getSums(const std::size_t& stage) const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  Sums total;
+  for(const auto& [key, sums] : m_Sums)
+  {
+    if(key.first != stage) continue;
+    total.Calls += sums.Calls;
+    total.Seconds += sums.Seconds;
+    for(std::size_t counter = 0; counter != PerfCounters::NbrCounters; ++counter) total.Counts[counter] += sums.Counts[counter];
+  }
+  return total;
+}
+
+std::string StageProfile::report(const std::uint64_t& events, const std::uint64_t& samples) const
+{
+  const double perEvent{1.0 / std::max<std::uint64_t>(events, 1)};
+  const double perSample{1.0 / std::max<std::uint64_t>(samples, 1)};
+  std::array<bool, PerfCounters::NbrCounters> available;
+  std::string                                 error;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    available = m_Available;
+    error     = m_Error;
+  }
+  // Unavailable counters are shown as -
+  auto column = [&](const PerfCounters::Counter& counter, const double& value, const std::size_t& width, const std::size_t& precision) { return available[counter] ? fmt::format("{:>{}.{}f}", value, width, precision) : fmt::format("{:>{}}", "-", width); };
+  auto line   = [&](const std::string& name, const Sums& sums) {
+    const double cycles{static_cast<double>(sums.Counts[PerfCounters::Cycles])};
+    const double instructions{static_cast<double>(sums.Counts[PerfCounters::Instructions])};
+    const double cacheMisses{static_cast<double>(sums.Counts[PerfCounters::CacheMisses])};
+    const double branchMisses{static_cast<double>(sums.Counts[PerfCounters::BranchMisses])};
+    std::string  ipc{available[PerfCounters::Cycles] && available[PerfCounters::Instructions] && cycles > 0 ? fmt::format("{:>6.2f}", instructions / cycles) : fmt::format("{:>6}", "-")};
+    return fmt::format("\t{:<24} {:>10.3f} {:>10.1f} {:>8.2f} {} {} {} {} {} {} {}\n", name, sums.Seconds * 1e3, sums.Seconds * 1e9 * perEvent, sums.Seconds * 1e9 * perSample, column(PerfCounters::Cycles, cycles * perEvent, 12, 0), column(PerfCounters::Cycles, cycles * perSample, 9, 2), column(PerfCounters::Instructions, instructions * perEvent, 12, 0), ipc, column(PerfCounters::CacheMisses, cacheMisses * perEvent, 10, 2), column(PerfCounters::CacheMisses, cacheMisses * perSample, 9, 4), column(PerfCounters::BranchMisses, branchMisses * perEvent, 10, 2));
+  };
+  std::string text{fmt::format("\t{:<24} {:>10} {:>10} {:>8} {:>12} {:>9} {:>12} {:>6} {:>10} {:>9} {:>10}\n", "Stage", "ms", "ns/event", "ns/samp", "cycles/evt", "cyc/samp", "instr/evt", "IPC", "cmiss/evt", "cmiss/smp", "bmiss/evt")};
+  for(std::size_t stage = 0; stage != m_Stages.size(); ++stage)
+  {
+    const Sums sums{getSums(stage)};
+    if(sums.Calls != 0) text += line(m_Stages[stage], sums);
+  }
+  // By thread only when a stage was measured by several of them
+  std::map<std::pair<std::size_t, std::size_t>, Sums> byThread;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    byThread = m_Sums;
+  }
+  for(std::size_t stage = 0; stage != m_Stages.size(); ++stage)
+  {
+    std::size_t threads{0};
+    for(const auto& entry : byThread) threads += entry.first.first == stage;
+    if(threads < 2) continue;
+    for(const auto& [key, sums] : byThread)
+      if(key.first == stage) text += line(fmt::format("{} (thread {})", m_Stages[stage], key.second), sums);
+  }
+  if(!error.empty()) text += fmt::format("\tHardware counters unavailable : {}\n", error);
+  return text;
+}
+
+StageClock::StageClock(StageProfile* profile, const std::size_t& thread) : m_Profile(profile), m_Thread(thread)
+{
+  if(m_Profile == nullptr) return;
+  m_Counters = std::make_unique<PerfCounters>();
+  m_Profile->setAvailable(*m_Counters);
+  m_Last = m_Counters->read();
+}
+
+void StageClock::lap(const std::size_t& stage)
+{
+  if(m_Profile == nullptr) return;
+  const PerfCounters::Values current{m_Counters->read()};
+  PerfCounters::Values       difference;
+  difference.Seconds = current.Seconds - m_Last.Seconds;
+  // A scaled count can go back a little when the multiplexing changes
+  for(std::size_t counter = 0; counter != PerfCounters::NbrCounters; ++counter) difference.Counts[counter] = current.Counts[counter] > m_Last.Counts[counter] ? current.Counts[counter] - m_Last.Counts[counter] : 0;
+  m_Profile->add(stage, m_Thread, difference);
+  m_Last = current;
+}
@@ -0,0 +1,187 @@
+#include "Crosstalk.hpp"
+
+#include "State.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+constexpr std::size_t Lanes{8};
+}
+
+CommonMode::CommonMode(const std::vector<std::vector<std::size_t>>& groups, const std::vector<double>& weights) : m_Groups(groups), m_Weights(weights)
+{
+  std::size_t largest{0};
+  for(const std::vector<std::size_t>& group : m_Groups)
+  {
+    largest = std::max(largest, group.size());
+    for(const std::size_t& channel : group)
+      if(channel >= m_Weights.size()) throw std::runtime_error(fmt::format("No common mode weight for channel {} !", channel));
+  }
+  m_Values.resize(largest);
+}
+
+void CommonMode::apply(const std::vector<double*>& data, const std::size_t& length)
+{
+  for(const std::vector<std::size_t>& group : m_Groups)
+  {
+    for(std::size_t t = 0; t != length; ++t)
+    {
+      std::size_t values{0};
+      for(const std::size_t& channel : group)
+        if(channel < data.size() && data[channel] != nullptr) m_Values[values++] = data[channel][t];
+      if(values < 2) continue;
+      std::nth_element(m_Values.begin(), m_Values.begin() + values / 2, m_Values.begin() + values);
+      double common{m_Values[values / 2]};
+      if(values % 2 == 0) common = 0.5 * (common + *std::max_element(m_Values.begin(), m_Values.begin() + values / 2));
+      for(const std::size_t& channel : group)
+        if(channel < data.size() && data[channel] != nullptr) data[channel][t] -= m_Weights[channel] * common;
+    }
+  }
+}
+
+Crosstalk::Crosstalk(const std::size_t& channels, const std::size_t& samples, const std::size_t& batch) :
+    m_Channels(channels), m_Samples(samples), m_BatchEvents(std::max<std::size_t>(batch, 1)), m_Batch(m_BatchEvents * samples * channels, 0), m_Present(channels, 0), m_Products(channels * channels, 0), m_Sums(channels, 0), m_Hits(channels, 0), m_Coincidences(channels * channels, 0)
+{
+  m_EventHits.reserve(channels);
+}
+
+void Crosstalk::addNoise(const std::size_t& channel, const double* data, const std::size_t& length, const std::size_t& begin)
+{
+  if(channel >= m_Channels || begin + m_Samples > length) return;
+  // Column of the channel in the rows of the current event
+  double* rows{&m_Batch[m_BatchSize * m_Samples * m_Channels + channel]};
+  for(std::size_t s = 0; s != m_Samples; ++s) rows[s * m_Channels] = data[begin + s];
+  if(m_Present[channel] == 0) ++m_NbrPresent;
+  m_Present[channel] = 1;
+}
+
+void Crosstalk::addHit(const std::size_t& channel)
+{
+  if(channel < m_Channels) m_EventHits.push_back(channel);
+}
+
+void Crosstalk::endEvent()
+{
+  ++m_Events;
+  for(const std::size_t& i : m_EventHits)
+  {
+    ++m_Hits[i];
+    for(const std::size_t& j : m_EventHits) ++m_Coincidences[i * m_Channels + j];
+  }
+  m_EventHits.clear();
+  if(m_NbrPresent == m_Channels && m_Samples != 0)
+  {
+    ++m_NoiseEvents;
+    if(++m_BatchSize == m_BatchEvents) update();
+  }
+  std::fill(m_Present.begin(), m_Present.end(), 0);
+  m_NbrPresent = 0;
+}
+
+void Crosstalk::update()
+{
+  const std::size_t rows{m_BatchSize * m_Samples};
+  const std::size_t n{m_Channels};
+  std::size_t       r{0};
+  // Rank-4 updates : each element of the triangle is read and written once for 4 rows
+  for(; r + 4 <= rows; r += 4)
+  {
+    const double* x0{&m_Batch[r * n]};
+    const double* x1{x0 + n};
+    const double* x2{x1 + n};
+    const double* x3{x2 + n};
+    for(std::size_t i = 0; i != n; ++i)
+    {
+      const double a0{x0[i]}, a1{x1[i]}, a2{x2[i]}, a3{x3[i]};
+      double*      products{&m_Products[i * n]};
+      // Tiles of Lanes columns in a local array : no aliasing with the rows so the products vectorise
+      std::size_t j{i};
+      for(; j + Lanes <= n; j += Lanes)
+      {
+        double tile[Lanes];
+        for(std::size_t l = 0; l != Lanes; ++l) tile[l] = a0 * x0[j + l] + a1 * x1[j + l] + a2 * x2[j + l] + a3 * x3[j + l];
+        for(std::size_t l = 0; l != Lanes; ++l) products[j + l] += tile[l];
+      }
+      for(; j != n; ++j) products[j] += a0 * x0[j] + a1 * x1[j] + a2 * x2[j] + a3 * x3[j];
+      m_Sums[i] += (a0 + a1) + (a2 + a3);
+    }
+  }
+  for(; r != rows; ++r)
+  {
+    const double* x{&m_Batch[r * n]};
+    for(std::size_t i = 0; i != n; ++i)
+    {
+      double* products{&m_Products[i * n]};
+      for(std::size_t j = i; j != n; ++j) products[j] += x[i] * x[j];
+      m_Sums[i] += x[i];
+    }
+  }
+  m_Rows += rows;
+  m_BatchSize = 0;
+}
+
+void Crosstalk::finish()
+{
+  if(m_BatchSize != 0) update();
+}
+
+double Crosstalk::getCovariance(const std::size_t& i, const std::size_t& j) const
+{
+  if(m_Rows < 2) return std::nan("");
+  const std::size_t low{std::min(i, j)};
+  const std::size_t high{std::max(i, j)};
+  return (m_Products[low * m_Channels + high] - m_Sums[i] * m_Sums[j] / m_Rows) / (m_Rows - 1);
+}
+
+double Crosstalk::getCorrelation(const std::size_t& i, const std::size_t& j) const
+{
+  return getCovariance(i, j) / std::sqrt(getCovariance(i, i) * getCovariance(j, j));
+}
+
+CommonMode Crosstalk::getCommonMode(const std::vector<std::vector<std::size_t>>& groups) const
+{
+  std::vector<double> weights(m_Channels, 0);
+  for(const std::vector<std::size_t>& group : groups)
+  {
+    // cov(x_i, m) = sum_j C_ij / K, var(m) = sum_jk C_jk / K^2
+    double variance{0};
+    for(const std::size_t& j : group)
+      for(const std::size_t& k : group) variance += getCovariance(j, k);
+    variance /= group.size() * group.size();
+    for(const std::size_t& i : group)
+    {
+      double covariance{0};
+      for(const std::size_t& j : group) covariance += getCovariance(i, j);
+      covariance /= group.size();
+      weights[i] = (group.size() < 2 || !(variance > 0)) ? 0 : covariance / variance;
+    }
+  }
+  return CommonMode(groups, weights);
+}
+
+void Crosstalk::save(std::ostream& stream) const
+{
+  State::write(stream, m_BatchSize, m_Rows, m_Events, m_NoiseEvents);
+  State::write(stream, std::vector<double>(m_Batch.begin(), m_Batch.begin() + m_BatchSize * m_Samples * m_Channels));
+  State::write(stream, m_Products);
+  State::write(stream, m_Sums);
+  State::write(stream, m_Hits);
+  State::write(stream, m_Coincidences);
+}
+
+void Crosstalk::restore(std::istream& stream)
+{
+  State::read(stream, m_BatchSize, m_Rows, m_Events, m_NoiseEvents);
+  if(m_BatchSize >= m_BatchEvents) throw std::runtime_error(fmt::format("Crosstalk state with {} events waiting for batches of {} !", m_BatchSize, m_BatchEvents));
+  std::vector<double> batch(m_BatchSize * m_Samples * m_Channels);
+  State::read(stream, batch);
+  std::copy(batch.begin(), batch.end(), m_Batch.begin());
+  State::read(stream, m_Products);
+  State::read(stream, m_Sums);
+  State::read(stream, m_Hits);
+  State::read(stream, m_Coincidences);
+}
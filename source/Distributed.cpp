@@ -0,0 +1,347 @@
+#include "Distributed.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
+using SocketLength = int;
+#else
+  #include <arpa/inet.h>
+  #include <netdb.h>
+  #include <netinet/in.h>
+  #include <poll.h>
+  #include <sys/socket.h>
+  #include <unistd.h>
+using SocketLength = socklen_t;
+#endif
+
+namespace
+{
+#if defined(MSG_NOSIGNAL)
+constexpr int SendFlags{MSG_NOSIGNAL};
+#else
+constexpr int SendFlags{0};
+#endif
+constexpr std::size_t MaximumMessage{std::size_t(1) << 30};
+
+void startup()
+{
+#ifdef _WIN32
+  static const bool started = []() {
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+  }();
+  if(!started) throw std::runtime_error("Can't initialise Winsock !");
+#endif
+}
+
+void closeHandle(const std::intptr_t& handle)
+{
+  if(handle == -1) return;
+#ifdef _WIN32
+  closesocket(static_cast<SOCKET>(handle));
+#else
+  close(static_cast<int>(handle));
+#endif
+}
+
+// The worker can die while we write to it : no SIGPIPE, the error is reported by the return value
+void noSignal(const std::intptr_t& handle)
+{
+#if defined(SO_NOSIGPIPE)
+  int on{1};
+  setsockopt(static_cast<int>(handle), SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+  static_cast<void>(handle);
+#endif
+}
+
+// recv gives up after seconds (the message is then lost)
+void receiveTimeout(const std::intptr_t& handle, const double& seconds)
+{
+#ifdef _WIN32
+  const DWORD timeout{static_cast<DWORD>(seconds * 1000)};
+#else
+  timeval timeout{};
+  timeout.tv_sec  = static_cast<decltype(timeout.tv_sec)>(seconds);
+  timeout.tv_usec = static_cast<decltype(timeout.tv_usec)>((seconds - timeout.tv_sec) * 1e6);
+#endif
+  setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+bool sendAll(const std::intptr_t& handle, const char* data, std::size_t size)
+{
+  while(size != 0)
+  {
+    const auto sent = ::send(handle, data, static_cast<int>(std::min<std::size_t>(size, 1 << 20)), SendFlags);
+    if(sent <= 0) return false;
+    data += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+bool receiveAll(const std::intptr_t& handle, char* data, std::size_t size)
+{
+  while(size != 0)
+  {
+    const auto received = ::recv(handle, data, static_cast<int>(std::min<std::size_t>(size, 1 << 20)), 0);
+    if(received <= 0) return false;
+    data += received;
+    size -= received;
+  }
+  return true;
+}
+
+bool sendMessage(const std::intptr_t& handle, const std::string& type, const std::string& payload)
+{
+  const std::string header{fmt::format("{} {}\n", type, payload.size())};
+  return sendAll(handle, header.data(), header.size()) && sendAll(handle, payload.data(), payload.size());
+}
+
+// Header read byte by byte so nothing of the next message is consumed
+bool receiveMessage(const std::intptr_t& handle, std::string& type, std::string& payload)
+{
+  std::string header;
+  char        character{0};
+  while(header.size() < 64)
+  {
+    if(!receiveAll(handle, &character, 1)) return false;
+    if(character == '\n') break;
+    header += character;
+  }
+  std::istringstream stream(header);
+  std::size_t        size{0};
+  if(!(stream >> type >> size) || size > MaximumMessage) return false;
+  payload.assign(size, '\0');
+  return size == 0 || receiveAll(handle, &payload[0], size);
+}
+}  // namespace
+
+std::string Task::serialize() const
+{
+  std::string task{fmt::format("{} {} {} {} {}\n", ID, Run, First, Events, Files.size())};
+  for(std::size_t i = 0; i != Files.size(); ++i) task += Files[i] + "\n";
+  return task;
+}
+
+Task Task::deserialize(const std::string& task)
+{
+  std::istringstream stream(task);
+  Task               result;
+  std::size_t        files{0};
+  stream >> result.ID >> result.Run >> result.First >> result.Events >> files;
+  if(!stream) throw std::runtime_error("Invalid task !");
+  stream.get();
+  result.Files.resize(files);
+  for(std::size_t i = 0; i != files; ++i) std::getline(stream, result.Files[i]);
+  return result;
+}
+
+Coordinator::Coordinator(const unsigned short& port, const double& timeout, const double& idle, const double& receive) : m_Timeout(timeout), m_Idle(idle), m_Receive(receive)
+{
+  startup();
+  m_Listener = static_cast<std::intptr_t>(socket(AF_INET, SOCK_STREAM, 0));
+  if(m_Listener == -1) throw std::runtime_error("Can't create the coordinator socket !");
+  int reuse{1};
+  setsockopt(m_Listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+  sockaddr_in address{};
+  address.sin_family      = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port        = htons(port);
+  if(bind(m_Listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(m_Listener, 64) != 0)
+  {
+    closeHandle(m_Listener);
+    throw std::runtime_error(fmt::format("Can't listen on port {} ({}) !", port, std::strerror(errno)));
+  }
+  SocketLength length{sizeof(address)};
+  getsockname(m_Listener, reinterpret_cast<sockaddr*>(&address), &length);
+  m_Port = ntohs(address.sin_port);
+}
+
+Coordinator::~Coordinator()
+{
+  for(std::size_t i = 0; i != m_Peers.size(); ++i) closeHandle(m_Peers[i].Handle);
+  closeHandle(m_Listener);
+}
+
+void Coordinator::addTask(const Task& task)
+{
+  m_Tasks.push_back(task);
+  m_Tasks.back().ID = m_Tasks.size() - 1;
+  m_Done.push_back(false);
+  m_Pending.push_back(m_Tasks.size() - 1);
+}
+
+void Coordinator::drop(const std::size_t& peer)
+{
+  // The task of a lost worker goes first in the queue
+  if(m_Peers[peer].Busy && !m_Done[m_Peers[peer].Task])
+  {
+    m_Pending.push_front(m_Peers[peer].Task);
+    ++m_Reassigned;
+  }
+  closeHandle(m_Peers[peer].Handle);
+  m_Peers.erase(m_Peers.begin() + peer);
+}
+
+void Coordinator::serve(Peer& peer)
+{
+  while(!m_Pending.empty() && m_Done[m_Pending.front()]) m_Pending.pop_front();
+  if(m_Pending.empty()) return;
+  peer.Task = m_Pending.front();
+  m_Pending.pop_front();
+  peer.Busy    = true;
+  peer.Waiting = false;
+  peer.Since   = std::chrono::steady_clock::now();
+}
+
+void Coordinator::run(const std::function<void(const Task&, const std::string&)>& result, const std::function<void(const Task&, const std::string&)>& failed)
+{
+  std::size_t remaining{0};
+  for(std::size_t i = 0; i != m_Done.size(); ++i)
+    if(!m_Done[i]) ++remaining;
+  auto lastPeer = std::chrono::steady_clock::now();
+  while(remaining != 0)
+  {
+#ifdef _WIN32
+    std::vector<WSAPOLLFD> descriptors{{static_cast<SOCKET>(m_Listener), POLLIN, 0}};
+    for(std::size_t i = 0; i != m_Peers.size(); ++i) descriptors.push_back({static_cast<SOCKET>(m_Peers[i].Handle), POLLIN, 0});
+    const int ready{WSAPoll(descriptors.data(), static_cast<ULONG>(descriptors.size()), 200)};
+#else
+    std::vector<pollfd> descriptors{{static_cast<int>(m_Listener), POLLIN, 0}};
+    for(std::size_t i = 0; i != m_Peers.size(); ++i) descriptors.push_back({static_cast<int>(m_Peers[i].Handle), POLLIN, 0});
+    const int ready{poll(descriptors.data(), descriptors.size(), 200)};
+    if(ready < 0 && errno == EINTR) continue;
+#endif
+    if(ready < 0) throw std::runtime_error("Coordinator poll failed !");
+    // Messages of the workers polled (the ones accepted below wait for the next round), backward so drop keeps the indices
+    for(std::size_t i = descriptors.size() - 1; i-- > 0;)
+    {
+      if((descriptors[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) == 0) continue;
+      std::string type;
+      std::string payload;
+      if(!receiveMessage(m_Peers[i].Handle, type, payload))
+      {
+        drop(i);
+        continue;
+      }
+      if(type == "READY") m_Peers[i].Waiting = true;
+      else if(type == "RESULT" || type == "FAILED")
+      {
+        // "<task ID>\n<result or reason>" for the task given to this worker, anything else : the worker is dropped
+        // and its task given again
+        const std::size_t separator{payload.find('\n')};
+        std::istringstream stream(payload.substr(0, separator));
+        std::size_t        id{0};
+        if(separator == std::string::npos || !(stream >> id) || !(stream >> std::ws).eof() || !m_Peers[i].Busy || m_Peers[i].Task != id)
+        {
+          drop(i);
+          continue;
+        }
+        m_Peers[i].Busy = false;
+        if(!m_Done[id])
+        {
+          m_Done[id] = true;
+          --remaining;
+          if(type == "RESULT") result(m_Tasks[id], payload.substr(separator + 1));
+          else
+          {
+            ++m_Failed;
+            if(failed) failed(m_Tasks[id], payload.substr(separator + 1));
+          }
+        }
+      }
+      else
+        drop(i);
+    }
+    if((descriptors[0].revents & POLLIN) != 0)
+    {
+      const std::intptr_t handle{static_cast<std::intptr_t>(accept(m_Listener, nullptr, nullptr))};
+      if(handle != -1)
+      {
+        noSignal(handle);
+        receiveTimeout(handle, m_Receive);
+        m_Peers.emplace_back();
+        m_Peers.back().Handle = handle;
+        ++m_Workers;
+      }
+    }
+    const auto now = std::chrono::steady_clock::now();
+    for(std::size_t i = m_Peers.size(); i-- > 0;)
+    {
+      if(m_Peers[i].Busy && m_Timeout > 0 && std::chrono::duration<double>(now - m_Peers[i].Since).count() > m_Timeout) drop(i);
+    }
+    for(std::size_t i = m_Peers.size(); i-- > 0;)
+    {
+      if(!m_Peers[i].Waiting || m_Peers[i].Busy) continue;
+      serve(m_Peers[i]);
+      if(m_Peers[i].Busy && !sendMessage(m_Peers[i].Handle, "TASK", m_Tasks[m_Peers[i].Task].serialize())) drop(i);
+    }
+    if(!m_Peers.empty()) lastPeer = now;
+    else if(remaining != 0 && std::chrono::duration<double>(now - lastPeer).count() > m_Idle)
+      throw std::runtime_error(fmt::format("No worker connected since {} s and {} tasks remain !", m_Idle, remaining));
+  }
+  for(std::size_t i = 0; i != m_Peers.size(); ++i)
+  {
+    sendMessage(m_Peers[i].Handle, "DONE", "");
+    closeHandle(m_Peers[i].Handle);
+  }
+  m_Peers.clear();
+}
+
+Worker::Worker(const std::string& host, const unsigned short& port)
+{
+  startup();
+  addrinfo hints{};
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses{nullptr};
+  if(getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) throw std::runtime_error(fmt::format("Can't resolve {} !", host));
+  for(addrinfo* address = addresses; address != nullptr && m_Handle == -1; address = address->ai_next)
+  {
+    m_Handle = static_cast<std::intptr_t>(socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+    if(m_Handle == -1) continue;
+    if(connect(m_Handle, address->ai_addr, static_cast<SocketLength>(address->ai_addrlen)) != 0)
+    {
+      closeHandle(m_Handle);
+      m_Handle = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  if(m_Handle == -1) throw std::runtime_error(fmt::format("Can't connect to the coordinator {}:{} !", host, port));
+  noSignal(m_Handle);
+}
+
+Worker::~Worker()
+{
+  closeHandle(m_Handle);
+}
+
+bool Worker::next(Task& task)
+{
+  std::string type;
+  std::string payload;
+  if(!sendMessage(m_Handle, "READY", "") || !receiveMessage(m_Handle, type, payload)) throw std::runtime_error("Lost the connection to the coordinator !");
+  if(type == "DONE") return false;
+  if(type != "TASK") throw std::runtime_error(fmt::format("Unexpected message {} from the coordinator !", type));
+  task = Task::deserialize(payload);
+  return true;
+}
+
+void Worker::send(const Task& task, const std::string& result)
+{
+  if(!sendMessage(m_Handle, "RESULT", fmt::format("{}\n", task.ID) + result)) throw std::runtime_error("Lost the connection to the coordinator !");
+}
+
+void Worker::fail(const Task& task, const std::string& reason)
+{
+  if(!sendMessage(m_Handle, "FAILED", fmt::format("{}\n", task.ID) + reason)) throw std::runtime_error("Lost the connection to the coordinator !");
+}
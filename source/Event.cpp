@@ -20,3 +20,15 @@ void Event::clear()
   FamilyCode     = "";
   Channels.clear();
 }
+
+void Event::copyHeader(const Event& event)
+{
+  BoardID        = event.BoardID;
+  EventNumber    = event.EventNumber;
+  Pattern        = event.Pattern;
+  ChannelMask    = event.ChannelMask;
+  TriggerTimeTag = event.TriggerTimeTag;
+  Period_ns      = event.Period_ns;
+  Model          = event.Model;
+  FamilyCode     = event.FamilyCode;
+}
@@ -0,0 +1,263 @@
+#include "EventBuilder.hpp"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+EventBuilder::EventBuilder(const std::vector<std::string>& files, const std::string& treeName, const double& window, const unsigned int& rolloverBits) : m_Window(window), m_Rollover(std::ldexp(1.0, rolloverBits))
+{
+  if(files.empty()) throw std::runtime_error("EventBuilder needs at least one file !!!");
+  m_Boards.reserve(files.size());
+  for(std::size_t i = 0; i != files.size(); ++i)
+  {
+    m_Boards.emplace_back();
+    Board& board = m_Boards.back();
+    board.Name   = files[i];
+    if(RawReader::isRaw(files[i]))
+    {
+      // The decoding threads are shared by the boards
+      board.Raw     = std::make_unique<RawReader>(files[i], std::max<std::size_t>(1, std::thread::hardware_concurrency() / files.size()));
+      board.Buffer  = new Event();
+      board.Entries = board.Raw->getEntries();
+      continue;
+    }
+    board.File.reset(TFile::Open(files[i].c_str()));
+    if(board.File == nullptr || board.File->IsZombie()) { throw std::runtime_error(fmt::format("File {} Not Opened", files[i])); }
+    board.Tree = static_cast<TTree*>(board.File->Get(treeName.c_str()));
+    if(board.Tree == nullptr || board.Tree->IsZombie()) { throw std::runtime_error(fmt::format("Problem Opening TTree \"{}\" in {} !!!", treeName, files[i])); }
+    board.Buffer     = new Event();
+    board.PerChannel = board.Tree->GetBranch("Header.") != nullptr;
+    if(board.Tree->SetBranchAddress(board.PerChannel ? "Header." : "Events", &board.Buffer)) { throw std::runtime_error(fmt::format("Error while SetBranchAddress in {} !!!", files[i])); }
+    if(board.PerChannel)
+    {
+      for(std::size_t ch = 0; board.Tree->GetBranch(fmt::format("Channel{}.", ch).c_str()) != nullptr; ++ch)
+      {
+        board.Channels.push_back(new Channel());
+        if(board.Tree->SetBranchAddress(fmt::format("Channel{}.", ch).c_str(), &board.Channels.back())) { throw std::runtime_error(fmt::format("Error while SetBranchAddress in {} !!!", files[i])); }
+      }
+      board.Needed.assign(board.Channels.size(), true);
+    }
+    board.Entries = board.Tree->GetEntries();
+  }
+  for(std::size_t i = 0; i != m_Boards.size(); ++i) advance(m_Boards[i]);
+}
+
+EventBuilder::~EventBuilder()
+{
+  for(std::size_t i = 0; i != m_Boards.size(); ++i)
+  {
+    if(m_Boards[i].Tree != nullptr) m_Boards[i].Tree->ResetBranchAddresses();
+    delete m_Boards[i].Buffer;
+    for(std::size_t ch = 0; ch != m_Boards[i].Channels.size(); ++ch) delete m_Boards[i].Channels[ch];
+    if(m_Boards[i].File != nullptr && m_Boards[i].File->IsOpen()) m_Boards[i].File->Close();
+  }
+}
+
+Long64_t EventBuilder::getEntries() const
+{
+  Long64_t entries{std::numeric_limits<Long64_t>::max()};
+  for(std::size_t i = 0; i != m_Boards.size(); ++i) entries = std::min(entries, m_Boards[i].Entries);
+  return entries;
+}
+
+void EventBuilder::setChannels(const std::vector<int>& channels)
+{
+  // The channels of the boards are concatenated, the first channel of a board is after the last one of the previous
+  std::size_t first{0};
+  for(std::size_t i = 0; i != m_Boards.size(); ++i)
+  {
+    Board&            board = m_Boards[i];
+    const std::size_t size{board.Raw != nullptr ? RawReader::NumberChannels : (board.PerChannel ? board.Channels.size() : board.Buffer->Channels.size())};
+    if(board.Raw != nullptr)
+    {
+      std::vector<bool> needed(size);
+      for(std::size_t ch = 0; ch != size; ++ch) needed[ch] = channels.empty() || std::find(channels.begin(), channels.end(), static_cast<int>(first + ch)) != channels.end();
+      board.Raw->setChannels(needed);
+    }
+    else if(board.PerChannel)
+    {
+      for(std::size_t ch = 0; ch != board.Channels.size(); ++ch)
+      {
+        board.Needed[ch] = channels.empty() || std::find(channels.begin(), channels.end(), static_cast<int>(first + ch)) != channels.end();
+        // The pattern covers the sub-branches of split channels
+        board.Tree->SetBranchStatus(fmt::format("Channel{}.*", ch).c_str(), board.Needed[ch]);
+      }
+    }
+    first += size;
+  }
+}
+
+void EventBuilder::setCodes(const bool& codes)
+{
+  for(Board& board : m_Boards)
+    if(board.Raw != nullptr) board.Raw->setCodes(codes);
+}
+
+std::size_t EventBuilder::getNumberSelectiveBoards() const
+{
+  return std::count_if(m_Boards.begin(), m_Boards.end(), [](const Board& board) { return board.PerChannel || board.Raw != nullptr; });
+}
+
+void EventBuilder::setCacheSize(const Long64_t& bytes)
+{
+  m_CacheSize = bytes;
+  // The raw files are mapped, the system page cache does the job
+  for(std::size_t i = 0; i != m_Boards.size(); ++i)
+    if(m_Boards[i].Tree != nullptr) m_Boards[i].Tree->SetCacheSize(bytes / static_cast<Long64_t>(m_Boards.size()));
+}
+
+bool EventBuilder::advance(Board& board)
+{
+  ++board.Entry;
+  if(board.Entry >= board.Entries)
+  {
+    board.Valid = false;
+    return false;
+  }
+  board.Buffer->clear();
+  if(board.Raw != nullptr)
+  {
+    if(!board.Raw->next(board.RawBuffer))
+    {
+      board.Valid = false;
+      return false;
+    }
+    fromRaw(board);
+  }
+  else
+    board.Tree->GetEntry(board.Entry);
+  if(board.PerChannel)
+  {
+    // Disabled branches are not read, their channels stay empty
+    board.Buffer->Channels.resize(board.Channels.size());
+    for(std::size_t ch = 0; ch != board.Channels.size(); ++ch)
+    {
+      if(!board.Needed[ch]) continue;
+      Channel& from = *board.Channels[ch];
+      Channel& to   = board.Buffer->Channels[ch];
+      to.RecordLength   = from.RecordLength;
+      to.Number         = from.Number;
+      to.Name           = from.Name;
+      to.TriggerTimeTag = from.TriggerTimeTag;
+      to.DCoffset       = from.DCoffset;
+      to.StartIndexCell = from.StartIndexCell;
+      to.Group          = from.Group;
+      to.Data.swap(from.Data);
+    }
+  }
+  // The trigger time tag is a free running counter, unwrap it to get a monotonic time
+  const double tag{board.Buffer->TriggerTimeTag};
+  if(board.Entry != 0 && tag < board.LastTag) board.Offset += m_Rollover;
+  board.LastTag = tag;
+  board.Time    = tag + board.Offset;
+  board.Valid   = true;
+  return true;
+}
+
+void EventBuilder::fromRaw(Board& board)
+{
+  const RawEvent& raw   = board.RawBuffer;
+  Event&          event = *board.Buffer;
+  event.BoardID         = raw.BoardID;
+  event.EventNumber     = raw.EventNumber;
+  event.Pattern         = raw.Pattern;
+  event.ChannelMask     = raw.GroupMask;
+  event.EventSize       = raw.EventSize;
+  event.TriggerTimeTag  = raw.TriggerTimeTag;
+  event.Period_ns       = raw.Period_ns;
+  event.FamilyCode      = "XX742";
+  event.Channels.resize(raw.Channels.size());
+  for(std::size_t ch = 0; ch != raw.Channels.size(); ++ch)
+  {
+    RawChannel& from = board.RawBuffer.Channels[ch];
+    Channel&    to   = event.Channels[ch];
+    to.RecordLength   = std::max(from.Data.size(), from.Codes.size());
+    to.Number         = from.Number;
+    to.Name           = ch < RawReader::Groups * RawReader::ChannelsByGroup ? fmt::format("CH{}", ch) : fmt::format("TR{}", from.Group);
+    to.TriggerTimeTag = from.TriggerTimeTag;
+    to.StartIndexCell = from.StartIndexCell;
+    to.Group          = from.Group;
+    // The decoded samples are given as they are
+    to.Data.swap(from.Data);
+    to.Codes.swap(from.Codes);
+  }
+}
+
+Long64_t EventBuilder::skip(const Long64_t& events)
+{
+  if(events <= 0) return 0;
+  if(m_Boards.size() == 1)
+  {
+    Board& board = m_Boards[0];
+    if(!board.Valid) return 0;
+    // The head is the entry already read, the next ones are not read at all
+    const Long64_t skipped{std::min(events, board.Entries - board.Entry)};
+    if(board.Raw != nullptr) board.Raw->skip(skipped - 1);
+    board.Entry += skipped - 1;
+    m_Built += skipped;
+    advance(board);
+    return skipped;
+  }
+  Event    scratch;
+  Long64_t skipped{0};
+  while(skipped != events && next(scratch)) ++skipped;
+  return skipped;
+}
+
+bool EventBuilder::next(Event& event)
+{
+  // Only one board, nothing to align
+  if(m_Boards.size() == 1)
+  {
+    Board& board = m_Boards[0];
+    if(!board.Valid) return false;
+    event.copyHeader(*board.Buffer);
+    event.EventSize = board.Buffer->EventSize;
+    event.Channels.swap(board.Buffer->Channels);
+    ++m_Built;
+    advance(board);
+    return true;
+  }
+  while(true)
+  {
+    std::size_t earliest{0};
+    double      min{std::numeric_limits<double>::max()};
+    double      max{std::numeric_limits<double>::lowest()};
+    for(std::size_t i = 0; i != m_Boards.size(); ++i)
+    {
+      if(!m_Boards[i].Valid) return false;
+      if(m_Boards[i].Time < min)
+      {
+        min      = m_Boards[i].Time;
+        earliest = i;
+      }
+      max = std::max(max, m_Boards[i].Time);
+    }
+    // The earliest head has no partner on at least one board : drop it and try again
+    if(max - min > m_Window)
+    {
+      ++m_Dropped;
+      advance(m_Boards[earliest]);
+      continue;
+    }
+    event.clear();
+    event.copyHeader(*m_Boards[0].Buffer);
+    event.EventNumber = static_cast<int>(m_Built);
+    for(std::size_t i = 0; i != m_Boards.size(); ++i)
+    {
+      Event& head = *m_Boards[i].Buffer;
+      event.EventSize += head.EventSize;
+      event.Channels.insert(event.Channels.end(), std::make_move_iterator(head.Channels.begin()), std::make_move_iterator(head.Channels.end()));
+      advance(m_Boards[i]);
+    }
+    ++m_Built;
+    return true;
+  }
+}
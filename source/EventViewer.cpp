@@ -0,0 +1,107 @@
+#include "EventViewer.hpp"
+
+double EventViewer::m_Period{1.0};
+int    EventViewer::m_CanvasX{1200};
+int    EventViewer::m_CanvasY{1500};
+int    EventViewer::m_PositionCanvasX{0};
+int    EventViewer::m_PositionCanvasY{0};
+
+void EventViewer::setPaveLabel(const std::string& title)
+{
+  create();
+  m_PaveLabel->SetLabel(title.c_str());
+  m_PaveLabel->Draw();
+}
+
+void EventViewer::setCanvasName(const std::string& title)
+{
+  m_Name = title;
+  if(m_Canvas != nullptr) m_Canvas->SetName(title.c_str());
+}
+
+void EventViewer::setCanvasTitle(const std::string& title)
+{
+  m_Title = title;
+  if(m_Canvas != nullptr) m_Canvas->SetTitle(title.c_str());
+}
+
+void EventViewer::divide(const int& div)
+{
+  m_Division = div;
+  if(m_Pad != nullptr) m_Pad->Divide(1, div, 0, 0);
+}
+
+void EventViewer::cd(const int& id)
+{
+  create();
+  m_Pad->cd(id);
+}
+
+void EventViewer::cdNext()
+{
+  create();
+  m_cd++;
+  m_Pad->cd(m_cd);
+}
+
+void EventViewer::saveAs(const std::string& filename)
+{
+  create();
+  m_Canvas->SaveAs(filename.c_str());
+}
+
+void EventViewer::createWaveForm(const int& number, const Channel& channel)
+{
+  TH1F& plot{m_ChannelPlot[number]};
+  plot = TH1F(("Waveform_" + std::to_string(number)).c_str(), ";Time (ns);Signal (mV)", channel.Data.size(), 0, channel.Data.size());
+  plot.Clear();
+  for(std::size_t i = 0; i != channel.Data.size(); ++i) plot.Fill(i, channel.Data[i]);
+  plot.SetLineColor(16);
+  plot.GetXaxis()->SetRangeUser(0, channel.Data.size());
+  plot.GetXaxis()->SetLimits(0., channel.Data.size() * m_Period);
+}
+
+void EventViewer::UnderlineSignalRegion(const int& channel, const Color_t& color, const double& min, const double& max)
+{
+  TH1F& h1c{m_SignalPlot[channel]};
+  h1c = m_ChannelPlot[channel];
+  h1c.SetLineColor(color);
+  h1c.GetXaxis()->SetRange(min, max);
+  h1c.Draw("HISTsame");
+}
+
+TGraph& EventViewer::getMarker(const int& channel, const double& x, const double& y)
+{
+  TGraph& marker{m_Markers[channel]};
+  marker.SetPoint(0, x, y);
+  return marker;
+}
+
+TArrow& EventViewer::getArrow(const int& channel, const int& index, const double& x1, const double& y1, const double& x2, const double& y2)
+{
+  TArrow& arrow{m_Arrows[std::make_pair(channel, index)]};
+  arrow.SetX1(x1);
+  arrow.SetY1(y1);
+  arrow.SetX2(x2);
+  arrow.SetY2(y2);
+  arrow.SetArrowSize(0.005);
+  arrow.SetOption("<|>");
+  return arrow;
+}
+
+void EventViewer::create()
+{
+  if(m_Canvas != nullptr) return;
+  m_Canvas = new TCanvas(true);
+  m_Canvas->SetName(m_Name.c_str());
+  m_Canvas->SetTitle(m_Title.c_str());
+  m_Canvas->SetFillStyle(4000);
+  m_Canvas->SetCanvasSize(m_CanvasX, m_CanvasY);
+  m_Canvas->SetWindowPosition(m_PositionCanvasX, m_PositionCanvasY);
+  m_Canvas->cd();
+  m_Pad       = new TPad("", "", 0.01, 0.01, 0.99, 0.95);
+  m_PaveLabel = new TPaveLabel(0.01, 0.96, 0.99, 0.99, m_PaveTitle.c_str());
+  m_PaveLabel->Draw();
+  m_Pad->Draw();
+  if(m_Division > 0) m_Pad->Divide(1, m_Division, 0, 0);
+}
@@ -0,0 +1,73 @@
+#include "EventWriter.hpp"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "fmt/format.h"
+
+#include <stdexcept>
+
+EventWriter::EventWriter(const std::string& filename, const Layout& layout, const std::string& treeName, const int& compression, const int& basketSize, const int& splitLevel) : m_Layout(layout), m_BasketSize(basketSize), m_SplitLevel(splitLevel)
+{
+  m_File.reset(TFile::Open(filename.c_str(), "RECREATE", "", compression));
+  if(m_File == nullptr || m_File->IsZombie()) throw std::runtime_error(fmt::format("File {} Not Created", filename));
+  m_Tree = new TTree(treeName.c_str(), treeName.c_str());
+  m_Tree->SetDirectory(m_File.get());
+  // The channel branches are created with the first event (their number is not known before)
+  if(m_Layout == Layout::Object) m_Tree->Branch("Events", &m_Event, m_BasketSize, m_SplitLevel);
+  else
+    m_Tree->Branch("Header.", &m_HeaderPointer, m_BasketSize, m_SplitLevel);
+}
+
+EventWriter::~EventWriter()
+{
+  close();
+}
+
+EventWriter::Layout EventWriter::fromString(const std::string& layout)
+{
+  if(layout == "object") return Layout::Object;
+  else if(layout == "channels")
+    return Layout::PerChannel;
+  else
+    throw std::runtime_error(fmt::format("Unknown layout \"{}\" (object or channels) !", layout));
+}
+
+std::string EventWriter::toString(const Layout& layout)
+{
+  return layout == Layout::Object ? "object" : "channels";
+}
+
+void EventWriter::fill(const Event& event)
+{
+  if(m_Tree == nullptr) throw std::runtime_error("EventWriter already closed !!!");
+  // ROOT only reads the objects while filling, the branches point to the caller's event
+  if(m_Layout == Layout::Object) m_Event = const_cast<Event*>(&event);
+  else
+  {
+    if(m_Entries == 0) m_Channels.resize(event.Channels.size(), nullptr);
+    if(event.Channels.size() != m_Channels.size()) throw std::runtime_error(fmt::format("Event {} has {} channels but the tree has {} channel branches !", event.EventNumber, event.Channels.size(), m_Channels.size()));
+    m_Header.copyHeader(event);
+    m_Header.EventSize = event.EventSize;
+    for(std::size_t ch = 0; ch != m_Channels.size(); ++ch) m_Channels[ch] = const_cast<Channel*>(&event.Channels[ch]);
+    // The trailing dot prefixes the sub-branches with the channel name ("Channel3.Data")
+    if(m_Entries == 0)
+      for(std::size_t ch = 0; ch != m_Channels.size(); ++ch) m_Tree->Branch(fmt::format("Channel{}.", ch).c_str(), &m_Channels[ch], m_BasketSize, m_SplitLevel);
+  }
+  m_Tree->Fill();
+  ++m_Entries;
+}
+
+void EventWriter::setClusterSize(const Long64_t& entries)
+{
+  if(m_Tree != nullptr && entries > 0) m_Tree->SetAutoFlush(entries);
+}
+
+void EventWriter::close()
+{
+  if(m_Tree == nullptr) return;
+  m_File->cd();
+  m_Tree->Write("", TObject::kOverwrite);
+  m_Tree->ResetBranchAddresses();
+  m_File->Close();
+  m_Tree = nullptr;
+}
@@ -0,0 +1,159 @@
+#include "Filter.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+Filter Filter::MovingAverage(const std::size_t& width)
+{
+  if(width == 0) throw std::runtime_error("Moving average width must be > 0 !");
+  Filter filter;
+  filter.m_Type  = Type::MovingAverage;
+  filter.m_Width = width;
+  return filter;
+}
+
+Filter Filter::FIR(const std::vector<double>& coefficients)
+{
+  if(coefficients.empty()) throw std::runtime_error("FIR filter needs at least one coefficient !");
+  Filter filter;
+  filter.m_Type         = Type::FIR;
+  filter.m_Coefficients = coefficients;
+  filter.m_Width        = coefficients.size();
+  return filter;
+}
+
+Filter Filter::IIR(const double& alpha)
+{
+  if(alpha <= 0 || alpha > 1) throw std::runtime_error(fmt::format("IIR alpha must be in ]0,1] ({} given) !", alpha));
+  Filter filter;
+  filter.m_Type  = Type::IIR;
+  filter.m_Alpha = alpha;
+  return filter;
+}
+
+Filter Filter::fromString(const std::string& type, const std::size_t& width, const std::vector<double>& coefficients, const double& alpha)
+{
+  if(type == "none" || type.empty()) return Filter();
+  else if(type == "average") return MovingAverage(width);
+  else if(type == "fir") return FIR(coefficients);
+  else if(type == "iir") return IIR(alpha);
+  else throw std::runtime_error(fmt::format("Unknown filter \"{}\" (none, average, fir, iir) !", type));
+}
+
+std::string Filter::toString(const Type& type)
+{
+  switch(type)
+  {
+    case Type::MovingAverage: return "average";
+    case Type::FIR: return "fir";
+    case Type::IIR: return "iir";
+    default: return "none";
+  }
+}
+
+void Filter::apply(double* data, const std::size_t& length)
+{
+  const std::vector<double*> channels{data};
+  apply(channels, length);
+}
+
+void Filter::apply(const std::vector<double*>& channels, const std::size_t& length)
+{
+  if(length == 0) return;
+  switch(m_Type)
+  {
+    case Type::None: return;
+    case Type::MovingAverage:
+      for(std::size_t ch = 0; ch != channels.size(); ++ch) movingAverage(channels[ch], length);
+      return;
+    case Type::FIR:
+      for(std::size_t ch = 0; ch != channels.size(); ++ch) fir(channels[ch], length);
+      return;
+    case Type::IIR:
+      for(std::size_t ch = 0; ch < channels.size(); ch += m_Lanes) iir(channels, ch, std::min(ch + m_Lanes, channels.size()), length);
+      return;
+  }
+}
+
+// Copy the waveform in m_Padded with the edge samples repeated before and after
+void Filter::pad(const double* data, const std::size_t& length, const std::size_t& before, const std::size_t& after)
+{
+  m_Padded.resize(before + length + after);
+  std::fill(m_Padded.begin(), m_Padded.begin() + before, data[0]);
+  std::copy(data, data + length, m_Padded.begin() + before);
+  std::fill(m_Padded.begin() + before + length, m_Padded.end(), data[length - 1]);
+}
+
+// Centred moving average from the prefix sum : y[n] = (P[n+w]-P[n])/w
+void Filter::movingAverage(double* data, const std::size_t& length)
+{
+  const std::size_t before{(m_Width - 1) / 2};
+  const std::size_t after{m_Width - 1 - before};
+  pad(data, length, before + 1, after);
+  m_Padded[0] = 0;
+  for(std::size_t i = 1; i != m_Padded.size(); ++i) m_Padded[i] += m_Padded[i - 1];
+  const double  norm{1.0 / m_Width};
+  const double* prefix{m_Padded.data()};
+  for(std::size_t n = 0; n != length; ++n) data[n] = (prefix[n + m_Width] - prefix[n]) * norm;
+}
+
+// Centred FIR computed by blocks of output samples, the taps loop is outside so the inner loop vectorises
+void Filter::fir(double* data, const std::size_t& length)
+{
+  const std::size_t before{(m_Width - 1) / 2};
+  const std::size_t after{m_Width - 1 - before};
+  pad(data, length, before, after);
+  m_Block.resize(m_BlockSize);
+  const double* in{m_Padded.data()};
+  const double* taps{m_Coefficients.data()};
+  double*       out{m_Block.data()};
+  for(std::size_t begin = 0; begin < length; begin += m_BlockSize)
+  {
+    const std::size_t size{std::min(m_BlockSize, length - begin)};
+    std::fill(out, out + size, 0.0);
+    for(std::size_t k = 0; k != m_Width; ++k)
+    {
+      const double  tap{taps[k]};
+      const double* x{in + begin + k};
+      for(std::size_t n = 0; n != size; ++n) out[n] += tap * x[n];
+    }
+    // The padded copy holds the input, the block can be written back in place
+    std::copy(out, out + size, data + begin);
+  }
+}
+
+// Zero phase first order low-pass. The channels [begin,end) are interleaved in m_Block ([sample][lane])
+// so the recurrence, sequential in time, runs in parallel on the channels.
+void Filter::iir(const std::vector<double*>& channels, const std::size_t& begin, const std::size_t& end, const std::size_t& length)
+{
+  const std::size_t lanes{end - begin};
+  const double      alpha{m_Alpha};
+  m_Block.resize(length * m_Lanes);
+  double* block{m_Block.data()};
+  for(std::size_t l = 0; l != lanes; ++l)
+  {
+    const double* in{channels[begin + l]};
+    for(std::size_t n = 0; n != length; ++n) block[n * m_Lanes + l] = in[n];
+  }
+  // Forward
+  for(std::size_t n = 1; n != length; ++n)
+  {
+    double*       y{block + n * m_Lanes};
+    const double* previous{y - m_Lanes};
+    for(std::size_t l = 0; l != m_Lanes; ++l) y[l] = previous[l] + alpha * (y[l] - previous[l]);
+  }
+  // Backward
+  for(std::size_t n = length - 1; n-- != 0;)
+  {
+    double*       y{block + n * m_Lanes};
+    const double* previous{y + m_Lanes};
+    for(std::size_t l = 0; l != m_Lanes; ++l) y[l] = previous[l] + alpha * (y[l] - previous[l]);
+  }
+  for(std::size_t l = 0; l != lanes; ++l)
+  {
+    double* out{channels[begin + l]};
+    for(std::size_t n = 0; n != length; ++n) out[n] = block[n * m_Lanes + l];
+  }
+}
@@ -0,0 +1,79 @@
+#include "Histogram.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+Histogram::Histogram(const std::size_t& bins, const double& min, const double& max, const std::string& name, const std::string& title) : m_Name(name), m_Title(title), m_Min(min), m_Max(max), m_Counts(bins, 0)
+{
+  if(bins == 0 || !(max > min)) throw std::runtime_error(fmt::format("Histogram {} : invalid binning ({} bins in [{},{}[) !", name, bins, min, max));
+  m_InvWidth = bins / (max - min);
+}
+
+void Histogram::add(const Histogram& other)
+{
+  if(other.m_Counts.size() != m_Counts.size() || other.m_Min != m_Min || other.m_Max != m_Max) throw std::runtime_error(fmt::format("Histogram {} and {} don't have the same binning !", m_Name, other.m_Name));
+  for(std::size_t bin = 0; bin != m_Counts.size(); ++bin) m_Counts[bin] += other.m_Counts[bin];
+  m_Underflow += other.m_Underflow;
+  m_Overflow += other.m_Overflow;
+  m_Entries += other.m_Entries;
+}
+
+void Histogram::reset()
+{
+  std::fill(m_Counts.begin(), m_Counts.end(), 0);
+  m_Underflow = 0;
+  m_Overflow  = 0;
+  m_Entries   = 0;
+}
+
+double Histogram::getMean() const
+{
+  double        sum{0};
+  std::uint64_t entries{0};
+  for(std::size_t bin = 0; bin != m_Counts.size(); ++bin)
+  {
+    sum += m_Counts[bin] * getBinCenter(bin);
+    entries += m_Counts[bin];
+  }
+  return entries == 0 ? 0 : sum / entries;
+}
+
+void Histogram::write(std::ostream& stream) const
+{
+  // Strings are prefixed by their length so they can hold spaces or be empty
+  stream << fmt::format("{} {}\n{} {}\n{} {} {} {} {} {}\n", m_Name.size(), m_Name, m_Title.size(), m_Title, m_Counts.size(), m_Min, m_Max, m_Underflow, m_Overflow, m_Entries);
+  for(std::size_t bin = 0; bin != m_Counts.size(); ++bin) stream << m_Counts[bin] << (bin + 1 == m_Counts.size() ? '\n' : ' ');
+}
+
+Histogram Histogram::read(std::istream& stream)
+{
+  auto readString = [&stream]() {
+    std::size_t size{0};
+    stream >> size;
+    stream.get();
+    std::string string(size, ' ');
+    stream.read(&string[0], size);
+    return string;
+  };
+  const std::string name{readString()};
+  const std::string title{readString()};
+  std::size_t       bins{0};
+  double            min{0};
+  double            max{0};
+  std::uint64_t     underflow{0};
+  std::uint64_t     overflow{0};
+  std::uint64_t     entries{0};
+  stream >> bins >> min >> max >> underflow >> overflow >> entries;
+  if(!stream) throw std::runtime_error("Can't read the histogram !");
+  Histogram histogram(bins, min, max, name, title);
+  for(std::size_t bin = 0; bin != bins; ++bin) stream >> histogram.m_Counts[bin];
+  if(!stream) throw std::runtime_error(fmt::format("Can't read the counts of histogram {} !", name));
+  histogram.m_Underflow = underflow;
+  histogram.m_Overflow  = overflow;
+  histogram.m_Entries   = entries;
+  return histogram;
+}
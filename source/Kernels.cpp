@@ -0,0 +1,69 @@
+#include "Kernels.hpp"
+
+namespace Kernels
+{
+bool toCodes(const double* data, const std::size_t& length, std::int16_t* codes, std::int64_t& sum)
+{
+  // Clamped before the conversion (no overflow, NaN gives 4095), the distance to the samples is summed on Lanes lanes
+  double      residual[Lanes]{};
+  std::size_t i{0};
+  sum = 0;
+  for(; i + CodeBlock <= length; i += CodeBlock)
+  {
+    const double* x{data + i};
+    double        clamped[CodeBlock];
+    std::int32_t  block[CodeBlock];
+    for(std::size_t j = 0; j != CodeBlock; ++j) clamped[j] = std::max(0., std::min(4095., x[j]));
+    for(std::size_t j = 0; j != CodeBlock; ++j) block[j] = static_cast<std::int32_t>(clamped[j]);
+    for(std::size_t j = 0; j != CodeBlock; j += Lanes)
+      for(std::size_t l = 0; l != Lanes; ++l) residual[l] += std::fabs(x[j + l] - block[j + l]);
+    std::int32_t blockSum{0};
+    for(std::size_t j = 0; j != CodeBlock; ++j)
+    {
+      codes[i + j] = static_cast<std::int16_t>(block[j]);
+      blockSum += block[j];
+    }
+    sum += blockSum;
+  }
+  for(; i != length; ++i)
+  {
+    codes[i] = static_cast<std::int16_t>(std::max(0., std::min(4095., data[i])));
+    residual[0] += std::fabs(data[i] - codes[i]);
+    sum += codes[i];
+  }
+  return (residual[0] + residual[1]) + (residual[2] + residual[3]) == 0;
+}
+
+template<std::size_t N> Dispatcher Dispatcher::make()
+{
+  Dispatcher dispatcher;
+  dispatcher.m_RecordLength  = N;
+  dispatcher.m_MeanSigma     = &Kernels::meanSigma<N>;
+  dispatcher.m_Negative      = &Kernels::extremum<-1, N>;
+  dispatcher.m_Positive      = &Kernels::extremum<+1, N>;
+  dispatcher.m_Baseline      = &Kernels::baseline<N>;
+  dispatcher.m_CodeMeanSigma = &Kernels::meanSigma<N>;
+  dispatcher.m_CodeNegative  = &Kernels::extremum<-1, N>;
+  dispatcher.m_CodePositive  = &Kernels::extremum<+1, N>;
+  dispatcher.m_CodeMean      = &Kernels::mean<N>;
+  return dispatcher;
+}
+
+Dispatcher Dispatcher::generic()
+{
+  return Dispatcher();
+}
+
+// Record lengths of the V1742 (DRS4) : 1024 samples by default, 520/256/136 with the reduced windows
+Dispatcher Dispatcher::select(const std::size_t& recordLength)
+{
+  switch(recordLength)
+  {
+    case 1024: return make<1024>();
+    case 520: return make<520>();
+    case 256: return make<256>();
+    case 136: return make<136>();
+    default: return generic();
+  }
+}
+}  // namespace Kernels
@@ -0,0 +1,55 @@
+#include "Memory.hpp"
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #define VC_EXTRALEAN
+  #include <Windows.h>
+  #include <psapi.h>
+#elif defined(__APPLE__)
+  #include <mach/mach.h>
+  #include <sys/resource.h>
+#else
+  #include <sys/resource.h>
+  #include <unistd.h>
+
+  #include <fstream>
+#endif
+
+std::size_t getResidentMemory()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+  return counters.WorkingSetSize;
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t      count{MACH_TASK_BASIC_INFO_COUNT};
+  if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) return 0;
+  return info.resident_size;
+#else
+  // Second field of statm : resident pages
+  std::ifstream statm("/proc/self/statm");
+  std::size_t   size{0};
+  std::size_t   resident{0};
+  if(!(statm >> size >> resident)) return 0;
+  return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+std::size_t getPeakResidentMemory()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+  return counters.PeakWorkingSetSize;
+#else
+  rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  #if defined(__APPLE__)
+  // Bytes on macOS, kilobytes elsewhere
+  return static_cast<std::size_t>(usage.ru_maxrss);
+  #else
+  return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+  #endif
+#endif
+}
@@ -0,0 +1,113 @@
+#include "PeakFinder.hpp"
+
+#include "State.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+
+namespace
+{
+constexpr std::size_t Lanes{4};
+constexpr std::size_t Block{32};
+
+// Sign is a template parameter so the comparisons of a block vectorise
+template<int Sign> void search(PeakTrain& train, const double* data, const int& begin, const int& end, const double& baseline, const double& threshold, const double& hysteresis)
+{
+  // On sign x data : above high starts a peak, below low ends it
+  const double high{Sign * baseline + threshold};
+  const double low{Sign * baseline + hysteresis * threshold};
+  int          i{begin};
+  while(i < end)
+  {
+    // Skip the blocks without any sample above the threshold (maximum of the block on independent lanes, kept
+    // in registers)
+    while(i + static_cast<int>(Block) <= end)
+    {
+      const double* block{data + i};
+      double        a{Sign * block[0]}, b{Sign * block[1]}, c{Sign * block[2]}, d{Sign * block[3]};
+      for(std::size_t j = Lanes; j != Block; j += Lanes)
+      {
+        a = std::max(a, Sign * block[j]);
+        b = std::max(b, Sign * block[j + 1]);
+        c = std::max(c, Sign * block[j + 2]);
+        d = std::max(d, Sign * block[j + 3]);
+      }
+      if(std::max(std::max(a, b), std::max(c, d)) > high) break;
+      i += Block;
+    }
+    while(i < end && !(Sign * data[i] > high)) ++i;
+    if(i == end) break;
+    // In the peak up to the sample below low
+    int    tick{i};
+    double best{Sign * data[i]};
+    for(++i; i < end && !(Sign * data[i] < low); ++i)
+    {
+      if(Sign * data[i] > best)
+      {
+        best = Sign * data[i];
+        tick = i;
+      }
+    }
+    if(train.Number < PeakTrain::MaxPeaks) train.Peaks[train.Number] = Peak{tick, best - Sign * baseline};
+    ++train.Number;
+  }
+}
+}  // namespace
+
+PeakFinder::PeakFinder(const std::size_t& chambers, const std::size_t& capacity, const double& hysteresis) : m_Trains(std::max<std::size_t>(capacity, 1)), m_Hysteresis(hysteresis), m_PileUp(chambers, 0)
+{
+  for(std::size_t chamber = 0; chamber != chambers; ++chamber)
+  {
+    m_Peaks.emplace_back(16, 0, 16, fmt::format("Peaks_chamber{}", chamber), "Peaks in the signal window;Number of peaks;Hits");
+    m_InterPeakTime.emplace_back(200, 0, 100, fmt::format("Inter_peak_time_chamber{}", chamber), "Time between consecutive peaks;#Delta t (ns);Peaks");
+  }
+}
+
+const PeakTrain& PeakFinder::find(const int& chamber, const int& strip, const double* data, const std::size_t& length, const int& begin, const int& end, const int& sign, const double& baseline, const double& threshold)
+{
+  // The buffer has one slot by analysed channel, if full the last one is overwritten
+  PeakTrain& train{m_Trains[std::min(m_NbrTrains, m_Trains.size() - 1)]};
+  if(m_NbrTrains < m_Trains.size()) ++m_NbrTrains;
+  train.Chamber = chamber;
+  train.Strip   = strip;
+  train.Number  = 0;
+  const int first{std::max(begin, 0)};
+  const int last{std::min(end, static_cast<int>(length))};
+  if(sign < 0) search<-1>(train, data, first, last, baseline, threshold, m_Hysteresis);
+  else
+    search<+1>(train, data, first, last, baseline, threshold, m_Hysteresis);
+  return train;
+}
+
+void PeakFinder::endEvent(const double& period)
+{
+  for(std::size_t i = 0; i != m_NbrTrains; ++i)
+  {
+    const PeakTrain& train{m_Trains[i]};
+    if(train.Chamber < 0 || static_cast<std::size_t>(train.Chamber) >= m_Peaks.size()) continue;
+    m_Peaks[train.Chamber].fill(train.Number);
+    if(train.Number > 1) ++m_PileUp[train.Chamber];
+    for(std::size_t p = 1; p < train.getStored(); ++p) m_InterPeakTime[train.Chamber].fill((train.Peaks[p].Tick - train.Peaks[p - 1].Tick) * period);
+  }
+  m_NbrTrains = 0;
+}
+
+void PeakFinder::save(std::ostream& stream) const
+{
+  for(std::size_t chamber = 0; chamber != m_Peaks.size(); ++chamber)
+  {
+    m_Peaks[chamber].write(stream);
+    m_InterPeakTime[chamber].write(stream);
+  }
+  State::write(stream, m_PileUp);
+}
+
+void PeakFinder::restore(std::istream& stream)
+{
+  for(std::size_t chamber = 0; chamber != m_Peaks.size(); ++chamber)
+  {
+    m_Peaks[chamber]         = Histogram::read(stream);
+    m_InterPeakTime[chamber] = Histogram::read(stream);
+  }
+  State::read(stream, m_PileUp);
+}
@@ -0,0 +1,103 @@
+#include "Precision.hpp"
+
+#include "State.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+PrecisionValidation::PrecisionValidation(const std::size_t& chambers, const std::size_t& strips, const double& maxAmplitude, const double& maxSigma) : m_Chambers(chambers), m_EventHits(chambers), m_EventNoisy(chambers)
+{
+  const std::array<std::string, 2> names{"double", "compact"};
+  for(std::size_t i = 0; i != chambers; ++i)
+  {
+    for(std::size_t path = 0; path != 2; ++path)
+    {
+      const std::string suffix{"_Chamber" + std::to_string(i) + "_" + names[path]};
+      m_Chambers[i].Amplitude[path]    = Histogram(400, 0, maxAmplitude, "Amplitude" + suffix, "Amplitude (" + names[path] + ")");
+      m_Chambers[i].Sigma[path]        = Histogram(400, 0, maxSigma, "Sigma" + suffix, "Noise sigma (" + names[path] + ")");
+      m_Chambers[i].Multiplicity[path] = Histogram(strips + 1, 0, strips + 1, "Multiplicity" + suffix, "Hit multiplicity (" + names[path] + ")");
+    }
+    m_EventHits[i]  = {0, 0};
+    m_EventNoisy[i] = {false, false};
+  }
+}
+
+void PrecisionValidation::addChannel(const std::size_t& chamber, const Decision& reference, const Decision& compact)
+{
+  if(chamber >= m_Chambers.size()) return;
+  Chamber& counts{m_Chambers[chamber]};
+  ++counts.Channels;
+  counts.HitLost += reference.Hit && !compact.Hit;
+  counts.HitGained += !reference.Hit && compact.Hit;
+  counts.NoisyLost += reference.Noisy && !compact.Noisy;
+  counts.NoisyGained += !reference.Noisy && compact.Noisy;
+  // NaN (window outside the record) on both sides is not a difference
+  if(reference.Amplitude != compact.Amplitude) counts.MaxAmplitudeDifference = std::max(counts.MaxAmplitudeDifference, std::fabs(reference.Amplitude - compact.Amplitude));
+  if(reference.Sigma != compact.Sigma) counts.MaxSigmaDifference = std::max(counts.MaxSigmaDifference, std::fabs(reference.Sigma - compact.Sigma));
+  const std::array<const Decision*, 2> decisions{&reference, &compact};
+  for(std::size_t path = 0; path != 2; ++path)
+  {
+    counts.Amplitude[path].fill(decisions[path]->Amplitude);
+    counts.Sigma[path].fill(decisions[path]->Sigma);
+    m_EventHits[chamber][path] += decisions[path]->Hit;
+    m_EventNoisy[chamber][path] = m_EventNoisy[chamber][path] || decisions[path]->Noisy;
+  }
+}
+
+void PrecisionValidation::endEvent()
+{
+  ++m_Events;
+  for(std::size_t i = 0; i != m_Chambers.size(); ++i)
+  {
+    for(std::size_t path = 0; path != 2; ++path)
+    {
+      m_Chambers[i].Efficient[path] += m_EventHits[i][path] != 0;
+      m_Chambers[i].Noisy[path] += m_EventNoisy[i][path];
+      m_Chambers[i].Multiplicity[path].fill(m_EventHits[i][path]);
+    }
+    m_EventHits[i]  = {0, 0};
+    m_EventNoisy[i] = {false, false};
+  }
+}
+
+double PrecisionValidation::getEfficiency(const std::size_t& chamber, const Path& path) const
+{
+  return m_Events == 0 ? 0 : static_cast<double>(m_Chambers[chamber].Efficient[path]) / m_Events;
+}
+
+std::uint64_t PrecisionValidation::getChanges() const
+{
+  std::uint64_t changes{0};
+  for(const Chamber& chamber : m_Chambers) changes += chamber.HitLost + chamber.HitGained + chamber.NoisyLost + chamber.NoisyGained;
+  return changes;
+}
+
+std::size_t PrecisionValidation::countDifferences(const Histogram& a, const Histogram& b)
+{
+  std::size_t differences{static_cast<std::size_t>(a.getUnderflow() != b.getUnderflow()) + (a.getOverflow() != b.getOverflow())};
+  for(std::size_t bin = 0; bin != std::min(a.getNbins(), b.getNbins()); ++bin) differences += a.getBinContent(bin) != b.getBinContent(bin);
+  return differences + std::max(a.getNbins(), b.getNbins()) - std::min(a.getNbins(), b.getNbins());
+}
+
+void PrecisionValidation::save(std::ostream& stream) const
+{
+  State::write(stream, m_Events);
+  for(const Chamber& counts : m_Chambers)
+  {
+    State::write(stream, counts.Channels, counts.HitLost, counts.HitGained, counts.NoisyLost, counts.NoisyGained, counts.Efficient[0], counts.Efficient[1], counts.Noisy[0], counts.Noisy[1], counts.MaxAmplitudeDifference, counts.MaxSigmaDifference);
+    for(std::size_t path = 0; path != 2; ++path)
+      for(const Histogram* histogram : {&counts.Amplitude[path], &counts.Sigma[path], &counts.Multiplicity[path]}) histogram->write(stream);
+  }
+}
+
+void PrecisionValidation::restore(std::istream& stream)
+{
+  State::read(stream, m_Events);
+  for(Chamber& counts : m_Chambers)
+  {
+    State::read(stream, counts.Channels, counts.HitLost, counts.HitGained, counts.NoisyLost, counts.NoisyGained, counts.Efficient[0], counts.Efficient[1], counts.Noisy[0], counts.Noisy[1], counts.MaxAmplitudeDifference, counts.MaxSigmaDifference);
+    for(std::size_t path = 0; path != 2; ++path)
+      for(Histogram* histogram : {&counts.Amplitude[path], &counts.Sigma[path], &counts.Multiplicity[path]}) *histogram = Histogram::read(stream);
+  }
+}
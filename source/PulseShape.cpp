@@ -0,0 +1,86 @@
+#include "PulseShape.hpp"
+
+#include "State.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+
+PulseAnalyser::PulseAnalyser(const std::size_t& chambers, const std::size_t& capacity, const double& fraction, const std::pair<double, double>& chargeWindow, const double& impedance) :
+    m_Pulses(std::max<std::size_t>(capacity, 1)), m_Fraction(fraction), m_ChargeWindow(chargeWindow), m_Impedance(impedance), m_ChargeSum(chambers, 0), m_ChargeEntries(chambers, 0)
+{
+  for(std::size_t chamber = 0; chamber != chambers; ++chamber)
+  {
+    m_Charge.emplace_back(200, 0, 50, fmt::format("Charge_chamber{}", chamber), "Charge spectrum;Charge (pC);Hits");
+    m_Amplitude.emplace_back(200, 0, 500, fmt::format("Amplitude_chamber{}", chamber), "Amplitude;Amplitude (mV);Hits");
+    m_RiseTime.emplace_back(100, 0, 20, fmt::format("Rise_time_chamber{}", chamber), "Rise time 10%-90%;Rise time (ns);Hits");
+  }
+}
+
+double PulseAnalyser::crossing(const double* data, const int& sign, const int& peak, const double& baseline, const double& level)
+{
+  for(int tick = peak; tick > 0; --tick)
+  {
+    const double after{sign * (data[tick] - baseline)};
+    const double before{sign * (data[tick - 1] - baseline)};
+    if(before < level && after >= level) return tick - 1 + (level - before) / (after - before);
+  }
+  return std::nan("");
+}
+
+const Pulse& PulseAnalyser::analyse(const int& chamber, const int& strip, const double* data, const std::size_t& length, const int& sign, const int& peak, const double& baseline, const double& period)
+{
+  // The buffer has one slot by analysed channel, if full the last one is overwritten
+  Pulse& pulse{m_Pulses[std::min(m_NbrPulses, m_Pulses.size() - 1)]};
+  if(m_NbrPulses < m_Pulses.size()) ++m_NbrPulses;
+  pulse.Chamber   = chamber;
+  pulse.Strip     = strip;
+  pulse.Peak      = peak;
+  pulse.Amplitude = sign * (data[peak] - baseline);
+  // Charge : sum over the window around the peak (independent accumulators so it vectorises)
+  const std::size_t begin{static_cast<std::size_t>(std::max(0.0, peak - m_ChargeWindow.first))};
+  const std::size_t end{std::min(length, static_cast<std::size_t>(std::max(0.0, peak + m_ChargeWindow.second + 1)))};
+  double            sum[4]{0, 0, 0, 0};
+  std::size_t       i{begin};
+  for(; i + 4 <= end; i += 4)
+    for(std::size_t l = 0; l != 4; ++l) sum[l] += data[i + l];
+  for(; i < end; ++i) sum[0] += data[i];
+  const double integral{sign * ((sum[0] + sum[1]) + (sum[2] + sum[3]) - baseline * (end - begin))};
+  pulse.Charge = integral * period / m_Impedance;
+  const double t10{crossing(data, sign, peak, baseline, 0.1 * pulse.Amplitude)};
+  const double t90{crossing(data, sign, peak, baseline, 0.9 * pulse.Amplitude)};
+  pulse.RiseTime = (t90 - t10) * period;
+  pulse.Time     = crossing(data, sign, peak, baseline, m_Fraction * pulse.Amplitude) * period;
+  return pulse;
+}
+
+void PulseAnalyser::endEvent()
+{
+  for(std::size_t i = 0; i != m_NbrPulses; ++i)
+  {
+    const Pulse& pulse{m_Pulses[i]};
+    if(pulse.Chamber < 0 || static_cast<std::size_t>(pulse.Chamber) >= m_Charge.size()) continue;
+    m_Charge[pulse.Chamber].fill(pulse.Charge);
+    m_ChargeSum[pulse.Chamber] += std::llround(pulse.Charge / ChargeQuantum);
+    ++m_ChargeEntries[pulse.Chamber];
+    m_Amplitude[pulse.Chamber].fill(pulse.Amplitude);
+    if(!std::isnan(pulse.RiseTime)) m_RiseTime[pulse.Chamber].fill(pulse.RiseTime);
+  }
+  m_NbrPulses = 0;
+}
+
+void PulseAnalyser::save(std::ostream& stream) const
+{
+  for(std::size_t chamber = 0; chamber != m_Charge.size(); ++chamber)
+    for(const Histogram* histogram : {&m_Charge[chamber], &m_Amplitude[chamber], &m_RiseTime[chamber]}) histogram->write(stream);
+  State::write(stream, m_ChargeSum);
+  State::write(stream, m_ChargeEntries);
+}
+
+void PulseAnalyser::restore(std::istream& stream)
+{
+  for(std::size_t chamber = 0; chamber != m_Charge.size(); ++chamber)
+    for(Histogram* histogram : {&m_Charge[chamber], &m_Amplitude[chamber], &m_RiseTime[chamber]}) *histogram = Histogram::read(stream);
+  State::read(stream, m_ChargeSum);
+  State::read(stream, m_ChargeEntries);
+}
@@ -0,0 +1,343 @@
+#include "RawReader.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #define VC_EXTRALEAN
+  #include <Windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+constexpr std::uint32_t HeaderTag{0xA};
+constexpr std::size_t   HeaderWords{4};
+// Sampling period (ns) of the frequency code of the group header : 5, 2.5, 1 GS/s and 750 MS/s
+constexpr double        Periods[4]{0.2, 0.4, 1.0, 1.0 / 0.75};
+
+std::uint32_t word(const unsigned char* data, const std::size_t& index)
+{
+  std::uint32_t value;
+  std::memcpy(&value, data + 4 * index, 4);
+  return value;
+}
+
+// 12 bits value starting at bit of the packed words
+std::uint32_t get(const unsigned char* words, const std::size_t& bit)
+{
+  const std::size_t shift{bit % 32};
+  std::uint32_t     value{word(words, bit / 32) >> shift};
+  if(shift > 20) value |= word(words, bit / 32 + 1) << (32 - shift);
+  return value & 0xFFF;
+}
+
+void put(std::uint32_t* words, const std::size_t& bit, const double& sample)
+{
+  const std::uint32_t value{static_cast<std::uint32_t>(std::clamp<long>(std::lround(sample), 0, 0xFFF))};
+  const std::size_t   shift{bit % 32};
+  words[bit / 32] |= value << shift;
+  if(shift > 20) words[bit / 32 + 1] |= value >> (32 - shift);
+}
+
+// Channel of the 8 of a group : 3 words by sample, the position of the channel in them is the same for all the samples
+template<typename T> void unpackChannel(const unsigned char* words, const std::size_t& channel, std::vector<T>& data, const std::size_t& samples)
+{
+  const std::size_t first{12 * channel / 32};
+  const std::size_t shift{12 * channel % 32};
+  data.resize(samples);
+  for(std::size_t s = 0; s != samples; ++s)
+  {
+    std::uint32_t value{word(words, 3 * s + first) >> shift};
+    if(shift > 20) value |= word(words, 3 * s + first + 1) << (32 - shift);
+    data[s] = static_cast<T>(value & 0xFFF);
+  }
+}
+
+// Trigger channel : samples packed one after the other
+void unpackTrigger(const unsigned char* words, std::vector<double>& data, const std::size_t& samples)
+{
+  data.resize(samples);
+  for(std::size_t s = 0; s != samples; ++s) data[s] = get(words, 12 * s);
+}
+}  // namespace
+
+RawReader::RawReader(const std::string& file, const std::size_t& threads, const std::size_t& chunk) : m_Name(file), m_Needed(NumberChannels, true), m_Threads(std::max<std::size_t>(threads, 1)), m_ChunkSize(std::max<std::size_t>(chunk, 1))
+{
+#if defined(_WIN32)
+  m_File = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if(m_File == INVALID_HANDLE_VALUE) throw std::runtime_error(fmt::format("File {} Not Opened", file));
+  LARGE_INTEGER size;
+  GetFileSizeEx(m_File, &size);
+  m_Size = static_cast<std::size_t>(size.QuadPart);
+  if(m_Size != 0)
+  {
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(m_Mapping != nullptr) m_Data = static_cast<const unsigned char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    if(m_Data == nullptr)
+    {
+      if(m_Mapping != nullptr) CloseHandle(m_Mapping);
+      CloseHandle(m_File);
+      throw std::runtime_error(fmt::format("File {} can't be mapped in memory", file));
+    }
+  }
+#else
+  const int descriptor{open(file.c_str(), O_RDONLY)};
+  if(descriptor < 0) throw std::runtime_error(fmt::format("File {} Not Opened", file));
+  struct stat status;
+  if(fstat(descriptor, &status) != 0)
+  {
+    close(descriptor);
+    throw std::runtime_error(fmt::format("File {} Not Opened", file));
+  }
+  m_Size = static_cast<std::size_t>(status.st_size);
+  if(m_Size != 0)
+  {
+    void* map{mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, descriptor, 0)};
+    if(map == MAP_FAILED)
+    {
+      close(descriptor);
+      throw std::runtime_error(fmt::format("File {} can't be mapped in memory", file));
+    }
+    // The events are read in order, the kernel can read ahead
+    madvise(map, m_Size, MADV_SEQUENTIAL);
+    m_Data = static_cast<const unsigned char*>(map);
+  }
+  // The mapping stays valid after the file is closed
+  close(descriptor);
+#endif
+  // Index : the size in the header gives the next event, a truncated last event (acquisition stopped) is ignored
+  for(std::size_t offset = 0; offset + 4 * HeaderWords <= m_Size;)
+  {
+    const std::uint32_t first{word(m_Data + offset, 0)};
+    const std::size_t   words{first & 0x0FFFFFFF};
+    if((first >> 28) != HeaderTag || words < HeaderWords) throw std::runtime_error(fmt::format("Bad raw event header at byte {} of {} !", offset, file));
+    if(offset + 4 * words > m_Size) break;
+    m_Offsets.push_back(offset);
+    offset += 4 * words;
+  }
+  launch();
+}
+
+RawReader::~RawReader()
+{
+  try
+  {
+    wait();
+  }
+  catch(const std::exception&)
+  {
+  }
+#if defined(_WIN32)
+  if(m_Data != nullptr) UnmapViewOfFile(m_Data);
+  if(m_Mapping != nullptr) CloseHandle(m_Mapping);
+  if(m_File != nullptr && m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+#else
+  if(m_Data != nullptr) munmap(const_cast<unsigned char*>(m_Data), m_Size);
+#endif
+}
+
+bool RawReader::isRaw(const std::string& file)
+{
+  std::ifstream stream(file, std::ios::binary);
+  unsigned char header[4];
+  if(!stream.read(reinterpret_cast<char*>(header), 4)) return false;
+  const std::uint32_t first{word(header, 0)};
+  return (first >> 28) == HeaderTag && (first & 0x0FFFFFFF) >= HeaderWords;
+}
+
+void RawReader::setChannels(const std::vector<bool>& needed)
+{
+  wait();
+  if(needed.empty()) m_Needed.assign(NumberChannels, true);
+  else
+  {
+    m_Needed = needed;
+    m_Needed.resize(NumberChannels, false);
+  }
+}
+
+void RawReader::setCodes(const bool& codes)
+{
+  wait();
+  m_Codes = codes;
+}
+
+void RawReader::decode(const std::size_t& index, RawEvent& event) const
+{
+  const unsigned char* data{m_Data + m_Offsets[index]};
+  const std::size_t    words{word(data, 0) & 0x0FFFFFFF};
+  const std::uint32_t  second{word(data, 1)};
+  event.BoardID        = static_cast<int>(second >> 27);
+  event.Pattern        = static_cast<int>((second >> 8) & 0xFFFF);
+  event.GroupMask      = static_cast<int>(second & 0xF);
+  event.EventNumber    = static_cast<int>(word(data, 2) & 0x3FFFFF);
+  event.EventSize      = 4 * words;
+  event.TriggerTimeTag = word(data, 3);
+  event.Period_ns      = 0;
+  event.Channels.resize(NumberChannels);
+  for(std::size_t ch = 0; ch != NumberChannels; ++ch)
+  {
+    RawChannel& channel{event.Channels[ch]};
+    channel.Number         = static_cast<int>(ch);
+    channel.Group          = static_cast<int>(ch < Groups * ChannelsByGroup ? ch / ChannelsByGroup : ch - Groups * ChannelsByGroup);
+    channel.StartIndexCell = 0;
+    channel.TriggerTimeTag = 0;
+    // Keep the buffers, only the sizes are reset
+    channel.Data.clear();
+    channel.Codes.clear();
+  }
+  bool        first{true};
+  std::size_t position{HeaderWords};
+  for(std::size_t group = 0; group != Groups; ++group)
+  {
+    if(!(event.GroupMask & (1 << group))) continue;
+    if(position >= words) throw std::runtime_error(fmt::format("Group {} missing in the event {} of {} !", group, index, m_Name));
+    const std::uint32_t header{word(data, position)};
+    const std::size_t   size{header & 0xFFF};
+    const bool          trigger{((header >> 12) & 1) != 0};
+    const std::size_t   samples{size / 3};
+    const std::size_t   triggerWords{trigger ? 3 * samples / 8 : 0};
+    if(size % 3 != 0 || position + 1 + size + triggerWords + 1 > words) throw std::runtime_error(fmt::format("Corrupted group {} in the event {} of {} !", group, index, m_Name));
+    const unsigned char* samplesWords{data + 4 * (position + 1)};
+    const double         cell{static_cast<double>((header >> 20) & 0x3FF)};
+    const double         tag{static_cast<double>(word(data, position + 1 + size + triggerWords) & 0x3FFFFFFF)};
+    // Channel by channel : the block of the group (3 words by sample) stays in the cache, the channels not needed are skipped
+    for(std::size_t ch = 0; ch != ChannelsByGroup; ++ch)
+    {
+      RawChannel& channel{event.Channels[group * ChannelsByGroup + ch]};
+      channel.StartIndexCell = cell;
+      channel.TriggerTimeTag = tag;
+      if(!m_Needed[group * ChannelsByGroup + ch]) continue;
+      if(m_Codes) unpackChannel(samplesWords, ch, channel.Codes, samples);
+      else unpackChannel(samplesWords, ch, channel.Data, samples);
+    }
+    RawChannel& channel{event.Channels[Groups * ChannelsByGroup + group]};
+    channel.StartIndexCell = cell;
+    channel.TriggerTimeTag = tag;
+    if(trigger && m_Needed[Groups * ChannelsByGroup + group]) unpackTrigger(samplesWords + 4 * size, channel.Data, samples);
+    if(first)
+    {
+      event.TriggerTimeTag = tag;
+      event.Period_ns      = Periods[(header >> 16) & 0x3];
+      first                = false;
+    }
+    position += 1 + size + triggerWords + 1;
+  }
+}
+
+void RawReader::decodeChunk(std::vector<RawEvent>& chunk, const std::size_t& first, const std::size_t& count) const
+{
+  // Contiguous parts of the chunk, the last one decoded by the calling thread
+  const std::size_t               parts{std::min(m_Threads, count)};
+  std::vector<std::exception_ptr> errors(parts);
+  auto                            work = [&](const std::size_t& part) {
+    try
+    {
+      for(std::size_t i = part * count / parts; i != (part + 1) * count / parts; ++i) decode(first + i, chunk[i]);
+    }
+    catch(...)
+    {
+      errors[part] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  for(std::size_t part = 0; part + 1 < parts; ++part) threads.emplace_back(work, part);
+  work(parts - 1);
+  for(std::thread& thread : threads) thread.join();
+  for(const std::exception_ptr& error : errors)
+    if(error) std::rethrow_exception(error);
+}
+
+void RawReader::launch()
+{
+  m_Pending = std::min(m_ChunkSize, m_Offsets.size() - m_Next);
+  if(m_Pending == 0) return;
+  std::vector<RawEvent>& chunk{m_Chunks[1 - m_Current]};
+  if(chunk.size() < m_Pending) chunk.resize(m_Pending);
+  const std::size_t first{m_Next};
+  const std::size_t count{m_Pending};
+  m_Next += m_Pending;
+  m_Decoding = std::async(std::launch::async, [this, &chunk, first, count]() { decodeChunk(chunk, first, count); });
+}
+
+void RawReader::wait()
+{
+  if(m_Decoding.valid()) m_Decoding.get();
+}
+
+bool RawReader::next(RawEvent& event)
+{
+  if(m_Position == m_Ready)
+  {
+    wait();
+    if(m_Pending == 0) return false;
+    m_Current  = 1 - m_Current;
+    m_Ready    = m_Pending;
+    m_Position = 0;
+    // The chunk just read is filled again while this one is given
+    launch();
+  }
+  std::swap(event, m_Chunks[m_Current][m_Position++]);
+  return true;
+}
+
+std::int64_t RawReader::skip(const std::int64_t& events)
+{
+  if(events <= 0) return 0;
+  std::size_t skipped{std::min<std::size_t>(events, m_Ready - m_Position)};
+  m_Position += skipped;
+  if(skipped == static_cast<std::size_t>(events)) return events;
+  // The chunk decoded in the background is dropped, the decoding restarts after the skipped events
+  wait();
+  const std::size_t start{m_Next - m_Pending};
+  const std::size_t end{std::min(start + (events - skipped), m_Offsets.size())};
+  skipped += end - start;
+  m_Next     = end;
+  m_Ready    = 0;
+  m_Position = 0;
+  launch();
+  return static_cast<std::int64_t>(skipped);
+}
+
+void RawReader::encode(const RawEvent& event, std::vector<std::uint32_t>& words)
+{
+  words.assign(HeaderWords, 0);
+  for(std::size_t group = 0; group != Groups; ++group)
+  {
+    if(!(event.GroupMask & (1 << group))) continue;
+    const RawChannel& trigger{event.Channels.at(Groups * ChannelsByGroup + group)};
+    const std::size_t samples{event.Channels.at(group * ChannelsByGroup).Data.size()};
+    for(std::size_t ch = 0; ch != ChannelsByGroup; ++ch)
+      if(event.Channels[group * ChannelsByGroup + ch].Data.size() != samples) throw std::runtime_error(fmt::format("The channels of the group {} don't have the same number of samples !", group));
+    if(samples % 8 != 0 || 3 * samples > 0xFFF || (!trigger.Data.empty() && trigger.Data.size() != samples)) throw std::runtime_error(fmt::format("Bad number of samples {} for the group {} !", samples, group));
+    const std::size_t frequency{static_cast<std::size_t>(std::min_element(std::begin(Periods), std::end(Periods), [&](const double& a, const double& b) { return std::fabs(a - event.Period_ns) < std::fabs(b - event.Period_ns); }) - std::begin(Periods))};
+    const std::size_t triggerWords{trigger.Data.empty() ? 0 : 3 * samples / 8};
+    words.push_back(static_cast<std::uint32_t>(event.Channels[group * ChannelsByGroup].StartIndexCell) << 20 | static_cast<std::uint32_t>(frequency << 16 | (trigger.Data.empty() ? 0 : 1) << 12 | 3 * samples));
+    const std::size_t begin{words.size()};
+    words.resize(begin + 3 * samples + triggerWords, 0);
+    for(std::size_t ch = 0; ch != ChannelsByGroup; ++ch)
+    {
+      const std::vector<double>& data{event.Channels[group * ChannelsByGroup + ch].Data};
+      for(std::size_t s = 0; s != samples; ++s) put(&words[begin], 12 * (s * ChannelsByGroup + ch), data[s]);
+    }
+    for(std::size_t s = 0; s != trigger.Data.size(); ++s) put(&words[begin + 3 * samples], 12 * s, trigger.Data[s]);
+    words.push_back(static_cast<std::uint32_t>(event.Channels[group * ChannelsByGroup].TriggerTimeTag) & 0x3FFFFFFF);
+  }
+  words[0] = HeaderTag << 28 | static_cast<std::uint32_t>(words.size());
+  words[1] = static_cast<std::uint32_t>(event.BoardID & 0x1F) << 27 | static_cast<std::uint32_t>(event.Pattern & 0xFFFF) << 8 | static_cast<std::uint32_t>(event.GroupMask & 0xF);
+  words[2] = static_cast<std::uint32_t>(event.EventNumber) & 0x3FFFFF;
+  words[3] = static_cast<std::uint32_t>(event.TriggerTimeTag);
+}
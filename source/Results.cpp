@@ -0,0 +1,176 @@
+#include "Results.hpp"
+
+#include "fmt/format.h"
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #define VC_EXTRALEAN
+  #include <Windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace
+{
+constexpr char        Magic[8]{'R', 'P', 'C', 'R', 'E', 'S', '0', '1'};
+constexpr std::size_t Alignment{sizeof(double)};
+}  // namespace
+
+ResultsWriter::ResultsWriter(const std::string& filename, const std::vector<std::string>& columns, const bool& append, const std::size_t& keep) : m_Filename(filename), m_Columns(columns)
+{
+  if(columns.empty()) throw std::runtime_error(fmt::format("Results file {} needs at least one column !", filename));
+  std::string header(Magic, sizeof(Magic));
+  auto        append32 = [&header](const std::uint32_t& value) { header.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+  append32(static_cast<std::uint32_t>(columns.size()));
+  append32(0);
+  for(std::size_t i = 0; i != columns.size(); ++i)
+  {
+    append32(static_cast<std::uint32_t>(columns[i].size()));
+    header += columns[i];
+  }
+  header.resize((header.size() + Alignment - 1) / Alignment * Alignment, '\0');
+  const std::uint32_t size{static_cast<std::uint32_t>(header.size())};
+  std::memcpy(&header[sizeof(Magic) + sizeof(std::uint32_t)], &size, sizeof(size));
+  if(append && std::filesystem::exists(filename))
+  {
+    {
+      const ResultsReader reader(filename);
+      if(reader.getColumns() != columns) throw std::runtime_error(fmt::format("{} doesn't have the columns of the results to append !", filename));
+      m_NbrRecords = std::min(keep, reader.getNumberRecords());
+    }
+    // Records after the ones kept (and a partial one) dropped
+    std::filesystem::resize_file(filename, header.size() + m_NbrRecords * columns.size() * sizeof(double));
+    m_File.open(filename, std::ios::binary | std::ios::app);
+    if(!m_File) throw std::runtime_error(fmt::format("Can't open {} !", filename));
+    return;
+  }
+  m_File.open(filename, std::ios::binary | std::ios::trunc);
+  if(!m_File) throw std::runtime_error(fmt::format("Can't open {} !", filename));
+  m_File.write(header.data(), header.size());
+  m_File.flush();
+}
+
+void ResultsWriter::append(const std::vector<double>& record, const bool& flush)
+{
+  if(record.size() != m_Columns.size()) throw std::runtime_error(fmt::format("Record with {} values for {} columns in {} !", record.size(), m_Columns.size(), m_Filename));
+  m_File.write(reinterpret_cast<const char*>(record.data()), record.size() * sizeof(double));
+  if(flush) m_File.flush();
+  if(!m_File) throw std::runtime_error(fmt::format("Error while writing {} !", m_Filename));
+  ++m_NbrRecords;
+}
+
+void ResultsWriter::flush()
+{
+  m_File.flush();
+  if(!m_File) throw std::runtime_error(fmt::format("Error while writing {} !", m_Filename));
+}
+
+ResultsReader::ResultsReader(const std::string& filename)
+{
+#if defined(_WIN32)
+  m_FileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(m_FileHandle == INVALID_HANDLE_VALUE) throw std::runtime_error(fmt::format("Can't open {} !", filename));
+  LARGE_INTEGER size;
+  GetFileSizeEx(m_FileHandle, &size);
+  m_Size = static_cast<std::size_t>(size.QuadPart);
+  if(m_Size != 0)
+  {
+    m_MapHandle = CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(m_MapHandle != nullptr) m_Map = MapViewOfFile(m_MapHandle, FILE_MAP_READ, 0, 0, 0);
+  }
+#else
+  const int fd{open(filename.c_str(), O_RDONLY)};
+  if(fd < 0) throw std::runtime_error(fmt::format("Can't open {} !", filename));
+  struct stat info;
+  fstat(fd, &info);
+  m_Size = static_cast<std::size_t>(info.st_size);
+  if(m_Size != 0)
+  {
+    m_Map = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(m_Map == MAP_FAILED) m_Map = nullptr;
+  }
+  close(fd);
+#endif
+  const char* data{static_cast<const char*>(m_Map)};
+  if(data == nullptr || m_Size < sizeof(Magic) + 2 * sizeof(std::uint32_t) || std::memcmp(data, Magic, sizeof(Magic)) != 0)
+  {
+    unmap();
+    throw std::runtime_error(fmt::format("{} is not a results file !", filename));
+  }
+  std::uint32_t columns{0};
+  std::uint32_t headerSize{0};
+  std::memcpy(&columns, data + sizeof(Magic), sizeof(columns));
+  std::memcpy(&headerSize, data + sizeof(Magic) + sizeof(columns), sizeof(headerSize));
+  auto corrupted = [this, &filename]() {
+    unmap();
+    return std::runtime_error(fmt::format("{} has a corrupted header !", filename));
+  };
+  std::size_t position{sizeof(Magic) + 2 * sizeof(std::uint32_t)};
+  if(columns == 0 || headerSize > m_Size || headerSize % Alignment != 0 || headerSize < position) throw corrupted();
+  for(std::uint32_t i = 0; i != columns; ++i)
+  {
+    std::uint32_t length{0};
+    if(position + sizeof(length) > headerSize) throw corrupted();
+    std::memcpy(&length, data + position, sizeof(length));
+    position += sizeof(length);
+    // Compared with what is left of the header (position + length could wrap around)
+    if(length > headerSize - position) throw corrupted();
+    m_Columns.emplace_back(data + position, length);
+    position += length;
+  }
+  m_Records = reinterpret_cast<const double*>(data + headerSize);
+  // An incomplete last record (job killed while writing) is ignored
+  m_NbrRecords = (m_Size - headerSize) / (columns * sizeof(double));
+}
+
+ResultsReader::~ResultsReader()
+{
+  unmap();
+}
+
+void ResultsReader::unmap()
+{
+#if defined(_WIN32)
+  if(m_Map != nullptr) UnmapViewOfFile(m_Map);
+  if(m_MapHandle != nullptr) CloseHandle(m_MapHandle);
+  if(m_FileHandle != nullptr && m_FileHandle != INVALID_HANDLE_VALUE) CloseHandle(m_FileHandle);
+  m_MapHandle  = nullptr;
+  m_FileHandle = nullptr;
+#else
+  if(m_Map != nullptr) munmap(m_Map, m_Size);
+#endif
+  m_Map = nullptr;
+}
+
+bool ResultsReader::hasColumn(const std::string& name) const
+{
+  return std::find(m_Columns.begin(), m_Columns.end(), name) != m_Columns.end();
+}
+
+std::size_t ResultsReader::getColumnIndex(const std::string& name) const
+{
+  const std::vector<std::string>::const_iterator it{std::find(m_Columns.begin(), m_Columns.end(), name)};
+  if(it == m_Columns.end()) throw std::runtime_error(fmt::format("No column \"{}\" in the results file !", name));
+  return static_cast<std::size_t>(it - m_Columns.begin());
+}
+
+void ResultsReader::exportCSV(const std::string& filename) const
+{
+  std::ofstream out(filename);
+  if(!out) throw std::runtime_error(fmt::format("Can't open {} !", filename));
+  for(std::size_t column = 0; column != m_Columns.size(); ++column) out << (column == 0 ? "" : ",") << m_Columns[column];
+  out << "\n";
+  for(std::size_t record = 0; record != m_NbrRecords; ++record)
+  {
+    for(std::size_t column = 0; column != m_Columns.size(); ++column) out << (column == 0 ? "" : ",") << fmt::format("{}", get(record, column));
+    out << "\n";
+  }
+}
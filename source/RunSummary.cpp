@@ -0,0 +1,94 @@
+#include "RunSummary.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+void RunSummary::add(const RunSummary& other)
+{
+  if(Chambers.empty())
+  {
+    *this = other;
+    return;
+  }
+  if(other.Chambers.size() != Chambers.size()) throw std::runtime_error(fmt::format("Can't merge summaries with {} and {} chambers !", Chambers.size(), other.Chambers.size()));
+  Events += other.Events;
+  Invalid += other.Invalid;
+  Corrected += other.Corrected;
+  Classified += other.Classified;
+  for(std::size_t chamber = 0; chamber != Chambers.size(); ++chamber)
+  {
+    Chamber&       to = Chambers[chamber];
+    const Chamber& from = other.Chambers[chamber];
+    to.Efficient += from.Efficient;
+    to.EfficientCorrected += from.EfficientCorrected;
+    to.Hits += from.Hits;
+    for(std::size_t c = 0; c != to.Classes.size(); ++c) to.Classes[c] += from.Classes[c];
+    to.ClusterSize.add(from.ClusterSize);
+    to.ClusterNumber.add(from.ClusterNumber);
+    to.Charge.add(from.Charge);
+    to.ChargeSum += from.ChargeSum;
+    to.ChargeEntries += from.ChargeEntries;
+  }
+}
+
+std::string RunSummary::serialize() const
+{
+  std::ostringstream stream;
+  stream << fmt::format("RunSummary {} {} {} {} {}\n", Events, Invalid, Corrected, Classified, Chambers.size());
+  for(std::size_t chamber = 0; chamber != Chambers.size(); ++chamber)
+  {
+    const Chamber& summary = Chambers[chamber];
+    stream << fmt::format("{} {} {} {} {}", summary.Efficient, summary.EfficientCorrected, summary.Hits, summary.ChargeSum, summary.ChargeEntries);
+    for(std::size_t c = 0; c != summary.Classes.size(); ++c) stream << ' ' << summary.Classes[c];
+    stream << '\n';
+    summary.ClusterSize.write(stream);
+    summary.ClusterNumber.write(stream);
+    summary.Charge.write(stream);
+  }
+  return stream.str();
+}
+
+RunSummary RunSummary::deserialize(const std::string& summary)
+{
+  std::istringstream stream(summary);
+  std::string        magic;
+  std::size_t        chambers{0};
+  RunSummary         run;
+  stream >> magic >> run.Events >> run.Invalid >> run.Corrected >> run.Classified >> chambers;
+  if(!stream || magic != "RunSummary") throw std::runtime_error("Invalid run summary !");
+  run.Chambers.resize(chambers);
+  for(std::size_t chamber = 0; chamber != chambers; ++chamber)
+  {
+    Chamber& to = run.Chambers[chamber];
+    stream >> to.Efficient >> to.EfficientCorrected >> to.Hits >> to.ChargeSum >> to.ChargeEntries;
+    for(std::size_t c = 0; c != to.Classes.size(); ++c) stream >> to.Classes[c];
+    if(!stream) throw std::runtime_error(fmt::format("Invalid run summary for chamber {} !", chamber));
+    to.ClusterSize   = Histogram::read(stream);
+    to.ClusterNumber = Histogram::read(stream);
+    to.Charge        = Histogram::read(stream);
+  }
+  return run;
+}
+
+std::vector<std::string> RunSummary::getColumns()
+{
+  return {"HV", "Efficiency", "Error Efficiency", "Efficiency Corrected", "Error Efficiency Corrected", "Multiplicity", "Cluster Size", "Cluster Number", "Charge", "Avalanche", "Streamer", "Noise Burst"};
+}
+
+std::vector<double> RunSummary::getRecord(const std::size_t& chamber, const double& HV, const double& scaleFactor) const
+{
+  const Chamber& summary = Chambers[chamber];
+  // Events with an invalid trigger were not analysed, they don't count in the efficiency
+  const double   valid{static_cast<double>(Events - Invalid)};
+  const double   efficiency{summary.Efficient / (valid * scaleFactor)};
+  const double   corrected{summary.EfficientCorrected / (Corrected * scaleFactor)};
+  // Fraction of the events of each class (efficiency by class)
+  const double   classified{static_cast<double>(std::max<std::uint64_t>(Classified, 1))};
+  std::vector<double> record{HV, efficiency, std::sqrt(efficiency * (1 - efficiency) / valid), corrected, std::sqrt(corrected * (1 - corrected) / Corrected), static_cast<double>(summary.Hits) / summary.Efficient, summary.ClusterSize.getMean(), summary.ClusterNumber.getMean(), summary.getMeanCharge()};
+  for(const EventClass type : {EventClass::Avalanche, EventClass::Streamer, EventClass::NoiseBurst}) record.push_back(summary.Classes[static_cast<std::size_t>(type)] / classified);
+  return record;
+}
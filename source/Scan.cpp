@@ -0,0 +1,185 @@
+#include "Scan.hpp"
+
+#include "Kernels.hpp"
+#include "State.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+Scan::Scan(const std::size_t& chambers, const std::vector<double>& sigmas, const std::vector<std::pair<double, double>>& windows, const std::vector<double>& noiseRatios, const std::pair<double, double>& noiseWindow, const std::pair<double, double>& noiseWindowAfter) :
+    m_Chambers(chambers), m_Sigmas(sigmas), m_Windows(windows), m_NoiseRatios(noiseRatios), m_NoiseWindow(noiseWindow), m_NoiseWindowAfter(noiseWindowAfter)
+{
+  if(m_Sigmas.empty() || m_Windows.empty()) throw std::runtime_error("The scan needs at least one threshold and one window !");
+  if(m_Sigmas.size() > std::numeric_limits<std::uint16_t>::max()) throw std::runtime_error(fmt::format("Too many thresholds in the scan ({}) !", m_Sigmas.size()));
+  // (int)(tick - delay -+ width/2) of WindowFinder::getWindow is tick + floor(-delay -+ width/2) (negative values are clamped to 0 anyway)
+  for(std::size_t w = 0; w != m_Windows.size(); ++w)
+  {
+    m_Begin.push_back(static_cast<int>(std::floor(-m_Windows[w].first - m_Windows[w].second / 2)));
+    m_End.push_back(static_cast<int>(std::floor(-m_Windows[w].first + m_Windows[w].second / 2)));
+    m_Bounds.push_back(m_Begin.back());
+    m_Bounds.push_back(m_End.back());
+  }
+  std::sort(m_Bounds.begin(), m_Bounds.end());
+  m_Bounds.erase(std::unique(m_Bounds.begin(), m_Bounds.end()), m_Bounds.end());
+  for(std::size_t w = 0; w != m_Windows.size(); ++w)
+  {
+    m_FirstSegment.push_back(std::lower_bound(m_Bounds.begin(), m_Bounds.end(), m_Begin[w]) - m_Bounds.begin());
+    m_LastSegment.push_back(std::lower_bound(m_Bounds.begin(), m_Bounds.end(), m_End[w]) - m_Bounds.begin());
+  }
+  m_Segment.resize(m_Bounds.size());
+  m_Distance.resize(m_Sigmas.size());
+  const std::size_t points{m_Chambers * m_Windows.size() * m_Sigmas.size()};
+  m_EventHits.assign(points, 0);
+  m_EventNoise.assign(m_Chambers * m_Sigmas.size(), 0);
+  m_EventNoisy.assign(m_Chambers * m_NoiseRatios.size(), 0);
+  m_NoisyBefore.assign(m_NoiseRatios.size(), 0);
+  m_Efficient.assign(points, 0);
+  m_Hits.assign(points, 0);
+  m_Corrected.assign(m_NoiseRatios.size(), 0);
+  m_EfficientCorrected.assign(m_NoiseRatios.size() * points, 0);
+  m_NoiseEvents.assign(m_Chambers * m_Sigmas.size(), 0);
+  m_NoisyEvents.assign(m_Chambers * m_NoiseRatios.size(), 0);
+}
+
+void Scan::addChannel(const int& chamber, const double* data, const std::size_t& length, const int& sign, const int& triggerTick)
+{
+  if(chamber < 0 || static_cast<std::size_t>(chamber) >= m_Chambers || length == 0) return;
+  const std::size_t               sigmas{m_Sigmas.size()};
+  const std::pair<double, double> noise{Kernels::meanSigma<0>(data, length, m_NoiseWindow.first, m_NoiseWindow.second)};
+  // Thresholds of this channel (same product as in the run)
+  for(std::size_t t = 0; t != sigmas; ++t) m_Distance[t] = m_Sigmas[t] * noise.second;
+
+  // Noise window after the signal : noisy ratio and hits without signal
+  const std::pair<double, double> after{Kernels::meanSigma<0>(data, length, m_NoiseWindowAfter.first, m_NoiseWindowAfter.second)};
+  const double                    ratio{after.second * 1.0 / noise.second};
+  for(std::size_t k = 0; k != m_NoiseRatios.size(); ++k) m_EventNoisy[chamber * m_NoiseRatios.size() + k] |= ratio >= m_NoiseRatios[k];
+  const int                    afterBegin{static_cast<int>(std::ceil(m_NoiseWindowAfter.first))};
+  const int                    afterEnd{static_cast<int>(std::floor(m_NoiseWindowAfter.second)) + 1};
+  const std::pair<double, int> afterExtremum{sign < 0 ? Kernels::extremum<-1, 0>(data, length, afterBegin, afterEnd) : Kernels::extremum<+1, 0>(data, length, afterBegin, afterEnd)};
+  if(afterBegin < afterEnd && afterBegin < static_cast<int>(length))
+  {
+    const double   deviation{std::fabs(afterExtremum.first - after.first)};
+    std::uint8_t*  noiseHits{&m_EventNoise[chamber * sigmas]};
+    for(std::size_t t = 0; t != sigmas; ++t) noiseHits[t] |= deviation > m_Distance[t];
+  }
+
+  // Extremum (on sign x data) of each segment between two consecutive bounds, clamped to the record
+  const int         size{static_cast<int>(length)};
+  const std::size_t nbrBounds{m_Bounds.size()};
+  auto              absolute = [&](const int& relative) { return std::min(std::max(triggerTick + relative, 0), size); };
+  for(std::size_t s = 0; s + 1 < nbrBounds; ++s)
+  {
+    double best{std::numeric_limits<double>::lowest()};
+    for(int i = absolute(m_Bounds[s]); i < absolute(m_Bounds[s + 1]); ++i) best = std::max(best, sign * data[i]);
+    m_Segment[s] = best;
+  }
+  // Prefix sums for the means, the mean of a window includes its last tick (MeanSTD convention)
+  const int first{absolute(m_Bounds.front())};
+  const int last{std::min(absolute(m_Bounds.back()) + 1, size)};
+  m_Prefix.resize(static_cast<std::size_t>(std::max(last - first, 0)) + 1);
+  m_Prefix[0] = 0;
+  for(int i = first; i < last; ++i) m_Prefix[i - first + 1] = m_Prefix[i - first] + data[i];
+
+  std::uint16_t* hits{&m_EventHits[index(chamber, 0, 0)]};
+  for(std::size_t w = 0; w != m_Windows.size(); ++w, hits += sigmas)
+  {
+    const int begin{absolute(m_Begin[w])};
+    const int end{absolute(m_End[w])};
+    if(begin >= end) continue;
+    double best{std::numeric_limits<double>::lowest()};
+    for(std::size_t s = m_FirstSegment[w]; s != m_LastSegment[w]; ++s) best = std::max(best, m_Segment[s]);
+    const int    meanEnd{std::min(end + 1, size)};
+    const double mean{(m_Prefix[meanEnd - first] - m_Prefix[begin - first]) / (meanEnd - begin)};
+    const double deviation{std::fabs(sign * best - mean)};
+    // All the thresholds at once
+    for(std::size_t t = 0; t != sigmas; ++t) hits[t] += deviation > m_Distance[t];
+  }
+}
+
+void Scan::endEvent()
+{
+  ++m_Events;
+  const std::size_t points{m_EventHits.size()};
+  for(std::size_t i = 0; i != points; ++i)
+  {
+    m_Efficient[i] += m_EventHits[i] != 0;
+    m_Hits[i] += m_EventHits[i];
+  }
+  // The event after a noisy one (any chamber) is excluded of the corrected efficiency, unless it is noisy itself
+  // (same rule as EfficiencyCounter in a run)
+  for(std::size_t k = 0; k != m_NoiseRatios.size(); ++k)
+  {
+    std::uint8_t noisy{0};
+    for(std::size_t chamber = 0; chamber != m_Chambers; ++chamber) noisy |= m_EventNoisy[chamber * m_NoiseRatios.size() + k];
+    if(m_NoisyBefore[k] == 0 || noisy != 0)
+    {
+      ++m_Corrected[k];
+      std::uint64_t* corrected{&m_EfficientCorrected[k * points]};
+      for(std::size_t i = 0; i != points; ++i) corrected[i] += m_EventHits[i] != 0;
+    }
+    m_NoisyBefore[k] = noisy;
+  }
+  for(std::size_t i = 0; i != m_EventNoise.size(); ++i) m_NoiseEvents[i] += m_EventNoise[i];
+  for(std::size_t i = 0; i != m_EventNoisy.size(); ++i) m_NoisyEvents[i] += m_EventNoisy[i];
+  std::fill(m_EventHits.begin(), m_EventHits.end(), 0);
+  std::fill(m_EventNoise.begin(), m_EventNoise.end(), 0);
+  std::fill(m_EventNoisy.begin(), m_EventNoisy.end(), 0);
+}
+
+void Scan::skipEvent()
+{
+  std::fill(m_NoisyBefore.begin(), m_NoisyBefore.end(), 0);
+  std::fill(m_EventHits.begin(), m_EventHits.end(), 0);
+  std::fill(m_EventNoise.begin(), m_EventNoise.end(), 0);
+  std::fill(m_EventNoisy.begin(), m_EventNoisy.end(), 0);
+}
+
+std::vector<std::string> Scan::getColumns()
+{
+  return {"HV", "Chamber", "Sigma", "Delay", "Width", "Sigma Noise", "Efficiency", "Error Efficiency", "Efficiency Corrected", "Error Efficiency Corrected", "Multiplicity", "Noise Rate", "Noisy Fraction"};
+}
+
+std::vector<std::vector<double>> Scan::getRecords(const double& HV, const double& scaleFactor, const double& period) const
+{
+  std::vector<std::vector<double>> records;
+  const double                     events{static_cast<double>(m_Events)};
+  // Duration (s) of the noise window after the signal
+  const double                     afterTicks{std::floor(m_NoiseWindowAfter.second) - std::ceil(m_NoiseWindowAfter.first) + 1};
+  const double                     duration{afterTicks * period * 1e-9};
+  for(std::size_t chamber = 0; chamber != m_Chambers; ++chamber)
+    for(std::size_t w = 0; w != m_Windows.size(); ++w)
+      for(std::size_t t = 0; t != m_Sigmas.size(); ++t)
+      {
+        const double efficiency{getEfficient(chamber, w, t) / (events * scaleFactor)};
+        const double multiplicity{static_cast<double>(getHits(chamber, w, t)) / getEfficient(chamber, w, t)};
+        const double noiseRate{getNoiseEvents(chamber, t) / (events * duration)};
+        // Without noise ratio : the corrected efficiency is the efficiency
+        const std::size_t noises{std::max<std::size_t>(m_NoiseRatios.size(), 1)};
+        for(std::size_t k = 0; k != noises; ++k)
+        {
+          const bool   noisy{!m_NoiseRatios.empty()};
+          const double corrected{noisy ? static_cast<double>(getCorrected(k)) : events};
+          const double efficiencyCorrected{noisy ? getEfficientCorrected(k, chamber, w, t) / (corrected * scaleFactor) : efficiency};
+          records.push_back({HV, static_cast<double>(chamber), m_Sigmas[t], m_Windows[w].first, m_Windows[w].second, noisy ? m_NoiseRatios[k] : std::nan(""), efficiency, std::sqrt(efficiency * (1 - efficiency) / events), efficiencyCorrected, std::sqrt(efficiencyCorrected * (1 - efficiencyCorrected) / corrected), multiplicity, noiseRate, noisy ? getNoisyEvents(chamber, k) / events : std::nan("")});
+        }
+      }
+  return records;
+}
+
+void Scan::save(std::ostream& stream) const
+{
+  State::write(stream, m_Events);
+  for(const std::vector<std::uint64_t>* counters : {&m_Efficient, &m_Hits, &m_Corrected, &m_EfficientCorrected, &m_NoiseEvents, &m_NoisyEvents}) State::write(stream, *counters);
+  // The event after a noisy one is excluded
+  State::write(stream, m_NoisyBefore);
+}
+
+void Scan::restore(std::istream& stream)
+{
+  State::read(stream, m_Events);
+  for(std::vector<std::uint64_t>* counters : {&m_Efficient, &m_Hits, &m_Corrected, &m_EfficientCorrected, &m_NoiseEvents, &m_NoisyEvents}) State::read(stream, *counters);
+  State::read(stream, m_NoisyBefore);
+}
@@ -0,0 +1,307 @@
+#include "Selection.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace
+{
+constexpr std::size_t Block{Selection::Block};
+
+// The result goes in a local block first : no aliasing with the operands so the loops vectorise
+template<typename Function> void unary(const double* a, double* out, const Function& function)
+{
+  double result[Block];
+  for(std::size_t i = 0; i != Block; ++i) result[i] = function(a[i]);
+  std::copy(result, result + Block, out);
+}
+
+template<typename Function> void binary(const double* a, const double* b, double* out, const Function& function)
+{
+  double result[Block];
+  for(std::size_t i = 0; i != Block; ++i) result[i] = function(a[i], b[i]);
+  std::copy(result, result + Block, out);
+}
+
+const std::map<std::string, std::size_t> Functions{{"abs", 1}, {"sqrt", 1}, {"min", 2}, {"max", 2}};
+}  // namespace
+
+Selection::Selection(const std::string& expression, const std::vector<std::string>& variables, const std::map<std::string, double>& constants) : m_Expression(expression), m_Variables(variables), m_Names(constants)
+{
+  for(const std::string& variable : m_Variables)
+    if(m_Names.count(variable) != 0) throw std::runtime_error(fmt::format("{} is both a variable and a constant of the selection !", variable));
+  parseOr();
+  skipSpaces();
+  if(m_Position != m_Expression.size()) fail("unexpected character");
+  // Deepest stack of the bytecode
+  std::size_t depth{0};
+  std::size_t deepest{0};
+  for(const Instruction& instruction : m_Code)
+  {
+    if(instruction.Code == Op::Variable || instruction.Code == Op::Constant) ++depth;
+    else if(instruction.Code >= Op::Add)
+      --depth;
+    deepest = std::max(deepest, depth);
+  }
+  m_Stack.resize(deepest);
+  for(const double& value : m_Values) m_Blocks.emplace_back(Block, value);
+  m_Tail.assign(m_Variables.size(), std::vector<double>(Block, 0));
+  m_TailColumns.resize(m_Variables.size());
+}
+
+void Selection::fail(const std::string& error) const
+{
+  throw std::runtime_error(fmt::format("Selection \"{}\" : {} at position {} !", m_Expression, error, m_Position));
+}
+
+void Selection::skipSpaces()
+{
+  while(m_Position < m_Expression.size() && std::isspace(static_cast<unsigned char>(m_Expression[m_Position]))) ++m_Position;
+}
+
+bool Selection::accept(const std::string& token)
+{
+  skipSpaces();
+  if(m_Expression.compare(m_Position, token.size(), token) != 0) return false;
+  // < > and ! must not take the beginning of <= >= and !=
+  if(token.size() == 1 && (token == "<" || token == ">" || token == "!") && m_Position + 1 < m_Expression.size() && m_Expression[m_Position + 1] == '=') return false;
+  m_Position += token.size();
+  return true;
+}
+
+void Selection::apply(const Op& code, const double* a, const double* b, double* out)
+{
+  switch(code)
+  {
+    case Op::Negate: unary(a, out, [](const double& x) { return -x; }); break;
+    case Op::Not: unary(a, out, [](const double& x) { return static_cast<double>(x == 0); }); break;
+    case Op::Abs: unary(a, out, [](const double& x) { return std::fabs(x); }); break;
+    case Op::Sqrt: unary(a, out, [](const double& x) { return std::sqrt(x); }); break;
+    case Op::Add: binary(a, b, out, [](const double& x, const double& y) { return x + y; }); break;
+    case Op::Subtract: binary(a, b, out, [](const double& x, const double& y) { return x - y; }); break;
+    case Op::Multiply: binary(a, b, out, [](const double& x, const double& y) { return x * y; }); break;
+    case Op::Divide: binary(a, b, out, [](const double& x, const double& y) { return x / y; }); break;
+    case Op::Less: binary(a, b, out, [](const double& x, const double& y) { return static_cast<double>(x < y); }); break;
+    case Op::LessEqual: binary(a, b, out, [](const double& x, const double& y) { return static_cast<double>(x <= y); }); break;
+    case Op::Greater: binary(a, b, out, [](const double& x, const double& y) { return static_cast<double>(x > y); }); break;
+    case Op::GreaterEqual: binary(a, b, out, [](const double& x, const double& y) { return static_cast<double>(x >= y); }); break;
+    case Op::Equal: binary(a, b, out, [](const double& x, const double& y) { return static_cast<double>(x == y); }); break;
+    case Op::NotEqual: binary(a, b, out, [](const double& x, const double& y) { return static_cast<double>(x != y); }); break;
+    case Op::And: binary(a, b, out, [](const double& x, const double& y) { return static_cast<double>((x != 0) & (y != 0)); }); break;
+    case Op::Or: binary(a, b, out, [](const double& x, const double& y) { return static_cast<double>((x != 0) | (y != 0)); }); break;
+    case Op::Min: binary(a, b, out, [](const double& x, const double& y) { return std::min(x, y); }); break;
+    case Op::Max: binary(a, b, out, [](const double& x, const double& y) { return std::max(x, y); }); break;
+    case Op::Variable:
+    case Op::Constant: break;
+  }
+}
+
+void Selection::emit(const Op& code, const std::size_t& operand)
+{
+  const std::size_t operands{code >= Op::Add ? std::size_t(2) : std::size_t(1)};
+  // Constant folding : the operands are the last instructions, if they are all constants the result is one too
+  bool constant{code != Op::Variable && code != Op::Constant && m_Code.size() >= operands};
+  for(std::size_t i = 0; constant && i != operands; ++i) constant = m_Code[m_Code.size() - 1 - i].Code == Op::Constant;
+  if(!constant)
+  {
+    m_Code.push_back({code, operand});
+    return;
+  }
+  double a[Block];
+  double b[Block];
+  double result[Block];
+  std::fill(a, a + Block, m_Values[m_Code[m_Code.size() - operands].Operand]);
+  std::fill(b, b + Block, m_Values[m_Code.back().Operand]);
+  // They are also the last values
+  for(std::size_t i = 0; i != operands; ++i)
+  {
+    m_Values.pop_back();
+    m_Code.pop_back();
+  }
+  apply(code, a, b, result);
+  pushConstant(result[0]);
+}
+
+void Selection::pushConstant(const double& value)
+{
+  m_Values.push_back(value);
+  m_Code.push_back({Op::Constant, m_Values.size() - 1});
+}
+
+void Selection::parseOr()
+{
+  parseAnd();
+  while(accept("||"))
+  {
+    parseAnd();
+    emit(Op::Or);
+  }
+}
+
+void Selection::parseAnd()
+{
+  parseComparison();
+  while(accept("&&"))
+  {
+    parseComparison();
+    emit(Op::And);
+  }
+}
+
+void Selection::parseComparison()
+{
+  parseSum();
+  const std::vector<std::pair<std::string, Op>> comparisons{{"<=", Op::LessEqual}, {">=", Op::GreaterEqual}, {"==", Op::Equal}, {"!=", Op::NotEqual}, {"<", Op::Less}, {">", Op::Greater}};
+  for(const std::pair<std::string, Op>& comparison : comparisons)
+  {
+    if(!accept(comparison.first)) continue;
+    parseSum();
+    emit(comparison.second);
+    return;
+  }
+}
+
+void Selection::parseSum()
+{
+  parseProduct();
+  while(true)
+  {
+    Op code{Op::Add};
+    if(accept("-")) code = Op::Subtract;
+    else if(!accept("+"))
+      return;
+    parseProduct();
+    emit(code);
+  }
+}
+
+void Selection::parseProduct()
+{
+  parseUnary();
+  while(true)
+  {
+    Op code{Op::Multiply};
+    if(accept("/")) code = Op::Divide;
+    else if(!accept("*"))
+      return;
+    parseUnary();
+    emit(code);
+  }
+}
+
+void Selection::parseUnary()
+{
+  if(accept("-"))
+  {
+    parseUnary();
+    emit(Op::Negate);
+  }
+  else if(accept("!"))
+  {
+    parseUnary();
+    emit(Op::Not);
+  }
+  else if(accept("+"))
+    parseUnary();
+  else
+    parsePrimary();
+}
+
+void Selection::parsePrimary()
+{
+  skipSpaces();
+  if(m_Position == m_Expression.size()) fail("missing operand");
+  if(accept("("))
+  {
+    parseOr();
+    if(!accept(")")) fail("missing )");
+    return;
+  }
+  const char first{m_Expression[m_Position]};
+  if(std::isdigit(static_cast<unsigned char>(first)) || first == '.')
+  {
+    const char* begin{m_Expression.c_str() + m_Position};
+    char*       end{nullptr};
+    const double value{std::strtod(begin, &end)};
+    m_Position += end - begin;
+    pushConstant(value);
+    return;
+  }
+  if(!std::isalpha(static_cast<unsigned char>(first)) && first != '_') fail("unexpected character");
+  const std::size_t begin{m_Position};
+  while(m_Position < m_Expression.size() && (std::isalnum(static_cast<unsigned char>(m_Expression[m_Position])) || m_Expression[m_Position] == '_')) ++m_Position;
+  const std::string name{m_Expression.substr(begin, m_Position - begin)};
+  if(Functions.count(name) != 0)
+  {
+    if(!accept("(")) fail(fmt::format("missing ( after {}", name));
+    parseOr();
+    if(Functions.at(name) == 2)
+    {
+      if(!accept(",")) fail(fmt::format("{} takes two arguments", name));
+      parseOr();
+    }
+    if(!accept(")")) fail("missing )");
+    emit(name == "abs" ? Op::Abs : name == "sqrt" ? Op::Sqrt : name == "min" ? Op::Min : Op::Max);
+    return;
+  }
+  const std::map<std::string, double>::const_iterator constant{m_Names.find(name)};
+  if(constant != m_Names.end())
+  {
+    pushConstant(constant->second);
+    return;
+  }
+  const std::vector<std::string>::const_iterator variable{std::find(m_Variables.begin(), m_Variables.end(), name)};
+  if(variable == m_Variables.end())
+  {
+    std::string known;
+    for(const std::string& name : m_Variables) known += (known.empty() ? "" : ", ") + name;
+    m_Position = begin;
+    fail(fmt::format("unknown name {} (variables : {})", name, known));
+  }
+  emit(Op::Variable, variable - m_Variables.begin());
+}
+
+void Selection::run(const std::vector<const double*>& columns, const std::size_t& offset, std::uint8_t* results, const std::size_t& rows)
+{
+  std::size_t top{0};
+  for(const Instruction& instruction : m_Code)
+  {
+    switch(instruction.Code)
+    {
+      case Op::Variable: m_Stack[top++].Data = columns[instruction.Operand] + offset; break;
+      case Op::Constant: m_Stack[top++].Data = m_Blocks[instruction.Operand].data(); break;
+      case Op::Negate:
+      case Op::Not:
+      case Op::Abs:
+      case Op::Sqrt:
+        apply(instruction.Code, m_Stack[top - 1].Data, nullptr, m_Stack[top - 1].Storage);
+        m_Stack[top - 1].Data = m_Stack[top - 1].Storage;
+        break;
+      default:
+        apply(instruction.Code, m_Stack[top - 2].Data, m_Stack[top - 1].Data, m_Stack[top - 2].Storage);
+        m_Stack[top - 2].Data = m_Stack[top - 2].Storage;
+        --top;
+        break;
+    }
+  }
+  for(std::size_t i = 0; i != rows; ++i) results[i] = m_Stack[0].Data[i] != 0;
+}
+
+void Selection::evaluate(const std::vector<const double*>& columns, const std::size_t& rows, std::uint8_t* results)
+{
+  if(columns.size() < m_Variables.size()) throw std::runtime_error(fmt::format("Selection \"{}\" needs {} columns, {} given !", m_Expression, m_Variables.size(), columns.size()));
+  std::size_t row{0};
+  for(; row + Block <= rows; row += Block) run(columns, row, results + row, Block);
+  if(row == rows) return;
+  // Last rows copied in full blocks
+  for(std::size_t v = 0; v != m_Variables.size(); ++v)
+  {
+    std::copy(columns[v] + row, columns[v] + rows, m_Tail[v].begin());
+    m_TailColumns[v] = m_Tail[v].data();
+  }
+  run(m_TailColumns, 0, results + row, rows - row);
+}
@@ -0,0 +1,238 @@
+#include "Spectrum.hpp"
+
+#include "State.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+const double Pi{std::acos(-1.0)};
+}
+
+FFT::FFT(const std::size_t& size) : m_Size(size)
+{
+  if(size < 4 || (size & (size - 1)) != 0) throw std::runtime_error(fmt::format("FFT size {} is not a power of two >= 4 !", size));
+  const std::size_t half{size / 2};
+  std::size_t       bits{0};
+  while((std::size_t(1) << bits) < half) ++bits;
+  m_Reverse.resize(half);
+  for(std::size_t i = 0; i != half; ++i)
+  {
+    std::size_t reversed{0};
+    for(std::size_t b = 0; b != bits; ++b)
+      if(i & (std::size_t(1) << b)) reversed |= std::size_t(1) << (bits - 1 - b);
+    m_Reverse[i] = reversed;
+  }
+  for(std::size_t j = 0; j != half / 2 + 1; ++j) m_Twiddles.push_back(std::polar(1.0, -2 * Pi * j / half));
+  for(std::size_t k = 0; k != half + 1; ++k) m_Split.push_back(std::polar(1.0, -2 * Pi * k / size));
+}
+
+std::size_t FFT::floorPowerOfTwo(const std::size_t& length)
+{
+  if(length < 4) return 0;
+  std::size_t size{4};
+  while(size * 2 <= length) size *= 2;
+  return size;
+}
+
+void FFT::power(const double* data, std::complex<double>* work, double* power) const
+{
+  const std::size_t half{m_Size / 2};
+  // Even samples as real part, odd ones as imaginary part, loaded in bit reversed order
+  for(std::size_t i = 0; i != half; ++i) work[i] = std::complex<double>(data[2 * m_Reverse[i]], data[2 * m_Reverse[i] + 1]);
+  for(std::size_t length = 2; length <= half; length *= 2)
+  {
+    const std::size_t middle{length / 2};
+    const std::size_t step{half / length};
+    for(std::size_t i = 0; i < half; i += length)
+    {
+      for(std::size_t j = 0; j != middle; ++j)
+      {
+        const std::complex<double> u{work[i + j]};
+        const std::complex<double> v{work[i + j + middle] * m_Twiddles[j * step]};
+        work[i + j]          = u + v;
+        work[i + j + middle] = u - v;
+      }
+    }
+  }
+  // Spectrum of the real signal from the one of the packed signal
+  for(std::size_t k = 0; k != half + 1; ++k)
+  {
+    const std::complex<double> z{work[k % half]};
+    const std::complex<double> zc{std::conj(work[(half - k) % half])};
+    const std::complex<double> even{0.5 * (z + zc)};
+    const std::complex<double> odd{std::complex<double>(0, -0.5) * (z - zc)};
+    power[k] = std::norm(even + m_Split[k] * odd);
+  }
+}
+
+NoiseSpectrum::NoiseSpectrum(const std::size_t& channels, const std::size_t& size, const std::size_t& threads, const std::size_t& batch) : m_Channels(channels), m_Plan(size), m_Power(channels * (size / 2 + 1), 0), m_Segments(channels, 0)
+{
+  // Hann window, its power normalises the density
+  for(std::size_t i = 0; i != size; ++i)
+  {
+    m_Window.push_back(0.5 * (1 - std::cos(2 * Pi * i / size)));
+    m_WindowPower += m_Window.back() * m_Window.back();
+  }
+  for(Batch& buffer : m_Batches)
+  {
+    buffer.Samples.resize(std::max<std::size_t>(batch, 1) * size);
+    buffer.Channels.resize(std::max<std::size_t>(batch, 1));
+    buffer.Power.resize(std::max<std::size_t>(batch, 1) * (size / 2 + 1));
+  }
+  // One thread : the batches are transformed by the caller
+  const std::size_t workers{std::max<std::size_t>(threads, 1)};
+  m_Buffers.resize(workers);
+  for(Buffers& buffers : m_Buffers)
+  {
+    buffers.Segment.resize(size);
+    buffers.Work.resize(size / 2);
+  }
+  for(std::size_t thread = 0; thread != workers && workers > 1; ++thread) m_Threads.emplace_back(&NoiseSpectrum::run, this, thread);
+}
+
+NoiseSpectrum::~NoiseSpectrum()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stop = true;
+  }
+  m_Start.notify_all();
+  for(std::thread& thread : m_Threads) thread.join();
+}
+
+bool NoiseSpectrum::add(const std::size_t& channel, const double* data, const std::size_t& length, const std::size_t& begin)
+{
+  const std::size_t size{m_Plan.getSize()};
+  if(channel >= m_Channels || begin + size > length) return false;
+  Batch& batch{m_Batches[m_Filling]};
+  std::copy(data + begin, data + begin + size, &batch.Samples[batch.Size * size]);
+  batch.Channels[batch.Size] = channel;
+  if(++batch.Size == batch.Channels.size()) submit();
+  return true;
+}
+
+void NoiseSpectrum::process(Batch& batch, Buffers& buffers, const std::size_t& thread) const
+{
+  const std::size_t size{m_Plan.getSize()};
+  const std::size_t bins{size / 2 + 1};
+  const std::size_t parts{m_Buffers.size()};
+  for(std::size_t s = thread * batch.Size / parts; s != (thread + 1) * batch.Size / parts; ++s)
+  {
+    const double* samples{&batch.Samples[s * size]};
+    double        mean{0};
+    for(std::size_t i = 0; i != size; ++i) mean += samples[i];
+    mean /= size;
+    for(std::size_t i = 0; i != size; ++i) buffers.Segment[i] = (samples[i] - mean) * m_Window[i];
+    m_Plan.power(buffers.Segment.data(), buffers.Work.data(), &batch.Power[s * bins]);
+  }
+}
+
+void NoiseSpectrum::accumulate(const Batch& batch)
+{
+  const std::size_t bins{getNumberBins()};
+  for(std::size_t s = 0; s != batch.Size; ++s)
+  {
+    const double* segment{&batch.Power[s * bins]};
+    double*       power{&m_Power[batch.Channels[s] * bins]};
+    for(std::size_t k = 0; k != bins; ++k) power[k] += segment[k];
+    ++m_Segments[batch.Channels[s]];
+  }
+}
+
+void NoiseSpectrum::submit()
+{
+  if(m_Threads.empty())
+  {
+    process(m_Batches[m_Filling], m_Buffers[0], 0);
+    accumulate(m_Batches[m_Filling]);
+    m_Batches[m_Filling].Size = 0;
+    return;
+  }
+  // The previous batch must be done before its buffer is filled again
+  wait();
+  if(m_Pending) accumulate(m_Batches[m_Processing]);
+  m_Pending = true;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Processing = m_Filling;
+    m_Running    = m_Threads.size();
+    ++m_Generation;
+  }
+  m_Start.notify_all();
+  m_Filling = 1 - m_Filling;
+  m_Batches[m_Filling].Size = 0;
+}
+
+void NoiseSpectrum::wait()
+{
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  m_Done.wait(lock, [this]() { return m_Running == 0; });
+}
+
+void NoiseSpectrum::run(const std::size_t& thread)
+{
+  std::uint64_t               generation{0};
+  // Opened by the thread itself : the counters are the ones of the calling thread
+  std::unique_ptr<StageClock> clock;
+  while(true)
+  {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Start.wait(lock, [&]() { return m_Stop || m_Generation != generation; });
+    if(m_Stop) return;
+    generation = m_Generation;
+    Batch& batch{m_Batches[m_Processing]};
+    if(m_Profile != nullptr && clock == nullptr) clock = std::make_unique<StageClock>(m_Profile, m_ProfileThread + thread);
+    const std::size_t stage{m_ProfileStage};
+    lock.unlock();
+    if(clock != nullptr) clock->restart();
+    process(batch, m_Buffers[thread], thread);
+    if(clock != nullptr) clock->lap(stage);
+    lock.lock();
+    if(--m_Running == 0) m_Done.notify_all();
+  }
+}
+
+void NoiseSpectrum::setProfile(StageProfile* profile, const std::size_t& stage, const std::size_t& firstThread)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Profile       = profile;
+  m_ProfileStage  = stage;
+  m_ProfileThread = firstThread;
+}
+
+void NoiseSpectrum::finish()
+{
+  if(m_Batches[m_Filling].Size != 0) submit();
+  if(m_Threads.empty()) return;
+  wait();
+  if(m_Pending) accumulate(m_Batches[m_Processing]);
+  m_Pending = false;
+}
+
+double NoiseSpectrum::getDensity(const std::size_t& channel, const std::size_t& bin, const double& period) const
+{
+  const std::size_t bins{getNumberBins()};
+  if(m_Segments[channel] == 0) return 0;
+  // One-sided : the negative frequencies are folded on the positive ones (not the DC and Nyquist bins)
+  const double factor{(bin == 0 || bin == bins - 1) ? 1.0 : 2.0};
+  const double rate{1.0 / (period * 1e-9)};
+  return factor * m_Power[channel * bins + bin] / (m_Segments[channel] * rate * m_WindowPower);
+}
+
+void NoiseSpectrum::save(std::ostream& stream)
+{
+  finish();
+  State::write(stream, m_Power);
+  State::write(stream, m_Segments);
+}
+
+void NoiseSpectrum::restore(std::istream& stream)
+{
+  finish();
+  State::read(stream, m_Power);
+  State::read(stream, m_Segments);
+}
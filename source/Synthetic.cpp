@@ -0,0 +1,79 @@
+#include "Synthetic.hpp"
+
+#include "RawReader.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+Waveforms::Waveforms(const std::size_t& events, const std::size_t& channels, const std::size_t& length, const unsigned int& seed) : m_Events(events), m_Channels(channels), m_Length(length), m_Data(events * channels * length)
+{
+  std::mt19937                     generator(seed);
+  std::normal_distribution<double> noise(0.0, 2.0);
+  std::uniform_real_distribution<> position(0.3 * length, 0.7 * length);
+  std::uniform_real_distribution<> amplitude(5.0, 80.0);
+  for(std::size_t evt = 0; evt != m_Events; ++evt)
+  {
+    for(std::size_t ch = 0; ch != m_Channels; ++ch)
+    {
+      double*      data{get(evt, ch)};
+      const double t0{position(generator)};
+      const double amp{(ch % 3 == 0) ? amplitude(generator) : 0.0};
+      for(std::size_t i = 0; i != m_Length; ++i)
+      {
+        const double t{(i - t0) / 4.0};
+        data[i] = noise(generator) - (t > 0 ? amp * t * std::exp(1.0 - t) : 0.0);
+      }
+    }
+  }
+}
+
+std::vector<std::uint16_t> WriteRawFile(const std::string& filename, const std::size_t& nbrEvents, const std::size_t& samples, const unsigned int& seed, const int& board, const std::vector<double>& timeTags)
+{
+  if(!timeTags.empty() && timeTags.size() != nbrEvents) throw std::runtime_error(fmt::format("{} time tags for {} events !", timeTags.size(), nbrEvents));
+  std::mt19937                     generator(seed);
+  std::normal_distribution<double> noise(0.0, 3.0);
+  std::uniform_real_distribution<> position(0.3 * samples, 0.7 * samples);
+  std::uniform_real_distribution<> amplitude(20.0, 600.0);
+  std::vector<std::uint16_t>       reference(nbrEvents * RawReader::NumberChannels * samples, 0);
+  std::ofstream                    file(filename, std::ios::binary);
+  if(!file) throw std::runtime_error(fmt::format("Can't open {} !", filename));
+  RawEvent                   event;
+  std::vector<std::uint32_t> words;
+  event.Channels.resize(RawReader::NumberChannels);
+  for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+  {
+    const double tag{timeTags.empty() ? 1000.0 * evt : timeTags[evt]};
+    event.BoardID        = board;
+    event.EventNumber    = static_cast<int>(evt);
+    event.Pattern        = static_cast<int>(evt % 7);
+    event.GroupMask      = 0xF;
+    event.TriggerTimeTag = tag;
+    event.Period_ns      = 0.2;
+    const double trigger{0.2 * samples};
+    for(std::size_t ch = 0; ch != RawReader::NumberChannels; ++ch)
+    {
+      RawChannel& channel{event.Channels[ch]};
+      channel.Number         = static_cast<int>(ch);
+      channel.Group          = static_cast<int>(ch < 32 ? ch / 8 : ch - 32);
+      channel.StartIndexCell = static_cast<double>((evt * 37) % 1024);
+      channel.TriggerTimeTag = tag;
+      channel.Data.resize(samples);
+      const bool   isTrigger{ch >= 32};
+      const double t0{isTrigger ? trigger : position(generator)};
+      const double amp{isTrigger ? 1500.0 : (ch % 3 == 0 ? amplitude(generator) : 0.0)};
+      for(std::size_t i = 0; i != samples; ++i)
+      {
+        const double t{(i - t0) / 4.0};
+        channel.Data[i] = std::round(std::clamp(2048 + noise(generator) - (t > 0 ? amp * t * std::exp(1.0 - t) : 0.0), 0.0, 4095.0));
+        reference[(evt * RawReader::NumberChannels + ch) * samples + i] = static_cast<std::uint16_t>(channel.Data[i]);
+      }
+    }
+    RawReader::encode(event, words);
+    file.write(reinterpret_cast<const char*>(words.data()), static_cast<std::streamsize>(words.size() * sizeof(std::uint32_t)));
+  }
+  return reference;
+}
@@ -0,0 +1,104 @@
+#include "TimeSeries.hpp"
+
+#include "State.hpp"
+#include "fmt/format.h"
+
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+TimeSeries::TimeSeries(const std::size_t& chambers, const double& binWidth, const std::size_t& maxBins, const double& tickPeriod, const unsigned int& rolloverBits) :
+    m_Chambers(chambers), m_BinWidth(binWidth), m_MaxBins(maxBins + maxBins % 2), m_TickPeriod(tickPeriod), m_Rollover(std::ldexp(1.0, rolloverBits)), m_Events(m_MaxBins, 0), m_Bins(m_MaxBins * chambers)
+{
+  if(binWidth <= 0 || maxBins < 2) throw std::runtime_error(fmt::format("TimeSeries : invalid binning ({} bins of {} s) !", maxBins, binWidth));
+}
+
+void TimeSeries::merge()
+{
+  for(std::size_t bin = 0; bin != m_MaxBins / 2; ++bin)
+  {
+    m_Events[bin] = m_Events[2 * bin] + m_Events[2 * bin + 1];
+    for(std::size_t chamber = 0; chamber != m_Chambers; ++chamber)
+    {
+      const Bin& a{m_Bins[2 * bin * m_Chambers + chamber]};
+      const Bin& b{m_Bins[(2 * bin + 1) * m_Chambers + chamber]};
+      m_Bins[bin * m_Chambers + chamber] = Bin{a.Efficient + b.Efficient, a.Hits + b.Hits, a.Noisy + b.Noisy};
+    }
+  }
+  for(std::size_t bin = m_MaxBins / 2; bin != m_MaxBins; ++bin)
+  {
+    m_Events[bin] = 0;
+    for(std::size_t chamber = 0; chamber != m_Chambers; ++chamber) m_Bins[bin * m_Chambers + chamber] = Bin();
+  }
+  m_NbrBins = (m_NbrBins + 1) / 2;
+  m_BinWidth *= 2;
+}
+
+void TimeSeries::fill(const double& triggerTimeTag, const std::vector<int>& hits, const std::vector<bool>& noisy)
+{
+  if(m_First)
+  {
+    m_First    = false;
+    m_FirstTag = triggerTimeTag;
+  }
+  else if(triggerTimeTag < m_LastTag)
+    m_Offset += m_Rollover;
+  m_LastTag = triggerTimeTag;
+  m_Time    = (triggerTimeTag + m_Offset - m_FirstTag) * m_TickPeriod;
+  std::size_t bin{static_cast<std::size_t>(m_Time / m_BinWidth)};
+  while(bin >= m_MaxBins)
+  {
+    merge();
+    bin = static_cast<std::size_t>(m_Time / m_BinWidth);
+  }
+  if(bin >= m_NbrBins) m_NbrBins = bin + 1;
+  ++m_Events[bin];
+  Bin* bins{&m_Bins[bin * m_Chambers]};
+  for(std::size_t chamber = 0; chamber != m_Chambers; ++chamber)
+  {
+    if(hits[chamber] > 0)
+    {
+      ++bins[chamber].Efficient;
+      bins[chamber].Hits += hits[chamber];
+    }
+    if(noisy[chamber]) ++bins[chamber].Noisy;
+  }
+}
+
+void TimeSeries::write(const std::string& filename) const
+{
+  std::ofstream out(filename);
+  if(!out) throw std::runtime_error(fmt::format("Can't open {} !", filename));
+  out << "Chamber,Time Begin (s),Time End (s),Events,Efficiency,Error Efficiency,Multiplicity,Noisy Fraction\n";
+  for(std::size_t chamber = 0; chamber != m_Chambers; ++chamber)
+  {
+    for(std::size_t bin = 0; bin != m_NbrBins; ++bin)
+    {
+      const Bin&          data{m_Bins[bin * m_Chambers + chamber]};
+      const std::uint64_t events{m_Events[bin]};
+      const double        efficiency{events == 0 ? 0 : data.Efficient * 1.0 / events};
+      const double        error{events == 0 ? 0 : std::sqrt(efficiency * (1 - efficiency) / events)};
+      const double        multiplicity{data.Efficient == 0 ? 0 : data.Hits * 1.0 / data.Efficient};
+      const double        noisy{events == 0 ? 0 : data.Noisy * 1.0 / events};
+      out << fmt::format("{},{},{},{},{},{},{},{}\n", chamber, bin * m_BinWidth, (bin + 1) * m_BinWidth, events, efficiency, error, multiplicity, noisy);
+    }
+  }
+}
+
+void TimeSeries::save(std::ostream& stream) const
+{
+  State::write(stream, m_BinWidth, m_NbrBins, m_First, m_FirstTag, m_LastTag, m_Offset, m_Time);
+  State::write(stream, m_Events);
+  std::vector<std::uint64_t> bins;
+  for(const Bin& bin : m_Bins) bins.insert(bins.end(), {bin.Efficient, bin.Hits, bin.Noisy});
+  State::write(stream, bins);
+}
+
+void TimeSeries::restore(std::istream& stream)
+{
+  State::read(stream, m_BinWidth, m_NbrBins, m_First, m_FirstTag, m_LastTag, m_Offset, m_Time);
+  State::read(stream, m_Events);
+  std::vector<std::uint64_t> bins(3 * m_Bins.size());
+  State::read(stream, bins);
+  for(std::size_t i = 0; i != m_Bins.size(); ++i) m_Bins[i] = Bin{bins[3 * i], bins[3 * i + 1], bins[3 * i + 2]};
+}
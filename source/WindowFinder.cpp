@@ -0,0 +1,112 @@
+#include "WindowFinder.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+WindowFinder::WindowFinder(const std::vector<int>& triggers, const double& width, const double& delay, const std::size_t& length) : m_Width(width)
+{
+  for(std::size_t i = 0; i != triggers.size(); ++i)
+  {
+    Group group;
+    group.Trigger = triggers[i];
+    group.Delay   = delay;
+    m_Groups.push_back(group);
+  }
+  setLength(length);
+}
+
+void WindowFinder::setLength(const std::size_t& length)
+{
+  if(length == m_Length && !m_Groups.empty() && m_Groups[0].Delays.getNbins() == 2 * length) return;
+  m_Length = length;
+  // One bin by tick, the signal can be before or after the trigger
+  for(std::size_t i = 0; i != m_Groups.size(); ++i) m_Groups[i].Delays = Histogram(2 * length, -static_cast<double>(length), static_cast<double>(length), fmt::format("Delay_trigger{}", m_Groups[i].Trigger), "Trigger tick - signal tick;Delay (ticks);Channels");
+}
+
+std::size_t WindowFinder::index(const int& trigger) const
+{
+  for(std::size_t i = 0; i != m_Groups.size(); ++i)
+    if(m_Groups[i].Trigger == trigger) return i;
+  throw std::runtime_error(fmt::format("Channel {} is not a trigger !", trigger));
+}
+
+void WindowFinder::fill(const int& trigger, const int& triggerTick, const int& signalTick)
+{
+  m_Groups[index(trigger)].Delays.fill(triggerTick - signalTick);
+}
+
+std::size_t WindowFinder::learn(const double& significance)
+{
+  std::size_t       learnt{0};
+  const std::size_t width{std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(m_Width)))};
+  for(std::size_t i = 0; i != m_Groups.size(); ++i)
+  {
+    Group&            group = m_Groups[i];
+    const Histogram&  delays{group.Delays};
+    const std::size_t bins{delays.getNbins()};
+    if(bins < width || delays.getEntries() == 0) continue;
+    // Interval of width bins with the most entries (running sum)
+    double sum{0};
+    for(std::size_t bin = 0; bin != width; ++bin) sum += delays.getBinContent(bin);
+    double      best{sum};
+    std::size_t first{0};
+    for(std::size_t bin = width; bin != bins; ++bin)
+    {
+      sum += static_cast<double>(delays.getBinContent(bin)) - static_cast<double>(delays.getBinContent(bin - width));
+      if(sum > best)
+      {
+        best  = sum;
+        first = bin - width + 1;
+      }
+    }
+    // Flat background : mean of the filled bins outside of the interval (the extrema of noise-only channels are
+    // spread over the record, so over the part of the histogram reachable for this trigger)
+    double      outside{0};
+    std::size_t filled{0};
+    for(std::size_t bin = 0; bin != bins; ++bin)
+    {
+      if((bin >= first && bin < first + width) || delays.getBinContent(bin) == 0) continue;
+      outside += delays.getBinContent(bin);
+      ++filled;
+    }
+    const double level{filled == 0 ? 0 : outside / filled};
+    const double background{level * width};
+    if(best - background < significance * std::sqrt(std::max(background, 1.0))) continue;
+    // Centroid of the background subtracted interval
+    double weighted{0};
+    double total{0};
+    for(std::size_t bin = first; bin != first + width; ++bin)
+    {
+      const double content{std::max(0.0, delays.getBinContent(bin) - level)};
+      // Integer delays : the low edge of the bin is the delay
+      weighted += content * delays.getBinLowEdge(bin);
+      total += content;
+    }
+    group.Delay  = weighted / total;
+    group.Learnt = true;
+    ++learnt;
+  }
+  return learnt;
+}
+
+bool WindowFinder::setTrigger(const int& trigger, const int& tick)
+{
+  Group& group = m_Groups[index(trigger)];
+  group.Tick   = tick;
+  const double begin{tick - group.Delay - m_Width / 2};
+  const double end{tick - group.Delay + m_Width / 2};
+  group.Valid = tick > 0 && end >= 0 && begin < static_cast<double>(m_Length);
+  if(!group.Valid) ++group.Invalid;
+  return group.Valid;
+}
+
+std::pair<int, int> WindowFinder::getWindow(const int& trigger) const
+{
+  const Group& group = m_Groups[index(trigger)];
+  const int    begin{static_cast<int>(group.Tick - group.Delay - m_Width / 2)};
+  const int    end{static_cast<int>(group.Tick - group.Delay + m_Width / 2)};
+  return {std::max(begin, 0), std::min(end, static_cast<int>(m_Length))};
+}
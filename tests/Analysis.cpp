@@ -0,0 +1,87 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Results.hpp"
+#include "Synthetic.hpp"
+#include "fmt/format.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+namespace fs = std::filesystem;
+
+// Synthetic raw run analysed by the Analysis executable in a folder of its own (the plots go in Results/ of the
+// working directory) : 8 strips of one chamber read on the group 0, its trigger on TR0
+class Fixture
+{
+public:
+  Fixture() : m_Folder(fs::temp_directory_path() / "TestAnalysis")
+  {
+    fs::remove_all(m_Folder);
+    fs::create_directories(m_Folder);
+    fs::current_path(m_Folder);
+    WriteRawFile((m_Folder / "7000V.dat").string(), 60, 1024);
+  }
+  ~Fixture()
+  {
+    fs::current_path(fs::temp_directory_path());
+    fs::remove_all(m_Folder);
+  }
+  // Status of the analysis run with the options given, the results of the chamber are in <name>_Chamber0.res
+  int analyse(const std::string& name, const std::string& options) const
+  {
+    const std::string command{fmt::format("\"{}\" --path \"{}/\" --saveAs \"{}\" -f 7000V.dat -s 500 -300 -n 0 150 --noiseAfter 900 1020 -c 1 -d 0 0 0 0 0 0 0 0 -p -1 -1 -1 -1 -1 -1 -1 -1 --triggers 32 33 34 35 --plotEvents 0 {}", ANALYSIS_EXECUTABLE, m_Folder.string(), (m_Folder / name).string(), options)};
+    return std::system(command.c_str());
+  }
+  std::vector<double> getRecords(const std::string& name) const
+  {
+    const ResultsReader reader((m_Folder / (name + "_Chamber0.res")).string());
+    std::vector<double> records;
+    for(std::size_t record = 0; record != reader.getNumberRecords(); ++record)
+      for(std::size_t column = 0; column != reader.getColumns().size(); ++column) records.push_back(reader.get(record, column));
+    return records;
+  }
+  std::size_t getNumberColumns(const std::string& name) const { return ResultsReader((m_Folder / (name + "_Chamber0.res")).string()).getColumns().size(); }
+  // Compared as bits : NaN (no efficient event) must give NaN again
+  static bool same(const std::vector<double>& a, const std::vector<double>& b) { return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0; }
+
+private:
+  fs::path m_Folder;
+};
+}  // namespace
+
+TEST_CASE("Filter off and identity filters leave the results unchanged")
+{
+  const Fixture fixture;
+  REQUIRE(fixture.analyse("Default", "") == 0);
+  REQUIRE(fixture.analyse("None", "--filter none") == 0);
+  REQUIRE(fixture.analyse("Identity", "--filter fir --filterCoefficients 1") == 0);
+  const std::vector<double> reference{fixture.getRecords("Default")};
+  // One record (one run), the fixture has hits : the comparison is not made on an empty run
+  REQUIRE(reference.size() == fixture.getNumberColumns("Default"));
+  CHECK(reference[1] > 0);
+  CHECK(Fixture::same(fixture.getRecords("None"), reference));
+  CHECK(Fixture::same(fixture.getRecords("Identity"), reference));
+  // A real filter goes through the same path and changes the features
+  REQUIRE(fixture.analyse("Average", "--filter average --filterWidth 9") == 0);
+  CHECK(fixture.getRecords("Average").size() == reference.size());
+}
+
+TEST_CASE("A resumed job doesn't make the runs complete again")
+{
+  const Fixture fixture;
+  REQUIRE(fixture.analyse("Resumed", "--checkpoint 20") == 0);
+  const std::vector<double> reference{fixture.getRecords("Resumed")};
+  REQUIRE(reference.size() == fixture.getNumberColumns("Resumed"));
+  // The run is skipped, its record kept once
+  REQUIRE(fixture.analyse("Resumed", "--checkpoint 20 --resume") == 0);
+  CHECK(Fixture::same(fixture.getRecords("Resumed"), reference));
+  // Checkpoint made with other options : the job stops before writing anything
+  fixture.analyse("Resumed", "--checkpoint 20 --resume --filter average --filterWidth 9");
+  CHECK(Fixture::same(fixture.getRecords("Resumed"), reference));
+}
@@ -0,0 +1,215 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "AnalysisEngine.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t NbrEvents{400};
+constexpr std::size_t Length{1024};
+constexpr std::size_t Strips{16};
+constexpr std::size_t Channels{Strips + 1};
+
+// 2 chambers of 8 strips and one trigger, the strips fire a pulse at a fixed delay before the trigger (a chamber
+// fires in 70% of the events, the next strip too in 30% of the cases). expected : events fired by chamber
+std::vector<double> Generate(std::vector<std::uint64_t>& expected)
+{
+  std::mt19937                     generator(23);
+  std::normal_distribution<double> noise(0.0, 2.0);
+  std::uniform_real_distribution<> uniform(0.0, 1.0);
+  std::vector<double>              data(NbrEvents * Channels * Length);
+  expected.assign(2, 0);
+  for(std::size_t evt = 0; evt != NbrEvents; ++evt)
+  {
+    double*           event{&data[evt * Channels * Length]};
+    const std::size_t trigger{static_cast<std::size_t>((0.55 + 0.1 * uniform(generator)) * Length)};
+    for(std::size_t i = 0; i != Channels * Length; ++i) event[i] = noise(generator);
+    for(std::size_t i = trigger; i != Length; ++i) event[Strips * Length + i] -= 100;
+    for(std::size_t chamber = 0; chamber != 2; ++chamber)
+    {
+      if(uniform(generator) >= 0.7) continue;
+      ++expected[chamber];
+      const std::size_t strip{chamber * 8 + static_cast<std::size_t>(uniform(generator) * 7)};
+      const double      amplitude{30 + 50 * uniform(generator)};
+      const double      t0{trigger - 0.2 * Length - 4};
+      const std::size_t last{strip + (uniform(generator) < 0.3 ? 2 : 1)};
+      for(std::size_t fired = strip; fired != last; ++fired)
+        for(std::size_t i = 0; i != Length; ++i)
+        {
+          const double t{(i - t0) / 4.0};
+          event[fired * Length + i] -= t > 0 ? amplitude * t * std::exp(1.0 - t) : 0.0;
+        }
+    }
+  }
+  return data;
+}
+
+AnalysisConfiguration Configuration()
+{
+  AnalysisConfiguration configuration;
+  for(std::size_t ch = 0; ch != Strips; ++ch) configuration.Strips.push_back({static_cast<int>(ch), static_cast<int>(ch / 8), static_cast<int>(ch), -1});
+  configuration.Triggers         = {static_cast<int>(Strips)};
+  configuration.SignalWindow     = {0.06 * Length, 0.2 * Length};
+  configuration.NoiseWindow      = {0.02 * Length, 0.15 * Length};
+  configuration.NoiseWindowAfter = {0.8 * Length, 0.98 * Length};
+  configuration.ADCCodes         = false;
+  return configuration;
+}
+
+// The classifier batches differ with the way the events are given, its counts too
+void CopyClasses(RunSummary& summary, const RunSummary& reference)
+{
+  summary.Classified = reference.Classified;
+  for(std::size_t chamber = 0; chamber != summary.Chambers.size(); ++chamber) summary.Chambers[chamber].Classes = reference.Chambers[chamber].Classes;
+}
+}  // namespace
+
+// The efficiency counted must be the one simulated, the same summary must come from the spans given event by event,
+// from Event like objects and from 4 threads (one engine each) whose summaries are merged
+TEST_CASE("Engine counts the simulated efficiency whatever the way the events are given")
+{
+  std::vector<std::uint64_t>  expected;
+  const std::vector<double>   data{Generate(expected)};
+  const AnalysisConfiguration configuration{Configuration()};
+  RunSummary                  reference;
+  {
+    AnalysisEngine engine(configuration);
+    engine.process(data.data(), NbrEvents, Channels, Length, 1.0);
+    reference = engine.getSummary();
+  }
+  REQUIRE(reference.Chambers.size() == 2);
+  for(std::size_t chamber = 0; chamber != 2; ++chamber) CHECK(reference.Chambers[chamber].Efficient == expected[chamber]);
+  CHECK(reference.Events == static_cast<std::int64_t>(NbrEvents));
+  CHECK(reference.Invalid == 0);
+  // Event by event, the summary taken every 7 events
+  {
+    AnalysisEngine engine(configuration);
+    RunSummary     merged{engine.getSummary()};
+    for(std::size_t evt = 0; evt != NbrEvents; ++evt)
+    {
+      engine.process(&data[evt * Channels * Length], 1, Channels, Length, 1.0);
+      if(evt % 7 == 6) merged.add(engine.takeSummary());
+    }
+    merged.add(engine.takeSummary());
+    CopyClasses(merged, reference);
+    CHECK(merged.serialize() == reference.serialize());
+  }
+  // Event like objects
+  {
+    struct Trace
+    {
+      std::vector<double> Data;
+    };
+    struct Record
+    {
+      std::vector<Trace> Channels;
+      double             Period_ns{1.0};
+    };
+    std::vector<Record> records(NbrEvents);
+    for(std::size_t evt = 0; evt != NbrEvents; ++evt)
+    {
+      records[evt].Channels.resize(Channels);
+      for(std::size_t ch = 0; ch != Channels; ++ch) records[evt].Channels[ch].Data.assign(data.begin() + (evt * Channels + ch) * Length, data.begin() + (evt * Channels + ch + 1) * Length);
+    }
+    AnalysisEngine engine(configuration);
+    engine.process(records);
+    CHECK(engine.getSummary().serialize() == reference.serialize());
+  }
+  // One engine by thread
+  {
+    const std::size_t        threads{4};
+    RunSummary               merged;
+    std::mutex               mutex;
+    std::vector<std::thread> workers;
+    for(std::size_t t = 0; t != threads; ++t)
+      workers.emplace_back([&, t]() {
+        const std::size_t first{t * NbrEvents / threads};
+        const std::size_t last{(t + 1) * NbrEvents / threads};
+        AnalysisEngine    engine(configuration);
+        engine.process(&data[first * Channels * Length], last - first, Channels, Length, 1.0);
+        const RunSummary            summary{engine.getSummary()};
+        std::lock_guard<std::mutex> lock(mutex);
+        if(merged.Chambers.empty()) merged = summary;
+        else
+          merged.add(summary);
+      });
+    for(std::thread& worker : workers) worker.join();
+    CopyClasses(merged, reference);
+    CHECK(merged.serialize() == reference.serialize());
+  }
+}
+
+TEST_CASE("Events without a valid trigger are counted apart")
+{
+  std::vector<std::uint64_t> expected;
+  std::vector<double>        data{Generate(expected)};
+  // No trigger pulse in the first event
+  for(std::size_t i = 0; i != Length; ++i) data[Strips * Length + i] = 0;
+  AnalysisEngine engine(Configuration());
+  engine.process(data.data(), 1, Channels, Length, 1.0);
+  CHECK_FALSE(engine.isLastValid());
+  engine.process(&data[Channels * Length], 1, Channels, Length, 1.0);
+  CHECK(engine.isLastValid());
+  const RunSummary summary{engine.getSummary()};
+  CHECK(summary.Invalid == 1);
+  CHECK(summary.Events == 2);
+}
+
+// Bookkeeping shared with Analysis : the event after a noisy one is out of the corrected efficiency, unless noisy
+// itself, an invalid event ends the skip, and a counter restored from a summary goes on as the uninterrupted one
+TEST_CASE("Corrected efficiency skips the event after a noisy one")
+{
+  // Hit in chamber 0 in all the valid events, noisy : events 1, 2 and 4, trigger invalid : event 5 (after the noisy 4)
+  const std::vector<bool> noisy{false, true, true, false, true, false, false};
+  auto                    Run = [&noisy](EfficiencyCounter& counter, const std::size_t& first, const std::size_t& last)
+  {
+    for(std::size_t evt = first; evt != last; ++evt)
+    {
+      counter.beginEvent();
+      if(evt == 5)
+      {
+        counter.skipEvent();
+        continue;
+      }
+      counter.addHit(0);
+      if(noisy[evt]) counter.setNoisy(1);
+      counter.endEvent();
+    }
+  };
+  EfficiencyCounter counter(2);
+  Run(counter, 0, noisy.size());
+  RunSummary summary(2);
+  counter.fill(summary);
+  // Events 3 (after the noisy 2) out, 2 is noisy after a noisy one and counted
+  CHECK(summary.Invalid == 1);
+  CHECK(summary.Corrected == 5);
+  CHECK(summary.Chambers[0].Efficient == 6);
+  CHECK(summary.Chambers[0].EfficientCorrected == 5);
+  CHECK(summary.Chambers[0].Hits == 6);
+  CHECK(summary.Chambers[1].Efficient == 0);
+
+  EfficiencyCounter interrupted(2);
+  Run(interrupted, 0, 3);
+  RunSummary checkpoint(2);
+  interrupted.fill(checkpoint);
+  EfficiencyCounter resumed(2);
+  resumed.restore(checkpoint, interrupted.isNoisyLast());
+  Run(resumed, 3, noisy.size());
+  RunSummary end(2);
+  resumed.fill(end);
+  CHECK(end.serialize() == summary.serialize());
+}
+
+TEST_CASE("Trigger tick is the first sample below a fraction of the minimum")
+{
+  const std::vector<double> trigger{0, -1, -10, -30, -100, -100, -40};
+  CHECK(TriggerTick(trigger.data(), trigger.size()) == 3);
+  CHECK(TriggerTick(trigger.data(), 0) == 0);
+}
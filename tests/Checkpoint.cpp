@@ -0,0 +1,66 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Checkpoint.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+
+TEST_CASE("Checkpoint read back is the one written")
+{
+  std::mt19937 generator(11);
+  Checkpoint   checkpoint;
+  checkpoint.Done           = 123456;
+  checkpoint.Events         = 1000000;
+  checkpoint.NoisyLast      = true;
+  checkpoint.Options        = Checkpoint::hash("--threshold\n5");
+  checkpoint.State          = "7 1 2 3\n\n0.5 -1e-300\n";
+  checkpoint.Summary        = RunSummary(4);
+  checkpoint.Summary.Events = checkpoint.Done;
+  for(RunSummary::Chamber& chamber : checkpoint.Summary.Chambers)
+  {
+    chamber.ClusterSize   = Histogram(32, 0, 32);
+    chamber.ClusterNumber = Histogram(16, 0, 16);
+    chamber.Charge        = Histogram(1000, 0, 100);
+    std::exponential_distribution<double> charge(0.2);
+    for(std::size_t i = 0; i != 100000; ++i)
+    {
+      const double value{charge(generator)};
+      chamber.Charge.fill(value);
+      chamber.ChargeSum += std::llround(value / PulseAnalyser::ChargeQuantum);
+      ++chamber.ChargeEntries;
+    }
+    chamber.Efficient = 98765;
+    chamber.Hits      = 123457;
+  }
+  const std::string filename{(std::filesystem::temp_directory_path() / "TestCheckpoint.txt").string()};
+  checkpoint.write(filename);
+  // Written again over the previous one
+  checkpoint.write(filename);
+  Checkpoint read;
+  REQUIRE(Checkpoint::read(filename, read));
+  CHECK(read.Done == checkpoint.Done);
+  CHECK(read.Events == checkpoint.Events);
+  CHECK(read.NoisyLast);
+  CHECK(read.Options == checkpoint.Options);
+  CHECK(read.State == checkpoint.State);
+  CHECK_FALSE(read.isFinished());
+  CHECK(read.Summary.serialize() == checkpoint.Summary.serialize());
+  CHECK_FALSE(std::filesystem::exists(filename + ".tmp"));
+  std::filesystem::remove(filename);
+  CHECK_FALSE(Checkpoint::read(filename, read));
+}
+
+TEST_CASE("Options hash is the same on every host")
+{
+  // FNV-1a reference values
+  CHECK(Checkpoint::hash("") == 14695981039346656037ULL);
+  CHECK(Checkpoint::hash("a") == 0xaf63dc4c8601ec8cULL);
+  CHECK(Checkpoint::hash("--threshold\n5") != Checkpoint::hash("--threshold\n6"));
+  Checkpoint finished;
+  finished.Done   = 1000;
+  finished.Events = 1000;
+  CHECK(finished.isFinished());
+}
@@ -0,0 +1,89 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Classifier.hpp"
+#include "Kernels.hpp"
+#include "Synthetic.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Features from the synthetic waveforms (minimum in the signal window, sigma ratio) scored by the cut classifier
+// and by a linear model built to give the same decisions
+TEST_CASE("Linear model reproduces the cuts")
+{
+  const Waveforms           waveforms(500, 32, 1024);
+  const std::size_t         length{waveforms.getLength()};
+  const std::size_t         chambers{(waveforms.getChannels() + 7) / 8};
+  const Kernels::Dispatcher kernels{Kernels::Dispatcher::select(length)};
+  const int                 begin{static_cast<int>(0.3 * length)};
+  const int                 end{static_cast<int>(0.8 * length)};
+  std::vector<std::pair<double, double>> features(waveforms.getEvents() * waveforms.getChannels());
+  for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+  {
+    for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+    {
+      const double*                   data{waveforms.get(evt, ch)};
+      const std::pair<double, double> noise{kernels.meanSigma(data, length, 0, 0.2 * length)};
+      const std::pair<double, double> after{kernels.meanSigma(data, length, 0.9 * length, length - 1)};
+      features[evt * waveforms.getChannels() + ch] = {noise.first - kernels.extremum(-1, data, length, begin, end).first, after.second / noise.second};
+    }
+  }
+  const std::string model{"Classifier_test.txt"};
+  {
+    // Amplitude is used in place of the charge : a streamer is a hit above 40 mV
+    std::ofstream file(model);
+    file << "# class w_hits w_amplitude w_charge w_ratio w_spread bias\n";
+    file << "empty 0 0 0 0 0 0\n";
+    file << "avalanche 1000 0 0 0 0 -500\n";
+    file << "streamer 1000 0 50 0 0 -2500\n";
+    file << "noise 0 0 0 1e6 0 -5e6\n";
+  }
+  std::vector<std::uint64_t> counts[2];
+  for(std::size_t m = 0; m != 2; ++m)
+  {
+    Classifier classifier(chambers, 5.0, 40.0);
+    if(m == 1) classifier.load(model);
+    CHECK(classifier.isLinear() == (m == 1));
+    for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+    {
+      for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+      {
+        const std::pair<double, double>& feature{features[evt * waveforms.getChannels() + ch]};
+        classifier.addChannel(ch / 8, feature.first, feature.second);
+        if(feature.first > 10.0) classifier.addHit(ch / 8, feature.first, 0);
+      }
+      classifier.endEvent();
+    }
+    classifier.flush();
+    // Each chamber event is classified once
+    std::uint64_t sum{0};
+    for(std::size_t chamber = 0; chamber != chambers; ++chamber)
+    {
+      for(std::size_t c = 0; c != Classifier::NbrClasses; ++c)
+      {
+        counts[m].push_back(classifier.getCount(chamber, static_cast<EventClass>(c)));
+        sum += counts[m].back();
+      }
+    }
+    CHECK(sum == chambers * waveforms.getEvents());
+  }
+  std::remove(model.c_str());
+  CHECK(counts[0] == counts[1]);
+}
+
+TEST_CASE("Malformed models are rejected")
+{
+  const std::string model{"Classifier_bad.txt"};
+  {
+    std::ofstream file(model);
+    file << "avalanche 1 2 3\n";
+  }
+  Classifier classifier(1);
+  CHECK_THROWS_AS(classifier.load(model), std::runtime_error);
+  std::remove(model.c_str());
+}
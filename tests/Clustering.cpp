@@ -0,0 +1,83 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Clustering.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+// Chamber 0 : strips 1 to 8, chamber 1 : strips 10 to 13, window of 10 ticks
+TEST_CASE("Adjacent strips within the window make one cluster timed by its earliest hit")
+{
+  ClusterBuilder clusters({{1, 2, 3, 4, 5, 6, 7, 8}, {10, 11, 12, 13}}, 10);
+  // Given out of order, strip 6 missing
+  clusters.addHit(0, 5, 98);
+  clusters.addHit(0, 3, 100);
+  clusters.addHit(0, 7, 100);
+  clusters.addHit(0, 4, 105);
+  clusters.addHit(1, 11, 300);
+  clusters.endEvent();
+  REQUIRE(clusters.getNumberClusters(0) == 2);
+  CHECK(clusters.getCluster(0, 0).Chamber == 0);
+  CHECK(clusters.getCluster(0, 0).FirstStrip == 3);
+  CHECK(clusters.getCluster(0, 0).Size == 3);
+  CHECK(clusters.getCluster(0, 0).Time == 98);
+  CHECK(clusters.getCluster(0, 1).FirstStrip == 7);
+  CHECK(clusters.getCluster(0, 1).Size == 1);
+  REQUIRE(clusters.getNumberClusters(1) == 1);
+  CHECK(clusters.getCluster(1, 0).Chamber == 1);
+  CHECK(clusters.getCluster(1, 0).Time == 300);
+  CHECK(clusters.getClusterSize(0).getEntries() == 2);
+  CHECK(clusters.getClusterNumber(0).getMean() == 2);
+  CHECK(clusters.getStripHits(0).getEntries() == 4);
+  // Nothing left for the next event
+  clusters.endEvent();
+  CHECK(clusters.getNumberClusters(0) == 0);
+  CHECK(clusters.getEvents() == 2);
+}
+
+TEST_CASE("Adjacent strips outside the time window are separate clusters")
+{
+  ClusterBuilder clusters({{1, 2, 3, 4}}, 10);
+  // Compared with the earliest hit of the cluster : strip 2 (10 ticks after it) is merged, strip 3 (21 ticks) is not
+  clusters.addHit(0, 1, 100);
+  clusters.addHit(0, 2, 110);
+  clusters.addHit(0, 3, 121);
+  clusters.addHit(0, 4, 125);
+  clusters.endEvent();
+  REQUIRE(clusters.getNumberClusters(0) == 2);
+  CHECK(clusters.getCluster(0, 0).Size == 2);
+  CHECK(clusters.getCluster(0, 0).Time == 100);
+  CHECK(clusters.getCluster(0, 1).FirstStrip == 3);
+  CHECK(clusters.getCluster(0, 1).Size == 2);
+  CHECK(clusters.getCluster(0, 1).Time == 121);
+}
+
+TEST_CASE("Hits beyond the capacity of a chamber are lost and counted")
+{
+  ClusterBuilder clusters({{1, 2, 3}}, 10);
+  for(int hit = 0; hit != 5; ++hit) clusters.addHit(0, 1 + hit % 3, 100);
+  CHECK(clusters.getLostHits() == 2);
+  clusters.endEvent();
+  // The buffer is empty again
+  for(int strip = 1; strip != 4; ++strip) clusters.addHit(0, strip, 100);
+  clusters.endEvent();
+  CHECK(clusters.getLostHits() == 2);
+  REQUIRE(clusters.getNumberClusters(0) == 1);
+  CHECK(clusters.getCluster(0, 0).Size == 3);
+}
+
+TEST_CASE("Cluster times are histogrammed in ticks over the record")
+{
+  ClusterBuilder clusters({{1, 2}}, 10);
+  clusters.setRecordLength(4096);
+  const Histogram& time{clusters.getClusterTime(0)};
+  CHECK(time.getMin() == 0);
+  CHECK(time.getMax() == 4096);
+  CHECK(time.getTitle() == "Cluster time;Time (ticks);Clusters");
+  clusters.addHit(0, 1, 3000);
+  clusters.endEvent();
+  CHECK(clusters.getClusterTime(0).getEntries() == 1);
+  CHECK(clusters.getClusterTime(0).getOverflow() == 0);
+  CHECK_THROWS_AS(clusters.setRecordLength(1024), std::runtime_error);
+}
@@ -0,0 +1,93 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Clustering.hpp"
+#include "Counters.hpp"
+#include "Kernels.hpp"
+#include "Spectrum.hpp"
+#include "Synthetic.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+// Stages of the per event chain (copy, baseline, features, clustering) and the FFT threads of the noise spectrum
+// measured with the hardware counters (time only without them) : each stage is measured once by event, the laps
+// cover the loop and, when the counters are there, each stage has counted cycles and instructions
+TEST_CASE("Laps measure every stage of the loop")
+{
+  const Waveforms   waveforms(200, 32, 1024);
+  const std::size_t channels{waveforms.getChannels()};
+  const std::size_t length{waveforms.getLength()};
+  const PerfCounters counters;
+  if(!counters.isAvailable()) MESSAGE("perf_event_open not available : " << counters.getError());
+  enum Stage : std::size_t
+  {
+    Copy,
+    Baseline,
+    Features,
+    Clustering,
+    Spectrum,
+    Threads
+  };
+  StageProfile                           profile({"copy", "baseline", "features", "clustering", "spectrum (caller)", "spectrum FFT"});
+  const Kernels::Dispatcher              kernels{Kernels::Dispatcher::select(length)};
+  std::vector<std::vector<int>>          strips(channels / 8);
+  for(std::size_t ch = 0; ch != channels; ++ch) strips[ch / 8].push_back(static_cast<int>(ch));
+  ClusterBuilder                         clusters(strips, 10, length);
+  NoiseSpectrum                          spectrum(channels, 256, 2);
+  std::vector<double>                    buffer(channels * length);
+  std::vector<std::pair<double, double>> noise(channels);
+  std::vector<std::pair<double, int>>    minimum(channels);
+  spectrum.setProfile(&profile, Threads, 1);
+  StageClock clock(&profile);
+  const auto start = std::chrono::steady_clock::now();
+  clock.restart();
+  for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+  {
+    std::copy(waveforms.get(evt, 0), waveforms.get(evt, 0) + channels * length, buffer.begin());
+    clock.lap(Copy);
+    for(std::size_t ch = 0; ch != channels; ++ch) kernels.baseline(&buffer[ch * length], length);
+    clock.lap(Baseline);
+    for(std::size_t ch = 0; ch != channels; ++ch)
+    {
+      noise[ch]   = kernels.meanSigma(&buffer[ch * length], length, 0, 0.2 * length);
+      minimum[ch] = kernels.extremum(-1, &buffer[ch * length], length, static_cast<int>(0.2 * length), static_cast<int>(length));
+    }
+    clock.lap(Features);
+    for(std::size_t ch = 0; ch != channels; ++ch)
+      if(noise[ch].first - minimum[ch].first >= 5 * noise[ch].second) clusters.addHit(static_cast<int>(ch / 8), static_cast<int>(ch), minimum[ch].second);
+    clusters.endEvent();
+    clock.lap(Clustering);
+    for(std::size_t ch = 0; ch != channels; ++ch) spectrum.add(ch, &buffer[ch * length], length, 0);
+    clock.lap(Spectrum);
+  }
+  spectrum.finish();
+  clock.lap(Spectrum);
+  const double seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+  double       measured{0};
+  for(std::size_t stage = Copy; stage != Threads; ++stage)
+  {
+    const StageProfile::Sums sums{profile.getSums(stage)};
+    measured += sums.Seconds;
+    CHECK(sums.Calls >= waveforms.getEvents());
+    if(counters.isAvailable(PerfCounters::Cycles) && counters.isAvailable(PerfCounters::Instructions))
+    {
+      CHECK(sums.Counts[PerfCounters::Cycles] != 0);
+      CHECK(sums.Counts[PerfCounters::Instructions] != 0);
+    }
+  }
+  CHECK(measured <= seconds);
+  CHECK(measured > 0.5 * seconds);
+  CHECK(profile.getSums(Threads).Calls != 0);
+  CHECK_FALSE(profile.report(waveforms.getEvents(), waveforms.getSamples()).empty());
+}
+
+TEST_CASE("Without profile nothing is measured")
+{
+  StageClock clock;
+  CHECK_FALSE(clock.isEnabled());
+  clock.restart();
+  clock.lap(0);
+}
@@ -0,0 +1,92 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Crosstalk.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// 64 strips with independent noise (RMS 2) plus a common mode (RMS 3) seen with a gain in [0.5,1.5] by each strip,
+// a hit on a strip gives a hit on the next one in 30% of the cases. The covariance must be the one of a direct
+// sum over the samples, the conditional probability close to 0.3 / 1.3 (the hits on a strip include the ones
+// induced by its neighbour) and the common mode subtraction must remove most of the correlation between strips.
+TEST_CASE("Covariance, coincidences and common mode subtraction")
+{
+  const std::size_t                nbrEvents{2000};
+  const std::size_t                channels{64};
+  const std::size_t                samples{200};
+  std::mt19937                     generator(17);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_real_distribution<> uniform(0.0, 1.0);
+  std::vector<double>              gains(channels);
+  for(double& gain : gains) gain = 0.5 + uniform(generator);
+  std::vector<std::vector<double>>      events(nbrEvents, std::vector<double>(channels * samples));
+  std::vector<std::vector<std::size_t>> hits(nbrEvents);
+  for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+  {
+    for(std::size_t s = 0; s != samples; ++s)
+    {
+      const double common{3 * normal(generator)};
+      for(std::size_t ch = 0; ch != channels; ++ch) events[evt][ch * samples + s] = 2 * normal(generator) + gains[ch] * common;
+    }
+    const std::size_t strip{static_cast<std::size_t>(uniform(generator) * (channels - 1))};
+    hits[evt].push_back(strip);
+    if(uniform(generator) < 0.3) hits[evt].push_back(strip + 1);
+  }
+  Crosstalk crosstalk(channels, samples);
+  for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+  {
+    for(std::size_t ch = 0; ch != channels; ++ch) crosstalk.addNoise(ch, &events[evt][ch * samples], samples, 0);
+    for(const std::size_t& hit : hits[evt]) crosstalk.addHit(hit);
+    crosstalk.endEvent();
+  }
+  crosstalk.finish();
+  CHECK(crosstalk.getEvents() == nbrEvents);
+  CHECK(crosstalk.getNoiseEvents() == nbrEvents);
+  // Direct sums sample by sample
+  std::vector<double> products(channels * channels, 0), sums(channels, 0);
+  for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+    for(std::size_t s = 0; s != samples; ++s)
+      for(std::size_t i = 0; i != channels; ++i)
+      {
+        sums[i] += events[evt][i * samples + s];
+        for(std::size_t j = 0; j != channels; ++j) products[i * channels + j] += events[evt][i * samples + s] * events[evt][j * samples + s];
+      }
+  const double rows{static_cast<double>(nbrEvents * samples)};
+  double       error{0};
+  for(std::size_t i = 0; i != channels; ++i)
+    for(std::size_t j = 0; j != channels; ++j)
+    {
+      const double covariance{(products[i * channels + j] - sums[i] * sums[j] / rows) / (rows - 1)};
+      error = std::max(error, std::fabs(crosstalk.getCovariance(i, j) - covariance) / std::fabs(covariance));
+    }
+  CHECK(error < 1e-9);
+  double conditional{0};
+  for(std::size_t i = 0; i + 1 != channels; ++i) conditional += crosstalk.getConditional(i + 1, i) / (channels - 1);
+  CHECK(std::fabs(conditional - 0.3 / 1.3) < 0.03);
+  // Correlation between strips before and after the common mode subtraction
+  std::vector<std::size_t> group(channels);
+  for(std::size_t ch = 0; ch != channels; ++ch) group[ch] = ch;
+  CommonMode           commonMode{crosstalk.getCommonMode({group})};
+  Crosstalk            corrected(channels, samples);
+  std::vector<double*> data(channels);
+  REQUIRE(commonMode.isEnabled());
+  for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+  {
+    for(std::size_t ch = 0; ch != channels; ++ch) data[ch] = &events[evt][ch * samples];
+    commonMode.apply(data, samples);
+    for(std::size_t ch = 0; ch != channels; ++ch) corrected.addNoise(ch, data[ch], samples, 0);
+    corrected.endEvent();
+  }
+  corrected.finish();
+  double before{0}, after{0};
+  for(std::size_t i = 0; i != channels; ++i)
+    for(std::size_t j = i + 1; j != channels; ++j)
+    {
+      before += std::fabs(crosstalk.getCorrelation(i, j));
+      after += std::fabs(corrected.getCorrelation(i, j));
+    }
+  CHECK(after < before / 3);
+}
@@ -0,0 +1,215 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Distributed.hpp"
+#include "RunSummary.hpp"
+
+#include "fmt/format.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+  #include <arpa/inet.h>
+  #include <netinet/in.h>
+  #include <sys/socket.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+RunSummary Summary(const Task& task)
+{
+  RunSummary summary(2);
+  summary.Events    = task.Events;
+  summary.Corrected = task.Events;
+  for(RunSummary::Chamber& chamber : summary.Chambers)
+  {
+    chamber.ClusterSize   = Histogram(10, 0, 10);
+    chamber.ClusterNumber = Histogram(10, 0, 10);
+    chamber.Charge        = Histogram(10, 0, 10);
+    chamber.Efficient     = task.ID + 1;
+    chamber.ClusterSize.fill(task.ID % 10);
+  }
+  return summary;
+}
+}  // namespace
+
+TEST_CASE("Tasks are serialised exactly")
+{
+  Task task;
+  task.ID     = 7;
+  task.Run    = 2;
+  task.First  = 12000;
+  task.Events = 500;
+  task.Files  = {"/data/run 1/7200V.root", "7200V_board2.root"};
+  const Task read{Task::deserialize(task.serialize())};
+  CHECK(read.ID == task.ID);
+  CHECK(read.Run == task.Run);
+  CHECK(read.First == task.First);
+  CHECK(read.Events == task.Events);
+  CHECK(read.Files == task.Files);
+  CHECK(read.isChunk());
+}
+
+// Coordinator and workers in the same process but over real sockets : one worker disconnects while holding a
+// task, its task must be processed by another one and the merged summary must hold each task once
+TEST_CASE("Task of a lost worker is reassigned and each result merged once")
+{
+  const std::size_t nbrTasks{24};
+  const std::size_t nbrWorkers{4};
+  Coordinator       coordinator(0, 0, 10);
+  for(std::size_t i = 0; i != nbrTasks; ++i)
+  {
+    Task task;
+    task.Run    = i % 3;
+    task.First  = 1000 * i;
+    task.Events = 1000;
+    task.Files  = {fmt::format("{}V.root", 7000 + 100 * task.Run)};
+    coordinator.addTask(task);
+  }
+  auto work = [&](const bool& failing) {
+    Worker worker("127.0.0.1", coordinator.getPort());
+    Task   task;
+    while(worker.next(task))
+    {
+      // Disconnect without answering
+      if(failing) return;
+      worker.send(task, Summary(task).serialize());
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.emplace_back(work, true);
+  for(std::size_t i = 1; i < nbrWorkers; ++i) workers.emplace_back(work, false);
+  std::vector<RunSummary> runs(3);
+  std::size_t             results{0};
+  coordinator.run([&](const Task& task, const std::string& result) {
+    runs[task.Run].add(RunSummary::deserialize(result));
+    ++results;
+  });
+  for(std::size_t i = 0; i != workers.size(); ++i) workers[i].join();
+  std::int64_t  events{0};
+  std::uint64_t efficient{0};
+  std::uint64_t entries{0};
+  for(const RunSummary& run : runs)
+  {
+    events += run.Events;
+    if(run.Chambers.empty()) continue;
+    efficient += run.Chambers[0].Efficient;
+    entries += run.Chambers[0].ClusterSize.getEntries();
+  }
+  CHECK(results == nbrTasks);
+  CHECK(events == static_cast<std::int64_t>(1000 * nbrTasks));
+  CHECK(efficient == nbrTasks * (nbrTasks + 1) / 2);
+  CHECK(entries == nbrTasks);
+  CHECK(coordinator.getReassigned() != 0);
+  CHECK(coordinator.getWorkers() == nbrWorkers);
+}
+
+TEST_CASE("A task a worker can't process is reported once and not given again")
+{
+  const std::size_t nbrTasks{8};
+  Coordinator       coordinator(0, 0, 10);
+  for(std::size_t i = 0; i != nbrTasks; ++i)
+  {
+    Task task;
+    task.Run   = i;
+    task.Files = {fmt::format("{}V.root", 7000 + 100 * i)};
+    coordinator.addTask(task);
+  }
+  // The files of the run 3 are missing
+  auto work = [&]() {
+    Worker worker("127.0.0.1", coordinator.getPort());
+    Task   task;
+    while(worker.next(task))
+    {
+      if(task.Run == 3) worker.fail(task, fmt::format("{} not found !", task.Files[0]));
+      else
+        worker.send(task, Summary(task).serialize());
+    }
+  };
+  std::vector<std::thread> workers;
+  for(std::size_t i = 0; i != 2; ++i) workers.emplace_back(work);
+  std::vector<std::size_t> results(nbrTasks, 0);
+  std::vector<std::string> reasons(nbrTasks);
+  coordinator.run([&](const Task& task, const std::string&) { ++results[task.Run]; }, [&](const Task& task, const std::string& reason) { reasons[task.Run] += reason; });
+  for(std::size_t i = 0; i != workers.size(); ++i) workers[i].join();
+  for(std::size_t run = 0; run != nbrTasks; ++run)
+  {
+    CHECK(results[run] == (run == 3 ? 0 : 1));
+    CHECK(reasons[run] == (run == 3 ? "7300V.root not found !" : ""));
+  }
+  CHECK(coordinator.getFailed() == 1);
+  CHECK(coordinator.getReassigned() == 0);
+}
+
+#ifndef _WIN32
+// One worker answers for another task than the one it holds, one stops in the middle of its result and keeps the
+// connection open : both are dropped, their tasks given to the good worker and the run ends
+TEST_CASE("Malformed or stalled results are dropped and their tasks reassigned")
+{
+  const std::size_t nbrTasks{6};
+  Coordinator       coordinator(0, 0, 10, 0.5);
+  for(std::size_t i = 0; i != nbrTasks; ++i)
+  {
+    Task task;
+    task.First  = 1000 * i;
+    task.Events = 1000;
+    task.Files  = {"7000V.root"};
+    coordinator.addTask(task);
+  }
+  auto wrong = [&]() {
+    Worker worker("127.0.0.1", coordinator.getPort());
+    Task   task;
+    if(!worker.next(task)) return;
+    Task other{task};
+    other.ID += 1000;
+    worker.send(other, Summary(task).serialize());
+  };
+  auto stalled = [&]() {
+    const int   handle{socket(AF_INET, SOCK_STREAM, 0)};
+    sockaddr_in address{};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port        = htons(coordinator.getPort());
+    if(connect(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0)
+    {
+      const std::string ready{"READY 0\n"};
+      const std::string half{"RESULT 100\n0\n"};
+      char              buffer[256];
+      if(send(handle, ready.data(), ready.size(), 0) > 0 && recv(handle, buffer, sizeof(buffer), 0) > 0) send(handle, half.data(), half.size(), 0);
+      std::this_thread::sleep_for(std::chrono::seconds(3));
+    }
+    close(handle);
+  };
+  auto good = [&]() {
+    // The others take their task first
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    Worker worker("127.0.0.1", coordinator.getPort());
+    Task   task;
+    while(worker.next(task)) worker.send(task, Summary(task).serialize());
+  };
+  std::vector<std::thread> workers;
+  workers.emplace_back(wrong);
+  workers.emplace_back(stalled);
+  workers.emplace_back(good);
+  RunSummary  run;
+  std::size_t results{0};
+  const auto  start = std::chrono::steady_clock::now();
+  coordinator.run([&](const Task&, const std::string& result) {
+    run.add(RunSummary::deserialize(result));
+    ++results;
+  });
+  const double seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+  for(std::size_t i = 0; i != workers.size(); ++i) workers[i].join();
+  CHECK(results == nbrTasks);
+  CHECK(run.Events == static_cast<std::int64_t>(1000 * nbrTasks));
+  CHECK(run.Chambers[0].Efficient == nbrTasks * (nbrTasks + 1) / 2);
+  CHECK(coordinator.getReassigned() == 2);
+  // Not waiting for the stalled worker to close its connection
+  CHECK(seconds < 2.5);
+}
+#endif
@@ -0,0 +1,195 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "EventBuilder.hpp"
+#include "RawReader.hpp"
+#include "Synthetic.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+namespace fs = std::filesystem;
+
+const std::size_t samples{64};
+const double      rollover{1 << 30};
+
+// Raw file of a board (id given as BoardID) with the time tags given, removed at the end
+class Board
+{
+public:
+  Board(const std::string& name, const int& id, const std::vector<double>& tags) : m_Filename((fs::temp_directory_path() / name).string()), m_Samples(WriteRawFile(m_Filename, tags.size(), samples, 23 + id, id, tags)) {}
+  ~Board() { fs::remove(m_Filename); }
+  Board(const Board&) = delete;
+  Board&             operator=(const Board&) = delete;
+  const std::string& getFilename() const { return m_Filename; }
+  // Sample written in the entry of the file
+  double             get(const std::size_t& entry, const std::size_t& ch, const std::size_t& i) const { return m_Samples[(entry * RawReader::NumberChannels + ch) * samples + i]; }
+
+private:
+  std::string                m_Filename;
+  std::vector<std::uint16_t> m_Samples;
+};
+
+// Channels of the built event which are not the ones of the entries of the boards, concatenated in the order of the boards
+std::size_t Mismatches(const Event& event, const std::vector<const Board*>& boards, const std::vector<std::size_t>& entries)
+{
+  if(event.Channels.size() != boards.size() * RawReader::NumberChannels) return event.Channels.size() + 1;
+  std::size_t errors{0};
+  for(std::size_t board = 0; board != boards.size(); ++board)
+  {
+    for(std::size_t ch = 0; ch != RawReader::NumberChannels; ++ch)
+    {
+      const Channel& channel{event.Channels[board * RawReader::NumberChannels + ch]};
+      errors += channel.Number != static_cast<int>(ch) || channel.Data.size() != samples;
+      for(std::size_t i = 0; i != channel.Data.size(); ++i) errors += channel.Data[i] != boards[board]->get(entries[board], ch, i);
+    }
+  }
+  return errors;
+}
+
+// Two boards, the second one missed the trigger of the event 10 (one tick later than the first one)
+std::vector<double> Tags(const std::size_t& events, const bool& missing)
+{
+  std::vector<double> tags;
+  for(std::size_t evt = 0; evt != events; ++evt)
+    if(!missing || evt != 10) tags.push_back(1000.0 * evt + (missing ? 1 : 0));
+  return tags;
+}
+}  // namespace
+
+TEST_CASE("Boards with an offset and a drift inside the window are built together, in the order of the files")
+{
+  const std::size_t   nbrEvents{100};
+  std::vector<double> first(nbrEvents);
+  std::vector<double> second(nbrEvents);
+  std::vector<double> third(nbrEvents);
+  for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+  {
+    first[evt]  = 1000.0 * evt + 4;
+    second[evt] = 1000.0 * evt + 3;
+    // One tick late on the second half : 2 ticks (the window) from the second board
+    third[evt] = 1000.0 * evt + 4 + (2 * evt) / nbrEvents;
+  }
+  const Board boards[3]{{"TestEventBuilder1.dat", 1, first}, {"TestEventBuilder2.dat", 2, second}, {"TestEventBuilder3.dat", 3, third}};
+  {
+    EventBuilder builder({boards[0].getFilename(), boards[1].getFilename(), boards[2].getFilename()});
+    CHECK(builder.getNumberBoards() == 3);
+    CHECK(builder.getEntries() == static_cast<Long64_t>(nbrEvents));
+    Event       event;
+    std::size_t errors{0};
+    std::size_t built{0};
+    for(; builder.next(event); ++built)
+    {
+      // Header of the first board
+      errors += event.BoardID != 1 || event.EventNumber != static_cast<int>(built) || event.TriggerTimeTag != first[built];
+      errors += Mismatches(event, {&boards[0], &boards[1], &boards[2]}, {built, built, built});
+    }
+    CHECK(built == nbrEvents);
+    CHECK(errors == 0);
+    CHECK(builder.getDropped() == 0);
+    CHECK(builder.getBuilt() == static_cast<Long64_t>(nbrEvents));
+  }
+  // Files in another order : the channels follow
+  {
+    EventBuilder builder({boards[2].getFilename(), boards[0].getFilename()});
+    Event        event;
+    std::size_t  errors{0};
+    std::size_t  built{0};
+    for(; builder.next(event); ++built) errors += event.BoardID != 3 || Mismatches(event, {&boards[2], &boards[0]}, {built, built}) != 0;
+    CHECK(built == nbrEvents);
+    CHECK(errors == 0);
+  }
+  // A narrower window misses the late events of the third board
+  {
+    EventBuilder builder({boards[1].getFilename(), boards[2].getFilename()}, "Tree", 1);
+    Event        event;
+    while(builder.next(event)) continue;
+    CHECK(builder.getBuilt() == static_cast<Long64_t>(nbrEvents / 2));
+    CHECK(builder.getDropped() != 0);
+  }
+}
+
+TEST_CASE("An event missing on one board is dropped on the others")
+{
+  const std::size_t nbrEvents{50};
+  const Board       boards[2]{{"TestEventBuilder1.dat", 1, Tags(nbrEvents, false)}, {"TestEventBuilder2.dat", 2, Tags(nbrEvents, true)}};
+  EventBuilder      builder({boards[0].getFilename(), boards[1].getFilename()});
+  CHECK(builder.getEntries() == static_cast<Long64_t>(nbrEvents - 1));
+  Event       event;
+  std::size_t errors{0};
+  std::size_t built{0};
+  for(; builder.next(event); ++built)
+  {
+    const std::size_t entry{built < 10 ? built : built + 1};
+    errors += event.EventNumber != static_cast<int>(built) || event.TriggerTimeTag != 1000.0 * entry;
+    errors += Mismatches(event, {&boards[0], &boards[1]}, {entry, built});
+  }
+  CHECK(built == nbrEvents - 1);
+  CHECK(errors == 0);
+  CHECK(builder.getDropped() == 1);
+}
+
+TEST_CASE("Time tags wrapping at 30 bits are unwrapped on each board")
+{
+  // The second board is one tick late : it wraps one event before the first one
+  const std::size_t   nbrEvents{12};
+  std::vector<double> first(nbrEvents);
+  std::vector<double> second(nbrEvents);
+  for(std::size_t evt = 0; evt != nbrEvents; ++evt)
+  {
+    first[evt]  = std::fmod(rollover - 5001 + 1000.0 * evt, rollover);
+    second[evt] = std::fmod(rollover - 5000 + 1000.0 * evt, rollover);
+  }
+  REQUIRE(second[5] == 0);
+  REQUIRE(first[5] == rollover - 1);
+  const Board boards[2]{{"TestEventBuilder1.dat", 1, first}, {"TestEventBuilder2.dat", 2, second}};
+  {
+    EventBuilder builder({boards[0].getFilename(), boards[1].getFilename()});
+    Event        event;
+    std::size_t  errors{0};
+    std::size_t  built{0};
+    // The time tag of the event is the one read
+    for(; builder.next(event); ++built) errors += event.TriggerTimeTag != first[built] || Mismatches(event, {&boards[0], &boards[1]}, {built, built}) != 0;
+    CHECK(built == nbrEvents);
+    CHECK(errors == 0);
+    CHECK(builder.getDropped() == 0);
+  }
+  // Unwrapped with a counter of 31 bits : the boards are apart between their wraps, the event 5 is lost on both
+  {
+    EventBuilder builder({boards[0].getFilename(), boards[1].getFilename()}, "Tree", 2, 31);
+    Event        event;
+    while(builder.next(event)) continue;
+    CHECK(builder.getBuilt() == static_cast<Long64_t>(nbrEvents - 1));
+    CHECK(builder.getDropped() == 2);
+  }
+}
+
+TEST_CASE("Skipping on several boards gives the events built after them")
+{
+  const std::size_t nbrEvents{50};
+  const Board       boards[2]{{"TestEventBuilder1.dat", 1, Tags(nbrEvents, false)}, {"TestEventBuilder2.dat", 2, Tags(nbrEvents, true)}};
+  for(const std::size_t skip : {0, 9, 10, 30, 48, 49, 60})
+  {
+    CAPTURE(skip);
+    EventBuilder builder({boards[0].getFilename(), boards[1].getFilename()});
+    CHECK(builder.skip(static_cast<Long64_t>(skip)) == static_cast<Long64_t>(std::min(skip, nbrEvents - 1)));
+    // The event 10 of the first board is dropped once it is passed
+    CHECK(builder.getDropped() == (skip > 10 ? 1 : 0));
+    Event event;
+    if(skip >= nbrEvents - 1)
+    {
+      CHECK_FALSE(builder.next(event));
+      continue;
+    }
+    REQUIRE(builder.next(event));
+    const std::size_t entry{skip < 10 ? skip : skip + 1};
+    CHECK(event.EventNumber == static_cast<int>(skip));
+    CHECK(Mismatches(event, {&boards[0], &boards[1]}, {entry, skip}) == 0);
+  }
+}
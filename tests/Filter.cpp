@@ -0,0 +1,63 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Filter.hpp"
+#include "Synthetic.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+std::vector<double> Filtered(Filter filter, const Waveforms& waveforms)
+{
+  Waveforms            copy{waveforms};
+  std::vector<double*> pointers(copy.getChannels());
+  for(std::size_t evt = 0; evt != copy.getEvents(); ++evt)
+  {
+    for(std::size_t ch = 0; ch != copy.getChannels(); ++ch) pointers[ch] = copy.get(evt, ch);
+    filter.apply(pointers, copy.getLength());
+  }
+  return copy.copy();
+}
+}  // namespace
+
+TEST_CASE("Filter off and identity filters leave the waveforms untouched")
+{
+  const Waveforms waveforms(50, 12, 256);
+  CHECK_FALSE(Filter().isEnabled());
+  CHECK(Filtered(Filter(), waveforms) == waveforms.copy());
+  CHECK(Filtered(Filter::fromString("none", 5, {}, 0.5), waveforms) == waveforms.copy());
+  CHECK(Filtered(Filter::FIR({1.0}), waveforms) == waveforms.copy());
+}
+
+TEST_CASE("Filters keep the pulses in place")
+{
+  // Moving average, symmetric FIR and zero phase IIR : the minimum of a clean pulse doesn't move
+  Waveforms waveforms(1, 1, 512);
+  double*   data{waveforms.get(0, 0)};
+  for(std::size_t i = 0; i != 512; ++i)
+  {
+    const double t{(i - 200.0) / 4.0};
+    data[i] = t > 0 ? -50 * t * std::exp(1.0 - t) : 0.0;
+  }
+  auto tick = [](const std::vector<double>& samples) {
+    std::size_t minimum{0};
+    for(std::size_t i = 0; i != samples.size(); ++i)
+      if(samples[i] < samples[minimum]) minimum = i;
+    return static_cast<int>(minimum);
+  };
+  const int reference{tick(waveforms.copy())};
+  CHECK(std::abs(tick(Filtered(Filter::MovingAverage(5), waveforms)) - reference) <= 1);
+  CHECK(std::abs(tick(Filtered(Filter::FIR(std::vector<double>(7, 1.0 / 7)), waveforms)) - reference) <= 1);
+  CHECK(std::abs(tick(Filtered(Filter::IIR(0.3), waveforms)) - reference) <= 1);
+}
+
+TEST_CASE("Filter parameters are checked")
+{
+  CHECK_THROWS_AS(Filter::MovingAverage(0), std::runtime_error);
+  CHECK_THROWS_AS(Filter::FIR({}), std::runtime_error);
+  CHECK_THROWS_AS(Filter::IIR(0), std::runtime_error);
+  CHECK_THROWS_AS(Filter::fromString("median", 5, {}, 0.5), std::runtime_error);
+}
@@ -0,0 +1,135 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Kernels.hpp"
+#include "Synthetic.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// Same algorithm as MeanSTD in Analysis.cpp : whole record scanned with the window checked sample by sample
+std::pair<double, double> ReferenceMeanSigma(const double* data, const std::size_t& length, const double& first, const double& second)
+{
+  double mean{0};
+  double sigma{0};
+  int    used{0};
+  for(std::size_t j = 0; j != length; ++j)
+  {
+    if(j >= first && j <= second)
+    {
+      used++;
+      mean += data[j];
+    }
+  }
+  mean /= used;
+  for(std::size_t j = 0; j != length; ++j)
+  {
+    if(j >= first && j <= second) sigma += (data[j] - mean) * (data[j] - mean);
+  }
+  return {mean, std::sqrt(sigma / (used - 1))};
+}
+
+// Same as getMinMax in Analysis.cpp
+std::pair<double, int> ReferenceMinimum(const double* data, const std::size_t& length, const int& begin, const int& end)
+{
+  double min{std::numeric_limits<double>::max()};
+  int    tick{0};
+  for(std::size_t j = begin; j != static_cast<std::size_t>(end) && j != length; ++j)
+  {
+    if(data[j] < min)
+    {
+      min  = data[j];
+      tick = j;
+    }
+  }
+  return {min, tick};
+}
+
+void CheckAgainstReference(const Kernels::Dispatcher& kernels, const Waveforms& waveforms)
+{
+  const std::size_t length{waveforms.getLength()};
+  const int         begin{static_cast<int>(0.4 * length)};
+  const int         end{static_cast<int>(0.6 * length)};
+  const double      noiseEnd{0.2 * length};
+  std::size_t       errors{0};
+  for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+  {
+    for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+    {
+      const double* data{waveforms.get(evt, ch)};
+      // The kernels only change the summation order
+      const std::pair<double, double> noise{kernels.meanSigma(data, length, 0, noiseEnd)};
+      const std::pair<double, double> referenceNoise{ReferenceMeanSigma(data, length, 0, noiseEnd)};
+      const std::pair<double, double> signal{kernels.meanSigma(data, length, begin, end)};
+      const std::pair<double, double> referenceSignal{ReferenceMeanSigma(data, length, begin, end)};
+      errors += std::fabs(noise.second - referenceNoise.second) > 1e-9 * referenceNoise.second;
+      errors += std::fabs(signal.first - referenceSignal.first) > 1e-9 * std::fabs(referenceSignal.first) + 1e-12;
+      // The extremum is exact
+      errors += kernels.extremum(-1, data, length, begin, end) != ReferenceMinimum(data, length, begin, end);
+    }
+  }
+  CHECK(errors == 0);
+}
+}  // namespace
+
+TEST_CASE("Generic kernels agree with MeanSTD and getMinMax")
+{
+  CheckAgainstReference(Kernels::Dispatcher::generic(), Waveforms(200, 8, 1000));
+}
+
+TEST_CASE("Specialised kernels agree with MeanSTD and getMinMax")
+{
+  for(const std::size_t length : {1024, 520, 256, 136})
+  {
+    const Kernels::Dispatcher kernels{Kernels::Dispatcher::select(length)};
+    REQUIRE(kernels.isSpecialised());
+    CHECK(kernels.getRecordLength() == length);
+    CheckAgainstReference(kernels, Waveforms(100, 8, length));
+  }
+  CHECK_FALSE(Kernels::Dispatcher::select(1000).isSpecialised());
+}
+
+TEST_CASE("Windows outside the record are clamped")
+{
+  const Waveforms waveforms(1, 1, 256);
+  const double*   data{waveforms.get(0, 0)};
+  CHECK(std::isnan(Kernels::meanSigma<0>(data, 256, 300, 400).first));
+  CHECK(std::isnan(Kernels::meanSigma<0>(data, 256, -20, -10).first));
+  CHECK(Kernels::meanSigma<256>(data, 256, -10, 1000) == Kernels::meanSigma<0>(data, 256, 0, 255));
+  CHECK(Kernels::extremum<-1, 256>(data, 256, -1, 1000) == Kernels::extremum<-1, 0>(data, 256, 0, 256));
+}
+
+TEST_CASE("Code kernels give the double results on integer samples")
+{
+  const Waveforms           waveforms(20, 4, 520);
+  const Kernels::Dispatcher kernels{Kernels::Dispatcher::select(520)};
+  std::vector<double>       samples(520);
+  std::vector<std::int16_t> codes(520);
+  for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+  {
+    for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+    {
+      for(std::size_t i = 0; i != 520; ++i) samples[i] = std::round(2048 + 4 * waveforms.get(evt, ch)[i]);
+      std::int64_t sum{0};
+      REQUIRE(Kernels::toCodes(samples.data(), 520, codes.data(), sum));
+      CHECK(kernels.mean(codes.data(), 520) == doctest::Approx(static_cast<double>(sum) / 520));
+      const std::pair<double, double> code{kernels.meanSigma(codes.data(), 520, 100, 300)};
+      const std::pair<double, double> reference{ReferenceMeanSigma(samples.data(), 520, 100, 300)};
+      CHECK(code.first == doctest::Approx(reference.first));
+      CHECK(code.second == doctest::Approx(reference.second));
+      const std::pair<int, int> minimum{kernels.extremum(-1, codes.data(), 520, 100, 300)};
+      CHECK(std::make_pair(static_cast<double>(minimum.first), minimum.second) == ReferenceMinimum(samples.data(), 520, 100, 300));
+    }
+  }
+  // Samples which are not codes are reported
+  const double notCodes[3]{12, 4096, 3.5};
+  std::int16_t converted[3];
+  std::int64_t sum{0};
+  CHECK_FALSE(Kernels::toCodes(notCodes, 3, converted, sum));
+  CHECK(converted[1] == 4095);
+}
@@ -0,0 +1,77 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "PeakFinder.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Waveforms with 0 to 3 separated pulses : the peak finder against a sample by sample version of the same
+// hysteresis search (same peaks expected) and against the number of pulses generated
+TEST_CASE("Peak finder gives the peaks of the sample by sample search")
+{
+  const std::size_t                nbrWaveforms{200};
+  const std::size_t                length{1024};
+  std::mt19937                     generator(5);
+  std::normal_distribution<double> noise(0.0, 2.0);
+  std::uniform_int_distribution<>  pulses(0, 3);
+  std::uniform_real_distribution<> amplitude(20.0, 80.0);
+  std::vector<double>              data(nbrWaveforms * length);
+  std::vector<std::size_t>         truth(nbrWaveforms);
+  for(std::size_t w = 0; w != nbrWaveforms; ++w)
+  {
+    double* waveform{&data[w * length]};
+    for(std::size_t i = 0; i != length; ++i) waveform[i] = noise(generator);
+    truth[w] = pulses(generator);
+    for(std::size_t p = 0; p != truth[w]; ++p)
+    {
+      const double t0{(p + 1) * length / 5.0};
+      const double amp{amplitude(generator)};
+      for(std::size_t i = 0; i != length; ++i)
+      {
+        const double t{(i - t0) / 4.0};
+        waveform[i] -= t > 0 ? amp * t * std::exp(1.0 - t) : 0.0;
+      }
+    }
+  }
+  const double threshold{5 * 2.0};
+  const double hysteresis{0.5};
+  PeakFinder   finder(1, nbrWaveforms, hysteresis);
+  for(std::size_t w = 0; w != nbrWaveforms; ++w) finder.find(0, w, &data[w * length], length, 0, length, -1, 0, threshold);
+  REQUIRE(finder.getNumberTrains() == nbrWaveforms);
+  std::size_t differences{0};
+  std::size_t correct{0};
+  for(std::size_t w = 0; w != nbrWaveforms; ++w)
+  {
+    // Sample by sample reference
+    const double* waveform{&data[w * length]};
+    PeakTrain     reference;
+    bool          inPeak{false};
+    for(std::size_t i = 0; i != length; ++i)
+    {
+      const double y{-waveform[i]};
+      if(!inPeak && y > threshold)
+      {
+        inPeak = true;
+        if(reference.Number < PeakTrain::MaxPeaks) reference.Peaks[reference.Number] = Peak{static_cast<int>(i), y};
+        ++reference.Number;
+      }
+      else if(inPeak && y < hysteresis * threshold)
+        inPeak = false;
+      else if(inPeak && reference.Number <= PeakTrain::MaxPeaks && y > reference.Peaks[reference.Number - 1].Amplitude)
+        reference.Peaks[reference.Number - 1] = Peak{static_cast<int>(i), y};
+    }
+    const PeakTrain& train{finder.getTrain(w)};
+    if(train.Number == truth[w]) ++correct;
+    bool same{train.Number == reference.Number};
+    for(std::size_t p = 0; same && p != train.getStored(); ++p) same = train.Peaks[p].Tick == reference.Peaks[p].Tick && train.Peaks[p].Amplitude == reference.Peaks[p].Amplitude;
+    if(!same) ++differences;
+  }
+  CHECK(differences == 0);
+  // Pulses of at least 20 mV for a noise of 2 mV
+  CHECK(correct > 0.9 * nbrWaveforms);
+  finder.endEvent(1.0);
+  CHECK(finder.getNumberTrains() == 0);
+  CHECK(finder.getPeaks(0).getEntries() == nbrWaveforms);
+}
@@ -0,0 +1,92 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Kernels.hpp"
+#include "Precision.hpp"
+#include "Synthetic.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Features of the Analysis selections computed on the same 12 bits codes in double (ToVolt, baseline, kernels on mV)
+// and in compact precision (int16 codes, integer sums, results converted to mV), the decisions must not change
+TEST_CASE("Compact precision takes the decisions of the double one")
+{
+  constexpr double                DacToVolt{560. / 2048};
+  const Waveforms                 waveforms(500, 32, 1024);
+  const std::size_t               length{waveforms.getLength()};
+  const std::size_t               channels{waveforms.getChannels()};
+  const std::size_t               events{waveforms.getEvents()};
+  const std::pair<double, double> noise{0, 0.2 * length};
+  const std::pair<double, double> noiseAfter{0.8 * length, length - 1.};
+  const int                       begin{static_cast<int>(0.4 * length)};
+  const int                       end{static_cast<int>(0.6 * length)};
+  const Kernels::Dispatcher       kernels{Kernels::Dispatcher::select(length)};
+  std::vector<double>             codes(length);
+  std::vector<double>             volts(length);
+  std::vector<std::int16_t>       compact(length);
+  PrecisionValidation             validation(4, channels);
+  const double                    nsigma{5};
+  const double                    nsigmaNoise{5};
+  for(std::size_t evt = 0; evt != events; ++evt)
+  {
+    for(std::size_t ch = 0; ch != channels; ++ch)
+    {
+      // ADC codes as stored in Channel::Data (pedestal above 2048 so the pulses stay in range)
+      for(std::size_t i = 0; i != length; ++i) codes[i] = std::max(0., std::min(4095., std::round(2248 + waveforms.get(evt, ch)[i] / DacToVolt)));
+      PrecisionValidation::Decision decisions[2];
+      {
+        for(std::size_t j = 0; j != length; ++j) volts[j] = (codes[j] - 2048) * DacToVolt;
+        kernels.baseline(volts.data(), length);
+        const std::pair<double, double> signal{kernels.meanSigma(volts.data(), length, begin, end)};
+        const float                     value{static_cast<float>(kernels.extremum(-1, volts.data(), length, begin, end).first)};
+        const double                    sigma{kernels.meanSigma(volts.data(), length, noise.first, noise.second).second};
+        const double                    after{kernels.meanSigma(volts.data(), length, noiseAfter.first, noiseAfter.second).second};
+        const double                    amplitude{std::fabs(value - signal.first)};
+        decisions[PrecisionValidation::Double] = {amplitude > nsigma * sigma, after / sigma >= nsigmaNoise, amplitude, sigma};
+      }
+      {
+        std::int64_t sum{0};
+        REQUIRE(Kernels::toCodes(codes.data(), length, compact.data(), sum));
+        const double                    baseline{static_cast<double>(sum) / length};
+        const std::pair<double, double> signal{kernels.meanSigma(compact.data(), length, begin, end)};
+        const float                     value{static_cast<float>((kernels.extremum(-1, compact.data(), length, begin, end).first - baseline) * DacToVolt)};
+        const double                    sigma{kernels.meanSigma(compact.data(), length, noise.first, noise.second).second * DacToVolt};
+        const double                    after{kernels.meanSigma(compact.data(), length, noiseAfter.first, noiseAfter.second).second * DacToVolt};
+        const double                    amplitude{std::fabs(value - (signal.first - baseline) * DacToVolt)};
+        decisions[PrecisionValidation::Compact] = {amplitude > nsigma * sigma, after / sigma >= nsigmaNoise, amplitude, sigma};
+      }
+      validation.addChannel(ch % 4, decisions[0], decisions[1]);
+    }
+    validation.endEvent();
+  }
+  CHECK(validation.getEvents() == events);
+  for(std::size_t chamber = 0; chamber != validation.getNumberChambers(); ++chamber)
+  {
+    const PrecisionValidation::Chamber& counts{validation.getChamber(chamber)};
+    CHECK(PrecisionValidation::countDifferences(counts.Amplitude[0], counts.Amplitude[1]) == 0);
+    CHECK(PrecisionValidation::countDifferences(counts.Sigma[0], counts.Sigma[1]) == 0);
+    CHECK(PrecisionValidation::countDifferences(counts.Multiplicity[0], counts.Multiplicity[1]) == 0);
+    CHECK(counts.MaxAmplitudeDifference < 1e-4);
+    CHECK(counts.MaxSigmaDifference < 1e-4);
+    CHECK(validation.getEfficiency(chamber, PrecisionValidation::Double) == validation.getEfficiency(chamber, PrecisionValidation::Compact));
+  }
+  CHECK(validation.getChanges() == 0);
+}
+
+TEST_CASE("Changed decisions are counted")
+{
+  PrecisionValidation validation(1, 4);
+  validation.addChannel(0, {true, false, 50, 2}, {false, false, 9.9, 2});
+  validation.addChannel(0, {false, false, 3, 2}, {false, true, 3, 2});
+  validation.endEvent();
+  const PrecisionValidation::Chamber& counts{validation.getChamber(0)};
+  CHECK(counts.HitLost == 1);
+  CHECK(counts.NoisyGained == 1);
+  CHECK(validation.getChanges() == 2);
+  CHECK(validation.getEfficiency(0, PrecisionValidation::Double) == 1);
+  CHECK(validation.getEfficiency(0, PrecisionValidation::Compact) == 0);
+}
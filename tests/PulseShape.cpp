@@ -0,0 +1,69 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "PulseShape.hpp"
+#include "RunSummary.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// Negative triangular pulse of the amplitude given on a flat baseline, peak at the tick given
+std::vector<double> Triangle(const std::size_t& length, const std::size_t& peak, const double& amplitude, const double& baseline)
+{
+  std::vector<double> data(length, baseline);
+  for(std::size_t tick = peak - 5; tick != peak + 6; ++tick) data[tick] -= amplitude * (1 - std::fabs(static_cast<double>(tick) - peak) / 5);
+  return data;
+}
+}  // namespace
+
+TEST_CASE("Leading edge not crossing the levels gives no time")
+{
+  PulseAnalyser pulses(1, 2);
+  // Already below the levels at the start of the record
+  const std::vector<double> data(64, -40);
+  const Pulse& early{pulses.analyse(0, 0, data.data(), data.size(), -1, 3, 0, 1)};
+  CHECK(std::isnan(early.Time));
+  CHECK(std::isnan(early.RiseTime));
+  const std::vector<double> triangle{Triangle(64, 30, 50, 0)};
+  const Pulse&              pulse{pulses.analyse(0, 1, triangle.data(), triangle.size(), -1, 30, 0, 1)};
+  CHECK(pulse.Time == doctest::Approx(26));
+  CHECK(pulse.RiseTime == doctest::Approx(4));
+  pulses.endEvent();
+  // Both charges counted, only the rise time measured
+  CHECK(pulses.getCharge(0).getEntries() == 2);
+  CHECK(pulses.getChargeEntries(0) == 2);
+  CHECK(pulses.getRiseTime(0).getEntries() == 1);
+}
+
+TEST_CASE("Mean charge is exact whatever the binning and the merges")
+{
+  // Charges in the overflow of the histogram (50 pC) and inside
+  const std::vector<double> amplitudes{10, 450, 300, 25, 1000};
+  std::vector<RunSummary>   runs;
+  double                    sum{0};
+  for(const double& amplitude : amplitudes)
+  {
+    PulseAnalyser             pulses(1, 1);
+    const std::vector<double> data{Triangle(128, 60, amplitude, 2)};
+    sum += pulses.analyse(0, 0, data.data(), data.size(), -1, 60, 2, 1).Charge;
+    pulses.endEvent();
+    RunSummary run(1);
+    run.Chambers[0].Charge        = pulses.getCharge(0);
+    run.Chambers[0].ChargeSum     = pulses.getChargeSum(0);
+    run.Chambers[0].ChargeEntries = pulses.getChargeEntries(0);
+    runs.push_back(RunSummary::deserialize(run.serialize()));
+  }
+  RunSummary forward{runs.front()};
+  RunSummary backward{runs.back()};
+  for(std::size_t i = 1; i != runs.size(); ++i)
+  {
+    forward.add(runs[i]);
+    backward.add(runs[runs.size() - 1 - i]);
+  }
+  CHECK(forward.Chambers[0].Charge.getOverflow() != 0);
+  CHECK(forward.Chambers[0].getMeanCharge() == doctest::Approx(sum / amplitudes.size()).epsilon(1e-7));
+  CHECK(forward.Chambers[0].getMeanCharge() == backward.Chambers[0].getMeanCharge());
+  CHECK(RunSummary(1).Chambers[0].getMeanCharge() == 0);
+}
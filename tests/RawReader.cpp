@@ -0,0 +1,101 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "RawReader.hpp"
+#include "Synthetic.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Raw file read through the memory mapping with 1 to 4 decoding threads (all the channels, then 4 of them), the
+// decoded samples must be the ones written. Half an event at the end (acquisition stopped) must be ignored.
+TEST_CASE("Raw events decoded are the ones written")
+{
+  const std::size_t                nbrEvents{200};
+  const std::size_t                samples{1024};
+  const std::string                filename{(std::filesystem::temp_directory_path() / "TestRawReader.dat").string()};
+  const std::vector<std::uint16_t> reference{WriteRawFile(filename, nbrEvents, samples)};
+  {
+    std::ofstream           file(filename, std::ios::binary | std::ios::app);
+    const std::vector<char> half(4 * (4 + 3 * samples / 2), 0);
+    const std::uint32_t     header{0xAu << 28 | static_cast<std::uint32_t>(4 + 4 * (3 * samples + 3 * samples / 8 + 2))};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(half.data(), static_cast<std::streamsize>(half.size()));
+  }
+  CHECK(RawReader::isRaw(filename));
+  const std::vector<int> selected{0, 9, 18, 32};
+  for(const bool all : {true, false})
+  {
+    std::vector<bool> needed(RawReader::NumberChannels, all);
+    for(const int& ch : selected) needed[ch] = true;
+    for(const std::size_t threads : {1, 2, 4})
+    {
+      RawReader reader(filename, threads);
+      reader.setChannels(needed);
+      CHECK(reader.getEntries() == static_cast<std::int64_t>(nbrEvents));
+      RawEvent     event;
+      std::size_t  errors{0};
+      std::int64_t entries{0};
+      for(std::size_t evt = 0; reader.next(event); ++evt, ++entries)
+      {
+        errors += event.EventNumber != static_cast<int>(evt) || event.Period_ns != 0.2 || event.Channels[0].StartIndexCell != static_cast<double>((evt * 37) % 1024);
+        for(std::size_t ch = 0; ch != RawReader::NumberChannels; ++ch)
+        {
+          const std::vector<double>& data{event.Channels[ch].Data};
+          // The channels not requested can be in the chunk decoded before setChannels
+          if(data.empty() && needed[ch]) ++errors;
+          for(std::size_t i = 0; i != data.size(); ++i) errors += data[i] != reference[(evt * RawReader::NumberChannels + ch) * samples + i];
+        }
+      }
+      CHECK(entries == static_cast<std::int64_t>(nbrEvents));
+      CHECK(errors == 0);
+    }
+  }
+  // Channels of the groups decoded as codes, the triggers as doubles (the first chunk is decoded before setCodes)
+  {
+    RawReader reader(filename, 2, 16);
+    reader.setCodes(true);
+    RawEvent    event;
+    std::size_t errors{0};
+    std::size_t coded{0};
+    for(std::size_t evt = 0; reader.next(event); ++evt)
+    {
+      coded += !event.Channels[0].Codes.empty();
+      for(std::size_t ch = 0; ch != RawReader::NumberChannels; ++ch)
+      {
+        const RawChannel& channel{event.Channels[ch]};
+        const bool        trigger{ch >= RawReader::Groups * RawReader::ChannelsByGroup};
+        if(evt >= 16) errors += trigger ? !channel.Codes.empty() : !channel.Data.empty();
+        for(std::size_t i = 0; i != channel.Codes.size(); ++i) errors += channel.Codes[i] != reference[(evt * RawReader::NumberChannels + ch) * samples + i];
+      }
+    }
+    CHECK(coded == nbrEvents - 16);
+    CHECK(errors == 0);
+  }
+  // Skip inside and across the chunks
+  {
+    RawReader reader(filename, 2, 16);
+    RawEvent  event;
+    CHECK(reader.skip(5) == 5);
+    CHECK((reader.next(event) && event.EventNumber == 5));
+    CHECK(reader.skip(40) == 40);
+    CHECK((reader.next(event) && event.EventNumber == 46));
+    CHECK(reader.skip(static_cast<std::int64_t>(nbrEvents)) == static_cast<std::int64_t>(nbrEvents) - 47);
+    CHECK_FALSE(reader.next(event));
+  }
+  std::filesystem::remove(filename);
+}
+
+TEST_CASE("Files which are not raw are recognised")
+{
+  const std::string filename{(std::filesystem::temp_directory_path() / "TestRawReader.txt").string()};
+  {
+    std::ofstream file(filename);
+    file << "not a raw file\n";
+  }
+  CHECK_FALSE(RawReader::isRaw(filename));
+  std::filesystem::remove(filename);
+}
@@ -0,0 +1,141 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Clustering.hpp"
+#include "Kernels.hpp"
+#include "RunSummary.hpp"
+#include "Synthetic.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t Chunk{16};
+
+// Hits, clusters and charge of the events [first,last[ in a partial summary, as a chunk of the event loop
+class Chunks
+{
+public:
+  explicit Chunks(const Waveforms& waveforms) : m_Waveforms(waveforms), m_Kernels(Kernels::Dispatcher::select(waveforms.getLength())), m_Strips(std::max<std::size_t>(waveforms.getChannels() / 8, 1))
+  {
+    for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch) m_Strips[std::min(ch / 8, m_Strips.size() - 1)].push_back(static_cast<int>(ch));
+  }
+  std::size_t getNumberChunks() const { return (m_Waveforms.getEvents() + Chunk - 1) / Chunk; }
+  std::size_t getNumberChambers() const { return m_Strips.size(); }
+  RunSummary  analyse(const std::size_t& chunk) const
+  {
+    const std::size_t   first{std::min(chunk * Chunk, m_Waveforms.getEvents())};
+    const std::size_t   last{std::min(first + Chunk, m_Waveforms.getEvents())};
+    const std::size_t   length{m_Waveforms.getLength()};
+    RunSummary          summary(m_Strips.size());
+    ClusterBuilder      clusters(m_Strips, 10, length);
+    std::vector<double> buffer(length);
+    std::vector<int>    hits(m_Strips.size());
+    for(RunSummary::Chamber& chamber : summary.Chambers) chamber.Charge = Histogram(200, 0, 100);
+    for(std::size_t evt = first; evt != last; ++evt)
+    {
+      std::fill(hits.begin(), hits.end(), 0);
+      for(std::size_t ch = 0; ch != m_Waveforms.getChannels(); ++ch)
+      {
+        const double* data{m_Waveforms.get(evt, ch)};
+        buffer.assign(data, data + length);
+        m_Kernels.baseline(buffer.data(), length);
+        const std::size_t               chamber{std::min(ch / 8, m_Strips.size() - 1)};
+        const std::pair<double, double> noise{m_Kernels.meanSigma(buffer.data(), length, 0, 0.2 * length)};
+        const std::pair<double, int>    minimum{m_Kernels.extremum(-1, buffer.data(), length, static_cast<int>(0.2 * length), static_cast<int>(length))};
+        if(noise.first - minimum.first < 5 * noise.second) continue;
+        ++hits[chamber];
+        clusters.addHit(static_cast<int>(chamber), static_cast<int>(ch), minimum.second);
+        summary.Chambers[chamber].Charge.fill(noise.first - minimum.first);
+        summary.Chambers[chamber].ChargeSum += std::llround((noise.first - minimum.first) / PulseAnalyser::ChargeQuantum);
+        ++summary.Chambers[chamber].ChargeEntries;
+      }
+      clusters.endEvent();
+      for(std::size_t chamber = 0; chamber != m_Strips.size(); ++chamber)
+      {
+        summary.Chambers[chamber].Efficient += hits[chamber] != 0;
+        summary.Chambers[chamber].EfficientCorrected += hits[chamber] != 0;
+        summary.Chambers[chamber].Hits += hits[chamber];
+      }
+    }
+    summary.Events    = static_cast<std::int64_t>(last - first);
+    summary.Corrected = summary.Events;
+    for(std::size_t chamber = 0; chamber != m_Strips.size(); ++chamber)
+    {
+      summary.Chambers[chamber].ClusterSize   = clusters.getClusterSize(chamber);
+      summary.Chambers[chamber].ClusterNumber = clusters.getClusterNumber(chamber);
+    }
+    return summary;
+  }
+
+private:
+  const Waveforms&              m_Waveforms;
+  const Kernels::Dispatcher     m_Kernels;
+  std::vector<std::vector<int>> m_Strips;
+};
+
+// Partial summaries merged in the order the chunks finish on the threads
+RunSummary Merge(const Chunks& chunks, const std::size_t& threads)
+{
+  // Empty summary with the binning of the partial ones
+  RunSummary               merged{chunks.analyse(chunks.getNumberChunks())};
+  std::mutex               mutex;
+  std::atomic<std::size_t> next{0};
+  auto                     work = [&]() {
+    for(std::size_t i = next++; i < chunks.getNumberChunks(); i = next++)
+    {
+      const RunSummary            partial{chunks.analyse(i)};
+      std::lock_guard<std::mutex> lock(mutex);
+      merged.add(partial);
+    }
+  };
+  std::vector<std::thread> workers;
+  for(std::size_t t = 1; t < threads; ++t) workers.emplace_back(work);
+  work();
+  for(std::thread& worker : workers) worker.join();
+  return merged;
+}
+
+// Compared as bits : NaN (no efficient event) must give NaN again
+std::vector<double> Records(const RunSummary& summary)
+{
+  std::vector<double> records;
+  for(std::size_t chamber = 0; chamber != summary.Chambers.size(); ++chamber)
+  {
+    const std::vector<double> record{summary.getRecord(chamber, 0, 1)};
+    records.insert(records.end(), record.begin(), record.end());
+  }
+  return records;
+}
+
+bool Same(const std::vector<double>& a, const std::vector<double>& b) { return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0; }
+}  // namespace
+
+// The events cut in chunks analysed by 1, 2, 8 and 32 threads, then merged in the reverse order : the merged
+// summary and the results records must be bitwise the ones of one thread
+TEST_CASE("Merged summary doesn't depend on the number of threads nor on the merge order")
+{
+  const Waveforms   waveforms(200, 32, 1024);
+  const Chunks      chunks(waveforms);
+  const RunSummary  reference{Merge(chunks, 1)};
+  const std::string serialized{reference.serialize()};
+  REQUIRE(reference.Events == static_cast<std::int64_t>(waveforms.getEvents()));
+  REQUIRE(reference.Chambers[0].Hits != 0);
+  for(const std::size_t threads : {2, 8, 32})
+  {
+    const RunSummary merged{Merge(chunks, threads)};
+    CHECK_MESSAGE(merged.serialize() == serialized, threads << " threads");
+    CHECK_MESSAGE(Same(Records(merged), Records(reference)), threads << " threads");
+  }
+  RunSummary reversed{chunks.analyse(chunks.getNumberChunks())};
+  for(std::size_t i = chunks.getNumberChunks(); i != 0; --i) reversed.add(chunks.analyse(i - 1));
+  CHECK(reversed.serialize() == serialized);
+  CHECK(Same(Records(reversed), Records(reference)));
+}
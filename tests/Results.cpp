@@ -0,0 +1,104 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Results.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+const std::string Filename{(std::filesystem::temp_directory_path() / "TestResults.res").string()};
+
+std::string Read()
+{
+  std::ifstream file(Filename, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void Write(const std::string& bytes)
+{
+  std::ofstream file(Filename, std::ios::binary | std::ios::trunc);
+  file.write(bytes.data(), bytes.size());
+}
+
+// Bytes of the file with the uint32 at the offset given replaced
+std::string Patch(std::string bytes, const std::size_t& offset, const std::uint32_t& value)
+{
+  std::memcpy(&bytes[offset], &value, sizeof(value));
+  return bytes;
+}
+}  // namespace
+
+TEST_CASE("Records read back are the ones written")
+{
+  {
+    ResultsWriter writer(Filename, {"Run", "Efficiency"});
+    writer.append({7000, 0.95});
+    writer.append({7100, 0.97});
+  }
+  {
+    // Job killed while writing a record
+    std::ofstream file(Filename, std::ios::binary | std::ios::app);
+    const double  half{7200};
+    file.write(reinterpret_cast<const char*>(&half), sizeof(half));
+  }
+  const ResultsReader reader(Filename);
+  REQUIRE(reader.getColumns() == std::vector<std::string>{"Run", "Efficiency"});
+  REQUIRE(reader.getNumberRecords() == 2);
+  CHECK(reader.get(1, 0) == 7100);
+  CHECK(reader.getColumn<double>("Efficiency") == std::vector<double>{0.95, 0.97});
+  CHECK_THROWS_AS(reader.getColumn<double>("Charge"), std::runtime_error);
+  std::filesystem::remove(Filename);
+}
+
+// Header : magic (8) | columns (4) | header size (4) | (length (4), name) x columns | padding
+TEST_CASE("Corrupted headers are refused")
+{
+  {
+    ResultsWriter writer(Filename, {"Run", "Efficiency"});
+    writer.append({7000, 0.95});
+  }
+  const std::string valid{Read()};
+  const std::size_t header{valid.size() - 2 * sizeof(double)};
+  // No column, header larger than the file, header too small for the names, name running past the header
+  for(const std::string& bytes : {Patch(valid, 8, 0), Patch(valid, 12, static_cast<std::uint32_t>(valid.size() + 8)), Patch(valid, 12, 24), Patch(valid, 16, 0xFFFFFFFFu), Patch(valid, 16, static_cast<std::uint32_t>(header))})
+  {
+    Write(bytes);
+    CHECK_THROWS_AS(ResultsReader{Filename}, std::runtime_error);
+  }
+  Write(valid.substr(0, 12));
+  CHECK_THROWS_AS(ResultsReader{Filename}, std::runtime_error);
+  Write(valid);
+  CHECK_NOTHROW(ResultsReader{Filename});
+  std::filesystem::remove(Filename);
+}
+
+TEST_CASE("A resumed job appends after the records kept")
+{
+  {
+    ResultsWriter writer(Filename, {"Run", "Efficiency"});
+    writer.append({7000, 0.95});
+    // Written after the checkpoint
+    writer.append({7100, 0.97});
+  }
+  {
+    ResultsWriter writer(Filename, {"Run", "Efficiency"}, true, 1);
+    CHECK(writer.getNumberRecords() == 1);
+    writer.append({7100, 0.96});
+    CHECK(writer.getNumberRecords() == 2);
+  }
+  const ResultsReader reader(Filename);
+  CHECK(reader.getColumn<double>("Efficiency") == std::vector<double>{0.95, 0.96});
+  CHECK_THROWS_AS((ResultsWriter{Filename, {"Run", "Charge"}, true}), std::runtime_error);
+  std::filesystem::remove(Filename);
+  ResultsWriter created(Filename, {"Run"}, true);
+  CHECK(created.getNumberRecords() == 0);
+  std::filesystem::remove(Filename);
+}
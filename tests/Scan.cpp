@@ -0,0 +1,79 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "AnalysisEngine.hpp"
+#include "Kernels.hpp"
+#include "RunSummary.hpp"
+#include "Scan.hpp"
+#include "Synthetic.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Scan of 19 thresholds x 16 windows x 3 noise thresholds in one pass against the same grid made point by point
+// the way a run does it (WindowFinder window, MeanSTD mean, extremum, corrected efficiency of EfficiencyCounter),
+// the counts must be the same
+TEST_CASE("Scan gives the counts of the runs made point by point")
+{
+  const Waveforms                        waveforms(100, 32, 1024);
+  const std::size_t                      length{waveforms.getLength()};
+  const std::size_t                      chambers{4};
+  const int                              tick{static_cast<int>(0.8 * length)};
+  const std::pair<double, double>        noiseWindow{0, 0.2 * length};
+  const std::pair<double, double>        noiseWindowAfter{0.85 * length, length - 1.0};
+  std::vector<double>                    sigmas;
+  std::vector<std::pair<double, double>> windows;
+  const std::vector<double>              noiseRatios{1.2, 1.5, 3.0};
+  for(double sigma = 1; sigma <= 10; sigma += 0.5) sigmas.push_back(sigma);
+  for(const double& delay : {0.2 * length, 0.25 * length, 0.3 * length, 0.35 * length})
+    for(const double& width : {0.1 * length, 0.2 * length, 0.3 * length, 0.45 * length}) windows.emplace_back(delay, width);
+  Scan scan(chambers, sigmas, windows, noiseRatios, noiseWindow, noiseWindowAfter);
+  for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+  {
+    for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch) scan.addChannel(ch % chambers, waveforms.get(evt, ch), length, -1, tick);
+    scan.endEvent();
+  }
+  REQUIRE(scan.getEvents() == waveforms.getEvents());
+
+  // One point as a run makes it, counted by the EfficiencyCounter of Analysis
+  const Kernels::Dispatcher kernels{Kernels::Dispatcher::generic()};
+  RunSummary                counts(chambers);
+  auto                      point = [&](const double& sigma, const std::pair<double, double>& window, const double& noiseRatio) {
+    const int         begin{std::max(static_cast<int>(tick - window.first - window.second / 2), 0)};
+    const int         end{std::min(static_cast<int>(tick - window.first + window.second / 2), static_cast<int>(length))};
+    EfficiencyCounter efficiency(chambers);
+    for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+    {
+      efficiency.beginEvent();
+      for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+      {
+        const double*                   data{waveforms.get(evt, ch)};
+        const std::pair<double, double> noise{kernels.meanSigma(data, length, noiseWindow.first, noiseWindow.second)};
+        const std::pair<double, double> after{kernels.meanSigma(data, length, noiseWindowAfter.first, noiseWindowAfter.second)};
+        if(after.second * 1.0 / noise.second >= noiseRatio) efficiency.setNoisy(ch % chambers);
+        const double value{kernels.extremum(-1, data, length, begin, end).first};
+        if(std::fabs(value - kernels.meanSigma(data, length, begin, end).first) > sigma * noise.second) efficiency.addHit(ch % chambers);
+      }
+      efficiency.endEvent();
+    }
+    efficiency.fill(counts);
+  };
+  std::size_t differences{0};
+  for(std::size_t w = 0; w != windows.size(); ++w)
+    for(std::size_t t = 0; t != sigmas.size(); ++t)
+      for(std::size_t k = 0; k != noiseRatios.size(); ++k)
+      {
+        point(sigmas[t], windows[w], noiseRatios[k]);
+        if(static_cast<std::uint64_t>(counts.Corrected) != scan.getCorrected(k)) ++differences;
+        for(std::size_t chamber = 0; chamber != chambers; ++chamber)
+        {
+          const RunSummary::Chamber& reference{counts.Chambers[chamber]};
+          if(reference.Efficient != scan.getEfficient(chamber, w, t) || reference.Hits != scan.getHits(chamber, w, t) || reference.EfficientCorrected != scan.getEfficientCorrected(k, chamber, w, t)) ++differences;
+        }
+      }
+  CHECK(differences == 0);
+  CHECK(scan.getRecords(7000, 1, 0.2).size() == chambers * windows.size() * sigmas.size() * noiseRatios.size());
+}
@@ -0,0 +1,69 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Selection.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Compiled selections against the same cuts written in C++ on the feature columns of many channels, the selected
+// rows must be the same
+TEST_CASE("Compiled selections select the rows of the hand written cuts")
+{
+  const std::size_t                rows{100003};
+  std::mt19937                     generator(29);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_real_distribution<> uniform(0.5, 3.0);
+  const std::vector<std::string>   variables{"value", "signal_mean", "sigma_noise", "sigma_after"};
+  std::vector<std::vector<double>> features(variables.size(), std::vector<double>(rows));
+  for(std::size_t row = 0; row != rows; ++row)
+  {
+    features[1][row] = normal(generator);
+    features[2][row] = uniform(generator);
+    features[3][row] = uniform(generator) * (row % 10 == 0 ? 4 : 1);
+    features[0][row] = features[1][row] + features[2][row] * 6 * normal(generator);
+  }
+  std::vector<const double*> columns;
+  for(const std::vector<double>& feature : features) columns.push_back(feature.data());
+  const double* value{columns[0]};
+  const double* mean{columns[1]};
+  const double* noise{columns[2]};
+  const double* after{columns[3]};
+  const double  nsigma{5};
+  struct Cut
+  {
+    std::string                             Expression;
+    std::function<bool(const std::size_t&)> Reference;
+  };
+  const std::vector<Cut> cuts{{"abs(value - signal_mean) > nsigma*sigma_noise", [&](const std::size_t& i) { return std::fabs(value[i] - mean[i]) > nsigma * noise[i]; }},
+                              {"abs(value - signal_mean) > 5*sigma_noise && sigma_after/sigma_noise < 3", [&](const std::size_t& i) { return std::fabs(value[i] - mean[i]) > 5 * noise[i] && after[i] / noise[i] < 3; }},
+                              {"!(max(value, signal_mean) - min(value, signal_mean) <= 5*sqrt(sigma_noise*sigma_noise)) || -value > 20", [&](const std::size_t& i) { return std::fabs(value[i] - mean[i]) > 5 * noise[i] || -value[i] > 20; }}};
+  std::vector<std::uint8_t> compiled(rows);
+  for(const Cut& cut : cuts)
+  {
+    Selection selection(cut.Expression, variables, {{"nsigma", nsigma}});
+    selection.evaluate(columns, rows, compiled.data());
+    std::size_t errors{0};
+    std::size_t selected{0};
+    for(std::size_t i = 0; i != rows; ++i)
+    {
+      errors += compiled[i] != cut.Reference(i);
+      selected += compiled[i];
+    }
+    CHECK(errors == 0);
+    CHECK(selected != 0);
+  }
+}
+
+TEST_CASE("Constants are folded and syntax errors reported")
+{
+  const std::vector<std::string> variables{"value", "signal_mean", "sigma_noise", "sigma_after"};
+  CHECK(Selection("2*3 + 1 > 6.5", variables).getNumberInstructions() == 1);
+  CHECK(Selection("value > nsigma", variables, {{"nsigma", 5}}).getNumberInstructions() == 3);
+  for(const char* bad : {"value >", "value > 1 &", "abs(value", "amplitude > 3", "min(value)"}) CHECK_THROWS_AS(Selection(bad, variables), std::runtime_error);
+}
@@ -0,0 +1,124 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+#include "doctest/doctest.h"
+
+#include "Classifier.hpp"
+#include "Clustering.hpp"
+#include "EventViewer.hpp"
+#include "Kernels.hpp"
+#include "Memory.hpp"
+#include "PulseShape.hpp"
+#include "Synthetic.hpp"
+#include "TLatex.h"
+#include "TLine.h"
+#include "TROOT.h"
+#include "TimeSeries.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Number of events of the soak, "--events N" on the command line (the default is small enough for each ctest run)
+static std::size_t NbrEvents{2000};
+
+// The per event chain of Analysis on many small events with the event display drawn for every event (waveform,
+// signal region, minimum marker, noise arrows, lines and labels, the canvas saved from time to time) : once the
+// first events are processed the resident memory must stay flat
+TEST_CASE("Resident memory stays flat over the events")
+{
+  gROOT->SetBatch(true);
+  const std::size_t                   channels{8};
+  const std::size_t                   length{128};
+  const Waveforms                     pool(64, channels, length, 7);
+  const Kernels::Dispatcher           kernels{Kernels::Dispatcher::select(length)};
+  const std::vector<std::vector<int>> strips{{0, 1, 2, 3}, {4, 5, 6, 7}};
+  ClusterBuilder                      clusters(strips, 10, length);
+  PulseAnalyser                       pulses(strips.size(), channels);
+  Classifier                          classifier(strips.size());
+  TimeSeries                          timeSeries(strips.size());
+  std::map<int, EventViewer>          viewers;
+  Channel                             channel;
+  std::vector<int>                    hits(strips.size());
+  const std::vector<bool>             noisy(strips.size(), false);
+  const std::filesystem::path         folder{std::filesystem::temp_directory_path() / "TestSoak"};
+  const std::size_t                   step{std::max<std::size_t>(NbrEvents / 20, 1)};
+  std::size_t                         warm{0};
+  std::size_t                         peak{0};
+  std::filesystem::create_directories(folder);
+  for(std::size_t chamber = 0; chamber != strips.size(); ++chamber)
+  {
+    viewers[static_cast<int>(chamber)].setCanvasName(fmt::format("Chamber{}", chamber));
+    viewers[static_cast<int>(chamber)].divide(static_cast<int>(strips[chamber].size()));
+  }
+  channel.Data.resize(length);
+  for(std::size_t evt = 0; evt != NbrEvents; ++evt)
+  {
+    std::fill(hits.begin(), hits.end(), 0);
+    for(std::map<int, EventViewer>::iterator it = viewers.begin(); it != viewers.end(); ++it)
+    {
+      it->second.reset();
+      it->second.setPaveLabel(fmt::format("Event {}", evt));
+    }
+    for(std::size_t ch = 0; ch != channels; ++ch)
+    {
+      const double* data{pool.get(evt % pool.getEvents(), ch)};
+      std::copy(data, data + length, channel.Data.begin());
+      kernels.baseline(channel.Data.data(), length);
+      const std::size_t               chamber{ch / 4};
+      const std::pair<double, double> noise{kernels.meanSigma(channel.Data.data(), length, 0, 30)};
+      const std::pair<double, int>    minimum{kernels.extremum(-1, channel.Data.data(), length, 30, length)};
+      const bool                      hit{noise.first - minimum.first >= 5 * noise.second};
+      classifier.addChannel(chamber, std::fabs(minimum.first - noise.first), 1.0);
+      // Display as Analysis draws it
+      EventViewer& viewer{viewers[static_cast<int>(chamber)]};
+      const int    number{static_cast<int>(ch)};
+      viewer.cdNext();
+      viewer.createWaveForm(number, channel);
+      viewer.getPlot(number).GetYaxis()->SetRangeUser(-100, 20);
+      viewer.getPlot(number).Draw("HIST");
+      viewer.UnderlineSignalRegion(number, hit ? 8 : 46, 30, length);
+      TLine line;
+      line.DrawLine(30, noise.first - 5 * noise.second, length, noise.first - 5 * noise.second);
+      viewer.getMarker(number, minimum.second, minimum.first).Draw("PSAME");
+      viewer.getArrow(number, 0, 0, noise.first, 0, noise.first - 5 * noise.second).Draw();
+      viewer.getArrow(number, 1, 30, noise.first, 30, noise.first - 5 * noise.second).Draw();
+      TLatex latex;
+      latex.DrawLatex(31, noise.first - 2.5 * noise.second, "5#times#sigma_{Noise}");
+      if(!hit) continue;
+      ++hits[chamber];
+      clusters.addHit(chamber, ch, minimum.second);
+      const Pulse& pulse{pulses.analyse(chamber, ch, channel.Data.data(), length, -1, minimum.second, noise.first, 1.0)};
+      classifier.addHit(chamber, pulse.Charge, pulse.Time);
+    }
+    if(evt % 500 == 0)
+      for(std::map<int, EventViewer>::iterator it = viewers.begin(); it != viewers.end(); ++it) it->second.saveAs((folder / fmt::format("Event{}chamber{}.png", evt, it->first)).string());
+    clusters.endEvent();
+    pulses.endEvent();
+    classifier.endEvent();
+    // 1 kHz trigger rate, the time tag wraps around as on the digitizer
+    timeSeries.fill(static_cast<double>((evt * 117647) % (std::size_t(1) << 30)), hits, noisy);
+    if((evt + 1) % step != 0) continue;
+    const std::size_t resident{getResidentMemory()};
+    if(evt + 1 == 2 * step) warm = resident;
+    if(evt + 1 > 2 * step) peak = std::max(peak, resident);
+  }
+  classifier.flush();
+  std::filesystem::remove_all(folder);
+  MESSAGE("resident memory " << warm / 1048576. << " MB after " << 2 * step << " events, at most " << peak / 1048576. << " MB after");
+  // Nothing measured (no /proc) : nothing to check
+  if(warm != 0) CHECK(peak <= warm + 2 * 1048576);
+}
+
+int main(int argc, char** argv)
+{
+  for(int i = 1; i + 1 < argc; ++i)
+    if(std::strcmp(argv[i], "--events") == 0) NbrEvents = std::strtoull(argv[i + 1], nullptr, 10);
+  doctest::Context context;
+  context.applyCommandLine(argc, argv);
+  return context.run();
+}
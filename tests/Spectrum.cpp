@@ -0,0 +1,81 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Spectrum.hpp"
+#include "Synthetic.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+TEST_CASE("FFT gives the power of the direct DFT")
+{
+  const FFT                         plan(64);
+  std::vector<double>               data(64), power(33);
+  std::vector<std::complex<double>> work(32);
+  std::mt19937                      generator(3);
+  std::normal_distribution<double>  normal(0.0, 1.0);
+  for(double& x : data) x = normal(generator);
+  plan.power(data.data(), work.data(), power.data());
+  double error{0};
+  for(std::size_t k = 0; k != power.size(); ++k)
+  {
+    std::complex<double> dft{0, 0};
+    for(std::size_t n = 0; n != data.size(); ++n) dft += data[n] * std::polar(1.0, -2 * std::acos(-1.0) * k * n / data.size());
+    error = std::max(error, std::fabs(std::norm(dft) - power[k]) / std::max(1.0, std::norm(dft)));
+  }
+  CHECK(error < 1e-9);
+  CHECK(FFT::floorPowerOfTwo(1000) == 512);
+  CHECK(FFT::floorPowerOfTwo(3) == 0);
+}
+
+// Noise PSD of the synthetic waveforms (gaussian noise of RMS 2 plus a 50 MHz pickup of amplitude 1 on every
+// channel) : the pickup bin must stand out and the density integrated over the frequencies must give back the
+// variance. The densities must be bitwise the same whatever the number of threads.
+TEST_CASE("Noise spectrum finds the pickup and doesn't depend on the number of threads")
+{
+  const Waveforms   waveforms(200, 16, 1024);
+  const std::size_t segment{256};
+  const double      period{1.0};
+  const double      pickup{50e6};
+  // Waveforms with the pickup added once, segments taken at the end of the records (no pulse there)
+  std::vector<double> data(waveforms.copy());
+  const std::size_t   length{waveforms.getLength()};
+  for(std::size_t i = 0; i != data.size(); ++i) data[i] += std::sin(2 * std::acos(-1.0) * pickup * (i % length) * period * 1e-9);
+  const std::size_t   begin{length - segment};
+  std::vector<double> reference;
+  for(const int threads : {1, 2, 8, 32})
+  {
+    NoiseSpectrum spectrum(waveforms.getChannels(), segment, threads);
+    for(std::size_t evt = 0; evt != waveforms.getEvents(); ++evt)
+      for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch) CHECK(spectrum.add(ch, &data[(evt * waveforms.getChannels() + ch) * length], length, begin));
+    spectrum.finish();
+    CHECK(spectrum.getSegments(0) == waveforms.getEvents());
+    // Variance of the noise + pickup from the density of channel 0
+    double      integral{0};
+    std::size_t peak{1};
+    for(std::size_t k = 0; k != spectrum.getNumberBins(); ++k)
+    {
+      integral += spectrum.getDensity(0, k, period) * spectrum.getFrequency(1, period);
+      if(k > 0 && spectrum.getDensity(0, k, period) > spectrum.getDensity(0, peak, period)) peak = k;
+    }
+    const double expected{2.0 * 2.0 + 0.5};
+    CHECK(std::fabs(spectrum.getFrequency(peak, period) - pickup) <= spectrum.getFrequency(1, period));
+    CHECK(std::fabs(integral - expected) <= 0.1 * expected);
+    std::vector<double> densities;
+    for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+      for(std::size_t k = 0; k != spectrum.getNumberBins(); ++k) densities.push_back(spectrum.getDensity(ch, k, period));
+    if(threads == 1) reference = densities;
+    CHECK(densities == reference);
+  }
+}
+
+TEST_CASE("Segments outside the record are refused")
+{
+  NoiseSpectrum       spectrum(1, 64);
+  std::vector<double> data(100, 0.0);
+  CHECK_FALSE(spectrum.add(0, data.data(), data.size(), 50));
+  CHECK(spectrum.add(0, data.data(), data.size(), 36));
+}
@@ -0,0 +1,179 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "Classifier.hpp"
+#include "Clustering.hpp"
+#include "Crosstalk.hpp"
+#include "PeakFinder.hpp"
+#include "Precision.hpp"
+#include "PulseShape.hpp"
+#include "Scan.hpp"
+#include "Spectrum.hpp"
+#include "State.hpp"
+#include "Synthetic.hpp"
+#include "TimeSeries.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+const std::size_t                   Chambers{2};
+const std::vector<std::vector<int>> Strips{{0, 1, 2, 3}, {4, 5, 6, 7}};
+
+// The accumulators of a run, with the options of Analysis
+struct Accumulators
+{
+  explicit Accumulators(const std::size_t& length)
+      : clusters(Strips, 10, length), pulses(Chambers, 8), peaks(Chambers, 8), classifier(Chambers, 5.0, 10.0, 16), timeSeries(Chambers), scan(Chambers, {3, 5}, {{0.3 * length, 0.4 * length}}, {1.5}, {0, 0.2 * length}, {0.85 * length, length - 1.0}), crosstalk(8, 32, 16), spectrum(8, 32, 1, 8), validation(Chambers)
+  {
+  }
+  ClusterBuilder      clusters;
+  PulseAnalyser       pulses;
+  PeakFinder          peaks;
+  Classifier          classifier;
+  TimeSeries          timeSeries;
+  Scan                scan;
+  Crosstalk           crosstalk;
+  NoiseSpectrum       spectrum;
+  PrecisionValidation validation;
+};
+
+// Per event chain of a run on the events [first, last[
+void Process(Accumulators& run, const Waveforms& waveforms, const std::size_t& first, const std::size_t& last)
+{
+  const std::size_t length{waveforms.getLength()};
+  const std::size_t noise{length / 5};
+  for(std::size_t evt = first; evt != last; ++evt)
+  {
+    std::vector<int> hits(Chambers);
+    for(std::size_t ch = 0; ch != waveforms.getChannels(); ++ch)
+    {
+      const double*     data{waveforms.get(evt, ch)};
+      const std::size_t chamber{ch / 4};
+      double            mean{0};
+      double            square{0};
+      for(std::size_t i = 0; i != noise; ++i)
+      {
+        mean += data[i];
+        square += data[i] * data[i];
+      }
+      mean /= noise;
+      const double sigma{std::sqrt(std::max(square / noise - mean * mean, 1e-12))};
+      const int    minimum{static_cast<int>(std::min_element(data + noise, data + length) - data)};
+      const double amplitude{mean - data[minimum]};
+      const bool   hit{amplitude >= 5 * sigma};
+      run.classifier.addChannel(chamber, amplitude, amplitude / sigma);
+      run.scan.addChannel(chamber, data, length, -1, static_cast<int>(0.8 * length));
+      run.crosstalk.addNoise(ch, data, length, 0);
+      run.spectrum.add(ch, data, length, 0);
+      run.validation.addChannel(chamber, {hit, false, amplitude, sigma}, {amplitude >= 5 * sigma + 0.5, false, std::round(amplitude), std::round(sigma)});
+      if(!hit) continue;
+      ++hits[chamber];
+      run.clusters.addHit(chamber, ch, minimum);
+      const Pulse& pulse{run.pulses.analyse(chamber, ch, data, length, -1, minimum, mean, 1.0)};
+      run.peaks.find(chamber, ch, data, length, noise, length, -1, mean, 5 * sigma);
+      run.classifier.addHit(chamber, pulse.Charge, pulse.Time);
+      run.crosstalk.addHit(ch);
+    }
+    run.clusters.endEvent();
+    run.pulses.endEvent();
+    run.peaks.endEvent(1.0);
+    run.classifier.endEvent();
+    run.timeSeries.fill(static_cast<double>(evt * 117647), hits, std::vector<bool>(Chambers, false));
+    run.scan.endEvent();
+    run.crosstalk.endEvent();
+    run.validation.endEvent();
+  }
+}
+
+std::string Save(Accumulators& run)
+{
+  std::ostringstream stream;
+  run.clusters.save(stream);
+  run.pulses.save(stream);
+  run.peaks.save(stream);
+  run.classifier.save(stream);
+  run.timeSeries.save(stream);
+  run.scan.save(stream);
+  run.crosstalk.save(stream);
+  run.spectrum.save(stream);
+  run.validation.save(stream);
+  return stream.str();
+}
+
+void Restore(Accumulators& run, const std::string& state)
+{
+  std::istringstream stream(state);
+  run.clusters.restore(stream);
+  run.pulses.restore(stream);
+  run.peaks.restore(stream);
+  run.classifier.restore(stream);
+  run.timeSeries.restore(stream);
+  run.scan.restore(stream);
+  run.crosstalk.restore(stream);
+  run.spectrum.restore(stream);
+  run.validation.restore(stream);
+}
+}  // namespace
+
+// A run interrupted in the middle of the batches (crosstalk, classifier, spectrum) and resumed from its state in new
+// accumulators ends with the state of the run made without interruption, bit for bit
+TEST_CASE("Resumed accumulators end as the ones of an uninterrupted run")
+{
+  const Waveforms waveforms(80, 8, 256, 5);
+  Accumulators    uninterrupted(waveforms.getLength());
+  Process(uninterrupted, waveforms, 0, waveforms.getEvents());
+  const std::string expected{Save(uninterrupted)};
+
+  std::string state;
+  {
+    Accumulators interrupted(waveforms.getLength());
+    Process(interrupted, waveforms, 0, 37);
+    state = Save(interrupted);
+  }
+  Accumulators resumed(waveforms.getLength());
+  Restore(resumed, state);
+  Process(resumed, waveforms, 37, waveforms.getEvents());
+  CHECK(Save(resumed) == expected);
+  CHECK(resumed.crosstalk.getEvents() == waveforms.getEvents());
+  CHECK(resumed.pulses.getChargeEntries(0) != 0);
+}
+
+TEST_CASE("A state is not restored into accumulators made with other options")
+{
+  Accumulators run(256);
+  Process(run, Waveforms(4, 8, 256, 5), 0, 4);
+  std::ostringstream stream;
+  run.scan.save(stream);
+  Scan               other(Chambers, {3, 5, 7}, {{76.8, 102.4}}, {1.5}, {0, 51.2}, {217.6, 255});
+  std::istringstream saved(stream.str());
+  CHECK_THROWS_AS(other.restore(saved), std::runtime_error);
+}
+
+TEST_CASE("Values are read back as written")
+{
+  std::stringstream         stream;
+  const std::vector<double> values{0.1, -1e-300, std::numeric_limits<double>::infinity(), 1.0 / 3};
+  std::vector<double>       read(values.size());
+  double                    nan{0};
+  std::uint8_t              code{0};
+  State::write(stream, values);
+  State::write(stream, std::nan(""), std::uint8_t{200});
+  State::read(stream, read);
+  State::read(stream, nan, code);
+  CHECK(read == values);
+  CHECK(std::isnan(nan));
+  CHECK(code == 200);
+  std::vector<double> shorter(2);
+  stream.seekg(0);
+  CHECK_THROWS_AS(State::read(stream, shorter), std::runtime_error);
+}
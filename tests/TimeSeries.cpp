@@ -0,0 +1,90 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "TimeSeries.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+// Contents expected in the bins of the final width, from the times (s) of the events
+struct Reference
+{
+  explicit Reference(const std::size_t& bins) : Events(bins, 0), Efficient(2 * bins, 0), Hits(2 * bins, 0), Noisy(2 * bins, 0) {}
+  std::vector<std::uint64_t> Events;
+  std::vector<std::uint64_t> Efficient;
+  std::vector<std::uint64_t> Hits;
+  std::vector<std::uint64_t> Noisy;
+};
+
+// Chamber 0 : evt % 3 hits, chamber 1 : 2 hits on the odd events, noisy one event out of 5 on chamber 0
+std::vector<int>  EventHits(const std::size_t& evt) { return {static_cast<int>(evt % 3), evt % 2 == 1 ? 2 : 0}; }
+std::vector<bool> EventNoisy(const std::size_t& evt) { return {evt % 5 == 0, false}; }
+
+// Times in ticks (tick period of 1 s, bins of 1 s at first) : the bins and the merges are exact
+std::size_t Mismatches(const TimeSeries& series, const std::vector<double>& times)
+{
+  Reference reference(series.getNumberBins());
+  for(std::size_t evt = 0; evt != times.size(); ++evt)
+  {
+    const std::size_t bin{static_cast<std::size_t>(std::floor(times[evt] / series.getBinWidth()))};
+    if(bin >= series.getNumberBins()) return times.size();
+    ++reference.Events[bin];
+    for(std::size_t chamber = 0; chamber != 2; ++chamber)
+    {
+      reference.Efficient[2 * bin + chamber] += EventHits(evt)[chamber] > 0;
+      reference.Hits[2 * bin + chamber] += EventHits(evt)[chamber];
+      reference.Noisy[2 * bin + chamber] += EventNoisy(evt)[chamber];
+    }
+  }
+  std::size_t errors{0};
+  for(std::size_t bin = 0; bin != series.getNumberBins(); ++bin)
+  {
+    errors += series.getEvents(bin) != reference.Events[bin];
+    for(std::size_t chamber = 0; chamber != 2; ++chamber)
+    {
+      errors += series.getEfficient(bin, chamber) != reference.Efficient[2 * bin + chamber];
+      errors += series.getHits(bin, chamber) != reference.Hits[2 * bin + chamber];
+      errors += series.getNoisy(bin, chamber) != reference.Noisy[2 * bin + chamber];
+    }
+  }
+  return errors;
+}
+}  // namespace
+
+TEST_CASE("Bins merged when the run outgrows maxBins hold the events of their time range")
+{
+  TimeSeries          series(2, 1.0, 8, 1.0);
+  std::vector<double> times;
+  for(std::size_t evt = 0; evt != 100; ++evt)
+  {
+    times.push_back(3.0 * evt);
+    series.fill(times.back(), EventHits(evt), EventNoisy(evt));
+  }
+  // 297 s in bins of 64 s : 5 bins
+  CHECK(series.getTime() == 297);
+  CHECK(series.getBinWidth() == 64);
+  CHECK(series.getNumberBins() == 5);
+  CHECK(Mismatches(series, times) == 0);
+  std::uint64_t events{0};
+  for(std::size_t bin = 0; bin != series.getNumberBins(); ++bin) events += series.getEvents(bin);
+  CHECK(events == times.size());
+}
+
+TEST_CASE("Time tags wrapping during the run continue the series")
+{
+  // Counter of 10 bits started at 1000 : it wraps after the 3rd event
+  TimeSeries          series(2, 1.0, 8, 1.0, 10);
+  std::vector<double> times;
+  for(std::size_t evt = 0; evt != 60; ++evt)
+  {
+    times.push_back(10.0 * evt);
+    series.fill(std::fmod(1000 + 10.0 * evt, 1024), EventHits(evt), EventNoisy(evt));
+  }
+  CHECK(series.getTime() == 590);
+  CHECK(series.getBinWidth() == 128);
+  CHECK(series.getNumberBins() == 5);
+  CHECK(Mismatches(series, times) == 0);
+}
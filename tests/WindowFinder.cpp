@@ -0,0 +1,28 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "WindowFinder.hpp"
+
+#include <utility>
+#include <vector>
+
+// Records of 4096 samples : the windows late in the record must be valid and the delays learnt there
+TEST_CASE("Windows follow the record length")
+{
+  WindowFinder windows({8}, 100, 50);
+  windows.setLength(4096);
+  CHECK(windows.getLength() == 4096);
+  CHECK(windows.getDelays(8).getNbins() == 8192);
+  CHECK(windows.setTrigger(8, 3000));
+  CHECK(windows.getWindow(8) == std::pair<int, int>{2900, 3000});
+  CHECK_FALSE(windows.setTrigger(8, 5000));
+  // Signal 1500 ticks before the trigger (outside of a 1024 samples histogram)
+  for(int i = 0; i != 1000; ++i) windows.fill(8, 3500, 2000 + i % 5);
+  for(int tick = 0; tick < 4000; tick += 40) windows.fill(8, 3500, tick);
+  REQUIRE(windows.learn() == 1);
+  CHECK(windows.getDelay(8) == doctest::Approx(1498).epsilon(0.01));
+  // Same length again : the learnt delay and the histogram are kept
+  windows.setLength(4096);
+  CHECK(windows.getDelays(8).getEntries() == 1100);
+  CHECK(windows.isLearnt(8));
+}